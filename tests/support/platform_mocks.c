@@ -81,7 +81,6 @@ void PLAT_pollInput(void) {
 	// Process queued events by calling the SDL_PollEvent fake
 	// The fake's behavior is controlled by tests
 	if (mock_state.event_index < mock_state.event_count) {
-		SDL_Event* event = &mock_state.queued_events[mock_state.event_index];
 		mock_state.event_index++;
 
 		// Configure SDL_PollEvent to return this event
@@ -11,6 +11,8 @@
  * - PAD_anyJustPressed/anyPressed/anyJustReleased() - Query functions
  * - PAD_justPressed/isPressed/justReleased/justRepeated() - Button-specific queries
  * - PAD_tappedMenu() - Menu tap detection with timing
+ * - PAD_beginFrame() - Transient state reset and auto-repeat
+ * - PAD_setButton()/PAD_setHat() - Digital button and hat updates
  */
 
 #include "../../support/unity/unity.h"
@@ -343,6 +345,118 @@ void test_PAD_tappedMenu_returns_false_when_menu_still_held(void) {
 	TEST_ASSERT_FALSE(PAD_tappedMenu(start_time + 100));
 }
 
+///////////////////////////////
+// PAD_beginFrame tests
+///////////////////////////////
+
+void test_PAD_beginFrame_clears_transient_state(void) {
+	pad.just_pressed = BTN_A;
+	pad.just_released = BTN_B;
+	pad.just_repeated = BTN_X;
+	pad.is_pressed = BTN_START;
+	pad.repeat_at[BTN_ID_START] = 5000;
+
+	PAD_beginFrame(1000);
+
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.just_pressed);
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.just_released);
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.just_repeated);
+	TEST_ASSERT_EQUAL_INT(BTN_START, pad.is_pressed);
+}
+
+void test_PAD_beginFrame_repeats_held_button_when_due(void) {
+	pad.is_pressed = BTN_DPAD_DOWN;
+	pad.repeat_at[BTN_ID_DPAD_DOWN] = 1000;
+
+	PAD_beginFrame(1000);
+
+	TEST_ASSERT_TRUE(pad.just_repeated & BTN_DPAD_DOWN);
+	TEST_ASSERT_EQUAL_UINT32(1000 + PAD_REPEAT_INTERVAL, pad.repeat_at[BTN_ID_DPAD_DOWN]);
+}
+
+void test_PAD_beginFrame_does_not_repeat_before_due(void) {
+	pad.is_pressed = BTN_DPAD_DOWN;
+	pad.repeat_at[BTN_ID_DPAD_DOWN] = 1000;
+
+	PAD_beginFrame(999);
+
+	TEST_ASSERT_FALSE(pad.just_repeated & BTN_DPAD_DOWN);
+}
+
+///////////////////////////////
+// PAD_setButton / PAD_setHat tests
+///////////////////////////////
+
+void test_PAD_setButton_press_sets_state_and_schedules_repeat(void) {
+	PAD_setButton(BTN_ID_A, 1, 1000);
+
+	TEST_ASSERT_TRUE(pad.is_pressed & BTN_A);
+	TEST_ASSERT_TRUE(pad.just_pressed & BTN_A);
+	TEST_ASSERT_TRUE(pad.just_repeated & BTN_A);
+	TEST_ASSERT_EQUAL_UINT32(1000 + PAD_REPEAT_DELAY, pad.repeat_at[BTN_ID_A]);
+}
+
+void test_PAD_setButton_press_while_held_is_ignored(void) {
+	pad.is_pressed = BTN_A;
+	pad.repeat_at[BTN_ID_A] = 42;
+
+	PAD_setButton(BTN_ID_A, 1, 1000);
+
+	TEST_ASSERT_FALSE(pad.just_pressed & BTN_A);
+	TEST_ASSERT_EQUAL_UINT32(42, pad.repeat_at[BTN_ID_A]);
+}
+
+void test_PAD_setButton_release_clears_state(void) {
+	pad.is_pressed = BTN_A;
+	pad.just_repeated = BTN_A;
+
+	PAD_setButton(BTN_ID_A, 0, 1000);
+
+	TEST_ASSERT_FALSE(pad.is_pressed & BTN_A);
+	TEST_ASSERT_FALSE(pad.just_repeated & BTN_A);
+	TEST_ASSERT_TRUE(pad.just_released & BTN_A);
+}
+
+void test_PAD_setButton_ignores_invalid_id(void) {
+	PAD_setButton(BTN_ID_NONE, 1, 1000);
+	PAD_setButton(BTN_ID_COUNT, 1, 1000);
+
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.is_pressed);
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.just_pressed);
+}
+
+void test_PAD_setHat_vertical_presses_up(void) {
+	PAD_setHat(1, -1, 1000);
+
+	TEST_ASSERT_TRUE(pad.is_pressed & BTN_DPAD_UP);
+	TEST_ASSERT_FALSE(pad.is_pressed & BTN_DPAD_DOWN);
+}
+
+void test_PAD_setHat_rocking_releases_opposite(void) {
+	PAD_setHat(0, -1, 1000);
+	PAD_setHat(0, 1, 1100);
+
+	TEST_ASSERT_FALSE(pad.is_pressed & BTN_DPAD_LEFT);
+	TEST_ASSERT_TRUE(pad.just_released & BTN_DPAD_LEFT);
+	TEST_ASSERT_TRUE(pad.is_pressed & BTN_DPAD_RIGHT);
+}
+
+void test_PAD_setHat_centered_releases_both(void) {
+	pad.is_pressed = BTN_DPAD_DOWN;
+
+	PAD_setHat(1, 0, 1000);
+
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.is_pressed);
+	TEST_ASSERT_TRUE(pad.just_released & BTN_DPAD_DOWN);
+}
+
+void test_PAD_setHat_ignores_out_of_range_values(void) {
+	PAD_setHat(1, 2, 1000);
+
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.is_pressed);
+	TEST_ASSERT_EQUAL_INT(BTN_NONE, pad.just_released);
+}
+
 ///////////////////////////////
 // Test runner
 ///////////////////////////////
@@ -381,5 +495,20 @@ int main(void) {
 	RUN_TEST(test_PAD_tappedMenu_ignores_brightness_adjustment);
 	RUN_TEST(test_PAD_tappedMenu_returns_false_when_menu_still_held);
 
+	// PAD_beginFrame tests
+	RUN_TEST(test_PAD_beginFrame_clears_transient_state);
+	RUN_TEST(test_PAD_beginFrame_repeats_held_button_when_due);
+	RUN_TEST(test_PAD_beginFrame_does_not_repeat_before_due);
+
+	// PAD_setButton / PAD_setHat tests
+	RUN_TEST(test_PAD_setButton_press_sets_state_and_schedules_repeat);
+	RUN_TEST(test_PAD_setButton_press_while_held_is_ignored);
+	RUN_TEST(test_PAD_setButton_release_clears_state);
+	RUN_TEST(test_PAD_setButton_ignores_invalid_id);
+	RUN_TEST(test_PAD_setHat_vertical_presses_up);
+	RUN_TEST(test_PAD_setHat_rocking_releases_opposite);
+	RUN_TEST(test_PAD_setHat_centered_releases_both);
+	RUN_TEST(test_PAD_setHat_ignores_out_of_range_values);
+
 	return UNITY_END();
 }
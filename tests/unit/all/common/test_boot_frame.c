@@ -0,0 +1,231 @@
+/**
+ * test_boot_frame.c - Tests for the launcher boot frame snapshot
+ *
+ * Uses real temp files for save/load. Framebuffer targets are plain
+ * memory buffers, so only the fbdev ioctl path goes untested (beyond
+ * failing cleanly on something that isn't a framebuffer).
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/boot_frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RED_565 0xf800
+#define GREEN_565 0x07e0
+#define WHITE_565 0xffff
+
+static char temp_path[64];
+static BootFrame frame;
+
+void setUp(void) {
+	strcpy(temp_path, "/tmp/bootframe_XXXXXX");
+	int fd = mkstemp(temp_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+	memset(&frame, 0, sizeof(frame));
+}
+
+void tearDown(void) {
+	BootFrame_free(&frame);
+	unlink(temp_path);
+}
+
+// 4x2 screen with a padded pitch, like an SDL surface
+static uint16_t screen[2][6] = {
+    {RED_565, GREEN_565, WHITE_565, 0, 0xdead, 0xdead},
+    {0, WHITE_565, GREEN_565, RED_565, 0xdead, 0xdead},
+};
+
+static void captureScreen(void) {
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_capture(&frame, screen, 4, 2, sizeof(screen[0])));
+}
+
+///////////////////////////////
+// Capture
+///////////////////////////////
+
+void test_BootFrame_capture_packs_rows(void) {
+	captureScreen();
+
+	TEST_ASSERT_EQUAL_INT(4, frame.width);
+	TEST_ASSERT_EQUAL_INT(2, frame.height);
+	TEST_ASSERT_EQUAL_HEX16(WHITE_565, frame.pixels[2]);
+	TEST_ASSERT_EQUAL_HEX16(0, frame.pixels[4]); // second row, not padding
+	TEST_ASSERT_EQUAL_HEX16(RED_565, frame.pixels[7]);
+}
+
+void test_BootFrame_capture_reuses_buffer(void) {
+	captureScreen();
+	uint16_t* pixels = frame.pixels;
+	captureScreen();
+
+	TEST_ASSERT_EQUAL_PTR(pixels, frame.pixels);
+}
+
+void test_BootFrame_capture_tracks_changes(void) {
+	captureScreen();
+	TEST_ASSERT_TRUE(frame.changed);
+
+	frame.changed = 0;
+	captureScreen();
+	TEST_ASSERT_FALSE(frame.changed);
+
+	screen[1][3] = GREEN_565;
+	captureScreen();
+	screen[1][3] = RED_565;
+	TEST_ASSERT_TRUE(frame.changed);
+	TEST_ASSERT_EQUAL_HEX16(GREEN_565, frame.pixels[7]);
+}
+
+void test_BootFrame_capture_of_loaded_screen_is_unchanged(void) {
+	captureScreen();
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_save(&frame, temp_path));
+	BootFrame_free(&frame);
+
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_load(&frame, temp_path));
+	TEST_ASSERT_FALSE(frame.changed);
+	captureScreen();
+	TEST_ASSERT_FALSE(frame.changed);
+}
+
+///////////////////////////////
+// Save / load
+///////////////////////////////
+
+void test_BootFrame_save_and_load_roundtrip(void) {
+	captureScreen();
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_save(&frame, temp_path));
+
+	BootFrame loaded;
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_load(&loaded, temp_path));
+	TEST_ASSERT_EQUAL_INT(4, loaded.width);
+	TEST_ASSERT_EQUAL_INT(2, loaded.height);
+	TEST_ASSERT_EQUAL_MEMORY(frame.pixels, loaded.pixels, 4 * 2 * sizeof(uint16_t));
+	BootFrame_free(&loaded);
+}
+
+void test_BootFrame_save_leaves_no_temp_file(void) {
+	captureScreen();
+	BootFrame_save(&frame, temp_path);
+
+	char tmp_path[128];
+	sprintf(tmp_path, "%s.tmp", temp_path);
+	TEST_ASSERT_EQUAL_INT(-1, access(tmp_path, F_OK));
+}
+
+void test_BootFrame_save_without_capture_fails(void) {
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_save(&frame, temp_path));
+}
+
+void test_BootFrame_load_missing_file_fails(void) {
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_load(&frame, "/tmp/bootframe_missing.bin"));
+	TEST_ASSERT_NULL(frame.pixels);
+}
+
+void test_BootFrame_load_rejects_bad_magic(void) {
+	FILE* file = fopen(temp_path, "wb");
+	uint32_t header[3] = {0x12345678, 4, 2};
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(screen, sizeof(screen), 1, file);
+	fclose(file);
+
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_load(&frame, temp_path));
+}
+
+void test_BootFrame_load_rejects_truncated_pixels(void) {
+	FILE* file = fopen(temp_path, "wb");
+	uint32_t header[3] = {BOOT_FRAME_MAGIC, 640, 480};
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(screen, sizeof(screen), 1, file);
+	fclose(file);
+
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_load(&frame, temp_path));
+	TEST_ASSERT_NULL(frame.pixels);
+}
+
+///////////////////////////////
+// Blit
+///////////////////////////////
+
+void test_BootFrame_blit_copies_rgb565(void) {
+	captureScreen();
+	uint16_t fb[2][8] = {{0}};
+	BootFrame_Target target = {fb, 4, 2, sizeof(fb[0]), 16, 11, 5, 0, -1};
+
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_blit(&frame, &target));
+	TEST_ASSERT_EQUAL_HEX16(GREEN_565, fb[0][1]);
+	TEST_ASSERT_EQUAL_HEX16(RED_565, fb[1][3]);
+	TEST_ASSERT_EQUAL_HEX16(0, fb[0][4]); // pitch padding untouched
+}
+
+void test_BootFrame_blit_converts_to_xrgb8888(void) {
+	captureScreen();
+	uint32_t fb[2][4] = {{0}};
+	BootFrame_Target target = {fb, 4, 2, sizeof(fb[0]), 32, 16, 8, 0, -1};
+
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_blit(&frame, &target));
+	TEST_ASSERT_EQUAL_HEX32(0x00ff0000, fb[0][0]);
+	TEST_ASSERT_EQUAL_HEX32(0x0000ff00, fb[0][1]);
+	TEST_ASSERT_EQUAL_HEX32(0x00ffffff, fb[0][2]);
+}
+
+void test_BootFrame_blit_sets_alpha_and_channel_order(void) {
+	captureScreen();
+	uint32_t fb[2][4] = {{0}};
+	BootFrame_Target target = {fb, 4, 2, sizeof(fb[0]), 32, 0, 8, 16, 24}; // ABGR
+
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_blit(&frame, &target));
+	TEST_ASSERT_EQUAL_HEX32(0xff0000ff, fb[0][0]);
+	TEST_ASSERT_EQUAL_HEX32(0xff000000, fb[0][3]);
+}
+
+void test_BootFrame_blit_rejects_mismatch(void) {
+	captureScreen();
+	uint16_t fb[4][4] = {{0}};
+	BootFrame_Target rotated = {fb, 2, 4, 8, 16, 11, 5, 0, -1};
+	BootFrame_Target bgr = {fb, 4, 2, 8, 16, 0, 5, 11, -1};
+	BootFrame_Target depth = {fb, 4, 2, 12, 24, 16, 8, 0, -1};
+
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_blit(&frame, &rotated));
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_blit(&frame, &bgr));
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_blit(&frame, &depth));
+}
+
+void test_BootFrame_show_fails_on_non_framebuffer(void) {
+	captureScreen();
+
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_show(&frame, temp_path));
+	TEST_ASSERT_EQUAL_INT(-1, BootFrame_show(&frame, "/tmp/bootframe_missing_fb"));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_BootFrame_capture_packs_rows);
+	RUN_TEST(test_BootFrame_capture_reuses_buffer);
+	RUN_TEST(test_BootFrame_capture_tracks_changes);
+	RUN_TEST(test_BootFrame_capture_of_loaded_screen_is_unchanged);
+
+	RUN_TEST(test_BootFrame_save_and_load_roundtrip);
+	RUN_TEST(test_BootFrame_save_leaves_no_temp_file);
+	RUN_TEST(test_BootFrame_save_without_capture_fails);
+	RUN_TEST(test_BootFrame_load_missing_file_fails);
+	RUN_TEST(test_BootFrame_load_rejects_bad_magic);
+	RUN_TEST(test_BootFrame_load_rejects_truncated_pixels);
+
+	RUN_TEST(test_BootFrame_blit_copies_rgb565);
+	RUN_TEST(test_BootFrame_blit_converts_to_xrgb8888);
+	RUN_TEST(test_BootFrame_blit_sets_alpha_and_channel_order);
+	RUN_TEST(test_BootFrame_blit_rejects_mismatch);
+	RUN_TEST(test_BootFrame_show_fails_on_non_framebuffer);
+
+	return UNITY_END();
+}
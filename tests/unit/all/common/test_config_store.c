@@ -0,0 +1,186 @@
+/**
+ * test_config_store.c - Tests for the hash-indexed config store
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/config_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ConfigStore* store;
+
+static ConfigStore* parse(const char* text) {
+	return ConfigStore_new(strdup(text));
+}
+
+void setUp(void) {
+	store = NULL;
+}
+
+void tearDown(void) {
+	ConfigStore_free(store);
+}
+
+///////////////////////////////
+// Key index
+///////////////////////////////
+
+void test_KeyIndex_finds_added_keys(void) {
+	KeyIndex index;
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_init(&index, 3));
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_add(&index, "alpha", 0));
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_add(&index, "beta", 1));
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_add(&index, "gamma", 2));
+
+	TEST_ASSERT_EQUAL_INT(1, KeyIndex_find(&index, "beta"));
+	TEST_ASSERT_EQUAL_INT(2, KeyIndex_find(&index, "gamma"));
+	TEST_ASSERT_EQUAL_INT(-1, KeyIndex_find(&index, "delta"));
+	TEST_ASSERT_EQUAL_INT(-1, KeyIndex_find(&index, "bet"));
+	KeyIndex_free(&index);
+}
+
+void test_KeyIndex_keeps_first_duplicate(void) {
+	KeyIndex index;
+	KeyIndex_init(&index, 2);
+	KeyIndex_add(&index, "key", 0);
+
+	TEST_ASSERT_EQUAL_INT(-1, KeyIndex_add(&index, "key", 1));
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_find(&index, "key"));
+	KeyIndex_free(&index);
+}
+
+void test_KeyIndex_handles_many_keys(void) {
+	static char keys[500][32];
+	KeyIndex index;
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_init(&index, 500));
+	for (int i = 0; i < 500; i++) {
+		sprintf(keys[i], "core_option_%i", i);
+		TEST_ASSERT_EQUAL_INT(0, KeyIndex_add(&index, keys[i], i));
+	}
+
+	for (int i = 0; i < 500; i++)
+		TEST_ASSERT_EQUAL_INT(i, KeyIndex_find(&index, keys[i]));
+	KeyIndex_free(&index);
+}
+
+void test_KeyIndex_empty_index_finds_nothing(void) {
+	KeyIndex index = {0};
+	TEST_ASSERT_EQUAL_INT(-1, KeyIndex_find(&index, "key"));
+	TEST_ASSERT_EQUAL_INT(-1, KeyIndex_add(&index, "key", 0));
+}
+
+///////////////////////////////
+// Config store
+///////////////////////////////
+
+void test_ConfigStore_parses_values(void) {
+	store = parse("minarch_screen_scaling = Aspect\n"
+	              "gpsp_bios = builtin\n");
+
+	TEST_ASSERT_EQUAL_INT(2, store->count);
+	TEST_ASSERT_EQUAL_STRING("Aspect", ConfigStore_get(store, "minarch_screen_scaling", NULL));
+	TEST_ASSERT_EQUAL_STRING("builtin", ConfigStore_get(store, "gpsp_bios", NULL));
+	TEST_ASSERT_NULL(ConfigStore_get(store, "gpsp_boot_mode", NULL));
+}
+
+void test_ConfigStore_reports_locked_keys(void) {
+	store = parse("-gpsp_frameskip = disabled\n"
+	              "gpsp_frameskip_interval = 1\n");
+
+	int locked = 0;
+	TEST_ASSERT_EQUAL_STRING("1", ConfigStore_get(store, "gpsp_frameskip_interval", &locked));
+	TEST_ASSERT_EQUAL_INT(0, locked);
+	TEST_ASSERT_EQUAL_STRING("disabled", ConfigStore_get(store, "gpsp_frameskip", &locked));
+	TEST_ASSERT_EQUAL_INT(1, locked);
+}
+
+void test_ConfigStore_matches_whole_keys_only(void) {
+	// a substring search would find "frameskip" inside the longer keys
+	store = parse("gpsp_frameskip = auto\n"
+	              "-core_frameskip_interval = 2\n");
+
+	int locked = 0;
+	TEST_ASSERT_NULL(ConfigStore_get(store, "frameskip", &locked));
+	TEST_ASSERT_NULL(ConfigStore_get(store, "frameskip_interval", &locked));
+	TEST_ASSERT_EQUAL_INT(0, locked);
+}
+
+void test_ConfigStore_keeps_spaces_in_keys_and_values(void) {
+	store = parse("bind Up = UP\n"
+	              "bind A Button = A:B\n"
+	              "minarch_prevent_tearing = Lenient = yes\n");
+
+	TEST_ASSERT_EQUAL_STRING("UP", ConfigStore_get(store, "bind Up", NULL));
+	TEST_ASSERT_EQUAL_STRING("A:B", ConfigStore_get(store, "bind A Button", NULL));
+	TEST_ASSERT_EQUAL_STRING("Lenient = yes", ConfigStore_get(store, "minarch_prevent_tearing", NULL));
+}
+
+void test_ConfigStore_handles_crlf_and_missing_final_newline(void) {
+	store = parse("a = 1\r\nb = 2");
+
+	TEST_ASSERT_EQUAL_STRING("1", ConfigStore_get(store, "a", NULL));
+	TEST_ASSERT_EQUAL_STRING("2", ConfigStore_get(store, "b", NULL));
+}
+
+void test_ConfigStore_skips_malformed_lines(void) {
+	store = parse("\n# comment\nno separator\n = orphan value\nkey=value\nkey = value\n");
+
+	TEST_ASSERT_EQUAL_INT(1, store->count);
+	TEST_ASSERT_EQUAL_STRING("value", ConfigStore_get(store, "key", NULL));
+}
+
+void test_ConfigStore_first_duplicate_wins(void) {
+	store = parse("key = first\n-key = second\n");
+
+	int locked = 0;
+	TEST_ASSERT_EQUAL_STRING("first", ConfigStore_get(store, "key", &locked));
+	TEST_ASSERT_EQUAL_INT(0, locked);
+}
+
+void test_ConfigStore_keeps_file_order(void) {
+	store = parse("bind Up = UP\nother = 1\nbind Down = DOWN\n");
+
+	TEST_ASSERT_EQUAL_INT(3, store->count);
+	TEST_ASSERT_EQUAL_STRING("bind Up", store->entries[0].key);
+	TEST_ASSERT_EQUAL_STRING("bind Down", store->entries[2].key);
+}
+
+void test_ConfigStore_empty_value(void) {
+	store = parse("key = \n");
+
+	TEST_ASSERT_EQUAL_STRING("", ConfigStore_get(store, "key", NULL));
+}
+
+void test_ConfigStore_null_text_and_store(void) {
+	TEST_ASSERT_NULL(ConfigStore_new(NULL));
+	TEST_ASSERT_NULL(ConfigStore_get(NULL, "key", NULL));
+	ConfigStore_free(NULL);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_KeyIndex_finds_added_keys);
+	RUN_TEST(test_KeyIndex_keeps_first_duplicate);
+	RUN_TEST(test_KeyIndex_handles_many_keys);
+	RUN_TEST(test_KeyIndex_empty_index_finds_nothing);
+
+	RUN_TEST(test_ConfigStore_parses_values);
+	RUN_TEST(test_ConfigStore_reports_locked_keys);
+	RUN_TEST(test_ConfigStore_matches_whole_keys_only);
+	RUN_TEST(test_ConfigStore_keeps_spaces_in_keys_and_values);
+	RUN_TEST(test_ConfigStore_handles_crlf_and_missing_final_newline);
+	RUN_TEST(test_ConfigStore_skips_malformed_lines);
+	RUN_TEST(test_ConfigStore_first_duplicate_wins);
+	RUN_TEST(test_ConfigStore_keeps_file_order);
+	RUN_TEST(test_ConfigStore_empty_value);
+	RUN_TEST(test_ConfigStore_null_text_and_store);
+
+	return UNITY_END();
+}
@@ -0,0 +1,269 @@
+/**
+ * test_core_info.c - Tests for the cached core metadata
+ *
+ * Uses real temp files, both for the cache entries and for a stand-in
+ * core binary whose mtime and size key the cache.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/core_info.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static char info_path[64];
+static char so_path[64];
+
+static void writeCore(const char* contents) {
+	FILE* file = fopen(so_path, "w");
+	TEST_ASSERT_NOT_NULL(file);
+	fputs(contents, file);
+	fclose(file);
+}
+
+static void setCoreMtime(time_t mtime) {
+	struct timeval times[2] = {{mtime, 0}, {mtime, 0}};
+	TEST_ASSERT_EQUAL_INT(0, utimes(so_path, times));
+}
+
+static void makeInfo(CoreInfo* info) {
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_init(info, so_path));
+	strcpy(info->library_name, "Gambatte");
+	strcpy(info->library_version, "v0.5.0 abc123");
+	strcpy(info->valid_extensions, "gb|gbc|dmg");
+	info->need_fullpath = 0;
+	info->state_size_class = 131072;
+}
+
+void setUp(void) {
+	strcpy(info_path, "/tmp/coreinfo_XXXXXX");
+	int fd = mkstemp(info_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+
+	strcpy(so_path, "/tmp/coreinfo_so_XXXXXX");
+	fd = mkstemp(so_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+	writeCore("core binary");
+	setCoreMtime(1700000000);
+}
+
+void tearDown(void) {
+	unlink(info_path);
+	unlink(so_path);
+}
+
+///////////////////////////////
+// Identity
+///////////////////////////////
+
+void test_CoreInfo_init_records_identity(void) {
+	CoreInfo info;
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_init(&info, so_path));
+
+	TEST_ASSERT_EQUAL_STRING(so_path, info.so_path);
+	TEST_ASSERT_EQUAL_INT64(1700000000, info.so_mtime);
+	TEST_ASSERT_EQUAL_INT64(11, info.so_size);
+	TEST_ASSERT_EQUAL_STRING("", info.valid_extensions);
+}
+
+void test_CoreInfo_init_fails_for_missing_core(void) {
+	CoreInfo info;
+	TEST_ASSERT_EQUAL_INT(-1, CoreInfo_init(&info, "/tmp/coreinfo_missing_libretro.so"));
+}
+
+void test_CoreInfo_isFresh_detects_core_changes(void) {
+	CoreInfo info;
+	makeInfo(&info);
+	TEST_ASSERT_TRUE(CoreInfo_isFresh(&info));
+
+	setCoreMtime(1700000001);
+	TEST_ASSERT_FALSE(CoreInfo_isFresh(&info));
+
+	writeCore("updated core binary");
+	setCoreMtime(1700000000);
+	TEST_ASSERT_FALSE(CoreInfo_isFresh(&info));
+
+	unlink(so_path);
+	TEST_ASSERT_FALSE(CoreInfo_isFresh(&info));
+}
+
+///////////////////////////////
+// Read / write
+///////////////////////////////
+
+void test_CoreInfo_write_and_read_roundtrip(void) {
+	CoreInfo info;
+	makeInfo(&info);
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_write(&info, info_path));
+
+	CoreInfo loaded;
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_read(&loaded, info_path));
+	TEST_ASSERT_TRUE(CoreInfo_equals(&info, &loaded));
+	TEST_ASSERT_EQUAL_STRING("v0.5.0 abc123", loaded.library_version);
+	TEST_ASSERT_TRUE(CoreInfo_isFresh(&loaded));
+}
+
+void test_CoreInfo_write_leaves_no_temp_file(void) {
+	CoreInfo info;
+	makeInfo(&info);
+	CoreInfo_write(&info, info_path);
+
+	char tmp_path[128];
+	sprintf(tmp_path, "%s.tmp", info_path);
+	TEST_ASSERT_EQUAL_INT(-1, access(tmp_path, F_OK));
+}
+
+void test_CoreInfo_read_ignores_unknown_keys(void) {
+	FILE* file = fopen(info_path, "w");
+	fprintf(file, "so_path=%s\nso_size=11\nfuture_key=1\nnot a pair\nneed_fullpath=1\n", so_path);
+	fclose(file);
+
+	CoreInfo info;
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_read(&info, info_path));
+	TEST_ASSERT_EQUAL_INT(1, info.need_fullpath);
+	TEST_ASSERT_EQUAL_INT64(11, info.so_size);
+}
+
+void test_CoreInfo_read_rejects_missing_identity(void) {
+	FILE* file = fopen(info_path, "w");
+	fprintf(file, "library_name=Gambatte\nvalid_extensions=gb\n");
+	fclose(file);
+
+	CoreInfo info;
+	TEST_ASSERT_EQUAL_INT(-1, CoreInfo_read(&info, info_path));
+	TEST_ASSERT_EQUAL_STRING("", info.valid_extensions);
+	TEST_ASSERT_EQUAL_INT(-1, CoreInfo_read(&info, "/tmp/coreinfo_missing.txt"));
+}
+
+void test_CoreInfo_equals_compares_all_fields(void) {
+	CoreInfo a, b;
+	makeInfo(&a);
+	makeInfo(&b);
+	TEST_ASSERT_TRUE(CoreInfo_equals(&a, &b));
+
+	b.state_size_class = 262144;
+	TEST_ASSERT_FALSE(CoreInfo_equals(&a, &b));
+
+	makeInfo(&b);
+	strcpy(b.valid_extensions, "gb|gbc");
+	TEST_ASSERT_FALSE(CoreInfo_equals(&a, &b));
+}
+
+///////////////////////////////
+// Extensions
+///////////////////////////////
+
+void test_CoreInfo_supportsFile_matches_listed_extensions(void) {
+	CoreInfo info;
+	makeInfo(&info);
+
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "/Roms/GB/Tetris.gb"));
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "Pokemon.GBC"));
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "boot.dmg"));
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "readme.txt"));
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "Tetris.g"));
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "Tetris.gbcx"));
+}
+
+void test_CoreInfo_supportsFile_needs_an_extension(void) {
+	CoreInfo info;
+	makeInfo(&info);
+
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "gb"));
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "Tetris."));
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "/Roms/x.gb/Tetris"));
+}
+
+void test_CoreInfo_supportsFile_accepts_all_without_extensions(void) {
+	CoreInfo info;
+	makeInfo(&info);
+	info.valid_extensions[0] = '\0';
+
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "anything.bin"));
+}
+
+void test_CoreInfo_supportsFile_accepts_all_when_truncated(void) {
+	CoreInfo info;
+	makeInfo(&info);
+
+	// longer than valid_extensions holds, with the only match past the cut
+	char extensions[512] = "";
+	for (int i = 0; i < 100; i++)
+		strcat(extensions, "ab|");
+	strcat(extensions, "zzz");
+	CoreInfo_setExtensions(&info, extensions);
+	TEST_ASSERT_TRUE(info.extensions_truncated);
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "Game.zzz"));
+
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_write(&info, info_path));
+	CoreInfo read;
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_read(&read, info_path));
+	TEST_ASSERT_TRUE(read.extensions_truncated);
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&read, "Game.zzz"));
+
+	CoreInfo_setExtensions(&info, "gb|gbc");
+	TEST_ASSERT_FALSE(info.extensions_truncated);
+	TEST_ASSERT_FALSE(CoreInfo_supportsFile(&info, "Game.zzz"));
+}
+
+void test_CoreInfo_read_flags_lines_longer_than_its_buffer(void) {
+	FILE* file = fopen(info_path, "w");
+	TEST_ASSERT_NOT_NULL(file);
+	fprintf(file, "so_path=%s\nso_size=11\nvalid_extensions=", so_path);
+	for (int i = 0; i < 500; i++)
+		fputs("ab|", file);
+	fputs("zzz\nneed_fullpath=1\n", file);
+	fclose(file);
+
+	CoreInfo info;
+	TEST_ASSERT_EQUAL_INT(0, CoreInfo_read(&info, info_path));
+	TEST_ASSERT_TRUE(info.extensions_truncated);
+	TEST_ASSERT_TRUE(CoreInfo_supportsFile(&info, "Game.zzz"));
+	TEST_ASSERT_EQUAL_INT(1, info.need_fullpath);
+}
+
+///////////////////////////////
+// Size class
+///////////////////////////////
+
+void test_CoreInfo_sizeClass_rounds_up_to_power_of_two(void) {
+	TEST_ASSERT_EQUAL_UINT(0, CoreInfo_sizeClass(0));
+	TEST_ASSERT_EQUAL_UINT(4096, CoreInfo_sizeClass(1));
+	TEST_ASSERT_EQUAL_UINT(4096, CoreInfo_sizeClass(4096));
+	TEST_ASSERT_EQUAL_UINT(131072, CoreInfo_sizeClass(65537));
+	TEST_ASSERT_EQUAL_UINT(131072, CoreInfo_sizeClass(131072));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_CoreInfo_init_records_identity);
+	RUN_TEST(test_CoreInfo_init_fails_for_missing_core);
+	RUN_TEST(test_CoreInfo_isFresh_detects_core_changes);
+
+	RUN_TEST(test_CoreInfo_write_and_read_roundtrip);
+	RUN_TEST(test_CoreInfo_write_leaves_no_temp_file);
+	RUN_TEST(test_CoreInfo_read_ignores_unknown_keys);
+	RUN_TEST(test_CoreInfo_read_rejects_missing_identity);
+	RUN_TEST(test_CoreInfo_equals_compares_all_fields);
+
+	RUN_TEST(test_CoreInfo_supportsFile_matches_listed_extensions);
+	RUN_TEST(test_CoreInfo_supportsFile_needs_an_extension);
+	RUN_TEST(test_CoreInfo_supportsFile_accepts_all_without_extensions);
+	RUN_TEST(test_CoreInfo_supportsFile_accepts_all_when_truncated);
+	RUN_TEST(test_CoreInfo_read_flags_lines_longer_than_its_buffer);
+
+	RUN_TEST(test_CoreInfo_sizeClass_rounds_up_to_power_of_two);
+
+	return UNITY_END();
+}
@@ -0,0 +1,201 @@
+/**
+ * test_cpu_governor.c - Tests for the frame-time-driven CPU governor
+ *
+ * Frame work is fed directly as microseconds against a 60fps budget
+ * (16666us), so every decision can be driven frame by frame.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/cpu_governor.h"
+
+#define FRAME_US 16666
+#define LIGHT_US 4000 // well under the idle threshold
+#define MEDIUM_US 11000 // neither idle nor tight
+#define HEAVY_US 15500 // over the busy threshold
+
+static CpuGovernor governor;
+
+void setUp(void) {
+	CpuGovernor_init(&governor, 60.0, 1);
+}
+
+void tearDown(void) {
+}
+
+static int feed(int frames, uint32_t work_us) {
+	int changes = 0;
+	for (int i = 0; i < frames; i++)
+		changes += CpuGovernor_addSample(&governor, work_us);
+	return changes;
+}
+
+///////////////////////////////
+// Initialization
+///////////////////////////////
+
+void test_CpuGovernor_init_sets_budget_and_level(void) {
+	TEST_ASSERT_EQUAL_UINT32(FRAME_US, governor.frame_us);
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_init_clamps_level(void) {
+	CpuGovernor_init(&governor, 60.0, 7);
+	TEST_ASSERT_EQUAL_INT(CPU_GOVERNOR_LEVELS - 1, CpuGovernor_getLevel(&governor));
+
+	CpuGovernor_init(&governor, 60.0, -1);
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_ignores_samples_without_frame_rate(void) {
+	CpuGovernor_init(&governor, 0, 1);
+
+	TEST_ASSERT_EQUAL_INT(0, feed(CPU_GOVERNOR_WINDOW * 10, HEAVY_US));
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+///////////////////////////////
+// Stepping up
+///////////////////////////////
+
+void test_CpuGovernor_steps_up_on_tight_frames(void) {
+	TEST_ASSERT_EQUAL_INT(0, feed(CPU_GOVERNOR_TIGHT_FRAMES - 1, HEAVY_US));
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_addSample(&governor, HEAVY_US));
+
+	TEST_ASSERT_EQUAL_INT(2, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_stays_at_top_level(void) {
+	CpuGovernor_init(&governor, 60.0, CPU_GOVERNOR_LEVELS - 1);
+
+	TEST_ASSERT_EQUAL_INT(0, feed(CPU_GOVERNOR_WINDOW * 3, HEAVY_US));
+	TEST_ASSERT_EQUAL_INT(CPU_GOVERNOR_LEVELS - 1, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_tight_frames_count_per_window(void) {
+	// one spike per window never adds up to a step
+	for (int i = 0; i < 5; i++) {
+		feed(CPU_GOVERNOR_WINDOW - 1, MEDIUM_US);
+		CpuGovernor_addSample(&governor, HEAVY_US);
+	}
+
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+///////////////////////////////
+// Stepping down
+///////////////////////////////
+
+void test_CpuGovernor_steps_down_after_sustained_idle(void) {
+	feed(CPU_GOVERNOR_WINDOW * (CPU_GOVERNOR_IDLE_WINDOWS - 1), LIGHT_US);
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+
+	TEST_ASSERT_EQUAL_INT(1, feed(CPU_GOVERNOR_WINDOW, LIGHT_US));
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_medium_load_holds_level(void) {
+	TEST_ASSERT_EQUAL_INT(0, feed(CPU_GOVERNOR_WINDOW * 20, MEDIUM_US));
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_busy_window_restarts_idle_count(void) {
+	feed(CPU_GOVERNOR_WINDOW * (CPU_GOVERNOR_IDLE_WINDOWS - 1), LIGHT_US);
+	feed(CPU_GOVERNOR_WINDOW, MEDIUM_US);
+	feed(CPU_GOVERNOR_WINDOW * (CPU_GOVERNOR_IDLE_WINDOWS - 1), LIGHT_US);
+
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_reverted_step_down_backs_off(void) {
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_IDLE_WINDOWS, LIGHT_US);
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLevel(&governor));
+
+	feed(CPU_GOVERNOR_TIGHT_FRAMES, HEAVY_US); // lower level couldn't cope
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+	TEST_ASSERT_EQUAL_INT(CPU_GOVERNOR_IDLE_WINDOWS * 2, governor.idle_required);
+
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_IDLE_WINDOWS, LIGHT_US);
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_IDLE_WINDOWS, LIGHT_US);
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLevel(&governor));
+}
+
+void test_CpuGovernor_late_step_up_keeps_idle_requirement(void) {
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_IDLE_WINDOWS, LIGHT_US);
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_REVERT_WINDOWS, MEDIUM_US);
+	feed(CPU_GOVERNOR_TIGHT_FRAMES, HEAVY_US); // a new heavy scene, not a revert
+
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+	TEST_ASSERT_EQUAL_INT(CPU_GOVERNOR_IDLE_WINDOWS, governor.idle_required);
+}
+
+void test_CpuGovernor_reset_discards_partial_window(void) {
+	feed(CPU_GOVERNOR_TIGHT_FRAMES - 1, HEAVY_US);
+	CpuGovernor_reset(&governor);
+	CpuGovernor_addSample(&governor, HEAVY_US);
+
+	TEST_ASSERT_EQUAL_INT(1, CpuGovernor_getLevel(&governor));
+}
+
+///////////////////////////////
+// Learning
+///////////////////////////////
+
+void test_CpuGovernor_learned_level_defaults_to_current(void) {
+	CpuGovernor_init(&governor, 60.0, 2);
+	TEST_ASSERT_EQUAL_INT(2, CpuGovernor_getLearnedLevel(&governor));
+}
+
+void test_CpuGovernor_learns_most_used_level(void) {
+	feed(CPU_GOVERNOR_WINDOW * CPU_GOVERNOR_IDLE_WINDOWS, LIGHT_US);
+	feed(CPU_GOVERNOR_WINDOW * 20, MEDIUM_US); // settles at powersave
+
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLevel(&governor));
+	TEST_ASSERT_EQUAL_INT(0, CpuGovernor_getLearnedLevel(&governor));
+}
+
+void test_CpuGovernor_learned_level_prefers_higher_on_tie(void) {
+	governor.level_frames[0] = 100;
+	governor.level_frames[2] = 100;
+
+	TEST_ASSERT_EQUAL_INT(2, CpuGovernor_getLearnedLevel(&governor));
+}
+
+void test_CpuGovernor_setFrameRate_keeps_level_and_history(void) {
+	feed(CPU_GOVERNOR_TIGHT_FRAMES, HEAVY_US);
+	CpuGovernor_setFrameRate(&governor, 50.0);
+
+	TEST_ASSERT_EQUAL_UINT32(20000, governor.frame_us);
+	TEST_ASSERT_EQUAL_INT(2, CpuGovernor_getLevel(&governor));
+	TEST_ASSERT_EQUAL_UINT32(CPU_GOVERNOR_TIGHT_FRAMES, governor.level_frames[1]);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_CpuGovernor_init_sets_budget_and_level);
+	RUN_TEST(test_CpuGovernor_init_clamps_level);
+	RUN_TEST(test_CpuGovernor_ignores_samples_without_frame_rate);
+
+	RUN_TEST(test_CpuGovernor_steps_up_on_tight_frames);
+	RUN_TEST(test_CpuGovernor_stays_at_top_level);
+	RUN_TEST(test_CpuGovernor_tight_frames_count_per_window);
+
+	RUN_TEST(test_CpuGovernor_steps_down_after_sustained_idle);
+	RUN_TEST(test_CpuGovernor_medium_load_holds_level);
+	RUN_TEST(test_CpuGovernor_busy_window_restarts_idle_count);
+	RUN_TEST(test_CpuGovernor_reverted_step_down_backs_off);
+	RUN_TEST(test_CpuGovernor_late_step_up_keeps_idle_requirement);
+	RUN_TEST(test_CpuGovernor_reset_discards_partial_window);
+
+	RUN_TEST(test_CpuGovernor_learned_level_defaults_to_current);
+	RUN_TEST(test_CpuGovernor_learns_most_used_level);
+	RUN_TEST(test_CpuGovernor_learned_level_prefers_higher_on_tie);
+	RUN_TEST(test_CpuGovernor_setFrameRate_keeps_level_and_history);
+
+	return UNITY_END();
+}
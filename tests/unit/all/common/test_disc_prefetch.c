@@ -0,0 +1,213 @@
+/**
+ * test_disc_prefetch.c - Tests for next-disc page cache warming
+ *
+ * Builds a real multi-disc game (m3u, cue sheets, track files) in a temp
+ * directory.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/disc_prefetch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char dir[64];
+static char m3u_path[128];
+static char disc_paths[3][128];
+
+static void writeFile(const char* name, const char* contents) {
+	char path[128];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE* file = fopen(path, "w");
+	TEST_ASSERT_NOT_NULL(file);
+	fputs(contents, file);
+	fclose(file);
+}
+
+static void writeSizedFile(const char* name, size_t size) {
+	char path[128];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE* file = fopen(path, "w");
+	TEST_ASSERT_NOT_NULL(file);
+	TEST_ASSERT_EQUAL_INT(0, ftruncate(fileno(file), (off_t)size));
+	fclose(file);
+}
+
+void setUp(void) {
+	strcpy(dir, "/tmp/discs_XXXXXX");
+	TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+
+	writeFile("Game.m3u", "Game (Disc 1).cue\nGame (Disc 2).cue\n\nGame (Disc 3).chd\n");
+	writeFile("Game (Disc 1).cue", "FILE \"Game (Disc 1).bin\" BINARY\n  TRACK 01 MODE2/2352\n");
+	writeFile("Game (Disc 2).cue", "FILE \"Game (Disc 2) (Track 1).bin\" BINARY\n"
+	                               "  TRACK 01 MODE2/2352\n"
+	                               "    INDEX 01 00:00:00\n"
+	                               "file track2.bin binary\r\n"
+	                               "  TRACK 02 AUDIO\n");
+	writeSizedFile("Game (Disc 1).bin", 1000);
+	writeSizedFile("Game (Disc 2) (Track 1).bin", 3 * DISC_PREFETCH_CHUNK + 100);
+	writeSizedFile("track2.bin", 5000);
+	writeSizedFile("Game (Disc 3).chd", 2000);
+
+	snprintf(m3u_path, sizeof(m3u_path), "%s/Game.m3u", dir);
+	snprintf(disc_paths[0], sizeof(disc_paths[0]), "%s/Game (Disc 1).cue", dir);
+	snprintf(disc_paths[1], sizeof(disc_paths[1]), "%s/Game (Disc 2).cue", dir);
+	snprintf(disc_paths[2], sizeof(disc_paths[2]), "%s/Game (Disc 3).chd", dir);
+}
+
+void tearDown(void) {
+	char command[128];
+	snprintf(command, sizeof(command), "rm -rf '%s'", dir);
+	system(command);
+}
+
+///////////////////////////////
+// Next disc
+///////////////////////////////
+
+void test_getNextDisc_follows_playlist_order(void) {
+	int count = 0;
+	M3U_Disc** discs = M3U_getAllDiscs(m3u_path, &count);
+	TEST_ASSERT_EQUAL_INT(3, count);
+
+	TEST_ASSERT_EQUAL_INT(1, DiscPrefetch_getNextDisc(discs, count, disc_paths[0]));
+	TEST_ASSERT_EQUAL_INT(2, DiscPrefetch_getNextDisc(discs, count, disc_paths[1]));
+	M3U_freeDiscs(discs, count);
+}
+
+void test_getNextDisc_none_after_last_or_unknown(void) {
+	int count = 0;
+	M3U_Disc** discs = M3U_getAllDiscs(m3u_path, &count);
+
+	TEST_ASSERT_EQUAL_INT(-1, DiscPrefetch_getNextDisc(discs, count, disc_paths[2]));
+	TEST_ASSERT_EQUAL_INT(-1, DiscPrefetch_getNextDisc(discs, count, "/tmp/other.cue"));
+	TEST_ASSERT_EQUAL_INT(-1, DiscPrefetch_getNextDisc(NULL, 0, disc_paths[0]));
+	M3U_freeDiscs(discs, count);
+}
+
+///////////////////////////////
+// Disc files
+///////////////////////////////
+
+void test_listFiles_cue_lists_its_tracks(void) {
+	char files[DISC_PREFETCH_MAX_FILES][512];
+	TEST_ASSERT_EQUAL_INT(3, DiscPrefetch_listFiles(disc_paths[1], files, DISC_PREFETCH_MAX_FILES));
+
+	char expected[128];
+	TEST_ASSERT_EQUAL_STRING(disc_paths[1], files[0]);
+	snprintf(expected, sizeof(expected), "%s/Game (Disc 2) (Track 1).bin", dir);
+	TEST_ASSERT_EQUAL_STRING(expected, files[1]);
+	snprintf(expected, sizeof(expected), "%s/track2.bin", dir);
+	TEST_ASSERT_EQUAL_STRING(expected, files[2]);
+}
+
+void test_listFiles_other_images_are_single_files(void) {
+	char files[DISC_PREFETCH_MAX_FILES][512];
+	TEST_ASSERT_EQUAL_INT(1, DiscPrefetch_listFiles(disc_paths[2], files, DISC_PREFETCH_MAX_FILES));
+	TEST_ASSERT_EQUAL_STRING(disc_paths[2], files[0]);
+}
+
+void test_listFiles_respects_capacity(void) {
+	char files[2][512];
+	TEST_ASSERT_EQUAL_INT(2, DiscPrefetch_listFiles(disc_paths[1], files, 2));
+	TEST_ASSERT_EQUAL_INT(0, DiscPrefetch_listFiles(disc_paths[1], files, 0));
+}
+
+void test_listFiles_absolute_track_path(void) {
+	writeFile("Abs.cue", "FILE \"/mnt/SDCARD/Roms/abs.bin\" BINARY\n");
+	char cue_path[128];
+	snprintf(cue_path, sizeof(cue_path), "%s/Abs.cue", dir);
+
+	char files[DISC_PREFETCH_MAX_FILES][512];
+	TEST_ASSERT_EQUAL_INT(2, DiscPrefetch_listFiles(cue_path, files, DISC_PREFETCH_MAX_FILES));
+	TEST_ASSERT_EQUAL_STRING("/mnt/SDCARD/Roms/abs.bin", files[1]);
+}
+
+///////////////////////////////
+// Warming
+///////////////////////////////
+
+void test_warmFile_reads_up_to_limit(void) {
+	char path[128];
+	snprintf(path, sizeof(path), "%s/Game (Disc 2) (Track 1).bin", dir);
+
+	TEST_ASSERT_EQUAL_INT(3 * DISC_PREFETCH_CHUNK + 100, DiscPrefetch_warmFile(path, SIZE_MAX, NULL));
+	TEST_ASSERT_EQUAL_INT(DISC_PREFETCH_CHUNK + 5, DiscPrefetch_warmFile(path, DISC_PREFETCH_CHUNK + 5, NULL));
+}
+
+void test_warmFile_missing_file(void) {
+	TEST_ASSERT_EQUAL_INT(0, DiscPrefetch_warmFile("/tmp/discs_missing.bin", 100, NULL));
+}
+
+void test_warmFile_cancelled(void) {
+	int cancel = 1;
+	TEST_ASSERT_EQUAL_INT(0, DiscPrefetch_warmFile(disc_paths[2], 100, &cancel));
+}
+
+void test_start_warms_next_disc_files(void) {
+	size_t cue_size = strlen("FILE \"Game (Disc 2) (Track 1).bin\" BINARY\n"
+	                         "  TRACK 01 MODE2/2352\n"
+	                         "    INDEX 01 00:00:00\n"
+	                         "file track2.bin binary\r\n"
+	                         "  TRACK 02 AUDIO\n");
+	size_t total = cue_size + 3 * DISC_PREFETCH_CHUNK + 100 + 5000;
+
+	DiscPrefetch prefetch = {0};
+	TEST_ASSERT_EQUAL_INT(0, DiscPrefetch_start(&prefetch, m3u_path, disc_paths[0], SIZE_MAX));
+	for (int i = 0; i < 2000 && __atomic_load_n(&prefetch.warmed, __ATOMIC_ACQUIRE) < total; i++)
+		usleep(1000);
+	DiscPrefetch_stop(&prefetch);
+
+	TEST_ASSERT_EQUAL_INT(total, prefetch.warmed);
+	TEST_ASSERT_EQUAL_INT(0, prefetch.running);
+}
+
+void test_start_respects_limit(void) {
+	DiscPrefetch prefetch = {0};
+	DiscPrefetch_start(&prefetch, m3u_path, disc_paths[0], 4096);
+	usleep(50000);
+	DiscPrefetch_stop(&prefetch);
+	TEST_ASSERT_TRUE(prefetch.warmed <= 4096);
+}
+
+void test_start_on_last_disc_warms_nothing(void) {
+	DiscPrefetch prefetch = {0};
+	TEST_ASSERT_EQUAL_INT(0, DiscPrefetch_start(&prefetch, m3u_path, disc_paths[2], SIZE_MAX));
+	usleep(50000);
+	DiscPrefetch_stop(&prefetch);
+	TEST_ASSERT_EQUAL_INT(0, prefetch.warmed);
+}
+
+void test_stop_without_start(void) {
+	DiscPrefetch prefetch = {0};
+	DiscPrefetch_stop(&prefetch);
+	TEST_ASSERT_EQUAL_INT(0, prefetch.running);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_getNextDisc_follows_playlist_order);
+	RUN_TEST(test_getNextDisc_none_after_last_or_unknown);
+
+	RUN_TEST(test_listFiles_cue_lists_its_tracks);
+	RUN_TEST(test_listFiles_other_images_are_single_files);
+	RUN_TEST(test_listFiles_respects_capacity);
+	RUN_TEST(test_listFiles_absolute_track_path);
+
+	RUN_TEST(test_warmFile_reads_up_to_limit);
+	RUN_TEST(test_warmFile_missing_file);
+	RUN_TEST(test_warmFile_cancelled);
+	RUN_TEST(test_start_warms_next_disc_files);
+	RUN_TEST(test_start_respects_limit);
+	RUN_TEST(test_start_on_last_disc_warms_nothing);
+	RUN_TEST(test_stop_without_start);
+
+	return UNITY_END();
+}
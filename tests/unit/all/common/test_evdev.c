@@ -0,0 +1,311 @@
+/**
+ * test_evdev.c - Tests for the shared evdev input backend
+ *
+ * Uses FIFOs in a temp directory as stand-in device nodes. FIFOs support
+ * non-blocking reads, epoll and inotify just like /dev/input/eventN, so
+ * batching, dispatch and hotplug can be tested without real hardware.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/evdev.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char temp_dir[64];
+static char device_path[128];
+
+typedef struct {
+	int count;
+	int last_device;
+	int last_type;
+	int last_code;
+	int last_value;
+} Received;
+
+static Received received;
+
+static int hotplug_connects;
+static int hotplug_disconnects;
+
+static void onEvent(int device, const EVDEV_Event* event, void* userdata) {
+	Received* r = userdata;
+	r->count += 1;
+	r->last_device = device;
+	r->last_type = event->type;
+	r->last_code = event->code;
+	r->last_value = event->value;
+}
+
+static void onHotplug(int device, int connected, void* userdata) {
+	if (connected)
+		hotplug_connects += 1;
+	else
+		hotplug_disconnects += 1;
+}
+
+static void writeEvents(int fd, int type, int code, int value, int count) {
+	EVDEV_Event event = {0};
+	event.type = (uint16_t)type;
+	event.code = (uint16_t)code;
+	event.value = value;
+	for (int i = 0; i < count; i++)
+		TEST_ASSERT_EQUAL_INT(sizeof(event), write(fd, &event, sizeof(event)));
+}
+
+void setUp(void) {
+	strcpy(temp_dir, "/tmp/evdevtest_XXXXXX");
+	TEST_ASSERT_NOT_NULL(mkdtemp(temp_dir));
+	sprintf(device_path, "%s/event3", temp_dir);
+	memset(&received, 0, sizeof(received));
+	hotplug_connects = 0;
+	hotplug_disconnects = 0;
+	TEST_ASSERT_EQUAL_INT(0, EVDEV_init());
+}
+
+void tearDown(void) {
+	EVDEV_quit();
+	unlink(device_path);
+	rmdir(temp_dir);
+}
+
+///////////////////////////////
+// Device registration
+///////////////////////////////
+
+void test_EVDEV_addDevice_opens_existing_device(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+
+	int device = EVDEV_addDevice(device_path, 0);
+
+	TEST_ASSERT_EQUAL_INT(0, device);
+	TEST_ASSERT_TRUE(EVDEV_isConnected(device));
+	TEST_ASSERT_EQUAL_STRING(device_path, EVDEV_getPath(device));
+}
+
+void test_EVDEV_addDevice_missing_device_is_not_connected(void) {
+	int device = EVDEV_addDevice(device_path, 0);
+
+	TEST_ASSERT_EQUAL_INT(0, device);
+	TEST_ASSERT_FALSE(EVDEV_isConnected(device));
+}
+
+void test_EVDEV_addDevice_fails_when_slots_exhausted(void) {
+	for (int i = 0; i < EVDEV_MAX_DEVICES; i++)
+		TEST_ASSERT_EQUAL_INT(i, EVDEV_addDevice(device_path, 0));
+
+	TEST_ASSERT_EQUAL_INT(-1, EVDEV_addDevice(device_path, 0));
+}
+
+void test_EVDEV_isConnected_rejects_invalid_index(void) {
+	TEST_ASSERT_FALSE(EVDEV_isConnected(-1));
+	TEST_ASSERT_FALSE(EVDEV_isConnected(EVDEV_MAX_DEVICES));
+	TEST_ASSERT_NULL(EVDEV_getPath(EVDEV_MAX_DEVICES));
+}
+
+///////////////////////////////
+// Event dispatch
+///////////////////////////////
+
+void test_EVDEV_poll_returns_zero_when_idle(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	TEST_ASSERT_EQUAL_INT(0, EVDEV_poll(onEvent, &received));
+	TEST_ASSERT_EQUAL_INT(0, received.count);
+
+	close(writer);
+}
+
+void test_EVDEV_poll_dispatches_key_event(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	int device = EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	writeEvents(writer, EVDEV_EV_KEY, 304, 1, 1);
+
+	TEST_ASSERT_EQUAL_INT(1, EVDEV_poll(onEvent, &received));
+	TEST_ASSERT_EQUAL_INT(device, received.last_device);
+	TEST_ASSERT_EQUAL_INT(EVDEV_EV_KEY, received.last_type);
+	TEST_ASSERT_EQUAL_INT(304, received.last_code);
+	TEST_ASSERT_EQUAL_INT(1, received.last_value);
+
+	close(writer);
+}
+
+void test_EVDEV_poll_skips_sync_events(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	writeEvents(writer, EVDEV_EV_KEY, 304, 1, 1);
+	writeEvents(writer, EVDEV_EV_SYN, 0, 0, 1);
+	writeEvents(writer, EVDEV_EV_ABS, EVDEV_ABS_HAT0Y, -1, 1);
+	writeEvents(writer, EVDEV_EV_SYN, 0, 0, 1);
+
+	TEST_ASSERT_EQUAL_INT(2, EVDEV_poll(onEvent, &received));
+	TEST_ASSERT_EQUAL_INT(EVDEV_EV_ABS, received.last_type);
+	TEST_ASSERT_EQUAL_INT(-1, received.last_value);
+
+	close(writer);
+}
+
+void test_EVDEV_poll_dispatches_switches_only_when_enabled(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	writeEvents(writer, EVDEV_EV_SW, 2, 1, 1);
+	TEST_ASSERT_EQUAL_INT(0, EVDEV_poll(onEvent, &received));
+
+	EVDEV_setEventTypes(EVDEV_TYPES_DEFAULT | EVDEV_TYPE(EVDEV_EV_SW));
+	writeEvents(writer, EVDEV_EV_SW, 2, 1, 1);
+	TEST_ASSERT_EQUAL_INT(1, EVDEV_poll(onEvent, &received));
+	TEST_ASSERT_EQUAL_INT(EVDEV_EV_SW, received.last_type);
+
+	close(writer);
+}
+
+void test_EVDEV_poll_drains_more_than_one_batch(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	int total = EVDEV_BATCH_SIZE * 2 + 5;
+	writeEvents(writer, EVDEV_EV_KEY, 305, 0, total);
+
+	TEST_ASSERT_EQUAL_INT(total, EVDEV_poll(onEvent, &received));
+	TEST_ASSERT_EQUAL_INT(0, EVDEV_poll(onEvent, &received));
+
+	close(writer);
+}
+
+void test_EVDEV_wait_times_out_without_input(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_addDevice(device_path, 0);
+	int writer = open(device_path, O_WRONLY | O_NONBLOCK);
+
+	TEST_ASSERT_EQUAL_INT(0, EVDEV_wait(onEvent, &received, 10));
+
+	close(writer);
+}
+
+///////////////////////////////
+// Hotplug
+///////////////////////////////
+
+void test_EVDEV_hotplug_connects_when_node_created(void) {
+	EVDEV_setHotplugCallback(onHotplug, NULL);
+	int device = EVDEV_addDevice(device_path, 1);
+	TEST_ASSERT_FALSE(EVDEV_isConnected(device));
+
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_poll(onEvent, &received);
+
+	TEST_ASSERT_TRUE(EVDEV_isConnected(device));
+	TEST_ASSERT_EQUAL_INT(1, hotplug_connects);
+}
+
+void test_EVDEV_hotplug_disconnects_when_node_removed(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_setHotplugCallback(onHotplug, NULL);
+	int device = EVDEV_addDevice(device_path, 1);
+	TEST_ASSERT_TRUE(EVDEV_isConnected(device));
+	TEST_ASSERT_EQUAL_INT(1, hotplug_connects);
+
+	unlink(device_path);
+	EVDEV_poll(onEvent, &received);
+
+	TEST_ASSERT_FALSE(EVDEV_isConnected(device));
+	TEST_ASSERT_EQUAL_INT(1, hotplug_disconnects);
+}
+
+void test_EVDEV_hotplug_ignores_other_nodes(void) {
+	EVDEV_setHotplugCallback(onHotplug, NULL);
+	int device = EVDEV_addDevice(device_path, 1);
+
+	char other_path[160];
+	sprintf(other_path, "%s/event4", temp_dir);
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(other_path, 0600));
+	EVDEV_poll(onEvent, &received);
+
+	TEST_ASSERT_FALSE(EVDEV_isConnected(device));
+	TEST_ASSERT_EQUAL_INT(0, hotplug_connects);
+
+	unlink(other_path);
+}
+
+void test_EVDEV_fixed_device_does_not_reconnect(void) {
+	int device = EVDEV_addDevice(device_path, 0);
+
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	EVDEV_poll(onEvent, &received);
+
+	TEST_ASSERT_FALSE(EVDEV_isConnected(device));
+}
+
+///////////////////////////////
+// Helpers
+///////////////////////////////
+
+void test_EVDEV_mapCode_finds_mapped_code(void) {
+	static const EVDEV_Mapping map[] = {{304, 4}, {305, 5}, EVDEV_MAPPING_END};
+
+	TEST_ASSERT_EQUAL_INT(5, EVDEV_mapCode(map, 305));
+	TEST_ASSERT_EQUAL_INT(-1, EVDEV_mapCode(map, 306));
+}
+
+void test_EVDEV_mapCode_first_match_wins(void) {
+	static const EVDEV_Mapping map[] = {{115, 16}, {115, 17}, EVDEV_MAPPING_END};
+
+	TEST_ASSERT_EQUAL_INT(16, EVDEV_mapCode(map, 115));
+}
+
+void test_EVDEV_mapCode_handles_null_map(void) {
+	TEST_ASSERT_EQUAL_INT(-1, EVDEV_mapCode(NULL, 304));
+}
+
+void test_EVDEV_eventTime_converts_to_microseconds(void) {
+	EVDEV_Event event = {0};
+	event.sec = 12;
+	event.usec = 345678;
+
+	TEST_ASSERT_EQUAL_UINT64(12345678ULL, EVDEV_eventTime(&event));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_EVDEV_addDevice_opens_existing_device);
+	RUN_TEST(test_EVDEV_addDevice_missing_device_is_not_connected);
+	RUN_TEST(test_EVDEV_addDevice_fails_when_slots_exhausted);
+	RUN_TEST(test_EVDEV_isConnected_rejects_invalid_index);
+
+	RUN_TEST(test_EVDEV_poll_returns_zero_when_idle);
+	RUN_TEST(test_EVDEV_poll_dispatches_key_event);
+	RUN_TEST(test_EVDEV_poll_skips_sync_events);
+	RUN_TEST(test_EVDEV_poll_dispatches_switches_only_when_enabled);
+	RUN_TEST(test_EVDEV_poll_drains_more_than_one_batch);
+	RUN_TEST(test_EVDEV_wait_times_out_without_input);
+
+	RUN_TEST(test_EVDEV_hotplug_connects_when_node_created);
+	RUN_TEST(test_EVDEV_hotplug_disconnects_when_node_removed);
+	RUN_TEST(test_EVDEV_hotplug_ignores_other_nodes);
+	RUN_TEST(test_EVDEV_fixed_device_does_not_reconnect);
+
+	RUN_TEST(test_EVDEV_mapCode_finds_mapped_code);
+	RUN_TEST(test_EVDEV_mapCode_first_match_wins);
+	RUN_TEST(test_EVDEV_mapCode_handles_null_map);
+	RUN_TEST(test_EVDEV_eventTime_converts_to_microseconds);
+
+	return UNITY_END();
+}
@@ -0,0 +1,103 @@
+/**
+ * test_frame_delay.c - Tests for automatic frame delay scheduling
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/frame_delay.h"
+
+static FrameDelay delay;
+
+void setUp(void) {
+	FrameDelay_init(&delay, 50.0); // 20000us frames keep the math readable
+}
+
+void tearDown(void) {}
+
+///////////////////////////////
+// Initialization
+///////////////////////////////
+
+void test_FrameDelay_init_computes_frame_time(void) {
+	TEST_ASSERT_EQUAL_UINT32(20000, delay.frame_us);
+
+	FrameDelay_init(&delay, 60.0);
+	TEST_ASSERT_EQUAL_UINT32(16666, delay.frame_us);
+}
+
+void test_FrameDelay_no_delay_without_samples(void) {
+	TEST_ASSERT_EQUAL_UINT32(0, FrameDelay_getDelay(&delay));
+}
+
+void test_FrameDelay_invalid_fps_never_delays(void) {
+	FrameDelay_init(&delay, 0);
+	FrameDelay_addSample(&delay, 1000);
+
+	TEST_ASSERT_EQUAL_UINT32(0, FrameDelay_getDelay(&delay));
+}
+
+///////////////////////////////
+// Estimation
+///////////////////////////////
+
+void test_FrameDelay_delay_leaves_margin(void) {
+	FrameDelay_addSample(&delay, 5000);
+
+	TEST_ASSERT_EQUAL_UINT32(20000 - 5000 - FRAME_DELAY_MARGIN_US, FrameDelay_getDelay(&delay));
+}
+
+void test_FrameDelay_slow_frame_raises_estimate_immediately(void) {
+	FrameDelay_addSample(&delay, 5000);
+	FrameDelay_addSample(&delay, 12000);
+
+	TEST_ASSERT_EQUAL_UINT32(12000, delay.work_us);
+}
+
+void test_FrameDelay_fast_frame_decays_slowly(void) {
+	FrameDelay_addSample(&delay, 12800);
+	FrameDelay_addSample(&delay, 1000);
+
+	TEST_ASSERT_EQUAL_UINT32(12800 - 12800 / FRAME_DELAY_DECAY, delay.work_us);
+}
+
+void test_FrameDelay_decay_converges_to_sample(void) {
+	FrameDelay_addSample(&delay, 12000);
+	for (int i = 0; i < 1000; i++)
+		FrameDelay_addSample(&delay, 4000);
+
+	TEST_ASSERT_EQUAL_UINT32(4000, delay.work_us);
+}
+
+void test_FrameDelay_no_delay_when_work_fills_frame(void) {
+	FrameDelay_addSample(&delay, 19000);
+
+	TEST_ASSERT_EQUAL_UINT32(0, FrameDelay_getDelay(&delay));
+}
+
+void test_FrameDelay_reset_clears_estimate(void) {
+	FrameDelay_addSample(&delay, 5000);
+	FrameDelay_reset(&delay);
+
+	TEST_ASSERT_EQUAL_UINT32(0, FrameDelay_getDelay(&delay));
+	TEST_ASSERT_EQUAL_UINT32(20000, delay.frame_us);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_FrameDelay_init_computes_frame_time);
+	RUN_TEST(test_FrameDelay_no_delay_without_samples);
+	RUN_TEST(test_FrameDelay_invalid_fps_never_delays);
+
+	RUN_TEST(test_FrameDelay_delay_leaves_margin);
+	RUN_TEST(test_FrameDelay_slow_frame_raises_estimate_immediately);
+	RUN_TEST(test_FrameDelay_fast_frame_decays_slowly);
+	RUN_TEST(test_FrameDelay_decay_converges_to_sample);
+	RUN_TEST(test_FrameDelay_no_delay_when_work_fills_frame);
+	RUN_TEST(test_FrameDelay_reset_clears_estimate);
+
+	return UNITY_END();
+}
@@ -0,0 +1,356 @@
+/**
+ * test_image_cache.c - Tests for the background image cache
+ *
+ * Uses real temp files, "decoded" by reading their contents on the
+ * running worker thread. Loads can be held to test what happens while
+ * the worker is busy.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/image_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FILES (IMAGE_CACHE_SIZE + IMAGE_QUEUE_SIZE)
+
+static ImageCache cache;
+static char paths[FILES][64];
+
+static pthread_mutex_t hold_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hold_cond = PTHREAD_COND_INITIALIZER;
+static int holding;
+static int frees;
+
+static void* loadText(const char* path, void* userdata) {
+	pthread_mutex_lock(&hold_mutex);
+	while (holding)
+		pthread_cond_wait(&hold_cond, &hold_mutex);
+	pthread_mutex_unlock(&hold_mutex);
+
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return NULL;
+	char* text = calloc(1, 64);
+	if (!fgets(text, 64, file)) {
+		free(text);
+		text = NULL;
+	}
+	fclose(file);
+	if (text && userdata)
+		strcat(text, userdata);
+	return text;
+}
+
+static int saveText(void* image, const char* path, void* userdata) {
+	(void)userdata;
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return -1;
+	fputs(image, file);
+	fclose(file);
+	return 0;
+}
+
+static void freeText(void* image) {
+	frees += 1;
+	free(image);
+}
+
+static void hold(int value) {
+	pthread_mutex_lock(&hold_mutex);
+	holding = value;
+	pthread_cond_broadcast(&hold_cond);
+	pthread_mutex_unlock(&hold_mutex);
+}
+
+static void writeImage(int index, const char* text) {
+	FILE* file = fopen(paths[index], "w");
+	TEST_ASSERT_NOT_NULL(file);
+	fputs(text, file);
+	fclose(file);
+}
+
+/**
+ * Requests an image until it's loaded or known missing.
+ */
+static int waitFor(int index, void** image) {
+	int state;
+	while ((state = ImageCache_request(&cache, paths[index], image)) == IMAGE_LOADING ||
+	       state == IMAGE_NONE)
+		ImageCache_flush(&cache);
+	return state;
+}
+
+void setUp(void) {
+	for (int i = 0; i < FILES; i++) {
+		sprintf(paths[i], "/tmp/image_XXXXXX");
+		int fd = mkstemp(paths[i]);
+		TEST_ASSERT_TRUE(fd >= 0);
+		close(fd);
+		unlink(paths[i]);
+	}
+	holding = 0;
+	frees = 0;
+	TEST_ASSERT_EQUAL_INT(0, ImageCache_start(&cache, IMAGE_CACHE_SIZE, loadText, saveText, freeText, NULL));
+}
+
+void tearDown(void) {
+	hold(0);
+	ImageCache_stop(&cache);
+	for (int i = 0; i < FILES; i++)
+		unlink(paths[i]);
+}
+
+///////////////////////////////
+// Loading
+///////////////////////////////
+
+void test_request_loads_in_background(void) {
+	writeImage(0, "zero");
+	hold(1);
+
+	void* image = NULL;
+	TEST_ASSERT_EQUAL_INT(IMAGE_LOADING, ImageCache_request(&cache, paths[0], &image));
+	TEST_ASSERT_NULL(image);
+	TEST_ASSERT_EQUAL_INT(IMAGE_LOADING, ImageCache_request(&cache, paths[0], &image));
+
+	hold(0);
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(0, &image));
+	TEST_ASSERT_EQUAL_STRING("zero", image);
+}
+
+void test_userdata_reaches_the_loader(void) {
+	ImageCache_stop(&cache);
+	TEST_ASSERT_EQUAL_INT(0, ImageCache_start(&cache, IMAGE_CACHE_SIZE, loadText, saveText, freeText, "@2x"));
+	writeImage(0, "zero");
+
+	void* image = NULL;
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(0, &image));
+	TEST_ASSERT_EQUAL_STRING("zero@2x", image);
+}
+
+void test_ready_image_is_not_loaded_again(void) {
+	writeImage(0, "zero");
+	waitFor(0, NULL);
+
+	void* image = NULL;
+	for (int i = 0; i < 10; i++)
+		TEST_ASSERT_EQUAL_INT(IMAGE_READY, ImageCache_request(&cache, paths[0], &image));
+	TEST_ASSERT_EQUAL_STRING("zero", image);
+	TEST_ASSERT_EQUAL_INT(1, cache.loads);
+}
+
+void test_missing_image_is_remembered(void) {
+	void* image = (void*)1;
+	TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, waitFor(0, &image));
+	TEST_ASSERT_NULL(image);
+
+	// created afterwards, still known missing until retried
+	writeImage(0, "late");
+	for (int i = 0; i < 10; i++)
+		TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, ImageCache_request(&cache, paths[0], NULL));
+	TEST_ASSERT_EQUAL_INT(1, cache.loads);
+}
+
+void test_retry_loads_missing_image_again(void) {
+	TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, waitFor(0, NULL));
+	writeImage(0, "late");
+
+	ImageCache_retry(&cache, paths[0]);
+	void* image = NULL;
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(0, &image));
+	TEST_ASSERT_EQUAL_STRING("late", image);
+	TEST_ASSERT_EQUAL_INT(2, cache.loads);
+}
+
+void test_retry_keeps_ready_image(void) {
+	writeImage(0, "zero");
+	waitFor(0, NULL);
+
+	ImageCache_retry(&cache, paths[0]);
+	ImageCache_retry(&cache, paths[1]); // never requested
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, ImageCache_request(&cache, paths[0], NULL));
+	TEST_ASSERT_EQUAL_INT(1, cache.loads);
+}
+
+///////////////////////////////
+// Eviction and queueing
+///////////////////////////////
+
+void test_least_recently_used_is_evicted(void) {
+	for (int i = 0; i <= IMAGE_CACHE_SIZE; i++)
+		writeImage(i, "image");
+	for (int i = 0; i < IMAGE_CACHE_SIZE; i++)
+		TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(i, NULL));
+
+	// using the first keeps it, the second is now the oldest
+	waitFor(0, NULL);
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(IMAGE_CACHE_SIZE, NULL));
+	TEST_ASSERT_EQUAL_INT(1, frees);
+
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, ImageCache_request(&cache, paths[0], NULL));
+	TEST_ASSERT_EQUAL_INT(IMAGE_LOADING, ImageCache_request(&cache, paths[1], NULL));
+}
+
+void test_missing_image_is_remembered_after_eviction(void) {
+	TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, waitFor(0, NULL));
+	writeImage(0, "late");
+
+	// evict it, then come back to it
+	for (int i = 1; i <= IMAGE_CACHE_SIZE; i++)
+		waitFor(i, NULL);
+	TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, ImageCache_request(&cache, paths[0], NULL));
+	TEST_ASSERT_EQUAL_INT(IMAGE_CACHE_SIZE + 1, cache.loads);
+}
+
+void test_full_queue_is_retried_on_next_request(void) {
+	for (int i = 0; i <= IMAGE_QUEUE_SIZE; i++)
+		writeImage(i, "image");
+	hold(1);
+
+	for (int i = 0; i < IMAGE_QUEUE_SIZE; i++)
+		TEST_ASSERT_EQUAL_INT(IMAGE_LOADING, ImageCache_request(&cache, paths[i], NULL));
+	TEST_ASSERT_EQUAL_INT(IMAGE_NONE, ImageCache_request(&cache, paths[IMAGE_QUEUE_SIZE], NULL));
+
+	hold(0);
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(IMAGE_QUEUE_SIZE, NULL));
+}
+
+void test_evicted_loads_are_skipped(void) {
+	for (int i = 0; i < FILES; i++)
+		writeImage(i, "image");
+	hold(1);
+
+	// fill the queue, then scroll past enough items to evict all of it
+	for (int i = 0; i < IMAGE_QUEUE_SIZE; i++)
+		ImageCache_request(&cache, paths[i], NULL);
+	for (int i = IMAGE_QUEUE_SIZE; i < FILES; i++)
+		TEST_ASSERT_EQUAL_INT(IMAGE_NONE, ImageCache_request(&cache, paths[i], NULL));
+
+	hold(0);
+	ImageCache_flush(&cache);
+	// only the load already running when they were evicted happened
+	TEST_ASSERT_TRUE(cache.loads <= 1);
+	TEST_ASSERT_EQUAL_INT(cache.loads, frees);
+
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(FILES - 1, NULL));
+}
+
+///////////////////////////////
+// Storing
+///////////////////////////////
+
+void test_store_is_cached_immediately_and_written(void) {
+	TEST_ASSERT_EQUAL_INT(IMAGE_MISSING, waitFor(0, NULL));
+
+	TEST_ASSERT_EQUAL_INT(0, ImageCache_store(&cache, paths[0], strdup("new"), strdup("copy")));
+	void* image = NULL;
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, ImageCache_request(&cache, paths[0], &image));
+	TEST_ASSERT_EQUAL_STRING("new", image);
+
+	// the written copy is loaded once the cached image is evicted
+	ImageCache_flush(&cache);
+	TEST_ASSERT_EQUAL_INT(1, cache.saves);
+	TEST_ASSERT_EQUAL_INT(1, frees);
+	for (int i = 1; i <= IMAGE_CACHE_SIZE; i++)
+		ImageCache_request(&cache, paths[i], NULL);
+	TEST_ASSERT_EQUAL_INT(IMAGE_READY, waitFor(0, &image));
+	TEST_ASSERT_EQUAL_STRING("copy", image);
+}
+
+void test_stop_finishes_queued_writes(void) {
+	hold(1);
+	ImageCache_request(&cache, paths[0], NULL); // keeps the worker busy
+	for (int i = 1; i < IMAGE_QUEUE_SIZE; i++)
+		ImageCache_store(&cache, paths[i], strdup("new"), strdup("copy"));
+
+	pthread_mutex_lock(&cache.mutex);
+	cache.quit = 1;
+	pthread_mutex_unlock(&cache.mutex);
+	hold(0);
+	ImageCache_stop(&cache);
+
+	for (int i = 1; i < IMAGE_QUEUE_SIZE; i++)
+		TEST_ASSERT_EQUAL_INT(0, access(paths[i], F_OK));
+}
+
+///////////////////////////////
+// Lifecycle
+///////////////////////////////
+
+void test_stop_frees_images(void) {
+	writeImage(0, "zero");
+	writeImage(1, "one");
+	waitFor(0, NULL);
+	waitFor(1, NULL);
+
+	ImageCache_stop(&cache);
+	TEST_ASSERT_EQUAL_INT(2, frees);
+	TEST_ASSERT_EQUAL_INT(IMAGE_NONE, ImageCache_request(&cache, paths[0], NULL));
+}
+
+void test_stop_drops_queued_loads(void) {
+	for (int i = 0; i < IMAGE_QUEUE_SIZE; i++)
+		writeImage(i, "image");
+	hold(1);
+	for (int i = 0; i < IMAGE_QUEUE_SIZE; i++)
+		ImageCache_request(&cache, paths[i], NULL);
+
+	// stop as the held load finishes, like ImageCache_stop() would set it
+	pthread_mutex_lock(&cache.mutex);
+	cache.quit = 1;
+	pthread_mutex_unlock(&cache.mutex);
+	hold(0);
+	pthread_mutex_lock(&cache.mutex);
+	int loads = cache.loads;
+	pthread_mutex_unlock(&cache.mutex);
+	ImageCache_stop(&cache);
+
+	TEST_ASSERT_TRUE(loads <= 1);
+	TEST_ASSERT_EQUAL_INT(loads, frees);
+	TEST_ASSERT_FALSE(cache.running);
+}
+
+void test_unstarted_cache_is_a_noop(void) {
+	ImageCache idle;
+	memset(&idle, 0, sizeof(idle));
+	void* image = (void*)1;
+	TEST_ASSERT_EQUAL_INT(IMAGE_NONE, ImageCache_request(&idle, paths[0], &image));
+	TEST_ASSERT_NULL(image);
+	ImageCache_retry(&idle, paths[0]);
+	TEST_ASSERT_EQUAL_INT(-1, ImageCache_store(&idle, paths[0], NULL, NULL));
+	ImageCache_flush(&idle);
+	ImageCache_stop(&idle);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_request_loads_in_background);
+	RUN_TEST(test_userdata_reaches_the_loader);
+	RUN_TEST(test_ready_image_is_not_loaded_again);
+	RUN_TEST(test_missing_image_is_remembered);
+	RUN_TEST(test_retry_loads_missing_image_again);
+	RUN_TEST(test_retry_keeps_ready_image);
+
+	RUN_TEST(test_least_recently_used_is_evicted);
+	RUN_TEST(test_missing_image_is_remembered_after_eviction);
+	RUN_TEST(test_full_queue_is_retried_on_next_request);
+	RUN_TEST(test_evicted_loads_are_skipped);
+
+	RUN_TEST(test_store_is_cached_immediately_and_written);
+	RUN_TEST(test_stop_finishes_queued_writes);
+
+	RUN_TEST(test_stop_frees_images);
+	RUN_TEST(test_stop_drops_queued_loads);
+	RUN_TEST(test_unstarted_cache_is_a_noop);
+
+	return UNITY_END();
+}
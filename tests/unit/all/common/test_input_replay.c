@@ -0,0 +1,224 @@
+/**
+ * test_input_replay.c - Tests for benchmark input recordings
+ *
+ * Uses real temp files for the recordings.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/input_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char path[64];
+static InputRecorder recorder;
+static InputReplay replay;
+
+static InputReplay_Frame makeFrame(uint32_t buttons, int16_t lx) {
+	InputReplay_Frame frame = {.buttons = buttons, .axes = {lx, 0, 0, -lx}};
+	return frame;
+}
+
+static long fileSize(void) {
+	FILE* file = fopen(path, "rb");
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+void setUp(void) {
+	strcpy(path, "/tmp/replay_XXXXXX");
+	int fd = mkstemp(path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+	memset(&recorder, 0, sizeof(recorder));
+	memset(&replay, 0, sizeof(replay));
+}
+
+void tearDown(void) {
+	InputRecorder_close(&recorder);
+	InputReplay_free(&replay);
+	unlink(path);
+}
+
+///////////////////////////////
+// Recording and replay
+///////////////////////////////
+
+void test_roundtrip_replays_every_frame(void) {
+	const char state[] = "save state bytes";
+	TEST_ASSERT_EQUAL_INT(0, InputRecorder_open(&recorder, path, state, sizeof(state)));
+	for (int i = 0; i < 100; i++) {
+		InputReplay_Frame frame = makeFrame(i % 7 == 0 ? 1u << (i % 16) : 0, (int16_t)(i * 100));
+		TEST_ASSERT_EQUAL_INT(0, InputRecorder_add(&recorder, &frame));
+	}
+	TEST_ASSERT_EQUAL_INT(0, InputRecorder_close(&recorder));
+
+	TEST_ASSERT_EQUAL_INT(0, InputReplay_load(&replay, path));
+	TEST_ASSERT_EQUAL_INT(100, replay.frame_count);
+	TEST_ASSERT_EQUAL_INT(sizeof(state), replay.state_size);
+	TEST_ASSERT_EQUAL_MEMORY(state, replay.state, sizeof(state));
+
+	InputReplay_Frame frame;
+	for (int i = 0; i < 100; i++) {
+		TEST_ASSERT_EQUAL_INT(0, InputReplay_next(&replay, &frame));
+		TEST_ASSERT_EQUAL_HEX32(i % 7 == 0 ? 1u << (i % 16) : 0, frame.buttons);
+		TEST_ASSERT_EQUAL_INT16(i * 100, frame.axes[0]);
+		TEST_ASSERT_EQUAL_INT16(-i * 100, frame.axes[3]);
+	}
+	TEST_ASSERT_EQUAL_INT(-1, InputReplay_next(&replay, &frame));
+}
+
+void test_held_input_is_run_length_encoded(void) {
+	InputRecorder_open(&recorder, path, NULL, 0);
+	InputReplay_Frame idle = makeFrame(0, 0);
+	InputReplay_Frame right = makeFrame(1u << 7, 0);
+	for (int i = 0; i < 3600; i++) // a minute at 60fps
+		InputRecorder_add(&recorder, i >= 1000 && i < 2000 ? &right : &idle);
+	InputRecorder_close(&recorder);
+
+	TEST_ASSERT_EQUAL_INT(3, recorder.run_count);
+	TEST_ASSERT_EQUAL_INT(5 * 4 + 3 * sizeof(InputReplay_Run), fileSize());
+
+	TEST_ASSERT_EQUAL_INT(0, InputReplay_load(&replay, path));
+	TEST_ASSERT_EQUAL_INT(3600, replay.frame_count);
+	TEST_ASSERT_EQUAL_INT(1000, replay.runs[1].count);
+	TEST_ASSERT_EQUAL_HEX32(1u << 7, replay.runs[1].frame.buttons);
+}
+
+void test_axes_start_a_new_run(void) {
+	InputRecorder_open(&recorder, path, NULL, 0);
+	InputReplay_Frame a = makeFrame(0, 10);
+	InputReplay_Frame b = makeFrame(0, 11);
+	InputRecorder_add(&recorder, &a);
+	InputRecorder_add(&recorder, &b);
+	InputRecorder_close(&recorder);
+
+	TEST_ASSERT_EQUAL_INT(2, recorder.run_count);
+}
+
+void test_empty_recording(void) {
+	TEST_ASSERT_EQUAL_INT(0, InputRecorder_open(&recorder, path, NULL, 0));
+	TEST_ASSERT_EQUAL_INT(0, InputRecorder_close(&recorder));
+	TEST_ASSERT_EQUAL_INT(0, InputRecorder_close(&recorder));
+
+	TEST_ASSERT_EQUAL_INT(0, InputReplay_load(&replay, path));
+	InputReplay_Frame frame;
+	TEST_ASSERT_EQUAL_INT(-1, InputReplay_next(&replay, &frame));
+}
+
+void test_unwritable_path(void) {
+	TEST_ASSERT_EQUAL_INT(-1, InputRecorder_open(&recorder, "/tmp/replay_missing/rec", NULL, 0));
+	InputReplay_Frame frame = makeFrame(0, 0);
+	TEST_ASSERT_EQUAL_INT(-1, InputRecorder_add(&recorder, &frame));
+}
+
+///////////////////////////////
+// Invalid recordings
+///////////////////////////////
+
+void test_load_rejects_bad_magic(void) {
+	FILE* file = fopen(path, "wb");
+	uint32_t header[5] = {0x12345678, INPUT_REPLAY_VERSION, 0, 0, 0};
+	fwrite(header, sizeof(header), 1, file);
+	fclose(file);
+
+	TEST_ASSERT_EQUAL_INT(-1, InputReplay_load(&replay, path));
+}
+
+void test_load_rejects_truncated_runs(void) {
+	InputRecorder_open(&recorder, path, "st", 2);
+	for (int i = 0; i < 10; i++) {
+		InputReplay_Frame frame = makeFrame((uint32_t)i, 0);
+		InputRecorder_add(&recorder, &frame);
+	}
+	InputRecorder_close(&recorder);
+	TEST_ASSERT_EQUAL_INT(0, truncate(path, fileSize() - 1));
+
+	TEST_ASSERT_EQUAL_INT(-1, InputReplay_load(&replay, path));
+	TEST_ASSERT_NULL(replay.runs);
+}
+
+void test_unfinished_recording_replays_nothing(void) {
+	// a crash before close leaves the header counts at zero with runs after it
+	InputRecorder_open(&recorder, path, NULL, 0);
+	InputReplay_Frame a = makeFrame(1, 0);
+	InputReplay_Frame b = makeFrame(2, 0);
+	InputRecorder_add(&recorder, &a);
+	InputRecorder_add(&recorder, &b);
+	fflush(recorder.file);
+
+	InputReplay unfinished;
+	TEST_ASSERT_EQUAL_INT(0, InputReplay_load(&unfinished, path));
+	TEST_ASSERT_EQUAL_INT(0, unfinished.frame_count);
+	InputReplay_free(&unfinished);
+}
+
+void test_load_missing_file(void) {
+	TEST_ASSERT_EQUAL_INT(-1, InputReplay_load(&replay, "/tmp/replay_missing.rec"));
+}
+
+///////////////////////////////
+// Frame hash
+///////////////////////////////
+
+void test_hashFrame_ignores_row_padding(void) {
+	uint8_t packed[4][6];
+	uint8_t padded[4][16];
+	memset(padded, 0xEE, sizeof(padded));
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 6; x++)
+			packed[y][x] = padded[y][x] = (uint8_t)(y * 6 + x);
+
+	uint64_t a = InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, packed, 6, 4, 6);
+	uint64_t b = InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, padded, 6, 4, 16);
+	TEST_ASSERT_TRUE(a == b);
+}
+
+void test_hashFrame_detects_pixel_changes(void) {
+	uint16_t frame[8][20] = {{0}};
+	uint64_t base = InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, frame, 40, 8, 40);
+
+	frame[7][19] = 1; // in the tail bytes after the last full word
+	TEST_ASSERT_TRUE(InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, frame, 40, 8, 40) != base);
+	frame[7][19] = 0;
+	frame[3][2] = 0x8000;
+	TEST_ASSERT_TRUE(InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, frame, 40, 8, 40) != base);
+}
+
+void test_hashFrame_chains_frames_in_order(void) {
+	uint8_t a[8] = {1}, b[8] = {2};
+	uint64_t ab = InputReplay_hashFrame(InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, a, 8, 1, 8),
+	                                    b, 8, 1, 8);
+	uint64_t ba = InputReplay_hashFrame(InputReplay_hashFrame(INPUT_REPLAY_HASH_SEED, b, 8, 1, 8),
+	                                    a, 8, 1, 8);
+	TEST_ASSERT_TRUE(ab != ba);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_roundtrip_replays_every_frame);
+	RUN_TEST(test_held_input_is_run_length_encoded);
+	RUN_TEST(test_axes_start_a_new_run);
+	RUN_TEST(test_empty_recording);
+	RUN_TEST(test_unwritable_path);
+
+	RUN_TEST(test_load_rejects_bad_magic);
+	RUN_TEST(test_load_rejects_truncated_runs);
+	RUN_TEST(test_unfinished_recording_replays_nothing);
+	RUN_TEST(test_load_missing_file);
+
+	RUN_TEST(test_hashFrame_ignores_row_padding);
+	RUN_TEST(test_hashFrame_detects_pixel_changes);
+	RUN_TEST(test_hashFrame_chains_frames_in_order);
+
+	return UNITY_END();
+}
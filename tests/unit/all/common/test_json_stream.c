@@ -0,0 +1,293 @@
+/**
+ * test_json_stream.c - Tests for the incremental JSON tokenizer
+ *
+ * Documents are fed through pipes, large ones through temp files so that
+ * tokens span several buffer refills.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/json_stream.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static JsonStream stream;
+static int fds[2];
+
+// Opens the stream on a pipe holding the document
+static void openString(const char* json) {
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	size_t length = strlen(json);
+	TEST_ASSERT_EQUAL_INT((int)length, (int)write(fds[1], json, length));
+	close(fds[1]);
+	fds[1] = -1;
+	JsonStream_open(&stream, fds[0]);
+}
+
+// Reads the whole document, returns the last token (END or ERROR)
+static JsonStream_Token drain(void) {
+	JsonStream_Token token;
+	while ((token = JsonStream_next(&stream)) > JSON_STREAM_END)
+		;
+	return token;
+}
+
+static void assertRejected(const char* json) {
+	openString(json);
+	if (drain() != JSON_STREAM_ERROR)
+		TEST_FAIL_MESSAGE(json);
+	JsonStream_close(&stream);
+	close(fds[0]);
+	fds[0] = -1;
+}
+
+void setUp(void) {
+	fds[0] = fds[1] = -1;
+	memset(&stream, 0, sizeof(stream));
+}
+
+void tearDown(void) {
+	JsonStream_close(&stream);
+	if (fds[0] >= 0)
+		close(fds[0]);
+	if (fds[1] >= 0)
+		close(fds[1]);
+}
+
+///////////////////////////////
+// Tokens
+///////////////////////////////
+
+void test_tokens_of_nested_document(void) {
+	openString("{\"items\": [\"a\", 1.5, -2, true, false, null, {}, []], \"n\": 0}");
+
+	JsonStream_Token expected[] = {
+	    JSON_STREAM_OBJECT_BEGIN, JSON_STREAM_KEY, JSON_STREAM_ARRAY_BEGIN, JSON_STREAM_STRING,
+	    JSON_STREAM_NUMBER, JSON_STREAM_NUMBER, JSON_STREAM_TRUE, JSON_STREAM_FALSE,
+	    JSON_STREAM_NULL, JSON_STREAM_OBJECT_BEGIN, JSON_STREAM_OBJECT_END,
+	    JSON_STREAM_ARRAY_BEGIN, JSON_STREAM_ARRAY_END, JSON_STREAM_ARRAY_END, JSON_STREAM_KEY,
+	    JSON_STREAM_NUMBER, JSON_STREAM_OBJECT_END, JSON_STREAM_END,
+	};
+	for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		JsonStream_Token token = JsonStream_next(&stream);
+		TEST_ASSERT_EQUAL_INT(expected[i], token);
+		if (i == 1)
+			TEST_ASSERT_EQUAL_STRING("items", stream.string);
+		if (i == 3)
+			TEST_ASSERT_EQUAL_STRING("a", stream.string);
+		if (i == 4)
+			TEST_ASSERT_EQUAL_FLOAT(1.5, stream.number);
+		if (i == 5)
+			TEST_ASSERT_EQUAL_FLOAT(-2, stream.number);
+	}
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+}
+
+void test_scalar_root(void) {
+	openString(" \"only\" ");
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+}
+
+void test_comments_between_tokens(void) {
+	openString("/* header */ [ // first\n \"a // not a comment\", /* x */ 2 ]\n// end");
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_BEGIN, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_STRING("a // not a comment", stream.string);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_NUMBER, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+}
+
+void test_string_escapes(void) {
+	openString("[\"q\\\"b\\\\s\\/n\\n\\t\", \"\\u00e9\\u20ac\\ud83d\\ude00\", \"a\\u0000b\"]");
+	JsonStream_next(&stream);
+
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_STRING("q\"b\\s/n\n\t", stream.string);
+
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_STRING("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", stream.string);
+
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(3, stream.string_length);
+	TEST_ASSERT_EQUAL_MEMORY("a\0b", stream.string, 3);
+}
+
+void test_tokens_span_buffer_refills(void) {
+	char path[] = "/tmp/json_stream_XXXXXX";
+	int fd = mkstemp(path);
+	TEST_ASSERT_TRUE(fd >= 0);
+
+	// long strings and many small items, so tokens straddle the buffer edges
+	size_t long_length = 3 * JSON_STREAM_BUFFER_SIZE + 7;
+	char* value = malloc(long_length + 1);
+	memset(value, 'x', long_length);
+	value[long_length] = '\0';
+	FILE* file = fdopen(dup(fd), "w");
+	fprintf(file, "{\"long\": \"%s\", \"items\": [", value);
+	for (int i = 0; i < 5000; i++)
+		fprintf(file, "%s{\"name\": \"Item \\u0041%d\"}", i ? "," : "", i);
+	fprintf(file, "]}");
+	fclose(file);
+	lseek(fd, 0, SEEK_SET);
+	JsonStream_open(&stream, fd);
+
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_BEGIN, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_KEY, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(long_length, stream.string_length);
+	TEST_ASSERT_EQUAL_MEMORY(value, stream.string, long_length);
+
+	JsonStream_next(&stream);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_BEGIN, JsonStream_next(&stream));
+	char expected[32];
+	for (int i = 0; i < 5000; i++) {
+		TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_BEGIN, JsonStream_next(&stream));
+		TEST_ASSERT_EQUAL_INT(JSON_STREAM_KEY, JsonStream_next(&stream));
+		TEST_ASSERT_EQUAL_INT(JSON_STREAM_STRING, JsonStream_next(&stream));
+		snprintf(expected, sizeof(expected), "Item A%d", i);
+		TEST_ASSERT_EQUAL_STRING(expected, stream.string);
+		TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_END, JsonStream_next(&stream));
+	}
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+
+	free(value);
+	close(fd);
+	unlink(path);
+}
+
+///////////////////////////////
+// Skipping
+///////////////////////////////
+
+void test_skip_nested_value(void) {
+	openString("{\"skip\": {\"a\": [1, {\"b\": []}], \"c\": \"}\"}, \"keep\": 3}");
+	JsonStream_next(&stream);
+	JsonStream_next(&stream);
+	TEST_ASSERT_EQUAL_INT(0, JsonStream_skip(&stream, JsonStream_next(&stream)));
+
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_KEY, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_STRING("keep", stream.string);
+	TEST_ASSERT_EQUAL_INT(0, JsonStream_skip(&stream, JsonStream_next(&stream)));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+}
+
+void test_skip_reports_errors(void) {
+	openString("[[1, 2");
+	JsonStream_next(&stream);
+	TEST_ASSERT_EQUAL_INT(-1, JsonStream_skip(&stream, JsonStream_next(&stream)));
+	TEST_ASSERT_NOT_NULL(stream.error);
+}
+
+///////////////////////////////
+// Invalid documents
+///////////////////////////////
+
+void test_rejects_invalid_documents(void) {
+	assertRejected("");
+	assertRejected("[1, 2,]");
+	assertRejected("{\"a\" 1}");
+	assertRejected("{\"a\": 1,}");
+	assertRejected("{1: 2}");
+	assertRejected("[\"open");
+	assertRejected("[\"tab\there\"]");
+	assertRejected("[\"\\x\"]");
+	assertRejected("[\"\\ude00\"]");
+	assertRejected("[01]");
+	assertRejected("[-]");
+	assertRejected("[+1]");
+	assertRejected("[tru]");
+	assertRejected("[1}");
+	assertRejected("{} {}");
+	assertRejected("[1] /* open");
+	assertRejected("[1] / 2");
+}
+
+void test_error_is_sticky(void) {
+	openString("[1 2]");
+	JsonStream_next(&stream);
+	JsonStream_next(&stream);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ERROR, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_STRING("expected ',' or the end of the container", stream.error);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ERROR, JsonStream_next(&stream));
+}
+
+void test_malformed_first_item(void) {
+	// minui-list reads the first screen of items before showing anything,
+	// so this fails before a single item is complete
+	openString("{\"items\": [{\"name\": \"A\",}, {\"name\": \"B\"}]}");
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_BEGIN, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_KEY, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_BEGIN, JsonStream_next(&stream));
+	JsonStream_Token token = JsonStream_next(&stream);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_OBJECT_BEGIN, token);
+	TEST_ASSERT_EQUAL_INT(-1, JsonStream_skip(&stream, token));
+	TEST_ASSERT_NOT_NULL(stream.error);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ERROR, JsonStream_next(&stream));
+}
+
+void test_nesting_limit(void) {
+	char json[JSON_STREAM_MAX_DEPTH + 2];
+	memset(json, '[', JSON_STREAM_MAX_DEPTH + 1);
+	json[JSON_STREAM_MAX_DEPTH + 1] = '\0';
+	openString(json);
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ERROR, drain());
+	TEST_ASSERT_EQUAL_STRING("nested too deeply", stream.error);
+}
+
+///////////////////////////////
+// Readiness
+///////////////////////////////
+
+void test_ready_follows_the_writer(void) {
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	JsonStream_open(&stream, fds[0]);
+	TEST_ASSERT_EQUAL_INT(0, JsonStream_ready(&stream));
+
+	TEST_ASSERT_EQUAL_INT(4, (int)write(fds[1], "[1, ", 4));
+	TEST_ASSERT_EQUAL_INT(1, JsonStream_ready(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_BEGIN, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_NUMBER, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(1, JsonStream_ready(&stream)); // ", " is still buffered
+
+	TEST_ASSERT_EQUAL_INT(2, (int)write(fds[1], "2]", 2));
+	close(fds[1]);
+	fds[1] = -1;
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_NUMBER, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_ARRAY_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(JSON_STREAM_END, JsonStream_next(&stream));
+	TEST_ASSERT_EQUAL_INT(1, JsonStream_ready(&stream));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_tokens_of_nested_document);
+	RUN_TEST(test_scalar_root);
+	RUN_TEST(test_comments_between_tokens);
+	RUN_TEST(test_string_escapes);
+	RUN_TEST(test_tokens_span_buffer_refills);
+
+	RUN_TEST(test_skip_nested_value);
+	RUN_TEST(test_skip_reports_errors);
+
+	RUN_TEST(test_rejects_invalid_documents);
+	RUN_TEST(test_error_is_sticky);
+	RUN_TEST(test_malformed_first_item);
+	RUN_TEST(test_nesting_limit);
+
+	RUN_TEST(test_ready_follows_the_writer);
+
+	return UNITY_END();
+}
@@ -0,0 +1,276 @@
+/**
+ * test_keymon_core.c - Tests for the event-driven keymon core
+ *
+ * Runs KEYMON_run() on a background thread with a FIFO standing in for
+ * the input device (see test_evdev.c). Events are stamped relative to
+ * CLOCK_MONOTONIC, so a press stamped in the past makes the repeat timer
+ * fire a known number of times immediately instead of waiting for it.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/evdev.h"
+#include "../../../../workspace/all/common/keymon_core.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CODE_PLUS 115
+#define CODE_MENU 1
+#define CODE_JACK 2
+
+static char temp_dir[64];
+static char device_path[128];
+static int writer;
+static pthread_t loop_pt;
+static int loop_started;
+
+static struct {
+	int presses;
+	int releases;
+	int repeats;
+	int switches;
+	int switch_value;
+	int resets;
+	int polls;
+} seen;
+
+static int handleKey(int code, int value) {
+	if (value == KEYMON_PRESSED)
+		seen.presses += 1;
+	else
+		seen.releases += 1;
+	return code == CODE_PLUS;
+}
+
+static void handleRepeat(int code) {
+	seen.repeats += 1;
+}
+
+static void handleSwitch(int code, int value) {
+	seen.switches += 1;
+	seen.switch_value = value;
+}
+
+static void reset(void) {
+	seen.resets += 1;
+}
+
+static void pollHardware(void) {
+	seen.polls += 1;
+}
+
+static KEYMON_Hooks hooks = {
+    .handleKey = handleKey,
+    .handleRepeat = handleRepeat,
+    .handleSwitch = handleSwitch,
+    .reset = reset,
+};
+
+static uint64_t nowMicros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void writeEvent(int type, int code, int value, uint64_t time_us) {
+	EVDEV_Event event = {0};
+	event.sec = (unsigned long)(time_us / 1000000);
+	event.usec = (unsigned long)(time_us % 1000000);
+	event.type = (uint16_t)type;
+	event.code = (uint16_t)code;
+	event.value = value;
+	TEST_ASSERT_EQUAL_INT(sizeof(event), write(writer, &event, sizeof(event)));
+}
+
+static void* runLoop(void* arg) {
+	static const char* inputs[2];
+	inputs[0] = device_path;
+	inputs[1] = NULL;
+	KEYMON_run(inputs, &hooks);
+	return NULL;
+}
+
+static void settle(void) {
+	usleep(50000); // let the loop thread dispatch
+}
+
+void setUp(void) {
+	strcpy(temp_dir, "/tmp/keymontest_XXXXXX");
+	TEST_ASSERT_NOT_NULL(mkdtemp(temp_dir));
+	sprintf(device_path, "%s/event0", temp_dir);
+	TEST_ASSERT_EQUAL_INT(0, mkfifo(device_path, 0600));
+	memset(&seen, 0, sizeof(seen));
+	hooks.poll = NULL;
+	hooks.poll_ms = 0;
+	writer = -1;
+	loop_started = 0;
+}
+
+static void startLoop(void) {
+	pthread_create(&loop_pt, NULL, runLoop, NULL);
+	loop_started = 1;
+	settle();
+	writer = open(device_path, O_WRONLY | O_NONBLOCK);
+	TEST_ASSERT_TRUE(writer >= 0);
+}
+
+void tearDown(void) {
+	if (loop_started) {
+		KEYMON_quit();
+		pthread_join(loop_pt, NULL);
+	}
+	if (writer >= 0)
+		close(writer);
+	unlink(device_path);
+	rmdir(temp_dir);
+}
+
+///////////////////////////////
+// Stale input
+///////////////////////////////
+
+void test_KEYMON_isStale(void) {
+	uint64_t now = 10 * 1000000;
+
+	TEST_ASSERT_FALSE(KEYMON_isStale(now, now));
+	TEST_ASSERT_FALSE(KEYMON_isStale(now - KEYMON_STALE_MS * 1000, now));
+	TEST_ASSERT_TRUE(KEYMON_isStale(now - KEYMON_STALE_MS * 1000 - 1, now));
+	TEST_ASSERT_FALSE(KEYMON_isStale(now + 5000000, now)); // wrong clock, not stale
+}
+
+///////////////////////////////
+// Event loop
+///////////////////////////////
+
+void test_KEYMON_dispatches_press_and_release(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_KEY, CODE_MENU, KEYMON_PRESSED, nowMicros());
+	writeEvent(EVDEV_EV_KEY, CODE_MENU, KEYMON_RELEASED, nowMicros());
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(1, seen.presses);
+	TEST_ASSERT_EQUAL_INT(1, seen.releases);
+	TEST_ASSERT_EQUAL_INT(0, seen.repeats);
+}
+
+void test_KEYMON_ignores_kernel_autorepeat(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_KEY, CODE_MENU, 2, nowMicros());
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(0, seen.presses);
+}
+
+void test_KEYMON_repeats_on_exact_schedule(void) {
+	startLoop();
+
+	// pressed long enough ago for the initial delay plus two intervals
+	uint64_t held_us = (KEYMON_REPEAT_DELAY_MS + 2 * KEYMON_REPEAT_INTERVAL_MS + 10) * 1000;
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_PRESSED, nowMicros() - held_us);
+	usleep(30000); // well before the next repeat is due
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_RELEASED, nowMicros());
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(1, seen.presses);
+	TEST_ASSERT_EQUAL_INT(3, seen.repeats);
+}
+
+void test_KEYMON_repeats_press_stamped_in_the_future(void) {
+	startLoop();
+
+	// a device that ignored the switch to CLOCK_MONOTONIC
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_PRESSED, nowMicros() + 3600ULL * 1000000);
+	usleep((KEYMON_REPEAT_DELAY_MS + KEYMON_REPEAT_INTERVAL_MS / 2) * 1000);
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_RELEASED, nowMicros());
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(1, seen.repeats);
+}
+
+void test_KEYMON_release_stops_repeat(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_PRESSED, nowMicros());
+	writeEvent(EVDEV_EV_KEY, CODE_PLUS, KEYMON_RELEASED, nowMicros());
+	usleep((KEYMON_REPEAT_DELAY_MS + KEYMON_REPEAT_INTERVAL_MS) * 1000);
+
+	TEST_ASSERT_EQUAL_INT(0, seen.repeats);
+}
+
+void test_KEYMON_non_repeating_key_never_repeats(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_KEY, CODE_MENU, KEYMON_PRESSED, nowMicros() - 500000);
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(1, seen.presses);
+	TEST_ASSERT_EQUAL_INT(0, seen.repeats);
+}
+
+void test_KEYMON_drops_stale_input_and_resets(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_KEY, CODE_MENU, KEYMON_PRESSED,
+	           nowMicros() - (KEYMON_STALE_MS + 500) * 1000);
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(0, seen.presses);
+	TEST_ASSERT_EQUAL_INT(1, seen.resets);
+}
+
+void test_KEYMON_dispatches_switches(void) {
+	startLoop();
+
+	writeEvent(EVDEV_EV_SW, CODE_JACK, 1, nowMicros());
+	settle();
+
+	TEST_ASSERT_EQUAL_INT(1, seen.switches);
+	TEST_ASSERT_EQUAL_INT(1, seen.switch_value);
+	TEST_ASSERT_EQUAL_INT(0, seen.presses);
+}
+
+void test_KEYMON_polls_immediately_and_periodically(void) {
+	hooks.poll = pollHardware;
+	hooks.poll_ms = 20;
+	startLoop(); // waits 50ms
+
+	TEST_ASSERT_TRUE(seen.polls >= 2);
+}
+
+void test_KEYMON_run_requires_handleKey(void) {
+	KEYMON_Hooks empty = {0};
+	const char* inputs[] = {NULL};
+
+	TEST_ASSERT_EQUAL_INT(-1, KEYMON_run(inputs, &empty));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_KEYMON_isStale);
+
+	RUN_TEST(test_KEYMON_dispatches_press_and_release);
+	RUN_TEST(test_KEYMON_ignores_kernel_autorepeat);
+	RUN_TEST(test_KEYMON_repeats_on_exact_schedule);
+	RUN_TEST(test_KEYMON_repeats_press_stamped_in_the_future);
+	RUN_TEST(test_KEYMON_release_stops_repeat);
+	RUN_TEST(test_KEYMON_non_repeating_key_never_repeats);
+	RUN_TEST(test_KEYMON_drops_stale_input_and_resets);
+	RUN_TEST(test_KEYMON_dispatches_switches);
+	RUN_TEST(test_KEYMON_polls_immediately_and_periodically);
+	RUN_TEST(test_KEYMON_run_requires_handleKey);
+
+	return UNITY_END();
+}
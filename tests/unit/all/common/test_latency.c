@@ -0,0 +1,191 @@
+/**
+ * test_latency.c - Tests for input-to-photon latency measurement
+ *
+ * Presses are stamped slightly in the past with LAT_now() so each stage
+ * produces a known minimum latency without sleeping.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/latency.h"
+
+#include <string.h>
+
+#define BUTTON 4 // Any button id, the tests press this one
+#define OTHER_BUTTON 7 // A button held at the same time
+
+void setUp(void) {
+	LAT_reset();
+	LAT_setEnabled(1);
+}
+
+void tearDown(void) {
+	LAT_setEnabled(0);
+}
+
+///////////////////////////////
+// Histogram
+///////////////////////////////
+
+void test_LAT_Histogram_add_tracks_stats(void) {
+	LAT_Histogram h;
+	memset(&h, 0, sizeof(h));
+
+	LAT_Histogram_add(&h, 10000);
+	LAT_Histogram_add(&h, 30000);
+
+	TEST_ASSERT_EQUAL_UINT32(2, h.count);
+	TEST_ASSERT_EQUAL_UINT64(10000, h.min_us);
+	TEST_ASSERT_EQUAL_UINT64(30000, h.max_us);
+	TEST_ASSERT_EQUAL_UINT64(40000, h.total_us);
+	TEST_ASSERT_EQUAL_UINT64(30000, h.last_us);
+}
+
+void test_LAT_Histogram_add_buckets_by_width(void) {
+	LAT_Histogram h;
+	memset(&h, 0, sizeof(h));
+
+	LAT_Histogram_add(&h, 0);
+	LAT_Histogram_add(&h, LAT_BUCKET_MS * 1000 - 1);
+	LAT_Histogram_add(&h, LAT_BUCKET_MS * 1000);
+
+	TEST_ASSERT_EQUAL_UINT32(2, h.buckets[0]);
+	TEST_ASSERT_EQUAL_UINT32(1, h.buckets[1]);
+}
+
+void test_LAT_Histogram_add_clamps_to_last_bucket(void) {
+	LAT_Histogram h;
+	memset(&h, 0, sizeof(h));
+
+	LAT_Histogram_add(&h, 10 * 1000 * 1000);
+
+	TEST_ASSERT_EQUAL_UINT32(1, h.buckets[LAT_BUCKET_COUNT - 1]);
+}
+
+void test_LAT_Histogram_percentile(void) {
+	LAT_Histogram h;
+	memset(&h, 0, sizeof(h));
+	for (int i = 0; i < 9; i++)
+		LAT_Histogram_add(&h, 1000); // bucket 0
+	LAT_Histogram_add(&h, 21000); // bucket 5
+
+	TEST_ASSERT_EQUAL_INT(LAT_BUCKET_MS, LAT_Histogram_percentile(&h, 50));
+	TEST_ASSERT_EQUAL_INT(LAT_BUCKET_MS, LAT_Histogram_percentile(&h, 90));
+	TEST_ASSERT_EQUAL_INT(6 * LAT_BUCKET_MS, LAT_Histogram_percentile(&h, 95));
+}
+
+void test_LAT_Histogram_percentile_empty(void) {
+	LAT_Histogram h;
+	memset(&h, 0, sizeof(h));
+
+	TEST_ASSERT_EQUAL_INT(0, LAT_Histogram_percentile(&h, 50));
+	TEST_ASSERT_EQUAL_INT(0, LAT_Histogram_percentile(NULL, 50));
+}
+
+///////////////////////////////
+// Measurement
+///////////////////////////////
+
+void test_LAT_full_measurement(void) {
+	LAT_markInput(LAT_now() - 20000, BUTTON);
+	LAT_markRead(1u << BUTTON);
+	LAT_markPresent();
+
+	const LAT_Histogram* read = LAT_getHistogram(LAT_STAGE_READ);
+	const LAT_Histogram* present = LAT_getHistogram(LAT_STAGE_PRESENT);
+	TEST_ASSERT_EQUAL_UINT32(1, read->count);
+	TEST_ASSERT_EQUAL_UINT32(1, present->count);
+	TEST_ASSERT_TRUE(read->last_us >= 20000);
+	TEST_ASSERT_TRUE(present->last_us >= read->last_us);
+}
+
+void test_LAT_present_without_read_is_ignored(void) {
+	LAT_markInput(LAT_now(), BUTTON);
+	LAT_markPresent();
+
+	TEST_ASSERT_EQUAL_UINT32(0, LAT_getHistogram(LAT_STAGE_PRESENT)->count);
+}
+
+void test_LAT_only_first_read_counts(void) {
+	LAT_markInput(LAT_now(), BUTTON);
+	LAT_markRead(1u << BUTTON);
+	LAT_markRead(1u << BUTTON);
+
+	TEST_ASSERT_EQUAL_UINT32(1, LAT_getHistogram(LAT_STAGE_READ)->count);
+}
+
+void test_LAT_press_in_flight_is_kept(void) {
+	uint64_t now = LAT_now();
+	LAT_markInput(now - 30000, BUTTON);
+	LAT_markInput(now, BUTTON);
+	LAT_markRead(1u << BUTTON);
+
+	TEST_ASSERT_TRUE(LAT_getHistogram(LAT_STAGE_READ)->last_us >= 30000);
+}
+
+void test_LAT_stale_press_is_replaced(void) {
+	uint64_t now = LAT_now();
+	LAT_markInput(now - (LAT_TIMEOUT_MS + 100) * 1000, BUTTON);
+	LAT_markInput(now, BUTTON);
+	LAT_markRead(1u << BUTTON);
+
+	TEST_ASSERT_TRUE(LAT_getHistogram(LAT_STAGE_READ)->last_us < LAT_TIMEOUT_MS * 1000);
+}
+
+void test_LAT_other_held_button_is_not_a_read(void) {
+	LAT_markInput(LAT_now(), BUTTON);
+	LAT_markRead(1u << OTHER_BUTTON);
+	TEST_ASSERT_EQUAL_UINT32(0, LAT_getHistogram(LAT_STAGE_READ)->count);
+
+	LAT_markRead((1u << OTHER_BUTTON) | (1u << BUTTON));
+	TEST_ASSERT_EQUAL_UINT32(1, LAT_getHistogram(LAT_STAGE_READ)->count);
+}
+
+void test_LAT_unmapped_press_is_ignored(void) {
+	LAT_markInput(LAT_now(), -1);
+	LAT_markRead(~0u);
+
+	TEST_ASSERT_EQUAL_UINT32(0, LAT_getHistogram(LAT_STAGE_READ)->count);
+}
+
+void test_LAT_disabled_records_nothing(void) {
+	LAT_setEnabled(0);
+
+	LAT_markInput(LAT_now(), BUTTON);
+	LAT_markRead(1u << BUTTON);
+	LAT_markPresent();
+
+	TEST_ASSERT_FALSE(LAT_isEnabled());
+	TEST_ASSERT_EQUAL_UINT32(0, LAT_getHistogram(LAT_STAGE_READ)->count);
+	TEST_ASSERT_EQUAL_UINT32(0, LAT_getHistogram(LAT_STAGE_PRESENT)->count);
+}
+
+void test_LAT_getHistogram_rejects_invalid_stage(void) {
+	TEST_ASSERT_NULL(LAT_getHistogram(-1));
+	TEST_ASSERT_NULL(LAT_getHistogram(LAT_STAGE_COUNT));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_LAT_Histogram_add_tracks_stats);
+	RUN_TEST(test_LAT_Histogram_add_buckets_by_width);
+	RUN_TEST(test_LAT_Histogram_add_clamps_to_last_bucket);
+	RUN_TEST(test_LAT_Histogram_percentile);
+	RUN_TEST(test_LAT_Histogram_percentile_empty);
+
+	RUN_TEST(test_LAT_full_measurement);
+	RUN_TEST(test_LAT_present_without_read_is_ignored);
+	RUN_TEST(test_LAT_only_first_read_counts);
+	RUN_TEST(test_LAT_press_in_flight_is_kept);
+	RUN_TEST(test_LAT_stale_press_is_replaced);
+	RUN_TEST(test_LAT_other_held_button_is_not_a_read);
+	RUN_TEST(test_LAT_unmapped_press_is_ignored);
+	RUN_TEST(test_LAT_disabled_records_nothing);
+	RUN_TEST(test_LAT_getHistogram_rejects_invalid_stage);
+
+	return UNITY_END();
+}
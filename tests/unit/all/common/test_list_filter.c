@@ -0,0 +1,180 @@
+/**
+ * test_list_filter.c - Tests for the incremental list filter
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/list_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static ListFilter filter;
+
+static void addAll(const char** names, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		TEST_ASSERT_EQUAL_INT(0, ListFilter_add(&filter, names[i]));
+}
+
+void setUp(void) {
+	memset(&filter, 0, sizeof(filter));
+}
+
+void tearDown(void) {
+	ListFilter_free(&filter);
+}
+
+///////////////////////////////
+// Folding
+///////////////////////////////
+
+void test_fold_lowercases_ascii(void) {
+	char out[64];
+	TEST_ASSERT_EQUAL_INT(18, ListFilter_fold(out, sizeof(out), "Super MARIO 64 (U)"));
+	TEST_ASSERT_EQUAL_STRING("super mario 64 (u)", out);
+}
+
+void test_fold_strips_latin1_accents(void) {
+	char out[64];
+	ListFilter_fold(out, sizeof(out), "Pokémon Édition Ærø Straße Þór");
+	TEST_ASSERT_EQUAL_STRING("pokemon edition aero strasse thor", out);
+}
+
+void test_fold_keeps_other_characters(void) {
+	char out[64];
+	ListFilter_fold(out, sizeof(out), "ドラゴン × ÷ €");
+	TEST_ASSERT_EQUAL_STRING("ドラゴン × ÷ €", out);
+}
+
+void test_fold_truncates_to_size(void) {
+	char out[6];
+	TEST_ASSERT_EQUAL_INT(5, ListFilter_fold(out, sizeof(out), "ABCDEFGH"));
+	TEST_ASSERT_EQUAL_STRING("abcde", out);
+
+	// a fold that doesn't fit is left out whole
+	TEST_ASSERT_EQUAL_INT(4, ListFilter_fold(out, sizeof(out), "ABCDß"));
+	TEST_ASSERT_EQUAL_STRING("abcd", out);
+}
+
+///////////////////////////////
+// Matching
+///////////////////////////////
+
+void test_apply_matches_substrings_in_order(void) {
+	const char* names[] = {"Super Mario Bros", "Zelda", "Mario Kart", "Dr. Mario", "Tetris"};
+	addAll(names, 5);
+
+	TEST_ASSERT_EQUAL_INT(3, ListFilter_apply(&filter, "mario"));
+	TEST_ASSERT_EQUAL_INT(0, filter.matches[0]);
+	TEST_ASSERT_EQUAL_INT(2, filter.matches[1]);
+	TEST_ASSERT_EQUAL_INT(3, filter.matches[2]);
+}
+
+void test_apply_ignores_case_and_accents(void) {
+	const char* names[] = {"Pokémon Red", "POKEMON BLUE", "Pokemon Yellow", "Digimon"};
+	addAll(names, 4);
+
+	TEST_ASSERT_EQUAL_INT(3, ListFilter_apply(&filter, "POKÉMON"));
+	TEST_ASSERT_EQUAL_INT(3, ListFilter_apply(&filter, "pokemon"));
+}
+
+void test_empty_query_matches_named_items(void) {
+	const char* names[] = {"Header", "One", "Two"};
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_add(&filter, NULL));
+	addAll(names + 1, 2);
+
+	TEST_ASSERT_EQUAL_INT(2, ListFilter_apply(&filter, ""));
+	TEST_ASSERT_EQUAL_INT(1, filter.matches[0]);
+	TEST_ASSERT_EQUAL_INT(2, filter.matches[1]);
+}
+
+void test_unnamed_items_never_match(void) {
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_add(&filter, NULL));
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, ""));
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, "x"));
+}
+
+void test_no_items(void) {
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, "anything"));
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, ""));
+}
+
+///////////////////////////////
+// Incremental queries
+///////////////////////////////
+
+void test_typing_narrows_and_deleting_widens(void) {
+	const char* names[] = {"alpha", "beta", "alphabet", "gamma"};
+	addAll(names, 4);
+
+	TEST_ASSERT_EQUAL_INT(4, ListFilter_apply(&filter, "a"));
+	TEST_ASSERT_EQUAL_INT(2, ListFilter_apply(&filter, "al"));
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "alphab"));
+	TEST_ASSERT_EQUAL_INT(2, filter.matches[0]);
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, "alphabz"));
+
+	// backspace goes back to every item
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "alphab"));
+	TEST_ASSERT_EQUAL_INT(2, ListFilter_apply(&filter, "al"));
+	TEST_ASSERT_EQUAL_INT(4, ListFilter_apply(&filter, ""));
+}
+
+void test_unrelated_query_rescans_everything(void) {
+	const char* names[] = {"alpha", "beta", "gamma"};
+	addAll(names, 3);
+
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "alp"));
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "bet"));
+	TEST_ASSERT_EQUAL_INT(1, filter.matches[0]);
+	// the old query anywhere inside the new one narrows too
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "beta"));
+	TEST_ASSERT_EQUAL_INT(0, ListFilter_apply(&filter, "xbeta"));
+}
+
+void test_items_added_later_are_matched(void) {
+	const char* names[] = {"mario", "mario kart"};
+	addAll(names, 1);
+	TEST_ASSERT_EQUAL_INT(1, ListFilter_apply(&filter, "mar"));
+
+	addAll(names + 1, 1);
+	TEST_ASSERT_EQUAL_INT(2, ListFilter_apply(&filter, "mari"));
+}
+
+void test_many_items(void) {
+	char name[32];
+	for (int i = 0; i < 10000; i++) {
+		snprintf(name, sizeof(name), "Game %05d (Rev %c)", i, 'A' + i % 3);
+		TEST_ASSERT_EQUAL_INT(0, ListFilter_add(&filter, name));
+	}
+
+	TEST_ASSERT_EQUAL_INT(10000, ListFilter_apply(&filter, "game"));
+	TEST_ASSERT_EQUAL_INT(1000, ListFilter_apply(&filter, "game 01"));
+	TEST_ASSERT_EQUAL_INT(3333, ListFilter_apply(&filter, "rev c"));
+	TEST_ASSERT_EQUAL_INT(2, filter.matches[0]);
+	TEST_ASSERT_EQUAL_INT(9998, filter.matches[3332]);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_fold_lowercases_ascii);
+	RUN_TEST(test_fold_strips_latin1_accents);
+	RUN_TEST(test_fold_keeps_other_characters);
+	RUN_TEST(test_fold_truncates_to_size);
+
+	RUN_TEST(test_apply_matches_substrings_in_order);
+	RUN_TEST(test_apply_ignores_case_and_accents);
+	RUN_TEST(test_empty_query_matches_named_items);
+	RUN_TEST(test_unnamed_items_never_match);
+	RUN_TEST(test_no_items);
+
+	RUN_TEST(test_typing_narrows_and_deleting_widens);
+	RUN_TEST(test_unrelated_query_rescans_everything);
+	RUN_TEST(test_items_added_later_are_matched);
+	RUN_TEST(test_many_items);
+
+	return UNITY_END();
+}
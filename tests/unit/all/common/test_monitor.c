@@ -0,0 +1,289 @@
+/**
+ * test_monitor.c - Tests for the shared hardware monitor scheduler
+ *
+ * The harness drives a MON_Scheduler with a simulated clock, using the
+ * platform mocks for battery readings and rumble, and reports how many
+ * times the monitor thread would wake per minute in each scenario.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../support/platform_mocks.h"
+#include "../../../../workspace/all/common/monitor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void PLAT_getBatteryStatus(int* is_charging, int* charge);
+void PLAT_setRumble(int strength);
+
+static MON_Scheduler scheduler;
+static uint64_t now_ms;
+
+static int in_game;
+static int battery_charge;
+static int battery_charging;
+static int battery_reads;
+
+static int queued_strength;
+static int strength;
+static int rumble_calls;
+
+void setUp(void) {
+	mock_reset_all();
+	memset(&scheduler, 0, sizeof(scheduler));
+	now_ms = 1000;
+	in_game = 0;
+	battery_charge = 100;
+	battery_charging = 0;
+	battery_reads = 0;
+	queued_strength = strength = 0;
+	rumble_calls = 0;
+}
+
+void tearDown(void) {}
+
+///////////////////////////////
+// Harness
+///////////////////////////////
+
+// Mirrors PWR_monitorBattery() in api.c
+static uint32_t batteryTask(void) {
+	int was_charging = battery_charging;
+	int had_charge = battery_charge;
+	PLAT_getBatteryStatus(&battery_charging, &battery_charge);
+	battery_reads += 1;
+	int changed = battery_charging != was_charging || battery_charge != had_charge;
+	return MON_batteryInterval(battery_charge, battery_charging, changed, in_game);
+}
+
+// Mirrors VIB_task() in api.c
+static uint32_t vibrationTask(void) {
+	static int defer = 0;
+	if (queued_strength == strength) {
+		defer = 0;
+		return MON_IDLE;
+	}
+	if (defer < 3 && queued_strength == 0) {
+		defer += 1;
+		return 17;
+	}
+	strength = queued_strength;
+	defer = 0;
+	PLAT_setRumble(strength);
+	rumble_calls += 1;
+	return MON_IDLE;
+}
+
+/**
+ * Advances the clock by duration_ms, running tasks as the monitor thread
+ * would, and returns the number of wakeups.
+ */
+static uint32_t simulate(uint32_t duration_ms) {
+	uint64_t end = now_ms + duration_ms;
+	uint32_t start = scheduler.wakeups;
+	while (1) {
+		int64_t timeout = MON_Scheduler_timeout(&scheduler, now_ms);
+		if (timeout < 0 || now_ms + timeout > end)
+			break;
+		now_ms += timeout;
+		MON_Scheduler_run(&scheduler, now_ms);
+	}
+	now_ms = end;
+	return scheduler.wakeups - start;
+}
+
+static uint32_t wakeupsPerMinute(const char* scenario) {
+	simulate(60000); // settle after the initial change
+	uint32_t wakeups = simulate(60000);
+	printf("monitor: %-28s %3u wakeups/min\n", scenario, wakeups);
+	return wakeups;
+}
+
+///////////////////////////////
+// Scheduler
+///////////////////////////////
+
+void test_MON_Scheduler_runs_task_when_due(void) {
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 500);
+
+	TEST_ASSERT_EQUAL_INT64(500, MON_Scheduler_timeout(&scheduler, now_ms));
+	TEST_ASSERT_EQUAL_INT(0, MON_Scheduler_run(&scheduler, now_ms + 499));
+	TEST_ASSERT_EQUAL_INT(1, MON_Scheduler_run(&scheduler, now_ms + 500));
+	TEST_ASSERT_EQUAL_INT(1, battery_reads);
+}
+
+void test_MON_Scheduler_idle_task_never_wakes(void) {
+	MON_Scheduler_add(&scheduler, vibrationTask, now_ms, MON_IDLE);
+
+	TEST_ASSERT_EQUAL_INT64(-1, MON_Scheduler_timeout(&scheduler, now_ms));
+	TEST_ASSERT_EQUAL_UINT32(0, simulate(60000));
+}
+
+void test_MON_Scheduler_wake_runs_immediately(void) {
+	int id = MON_Scheduler_add(&scheduler, batteryTask, now_ms, 30000);
+	MON_Scheduler_wake(&scheduler, id, now_ms);
+
+	TEST_ASSERT_EQUAL_INT64(0, MON_Scheduler_timeout(&scheduler, now_ms));
+}
+
+void test_MON_Scheduler_full(void) {
+	for (int i = 0; i < MON_MAX_TASKS; i++)
+		TEST_ASSERT_EQUAL_INT(i, MON_Scheduler_add(&scheduler, batteryTask, now_ms, 1000));
+	TEST_ASSERT_EQUAL_INT(-1, MON_Scheduler_add(&scheduler, batteryTask, now_ms, 1000));
+
+	MON_Scheduler_remove(&scheduler, 1);
+	TEST_ASSERT_EQUAL_INT(1, MON_Scheduler_add(&scheduler, batteryTask, now_ms, 1000));
+}
+
+void test_MON_Scheduler_suspend_holds_due_tasks(void) {
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 1000);
+	MON_Scheduler_setSuspended(&scheduler, 1);
+
+	TEST_ASSERT_EQUAL_UINT32(0, simulate(120000));
+	TEST_ASSERT_EQUAL_INT(0, battery_reads);
+
+	MON_Scheduler_setSuspended(&scheduler, 0);
+	TEST_ASSERT_EQUAL_INT64(0, MON_Scheduler_timeout(&scheduler, now_ms));
+}
+
+void test_MON_Scheduler_taken_task_waits_for_finish(void) {
+	int ids[MON_MAX_TASKS];
+	int id = MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+
+	TEST_ASSERT_EQUAL_INT(1, MON_Scheduler_takeDue(&scheduler, now_ms, ids));
+	TEST_ASSERT_EQUAL_INT(id, ids[0]);
+	TEST_ASSERT_EQUAL_INT64(-1, MON_Scheduler_timeout(&scheduler, now_ms));
+	TEST_ASSERT_EQUAL_INT(0, MON_Scheduler_takeDue(&scheduler, now_ms, ids));
+
+	MON_Scheduler_finish(&scheduler, id, batteryTask, now_ms, 500);
+	TEST_ASSERT_EQUAL_INT64(500, MON_Scheduler_timeout(&scheduler, now_ms));
+}
+
+void test_MON_Scheduler_finish_ignores_task_removed_while_running(void) {
+	int ids[MON_MAX_TASKS];
+	int id = MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+	MON_Scheduler_takeDue(&scheduler, now_ms, ids);
+
+	MON_Scheduler_remove(&scheduler, id);
+	TEST_ASSERT_EQUAL_INT(id, MON_Scheduler_add(&scheduler, vibrationTask, now_ms, MON_IDLE));
+	MON_Scheduler_finish(&scheduler, id, batteryTask, now_ms, 500);
+
+	TEST_ASSERT_EQUAL_INT64(-1, MON_Scheduler_timeout(&scheduler, now_ms));
+}
+
+///////////////////////////////
+// Battery policy
+///////////////////////////////
+
+void test_MON_batteryInterval_policy(void) {
+	TEST_ASSERT_EQUAL_UINT32(MON_BATTERY_LOW_MS, MON_batteryInterval(10, 0, 0, 1));
+	TEST_ASSERT_EQUAL_UINT32(MON_BATTERY_ACTIVE_MS, MON_batteryInterval(80, 1, 1, 1));
+	TEST_ASSERT_EQUAL_UINT32(MON_BATTERY_MENU_MS, MON_batteryInterval(80, 0, 0, 0));
+	TEST_ASSERT_EQUAL_UINT32(MON_BATTERY_GAME_MS, MON_batteryInterval(80, 0, 0, 1));
+	TEST_ASSERT_EQUAL_UINT32(MON_BATTERY_MENU_MS, MON_batteryInterval(10, 1, 0, 0));
+}
+
+///////////////////////////////
+// Wakeups per minute
+///////////////////////////////
+
+void test_wakeups_in_game_stable(void) {
+	in_game = 1;
+	mock_set_battery(80, 0);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+	MON_Scheduler_add(&scheduler, vibrationTask, now_ms, MON_IDLE);
+
+	// was 12 battery + ~3500 vibration wakeups with the fixed-rate threads
+	TEST_ASSERT_EQUAL_UINT32(2, wakeupsPerMinute("in game, stable"));
+}
+
+void test_wakeups_in_menu_stable(void) {
+	mock_set_battery(80, 0);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+
+	TEST_ASSERT_EQUAL_UINT32(6, wakeupsPerMinute("menu, stable"));
+}
+
+void test_wakeups_near_low_charge(void) {
+	in_game = 1;
+	mock_set_battery(15, 0);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+
+	TEST_ASSERT_EQUAL_UINT32(30, wakeupsPerMinute("in game, low charge"));
+}
+
+void test_wakeups_low_charge_while_charging(void) {
+	in_game = 1;
+	mock_set_battery(15, 1);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+
+	TEST_ASSERT_EQUAL_UINT32(2, wakeupsPerMinute("in game, charging"));
+}
+
+void test_wakeups_while_asleep(void) {
+	mock_set_battery(80, 0);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+	MON_Scheduler_add(&scheduler, vibrationTask, now_ms, MON_IDLE);
+	MON_Scheduler_setSuspended(&scheduler, 1);
+
+	TEST_ASSERT_EQUAL_UINT32(0, wakeupsPerMinute("asleep"));
+}
+
+void test_battery_change_polls_faster(void) {
+	in_game = 1;
+	mock_set_battery(80, 0);
+	MON_Scheduler_add(&scheduler, batteryTask, now_ms, 0);
+	simulate(60000);
+
+	mock_set_battery(80, 1); // charger plugged in
+	int reads = battery_reads;
+	simulate(MON_BATTERY_GAME_MS);
+	simulate(MON_BATTERY_ACTIVE_MS);
+
+	TEST_ASSERT_EQUAL_INT(2, battery_reads - reads);
+	TEST_ASSERT_EQUAL_INT(1, battery_charging);
+}
+
+void test_rumble_pulse_parks_after_stop(void) {
+	int id = MON_Scheduler_add(&scheduler, vibrationTask, now_ms, MON_IDLE);
+
+	queued_strength = 0xFFFF;
+	MON_Scheduler_wake(&scheduler, id, now_ms);
+	simulate(100);
+	queued_strength = 0;
+	MON_Scheduler_wake(&scheduler, id, now_ms);
+
+	// 3 deferred frames, then the stop, then nothing
+	TEST_ASSERT_EQUAL_UINT32(4, simulate(1000));
+	TEST_ASSERT_EQUAL_INT(2, rumble_calls);
+	TEST_ASSERT_EQUAL_INT(0, strength);
+	TEST_ASSERT_EQUAL_UINT32(0, simulate(60000));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_MON_Scheduler_runs_task_when_due);
+	RUN_TEST(test_MON_Scheduler_idle_task_never_wakes);
+	RUN_TEST(test_MON_Scheduler_wake_runs_immediately);
+	RUN_TEST(test_MON_Scheduler_full);
+	RUN_TEST(test_MON_Scheduler_suspend_holds_due_tasks);
+	RUN_TEST(test_MON_Scheduler_taken_task_waits_for_finish);
+	RUN_TEST(test_MON_Scheduler_finish_ignores_task_removed_while_running);
+
+	RUN_TEST(test_MON_batteryInterval_policy);
+
+	RUN_TEST(test_wakeups_in_game_stable);
+	RUN_TEST(test_wakeups_in_menu_stable);
+	RUN_TEST(test_wakeups_near_low_charge);
+	RUN_TEST(test_wakeups_low_charge_while_charging);
+	RUN_TEST(test_wakeups_while_asleep);
+	RUN_TEST(test_battery_change_polls_faster);
+	RUN_TEST(test_rumble_pulse_parks_after_stop);
+
+	return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/**
+ * test_option_list.c - Tests for option lookup and change tracking
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/option_list.h"
+
+#include <string.h>
+
+static char* values[] = {"disabled", "enabled", "auto", NULL};
+
+static Option options[3];
+static OptionList list;
+
+void setUp(void) {
+	memset(options, 0, sizeof(options));
+	options[0].key = "core_frameskip";
+	options[1].key = "core_palette";
+	options[2].key = "core_region";
+	for (int i = 0; i < 3; i++) {
+		options[i].values = values;
+		options[i].labels = values;
+		options[i].count = 3;
+	}
+
+	memset(&list, 0, sizeof(list));
+	list.options = options;
+	list.count = 3;
+}
+
+void tearDown(void) {
+	KeyIndex_free(&list.index);
+}
+
+/**
+ * Sets an option the way minarch does, flagging it if it changed.
+ */
+static void setValue(const char* key, const char* value) {
+	Option* item = OptionList_getOption(&list, key);
+	TEST_ASSERT_NOT_NULL(item);
+	int old_value = item->value;
+	Option_setValue(item, value);
+	OptionList_markChanged(&list, item, old_value);
+}
+
+///////////////////////////////
+// Lookup
+///////////////////////////////
+
+void test_Option_setValue_falls_back_to_first_value(void) {
+	Option_setValue(&options[0], "auto");
+	TEST_ASSERT_EQUAL_INT(2, options[0].value);
+
+	Option_setValue(&options[0], "bogus");
+	TEST_ASSERT_EQUAL_INT(0, options[0].value);
+
+	options[0].value = 1;
+	Option_setValue(&options[0], NULL);
+	TEST_ASSERT_EQUAL_INT(0, options[0].value);
+}
+
+void test_OptionList_getOption_scans_or_uses_index(void) {
+	TEST_ASSERT_EQUAL_PTR(&options[1], OptionList_getOption(&list, "core_palette"));
+	TEST_ASSERT_NULL(OptionList_getOption(&list, "core_missing"));
+
+	TEST_ASSERT_EQUAL_INT(0, KeyIndex_init(&list.index, list.count));
+	for (int i = 0; i < list.count; i++)
+		KeyIndex_add(&list.index, options[i].key, i);
+	TEST_ASSERT_EQUAL_PTR(&options[2], OptionList_getOption(&list, "core_region"));
+	TEST_ASSERT_NULL(OptionList_getOption(&list, "core_missing"));
+}
+
+///////////////////////////////
+// Change tracking
+///////////////////////////////
+
+void test_OptionList_markChanged_flags_changed_option(void) {
+	setValue("core_palette", "enabled");
+
+	TEST_ASSERT_TRUE(options[1].dirty);
+	TEST_ASSERT_TRUE(list.changed);
+	TEST_ASSERT_FALSE(options[0].dirty);
+	TEST_ASSERT_FALSE(options[2].dirty);
+}
+
+void test_OptionList_markChanged_ignores_same_value(void) {
+	setValue("core_palette", "disabled");
+
+	TEST_ASSERT_FALSE(options[1].dirty);
+	TEST_ASSERT_FALSE(list.changed);
+
+	setValue("core_palette", "enabled");
+	list.changed = 0;
+	OptionList_readValue(&list, "core_palette");
+	setValue("core_palette", "enabled");
+
+	TEST_ASSERT_FALSE(options[1].dirty);
+	TEST_ASSERT_FALSE(list.changed);
+}
+
+void test_OptionList_readValue_clears_dirty_bit(void) {
+	setValue("core_palette", "auto");
+	setValue("core_region", "enabled");
+
+	TEST_ASSERT_EQUAL_STRING("auto", OptionList_readValue(&list, "core_palette"));
+	TEST_ASSERT_FALSE(options[1].dirty);
+	// only the option that was read
+	TEST_ASSERT_TRUE(options[2].dirty);
+
+	// a later change flags it again
+	setValue("core_palette", "enabled");
+	TEST_ASSERT_TRUE(options[1].dirty);
+}
+
+void test_OptionList_readValue_returns_null_for_unknown_key(void) {
+	TEST_ASSERT_NULL(OptionList_readValue(&list, "core_missing"));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_Option_setValue_falls_back_to_first_value);
+	RUN_TEST(test_OptionList_getOption_scans_or_uses_index);
+
+	RUN_TEST(test_OptionList_markChanged_flags_changed_option);
+	RUN_TEST(test_OptionList_markChanged_ignores_same_value);
+	RUN_TEST(test_OptionList_readValue_clears_dirty_bit);
+	RUN_TEST(test_OptionList_readValue_returns_null_for_unknown_key);
+
+	return UNITY_END();
+}
@@ -0,0 +1,230 @@
+/**
+ * test_preview_cache.c - Tests for the background save state preview cache
+ *
+ * Uses real temp files written and read by the running worker thread.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/preview_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SLOTS 6
+#define WIDTH 32
+#define HEIGHT 24
+
+static PreviewCache cache;
+static char paths[SLOTS][64];
+static uint16_t pixels[HEIGHT][WIDTH];
+
+static void fillPixels(uint16_t value) {
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
+			pixels[y][x] = value + y * WIDTH + x;
+}
+
+static void writePreview(int slot, uint16_t value) {
+	BootFrame frame = {0};
+	fillPixels(value);
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_capture(&frame, pixels, WIDTH, HEIGHT, sizeof(pixels[0])));
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_save(&frame, paths[slot]));
+	BootFrame_free(&frame);
+}
+
+/**
+ * Requests a preview until it's loaded or known missing.
+ */
+static int waitFor(int slot, const BootFrame** frame) {
+	int state;
+	while ((state = PreviewCache_request(&cache, paths[slot], frame)) == PREVIEW_LOADING ||
+	       state == PREVIEW_NONE)
+		PreviewCache_flush(&cache);
+	return state;
+}
+
+void setUp(void) {
+	for (int i = 0; i < SLOTS; i++) {
+		sprintf(paths[i], "/tmp/preview_XXXXXX");
+		int fd = mkstemp(paths[i]);
+		TEST_ASSERT_TRUE(fd >= 0);
+		close(fd);
+		unlink(paths[i]);
+	}
+	TEST_ASSERT_EQUAL_INT(0, PreviewCache_start(&cache));
+}
+
+void tearDown(void) {
+	PreviewCache_stop(&cache);
+	for (int i = 0; i < SLOTS; i++)
+		unlink(paths[i]);
+}
+
+///////////////////////////////
+// Loading
+///////////////////////////////
+
+void test_request_loads_in_background(void) {
+	writePreview(0, 100);
+
+	const BootFrame* frame = NULL;
+	TEST_ASSERT_EQUAL_INT(PREVIEW_LOADING, PreviewCache_request(&cache, paths[0], &frame));
+	TEST_ASSERT_NULL(frame);
+
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, waitFor(0, &frame));
+	TEST_ASSERT_NOT_NULL(frame);
+	TEST_ASSERT_EQUAL_INT(WIDTH, frame->width);
+	TEST_ASSERT_EQUAL_INT(HEIGHT, frame->height);
+	TEST_ASSERT_EQUAL_UINT16(100 + WIDTH + 1, frame->pixels[WIDTH + 1]);
+}
+
+void test_missing_preview_is_remembered(void) {
+	TEST_ASSERT_EQUAL_INT(PREVIEW_MISSING, waitFor(1, NULL));
+	TEST_ASSERT_EQUAL_INT(PREVIEW_MISSING, PreviewCache_request(&cache, paths[1], NULL));
+}
+
+void test_invalid_preview_is_missing(void) {
+	FILE* file = fopen(paths[2], "w");
+	fputs("BM not a preview", file);
+	fclose(file);
+
+	TEST_ASSERT_EQUAL_INT(PREVIEW_MISSING, waitFor(2, NULL));
+}
+
+void test_cached_preview_isnt_reloaded(void) {
+	writePreview(0, 1);
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, waitFor(0, NULL));
+
+	// a different file on disk goes unnoticed while cached
+	writePreview(0, 2);
+	const BootFrame* frame = NULL;
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[0], &frame));
+	TEST_ASSERT_EQUAL_UINT16(1, frame->pixels[0]);
+}
+
+void test_least_recently_used_is_evicted(void) {
+	for (int i = 0; i < SLOTS; i++) {
+		writePreview(i, (uint16_t)i);
+		TEST_ASSERT_EQUAL_INT(PREVIEW_READY, waitFor(i, NULL));
+		PreviewCache_request(&cache, paths[0], NULL); // keep slot 0 hot
+	}
+
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[0], NULL));
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[SLOTS - 1], NULL));
+	TEST_ASSERT_EQUAL_INT(PREVIEW_LOADING, PreviewCache_request(&cache, paths[1], NULL));
+}
+
+void test_full_queue_retries_later(void) {
+	int states[SLOTS];
+	for (int i = 0; i < SLOTS; i++)
+		states[i] = PreviewCache_request(&cache, paths[i], NULL);
+
+	// more misses than queue slots, the extra ones are retried on the next request
+	int queued = 0;
+	for (int i = 0; i < SLOTS; i++)
+		queued += states[i] == PREVIEW_LOADING;
+	TEST_ASSERT_TRUE(queued >= 1 && queued <= IMAGE_QUEUE_SIZE);
+	TEST_ASSERT_EQUAL_INT(PREVIEW_MISSING, waitFor(SLOTS - 1, NULL));
+}
+
+///////////////////////////////
+// Saving
+///////////////////////////////
+
+void test_save_is_cached_immediately_and_written(void) {
+	fillPixels(500);
+	TEST_ASSERT_EQUAL_INT(0, PreviewCache_save(&cache, paths[3], pixels, WIDTH, HEIGHT,
+	                                           sizeof(pixels[0])));
+
+	const BootFrame* frame = NULL;
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[3], &frame));
+	TEST_ASSERT_EQUAL_UINT16(500, frame->pixels[0]);
+
+	PreviewCache_flush(&cache);
+	BootFrame saved = {0};
+	TEST_ASSERT_EQUAL_INT(0, BootFrame_load(&saved, paths[3]));
+	TEST_ASSERT_EQUAL_UINT16(500 + WIDTH * HEIGHT - 1, saved.pixels[WIDTH * HEIGHT - 1]);
+	BootFrame_free(&saved);
+	TEST_ASSERT_EQUAL_INT(1, cache.saves);
+}
+
+void test_save_copies_padded_rows(void) {
+	// only the first WIDTH / 2 pixels of each row belong to the preview
+	fillPixels(0);
+	PreviewCache_save(&cache, paths[3], pixels, WIDTH / 2, HEIGHT, sizeof(pixels[0]));
+
+	const BootFrame* frame = NULL;
+	PreviewCache_request(&cache, paths[3], &frame);
+	TEST_ASSERT_EQUAL_INT(WIDTH / 2, frame->width);
+	TEST_ASSERT_EQUAL_UINT16(WIDTH, frame->pixels[WIDTH / 2]);
+}
+
+void test_save_replaces_pending_load(void) {
+	writePreview(4, 7);
+	TEST_ASSERT_EQUAL_INT(PREVIEW_LOADING, PreviewCache_request(&cache, paths[4], NULL));
+
+	fillPixels(900);
+	PreviewCache_save(&cache, paths[4], pixels, WIDTH, HEIGHT, sizeof(pixels[0]));
+	PreviewCache_flush(&cache);
+
+	const BootFrame* frame = NULL;
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[4], &frame));
+	TEST_ASSERT_EQUAL_UINT16(900, frame->pixels[0]);
+}
+
+void test_save_over_missing_preview(void) {
+	TEST_ASSERT_EQUAL_INT(PREVIEW_MISSING, waitFor(5, NULL));
+
+	fillPixels(42);
+	PreviewCache_save(&cache, paths[5], pixels, WIDTH, HEIGHT, sizeof(pixels[0]));
+	TEST_ASSERT_EQUAL_INT(PREVIEW_READY, PreviewCache_request(&cache, paths[5], NULL));
+}
+
+void test_stop_finishes_queued_saves(void) {
+	fillPixels(0);
+	for (int i = 0; i < SLOTS; i++)
+		PreviewCache_save(&cache, paths[i], pixels, WIDTH, HEIGHT, sizeof(pixels[0]));
+	PreviewCache_stop(&cache);
+
+	for (int i = 0; i < SLOTS; i++)
+		TEST_ASSERT_EQUAL_INT(0, access(paths[i], F_OK));
+	TEST_ASSERT_EQUAL_INT(0, cache.running);
+}
+
+void test_not_started_does_nothing(void) {
+	PreviewCache_stop(&cache);
+
+	const BootFrame* frame = (const BootFrame*)1;
+	TEST_ASSERT_EQUAL_INT(PREVIEW_NONE, PreviewCache_request(&cache, paths[0], &frame));
+	TEST_ASSERT_NULL(frame);
+	TEST_ASSERT_EQUAL_INT(-1, PreviewCache_save(&cache, paths[0], pixels, WIDTH, HEIGHT,
+	                                            sizeof(pixels[0])));
+	PreviewCache_flush(&cache);
+	PreviewCache_stop(&cache);
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_request_loads_in_background);
+	RUN_TEST(test_missing_preview_is_remembered);
+	RUN_TEST(test_invalid_preview_is_missing);
+	RUN_TEST(test_cached_preview_isnt_reloaded);
+	RUN_TEST(test_least_recently_used_is_evicted);
+	RUN_TEST(test_full_queue_retries_later);
+
+	RUN_TEST(test_save_is_cached_immediately_and_written);
+	RUN_TEST(test_save_copies_padded_rows);
+	RUN_TEST(test_save_replaces_pending_load);
+	RUN_TEST(test_save_over_missing_preview);
+	RUN_TEST(test_stop_finishes_queued_saves);
+	RUN_TEST(test_not_started_does_nothing);
+
+	return UNITY_END();
+}
@@ -0,0 +1,211 @@
+/**
+ * test_settings_sync.c - Tests for the shared settings seqlock
+ *
+ * Uses an anonymous MAP_SHARED mapping and fork() so writers and readers
+ * really are separate processes, like keymon and minarch sharing
+ * /SharedSettings.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/settings_sync.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct {
+	int speaker;
+	int headphones;
+	int jack;
+} TestSettings;
+
+typedef struct {
+	TestSettings settings;
+	SettingsSync sync;
+} TestShared;
+
+static TestShared* shared;
+
+void setUp(void) {
+	shared = mmap(NULL, sizeof(TestShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+	              -1, 0);
+	TEST_ASSERT_TRUE(shared != MAP_FAILED);
+	memset(shared, 0, sizeof(TestShared));
+}
+
+void tearDown(void) {
+	munmap(shared, sizeof(TestShared));
+}
+
+static void writeSettings(int value) {
+	SettingsSync_beginWrite(&shared->sync);
+	shared->settings.speaker = value;
+	shared->settings.headphones = value;
+	shared->settings.jack = value;
+	SettingsSync_endWrite(&shared->sync);
+}
+
+static void waitChild(pid_t pid) {
+	int status = 0;
+	TEST_ASSERT_EQUAL_INT(pid, waitpid(pid, &status, 0));
+	TEST_ASSERT_TRUE(WIFEXITED(status));
+	TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+}
+
+///////////////////////////////
+// Seqlock
+///////////////////////////////
+
+void test_SettingsSync_read_copies_settings(void) {
+	writeSettings(7);
+
+	TestSettings copy;
+	SettingsSync_read(&shared->sync, &copy, &shared->settings, sizeof(copy));
+
+	TEST_ASSERT_EQUAL_INT(7, copy.speaker);
+	TEST_ASSERT_EQUAL_INT(7, copy.jack);
+}
+
+void test_SettingsSync_write_leaves_sequence_even(void) {
+	writeSettings(1);
+	writeSettings(2);
+
+	TEST_ASSERT_EQUAL_UINT32(4, shared->sync.sequence);
+}
+
+void test_SettingsSync_readers_never_see_torn_updates(void) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		for (int i = 1; i <= 20000; i++)
+			writeSettings(i);
+		_exit(0);
+	}
+
+	int torn = 0;
+	for (int i = 0; i < 20000; i++) {
+		TestSettings copy;
+		SettingsSync_read(&shared->sync, &copy, &shared->settings, sizeof(copy));
+		if (copy.speaker != copy.headphones || copy.speaker != copy.jack)
+			torn += 1;
+	}
+	waitChild(pid);
+
+	TEST_ASSERT_EQUAL_INT(0, torn);
+}
+
+void test_SettingsSync_serializes_writers(void) {
+	pid_t pids[2];
+	for (int i = 0; i < 2; i++) {
+		pids[i] = fork();
+		if (pids[i] == 0) {
+			for (int n = 0; n < 10000; n++) {
+				SettingsSync_beginWrite(&shared->sync);
+				shared->settings.speaker += 1; // not atomic on its own
+				SettingsSync_endWrite(&shared->sync);
+			}
+			_exit(0);
+		}
+	}
+	waitChild(pids[0]);
+	waitChild(pids[1]);
+
+	TEST_ASSERT_EQUAL_INT(20000, shared->settings.speaker);
+	TEST_ASSERT_EQUAL_UINT32(20000, SettingsSync_getGeneration(&shared->sync));
+}
+
+void test_SettingsSync_recovers_from_dead_writer(void) {
+	writeSettings(3);
+	shared->sync.sequence += 1; // writer died mid-update
+
+	TestSettings copy;
+	SettingsSync_read(&shared->sync, &copy, &shared->settings, sizeof(copy));
+	TEST_ASSERT_EQUAL_INT(3, copy.speaker);
+
+	writeSettings(4);
+	TEST_ASSERT_EQUAL_UINT32(0, shared->sync.sequence & 1);
+	TEST_ASSERT_EQUAL_INT(4, shared->settings.speaker);
+}
+
+void test_SettingsSync_takes_over_from_exited_writer(void) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		SettingsSync_beginWrite(&shared->sync);
+		_exit(0); // dies holding the lock
+	}
+	waitChild(pid);
+	TEST_ASSERT_EQUAL_INT(pid, shared->sync.owner);
+
+	writeSettings(5);
+	TEST_ASSERT_EQUAL_INT(0, shared->sync.owner);
+	TEST_ASSERT_EQUAL_UINT32(0, shared->sync.sequence & 1);
+	TEST_ASSERT_EQUAL_INT(5, shared->settings.jack);
+}
+
+void test_SettingsSync_waits_for_stopped_writer(void) {
+	pid_t stopped = fork();
+	if (stopped == 0) {
+		SettingsSync_beginWrite(&shared->sync);
+		shared->settings.speaker = 1;
+		raise(SIGSTOP); // like keymon stopped for sleep mid-update
+		shared->settings.headphones = 1;
+		shared->settings.jack = 1;
+		SettingsSync_endWrite(&shared->sync);
+		_exit(0);
+	}
+	int status = 0;
+	TEST_ASSERT_EQUAL_INT(stopped, waitpid(stopped, &status, WUNTRACED));
+	TEST_ASSERT_TRUE(WIFSTOPPED(status));
+
+	pid_t waiting = fork();
+	if (waiting == 0) {
+		writeSettings(2);
+		_exit(0);
+	}
+
+	// well past SETTINGS_SYNC_MAX_SPINS, which readers give up after
+	usleep(100000);
+	int overtook = shared->settings.jack == 2;
+	kill(stopped, SIGCONT);
+	waitChild(stopped);
+	waitChild(waiting);
+
+	TEST_ASSERT_FALSE(overtook);
+	TEST_ASSERT_EQUAL_INT(2, shared->settings.speaker);
+	TEST_ASSERT_EQUAL_INT(2, shared->settings.jack);
+	TEST_ASSERT_EQUAL_UINT32(4, shared->sync.sequence);
+}
+
+///////////////////////////////
+// Change notification
+///////////////////////////////
+
+void test_SettingsSync_generation_counts_updates(void) {
+	uint32_t before = SettingsSync_getGeneration(&shared->sync);
+	writeSettings(1);
+	writeSettings(2);
+
+	TEST_ASSERT_EQUAL_UINT32(before + 2, SettingsSync_getGeneration(&shared->sync));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_SettingsSync_read_copies_settings);
+	RUN_TEST(test_SettingsSync_write_leaves_sequence_even);
+	RUN_TEST(test_SettingsSync_readers_never_see_torn_updates);
+	RUN_TEST(test_SettingsSync_serializes_writers);
+	RUN_TEST(test_SettingsSync_recovers_from_dead_writer);
+	RUN_TEST(test_SettingsSync_takes_over_from_exited_writer);
+	RUN_TEST(test_SettingsSync_waits_for_stopped_writer);
+
+	RUN_TEST(test_SettingsSync_generation_counts_updates);
+
+	return UNITY_END();
+}
@@ -0,0 +1,236 @@
+/**
+ * test_sram_flusher.c - Tests for the background save RAM writer
+ *
+ * Writes real temp files through a running writer thread.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/sram_flusher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char sav_path[64];
+static char tmp_path[72];
+static SramFlusher flusher;
+static uint8_t sram[8192];
+
+static size_t readSave(uint8_t* buffer, size_t size) {
+	FILE* file = fopen(sav_path, "r");
+	if (!file)
+		return 0;
+	size_t count = fread(buffer, 1, size, file);
+	fclose(file);
+	return count;
+}
+
+void setUp(void) {
+	strcpy(sav_path, "/tmp/sram_XXXXXX");
+	int fd = mkstemp(sav_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+	unlink(sav_path);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", sav_path);
+
+	memset(&flusher, 0, sizeof(flusher));
+	for (size_t i = 0; i < sizeof(sram); i++)
+		sram[i] = (uint8_t)(i * 7);
+}
+
+void tearDown(void) {
+	SramFlusher_stop(&flusher);
+	unlink(sav_path);
+	unlink(tmp_path);
+}
+
+///////////////////////////////
+// Hash
+///////////////////////////////
+
+void test_hash_is_stable(void) {
+	TEST_ASSERT_TRUE(SramFlusher_hash(sram, sizeof(sram)) == SramFlusher_hash(sram, sizeof(sram)));
+}
+
+void test_hash_detects_any_single_byte_change(void) {
+	uint64_t base = SramFlusher_hash(sram, sizeof(sram));
+	for (size_t i = 0; i < sizeof(sram); i += 61) {
+		sram[i] ^= 1;
+		TEST_ASSERT_TRUE(SramFlusher_hash(sram, sizeof(sram)) != base);
+		sram[i] ^= 1;
+	}
+}
+
+void test_hash_covers_unaligned_tail(void) {
+	// 8195 bytes: the last three fall outside the 16 byte blocks
+	uint8_t buffer[8195] = {0};
+	uint64_t base = SramFlusher_hash(buffer, sizeof(buffer));
+	buffer[sizeof(buffer) - 1] = 1;
+	TEST_ASSERT_TRUE(SramFlusher_hash(buffer, sizeof(buffer)) != base);
+}
+
+void test_hash_depends_on_size(void) {
+	uint8_t zeros[32] = {0};
+	TEST_ASSERT_TRUE(SramFlusher_hash(zeros, 16) != SramFlusher_hash(zeros, 32));
+}
+
+///////////////////////////////
+// Atomic writes
+///////////////////////////////
+
+void test_writeFile_replaces_contents_without_leftovers(void) {
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_writeFile(sav_path, "old save", 8));
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_writeFile(sav_path, sram, sizeof(sram)));
+
+	static uint8_t saved[sizeof(sram) + 1];
+	TEST_ASSERT_EQUAL_INT(sizeof(sram), readSave(saved, sizeof(saved)));
+	TEST_ASSERT_EQUAL_MEMORY(sram, saved, sizeof(sram));
+	TEST_ASSERT_NOT_EQUAL(0, access(tmp_path, F_OK));
+}
+
+void test_writeFile_fails_for_missing_directory(void) {
+	TEST_ASSERT_EQUAL_INT(-1, SramFlusher_writeFile("/tmp/sram_missing_dir/game.sav", sram, 16));
+}
+
+///////////////////////////////
+// Flusher
+///////////////////////////////
+
+void test_unchanged_baseline_is_not_written(void) {
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_start(&flusher, sav_path, 1000));
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 5000));
+	SramFlusher_flush(&flusher);
+	TEST_ASSERT_EQUAL_INT(0, flusher.writes);
+	TEST_ASSERT_NOT_EQUAL(0, access(sav_path, F_OK));
+}
+
+void test_change_is_written_in_background(void) {
+	SramFlusher_start(&flusher, sav_path, 1000);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	sram[100] = 0xAA;
+	TEST_ASSERT_EQUAL_INT(1, SramFlusher_poll(&flusher, sram, sizeof(sram), 5000));
+	sram[200] = 0xBB; // after the copy, must not reach this write
+	SramFlusher_flush(&flusher);
+
+	static uint8_t saved[sizeof(sram)];
+	TEST_ASSERT_EQUAL_INT(sizeof(sram), readSave(saved, sizeof(saved)));
+	TEST_ASSERT_EQUAL_HEX8(0xAA, saved[100]);
+	TEST_ASSERT_EQUAL_HEX8((uint8_t)(200 * 7), saved[200]);
+	TEST_ASSERT_EQUAL_INT(1, flusher.writes);
+}
+
+void test_poll_respects_interval(void) {
+	SramFlusher_start(&flusher, sav_path, 1000);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 5000));
+	sram[0] ^= 1;
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 5999));
+	TEST_ASSERT_EQUAL_INT(1, SramFlusher_poll(&flusher, sram, sizeof(sram), 6000));
+}
+
+void test_same_change_is_written_once(void) {
+	SramFlusher_start(&flusher, sav_path, 0);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	sram[1] ^= 1;
+	TEST_ASSERT_EQUAL_INT(1, SramFlusher_poll(&flusher, sram, sizeof(sram), 1));
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 2));
+	SramFlusher_flush(&flusher);
+	TEST_ASSERT_EQUAL_INT(1, flusher.writes);
+}
+
+void test_latest_copy_wins(void) {
+	SramFlusher_start(&flusher, sav_path, 0);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	for (int i = 1; i <= 20; i++) {
+		sram[0] = (uint8_t)i;
+		SramFlusher_poll(&flusher, sram, sizeof(sram), i);
+	}
+	SramFlusher_flush(&flusher);
+
+	uint8_t saved[1];
+	TEST_ASSERT_EQUAL_INT(1, readSave(saved, sizeof(saved)));
+	TEST_ASSERT_EQUAL_UINT8(20, saved[0]);
+	TEST_ASSERT_EQUAL_INT(0, flusher.errors);
+}
+
+void test_stop_finishes_queued_write(void) {
+	SramFlusher_start(&flusher, sav_path, 0);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	sram[0] ^= 1;
+	SramFlusher_poll(&flusher, sram, sizeof(sram), 1);
+	SramFlusher_stop(&flusher);
+
+	uint8_t saved[1];
+	TEST_ASSERT_EQUAL_INT(1, readSave(saved, sizeof(saved)));
+	TEST_ASSERT_EQUAL_UINT8(sram[0], saved[0]);
+	TEST_ASSERT_EQUAL_INT(0, flusher.running);
+}
+
+void test_failed_write_is_retried(void) {
+	char dir_path[64] = "/tmp/sram_dir_XXXXXX";
+	TEST_ASSERT_NOT_NULL(mkdtemp(dir_path));
+	rmdir(dir_path);
+	char path[80];
+	snprintf(path, sizeof(path), "%s/game.sav", dir_path);
+
+	SramFlusher_start(&flusher, path, 1000);
+	SramFlusher_setBaseline(&flusher, sram, sizeof(sram));
+
+	sram[0] ^= 1;
+	TEST_ASSERT_EQUAL_INT(1, SramFlusher_poll(&flusher, sram, sizeof(sram), 5000));
+	SramFlusher_flush(&flusher);
+	TEST_ASSERT_EQUAL_INT(1, flusher.errors);
+
+	TEST_ASSERT_EQUAL_INT(0, mkdir(dir_path, 0755));
+	TEST_ASSERT_EQUAL_INT(1, SramFlusher_poll(&flusher, sram, sizeof(sram), 6000));
+	SramFlusher_flush(&flusher);
+	TEST_ASSERT_EQUAL_INT(1, flusher.writes);
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 7000));
+
+	SramFlusher_stop(&flusher);
+	unlink(path);
+	rmdir(dir_path);
+}
+
+void test_not_started_does_nothing(void) {
+	TEST_ASSERT_EQUAL_INT(0, SramFlusher_poll(&flusher, sram, sizeof(sram), 5000));
+	SramFlusher_flush(&flusher);
+	SramFlusher_stop(&flusher);
+	TEST_ASSERT_NOT_EQUAL(0, access(sav_path, F_OK));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_hash_is_stable);
+	RUN_TEST(test_hash_detects_any_single_byte_change);
+	RUN_TEST(test_hash_covers_unaligned_tail);
+	RUN_TEST(test_hash_depends_on_size);
+
+	RUN_TEST(test_writeFile_replaces_contents_without_leftovers);
+	RUN_TEST(test_writeFile_fails_for_missing_directory);
+
+	RUN_TEST(test_unchanged_baseline_is_not_written);
+	RUN_TEST(test_change_is_written_in_background);
+	RUN_TEST(test_poll_respects_interval);
+	RUN_TEST(test_same_change_is_written_once);
+	RUN_TEST(test_latest_copy_wins);
+	RUN_TEST(test_stop_finishes_queued_write);
+	RUN_TEST(test_failed_write_is_retried);
+	RUN_TEST(test_not_started_does_nothing);
+
+	return UNITY_END();
+}
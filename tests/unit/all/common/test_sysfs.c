@@ -0,0 +1,193 @@
+/**
+ * test_sysfs.c - Tests for the persistent-fd sysfs reader
+ *
+ * Uses regular files in a temp directory as stand-in attributes. Rewriting
+ * a file in place is visible through the already open descriptor, just
+ * like a sysfs attribute changing value.
+ */
+
+#include "../../../support/unity/unity.h"
+#include "../../../../workspace/all/common/sysfs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_dir[64];
+static char attr_path[128];
+
+static void writeAttr(const char* text) {
+	FILE* file = fopen(attr_path, "w");
+	TEST_ASSERT_NOT_NULL(file);
+	fputs(text, file);
+	fclose(file);
+}
+
+void setUp(void) {
+	strcpy(temp_dir, "/tmp/sysfstest_XXXXXX");
+	TEST_ASSERT_NOT_NULL(mkdtemp(temp_dir));
+	sprintf(attr_path, "%s/capacity", temp_dir);
+}
+
+void tearDown(void) {
+	unlink(attr_path);
+	rmdir(temp_dir);
+}
+
+///////////////////////////////
+// Reading
+///////////////////////////////
+
+void test_SysfsValue_getInt_reads_value(void) {
+	writeAttr("87\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+
+	TEST_ASSERT_EQUAL_INT(87, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+void test_SysfsValue_getString_strips_newline(void) {
+	writeAttr("up\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+
+	TEST_ASSERT_EQUAL_STRING("up", SysfsValue_getString(&value));
+
+	SysfsValue_close(&value);
+}
+
+void test_SysfsValue_missing_file_reads_as_zero(void) {
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_getInt(&value));
+	TEST_ASSERT_EQUAL_STRING("", SysfsValue_getString(&value));
+}
+
+void test_SysfsValue_keeps_descriptor_open(void) {
+	writeAttr("1\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+
+	SysfsValue_getInt(&value);
+	int fd = value.fd;
+	SysfsValue_getInt(&value);
+
+	TEST_ASSERT_TRUE(fd >= 0);
+	TEST_ASSERT_EQUAL_INT(fd, value.fd);
+
+	SysfsValue_close(&value);
+	TEST_ASSERT_EQUAL_INT(-1, value.fd);
+}
+
+void test_SysfsValue_sees_updates_through_open_descriptor(void) {
+	writeAttr("1\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+	TEST_ASSERT_EQUAL_INT(1, SysfsValue_getInt(&value));
+
+	writeAttr("0\n");
+
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+void test_SysfsValue_opens_file_created_later(void) {
+	SysfsValue value = SYSFS_VALUE(attr_path, 0);
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_getInt(&value));
+
+	writeAttr("42\n");
+
+	TEST_ASSERT_EQUAL_INT(42, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+///////////////////////////////
+// Rate limiting
+///////////////////////////////
+
+void test_SysfsValue_caches_within_interval(void) {
+	writeAttr("50\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 60000);
+	TEST_ASSERT_EQUAL_INT(50, SysfsValue_getInt(&value));
+
+	writeAttr("40\n");
+
+	TEST_ASSERT_EQUAL_INT(50, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+void test_SysfsValue_invalidate_forces_refresh(void) {
+	writeAttr("50\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 60000);
+	SysfsValue_getInt(&value);
+
+	writeAttr("40\n");
+	SysfsValue_invalidate(&value);
+
+	TEST_ASSERT_EQUAL_INT(40, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+void test_SysfsValue_refreshes_after_interval(void) {
+	writeAttr("50\n");
+	SysfsValue value = SYSFS_VALUE(attr_path, 5);
+	SysfsValue_getInt(&value);
+
+	writeAttr("40\n");
+	usleep(20000);
+
+	TEST_ASSERT_EQUAL_INT(40, SysfsValue_getInt(&value));
+
+	SysfsValue_close(&value);
+}
+
+///////////////////////////////
+// Integer parsing
+///////////////////////////////
+
+void test_SysfsValue_parseInt_decimal(void) {
+	TEST_ASSERT_EQUAL_INT(100, SysfsValue_parseInt("100\n"));
+	TEST_ASSERT_EQUAL_INT(-15, SysfsValue_parseInt("  -15"));
+	TEST_ASSERT_EQUAL_INT(7, SysfsValue_parseInt("+7"));
+}
+
+void test_SysfsValue_parseInt_hex_and_octal(void) {
+	TEST_ASSERT_EQUAL_INT(0xFF, SysfsValue_parseInt("0xff"));
+	TEST_ASSERT_EQUAL_INT(8, SysfsValue_parseInt("010"));
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_parseInt("0"));
+}
+
+void test_SysfsValue_parseInt_stops_at_non_digit(void) {
+	TEST_ASSERT_EQUAL_INT(3970, SysfsValue_parseInt("3970 mV"));
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_parseInt("connected"));
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_parseInt(""));
+	TEST_ASSERT_EQUAL_INT(0, SysfsValue_parseInt(NULL));
+}
+
+///////////////////////////////
+// Test Runner
+///////////////////////////////
+
+int main(void) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_SysfsValue_getInt_reads_value);
+	RUN_TEST(test_SysfsValue_getString_strips_newline);
+	RUN_TEST(test_SysfsValue_missing_file_reads_as_zero);
+	RUN_TEST(test_SysfsValue_keeps_descriptor_open);
+	RUN_TEST(test_SysfsValue_sees_updates_through_open_descriptor);
+	RUN_TEST(test_SysfsValue_opens_file_created_later);
+
+	RUN_TEST(test_SysfsValue_caches_within_interval);
+	RUN_TEST(test_SysfsValue_invalidate_forces_refresh);
+	RUN_TEST(test_SysfsValue_refreshes_after_interval);
+
+	RUN_TEST(test_SysfsValue_parseInt_decimal);
+	RUN_TEST(test_SysfsValue_parseInt_hex_and_octal);
+	RUN_TEST(test_SysfsValue_parseInt_stops_at_non_digit);
+
+	return UNITY_END();
+}
@@ -4,15 +4,28 @@
 #include "../../../../workspace/all/common/utils.h"
 #include "../../../support/unity/unity.h"
 #include "../../../support/platform.h"
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+static pid_t child; // Renamed child of the signalProcess tests, 0 if none
+
 // Unity requires these
 void setUp(void) {}
-void tearDown(void) {}
+void tearDown(void) {
+	// a failed assertion would otherwise leave the child in pause()
+	if (child > 0) {
+		kill(child, SIGKILL);
+		waitpid(child, NULL, 0);
+		child = 0;
+	}
+}
 
 ///////////////////////////////
 // Timing Tests
@@ -344,6 +357,127 @@ void test_allocFile_nonexistent(void) {
 	TEST_ASSERT_NULL(content);
 }
 
+void test_mkdirs_creates_parents(void) {
+	char base[] = "/tmp/test_mkdirs_XXXXXX";
+	TEST_ASSERT_NOT_NULL(mkdtemp(base));
+	char path[128];
+	sprintf(path, "%s/a/b/c", base);
+
+	TEST_ASSERT_EQUAL_INT(0, mkdirs(path));
+
+	struct stat st;
+	TEST_ASSERT_EQUAL_INT(0, stat(path, &st));
+	TEST_ASSERT_TRUE(S_ISDIR(st.st_mode));
+
+	rmdir(path);
+	sprintf(path, "%s/a/b", base);
+	rmdir(path);
+	sprintf(path, "%s/a", base);
+	rmdir(path);
+	rmdir(base);
+}
+
+void test_mkdirs_existing_directory_succeeds(void) {
+	TEST_ASSERT_EQUAL_INT(0, mkdirs("/tmp"));
+	TEST_ASSERT_EQUAL_INT(0, mkdirs("/tmp/"));
+}
+
+void test_mkdirs_fails_through_file(void) {
+	const char* path = "/tmp/test_mkdirs_file.txt";
+	touch((char*)path);
+
+	TEST_ASSERT_EQUAL_INT(-1, mkdirs(path));
+	TEST_ASSERT_EQUAL_INT(-1, mkdirs("/tmp/test_mkdirs_file.txt/sub"));
+
+	unlink(path);
+}
+
+///////////////////////////////
+// Process Tests
+///////////////////////////////
+
+/**
+ * Forks a child that renames itself and waits for signals.
+ *
+ * Returns once the rename is done, so signalProcess() can find it.
+ */
+static void forkNamedChild(const char* name) {
+	int ready[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(ready));
+	child = fork();
+	TEST_ASSERT_TRUE(child >= 0);
+	if (child == 0) {
+		close(ready[0]);
+		prctl(PR_SET_NAME, name);
+		if (write(ready[1], "", 1) != 1)
+			_exit(1);
+		pause();
+		_exit(0);
+	}
+	close(ready[1]);
+	char byte;
+	TEST_ASSERT_EQUAL_INT(1, read(ready[0], &byte, 1));
+	close(ready[0]);
+}
+
+void test_signalProcess_signals_by_name(void) {
+	forkNamedChild("utils_test_kid");
+
+	TEST_ASSERT_EQUAL_INT(1, signalProcess("utils_test_kid", SIGTERM));
+
+	int status = 0;
+	waitpid(child, &status, 0);
+	child = 0;
+	TEST_ASSERT_TRUE(WIFSIGNALED(status));
+	TEST_ASSERT_EQUAL_INT(SIGTERM, WTERMSIG(status));
+}
+
+void test_signalProcess_matches_truncated_names(void) {
+	forkNamedChild("utils_test_long_name"); // kernel keeps 15 chars
+
+	TEST_ASSERT_EQUAL_INT(0, signalProcess("utils_test_lon", SIGTERM)); // prefix only
+	TEST_ASSERT_EQUAL_INT(1, signalProcess("utils_test_long_name", SIGTERM));
+	waitpid(child, NULL, 0);
+	child = 0;
+}
+
+void test_signalProcess_no_match(void) {
+	TEST_ASSERT_EQUAL_INT(0, signalProcess("no_such_process", SIGCONT));
+	TEST_ASSERT_EQUAL_INT(0, signalProcess("", SIGCONT));
+}
+
+void test_zeroDevice_stops_when_full(void) {
+	TEST_ASSERT_EQUAL_INT(0, zeroDevice("/dev/full"));
+}
+
+void test_zeroDevice_missing_device(void) {
+	TEST_ASSERT_EQUAL_INT(-1, zeroDevice("/tmp/utils_test_missing_dir/fb0"));
+}
+
+void test_runProgram_returns_exit_status(void) {
+	TEST_ASSERT_EQUAL_INT(0, runProgram((char* const[]){"true", NULL}));
+	TEST_ASSERT_EQUAL_INT(1, runProgram((char* const[]){"false", NULL}));
+	TEST_ASSERT_EQUAL_INT(3, runProgram((char* const[]){"sh", "-c", "exit 3", NULL}));
+}
+
+void test_runProgram_passes_arguments_without_a_shell(void) {
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/utils_test_run_%d", getpid());
+
+	// a shell would split this into two arguments
+	char name[80];
+	snprintf(name, sizeof(name), "%s two", path);
+	TEST_ASSERT_EQUAL_INT(0, runProgram((char* const[]){"touch", name, NULL}));
+	TEST_ASSERT_TRUE(exists(name));
+	TEST_ASSERT_FALSE(exists(path));
+	unlink(name);
+}
+
+void test_runProgram_missing_program(void) {
+	TEST_ASSERT_NOT_EQUAL(0, runProgram((char* const[]){"utils_test_no_such_program", NULL}));
+	TEST_ASSERT_EQUAL_INT(-1, runProgram((char* const[]){NULL}));
+}
+
 ///////////////////////////////
 // Name Processing Tests
 ///////////////////////////////
@@ -745,6 +879,19 @@ int main(void) {
 	RUN_TEST(test_getInt_nonexistent_file);
 	RUN_TEST(test_putInt_negative);
 	RUN_TEST(test_allocFile_nonexistent);
+	RUN_TEST(test_mkdirs_creates_parents);
+	RUN_TEST(test_mkdirs_existing_directory_succeeds);
+	RUN_TEST(test_mkdirs_fails_through_file);
+
+	// Process
+	RUN_TEST(test_signalProcess_signals_by_name);
+	RUN_TEST(test_signalProcess_matches_truncated_names);
+	RUN_TEST(test_signalProcess_no_match);
+	RUN_TEST(test_zeroDevice_stops_when_full);
+	RUN_TEST(test_zeroDevice_missing_device);
+	RUN_TEST(test_runProgram_returns_exit_status);
+	RUN_TEST(test_runProgram_passes_arguments_without_a_shell);
+	RUN_TEST(test_runProgram_missing_program);
 
 	// Name processing
 	RUN_TEST(test_getDisplayName_simple);
@@ -22,13 +22,13 @@
  */
 
 #include <math.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 
 #include <fcntl.h>
-#include <pthread.h>
 #include <unistd.h>
 
 #include <errno.h>
@@ -42,6 +42,8 @@
 #include "audio_resampler.c"
 #include "defines.h"
 #include "gfx_text.h"
+#include "latency.h"
+#include "monitor.h"
 #include "pad.h"
 #include "utils.h"
 
@@ -244,6 +246,8 @@ static struct GFX_Context {
 
 	int mode;
 	int vsync;
+	int blitted; // Frame was drawn by PLAT_blitRenderer(), not into the screen
+	GFX_Renderer* renderer; // Last renderer passed to GFX_blitRenderer()
 } gfx;
 
 static SDL_Rect asset_rects[ASSET_COUNT];
@@ -261,12 +265,20 @@ static struct PWR_Context {
 	int requested_sleep;
 	int requested_wake;
 
-	pthread_t battery_pt;
+	int battery_task; // Monitor task id
 	int is_charging;
 	int charge;
 	int should_warn;
 
 	SDL_Surface* overlay;
+
+	void* presented; // Pixels of the frame on screen, NULL if the platform keeps it elsewhere
+	size_t presented_size;
+	GFX_Renderer* presented_renderer; // Renderer of the frame on screen when not in presented
+	void* resume_frame; // Last presented frame, shown again the moment we wake
+	size_t resume_size;
+	int has_resume_frame;
+	uint64_t woke_at; // Start of the last wake, 0 once a new frame was presented
 } pwr = {0};
 
 ///////////////////////////////
@@ -737,12 +749,19 @@ void GFX_setVsync(int vsync) {
  * Detects if HDMI connection state has changed.
  *
  * Tracks whether HDMI was connected/disconnected since last check.
- * Used to trigger display reconfiguration when needed.
+ * Used to trigger display reconfiguration when needed. Only re-reads
+ * shared settings after keymon (or anyone else) has written to them.
  *
  * @return 1 if HDMI state changed, 0 otherwise
  */
 int GFX_hdmiChanged(void) {
 	static int had_hdmi = -1;
+	static unsigned settings_seen;
+	unsigned generation = GetSettingsGeneration();
+	if (had_hdmi != -1 && generation == settings_seen)
+		return 0;
+	settings_seen = generation;
+
 	int has_hdmi = GetHDMI();
 	if (had_hdmi == -1)
 		had_hdmi = has_hdmi;
@@ -778,11 +797,37 @@ void GFX_startFrame(void) {
  * @param screen SDL surface to flip to the display
  *
  * @note Call GFX_startFrame() before rendering for proper timing
+ * @note Completes any pending latency measurement (see latency.h)
  */
 void GFX_flip(SDL_Surface* screen) {
 	int should_vsync = (gfx.vsync != VSYNC_OFF && (gfx.vsync == VSYNC_STRICT || frame_start == 0 ||
 	                                               SDL_GetTicks() - frame_start < FRAME_BUDGET));
+
+	// page-flipping platforms point screen->pixels at the back page once flipped
+	pwr.presented = PLAT_screenHoldsFrame(gfx.blitted) ? screen->pixels : NULL;
+	pwr.presented_size = (size_t)screen->pitch * screen->h;
+	pwr.presented_renderer = gfx.blitted && !pwr.presented ? gfx.renderer : NULL;
+	gfx.blitted = 0;
+
 	PLAT_flip(screen, should_vsync);
+	LAT_markPresent();
+
+	if (pwr.woke_at) {
+		LOG_info("wake: first new frame after %ims",
+		         (int)((getMicroseconds() - pwr.woke_at) / 1000));
+		pwr.woke_at = 0;
+	}
+}
+
+/**
+ * Blits a renderer's output for the next GFX_flip().
+ *
+ * @param renderer Rendering context
+ */
+void GFX_blitRenderer(GFX_Renderer* renderer) {
+	gfx.blitted = 1;
+	gfx.renderer = renderer;
+	PLAT_blitRenderer(renderer);
 }
 
 /**
@@ -821,6 +866,20 @@ FALLBACK_IMPLEMENTATION int PLAT_supportsOverscan(void) {
 	return 0;
 }
 
+/**
+ * Checks whether the screen surface holds the frame about to be flipped.
+ *
+ * Default implementation assumes renderer frames are presented from the
+ * renderer's own buffer, as on the SDL2 platforms. Platforms whose
+ * scalers write into the screen override this.
+ *
+ * @param blitted 1 if the frame was drawn by PLAT_blitRenderer()
+ * @return 1 if screen->pixels holds the frame, 0 otherwise
+ */
+FALLBACK_IMPLEMENTATION int PLAT_screenHoldsFrame(int blitted) {
+	return !blitted;
+}
+
 /**
  * Sets the color for screen effects (scanlines, grids).
  *
@@ -1654,8 +1713,28 @@ static struct SND_Context {
 
 	// Linear interpolation resampler with dynamic rate control
 	AudioResampler resampler;
+
+	int fade_frames; // Output frames left in the current fade in
+	int fade_length; // Total output frames of the current fade in
 } snd = {0};
 
+/**
+ * Ramps output up from silence while a fade in is in progress.
+ *
+ * @param out Interleaved stereo output
+ * @param frames Number of stereo frames in out
+ *
+ * @note Runs on SDL's audio thread, not the main thread
+ */
+static void SND_applyFade(int16_t* out, int frames) {
+	for (int i = 0; i < frames && snd.fade_frames > 0; i++) {
+		int gain = snd.fade_length - snd.fade_frames;
+		out[i * 2] = out[i * 2] * gain / snd.fade_length;
+		out[i * 2 + 1] = out[i * 2 + 1] * gain / snd.fade_length;
+		snd.fade_frames -= 1;
+	}
+}
+
 /**
  * SDL audio callback - consumes samples from the ring buffer.
  *
@@ -1678,7 +1757,7 @@ static void SND_audioCallback(void* userdata, uint8_t* stream, int len) { // pla
 
 	int16_t* out = (int16_t*)stream;
 	len /= (sizeof(int16_t) * 2);
-	// int full_len = len;
+	int full_len = len;
 
 	// if (snd.frame_out!=snd.frame_in) LOG_info("%8i consuming samples (%i frames)\n", ms(), len);
 
@@ -1710,6 +1789,9 @@ static void SND_audioCallback(void* userdata, uint8_t* stream, int len) { // pla
 			memset(out, 0, len * sizeof(int16_t) * 2);
 		}
 	}
+
+	if (snd.fade_frames > 0)
+		SND_applyFade((int16_t*)stream, full_len);
 }
 
 /**
@@ -1937,6 +2019,25 @@ void SND_init(double sample_rate, double frame_rate) { // plat_sound_init
 	snd.initialized = 1;
 }
 
+/**
+ * Drops buffered audio and fades back in from silence.
+ *
+ * Used when waking so stale pre-sleep audio isn't replayed and the output
+ * doesn't pop back in at full level.
+ *
+ * @param duration_ms Length of the fade in
+ */
+static void SND_fadeIn(int duration_ms) {
+	if (!snd.initialized || snd.frame_count == 0)
+		return;
+
+	SDL_LockAudio();
+	snd.frame_out = snd.frame_in;
+	snd.fade_length = snd.sample_rate_out * duration_ms / 1000;
+	snd.fade_frames = snd.fade_length;
+	SDL_UnlockAudio();
+}
+
 /**
  * Gets current audio buffer fill level as a percentage.
  *
@@ -2322,6 +2423,8 @@ FALLBACK_IMPLEMENTATION void PLAT_pollInput(void) {
 			pad.just_repeated |= btn; // set
 			pad.is_pressed |= btn; // set
 			pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
+			// SDL doesn't expose the kernel timestamp, so this undercounts by up to a poll
+			LAT_markInput(LAT_now(), id);
 		}
 	}
 
@@ -2377,56 +2480,57 @@ FALLBACK_IMPLEMENTATION int PLAT_shouldWake(void) {
 // Vibration context with deferred state changes to minimize motor wear
 static struct VIB_Context {
 	int initialized;
-	pthread_t pt;
+	int task; // Monitor task id
 	int queued_strength;
 	int strength; // Current applied strength
 } vib = {0};
 
 /**
- * Vibration worker thread that applies deferred strength changes.
+ * Vibration monitor task that applies deferred strength changes.
  *
- * Defers strength changes for 3 frames to prevent rapid on/off cycling
- * which can damage rumble motors. Runs continuously at ~60Hz.
+ * Defers turning the motor off for 3 frames to prevent rapid on/off
+ * cycling which can damage rumble motors. Only runs at ~60Hz while a
+ * change is pending, otherwise parks until VIB_setStrength() wakes it.
  *
- * @param arg Unused thread argument
- * @return Never returns (infinite loop)
+ * @return Milliseconds until the next run, or MON_IDLE
  */
-static void* VIB_thread(void* arg) {
+static uint32_t VIB_task(void) {
 #define DEFER_FRAMES 3
 	static int defer = 0;
-	while (1) {
-		SDL_Delay(17);
-		if (vib.queued_strength != vib.strength) {
-			if (defer < DEFER_FRAMES &&
-			    vib.queued_strength ==
-			        0) { // minimize vacillation between 0 and some number (which this motor doesn't like)
-				defer += 1;
-				continue;
-			}
-			vib.strength = vib.queued_strength;
-			defer = 0;
+	if (vib.queued_strength == vib.strength) {
+		defer = 0;
+		return MON_IDLE;
+	}
 
-			PLAT_setRumble(vib.strength);
-		}
+	if (defer < DEFER_FRAMES &&
+	    vib.queued_strength ==
+	        0) { // minimize vacillation between 0 and some number (which this motor doesn't like)
+		defer += 1;
+		return 17;
 	}
-	return 0;
+	vib.strength = vib.queued_strength;
+	defer = 0;
+
+	PLAT_setRumble(vib.strength);
+	return MON_IDLE;
 }
 
 /**
  * Initializes the vibration subsystem.
  *
- * Starts the vibration worker thread. Call this before using vibration.
+ * Registers the vibration task with the shared monitor. Call this before
+ * using vibration.
  */
 void VIB_init(void) {
 	vib.queued_strength = vib.strength = 0;
-	pthread_create(&vib.pt, NULL, &VIB_thread, NULL);
+	vib.task = MON_addTask(VIB_task, MON_IDLE);
 	vib.initialized = 1;
 }
 
 /**
  * Shuts down the vibration subsystem.
  *
- * Stops vibration and terminates the worker thread.
+ * Stops vibration and removes the monitor task.
  * Safe to call even if not initialized.
  */
 void VIB_quit(void) {
@@ -2434,14 +2538,16 @@ void VIB_quit(void) {
 		return;
 
 	VIB_setStrength(0);
-	pthread_cancel(vib.pt);
-	pthread_join(vib.pt, NULL);
+	MON_removeTask(vib.task);
+	if (vib.strength)
+		PLAT_setRumble(0); // deferred stop never ran
+	vib.initialized = 0;
 }
 
 /**
  * Queues a vibration strength change.
  *
- * Change is deferred by 3 frames to prevent rapid motor cycling.
+ * Turning off is deferred by 3 frames to prevent rapid motor cycling.
  * No-op if strength hasn't changed.
  *
  * @param strength Vibration strength (0=off, higher=stronger)
@@ -2450,6 +2556,7 @@ void VIB_setStrength(int strength) {
 	if (vib.queued_strength == strength)
 		return;
 	vib.queued_strength = strength;
+	MON_wake(vib.task);
 }
 
 /**
@@ -2524,35 +2631,36 @@ static void PWR_initOverlay(void) {
  *
  * Queries platform for current battery status and updates overlay
  * visibility based on charge level and warning state.
+ *
+ * @return 1 if the charge or charging state changed, 0 otherwise
  */
-static void PWR_updateBatteryStatus(void) {
+static int PWR_updateBatteryStatus(void) {
+	int was_charging = pwr.is_charging;
+	int had_charge = pwr.charge;
 	PLAT_getBatteryStatus(&pwr.is_charging, &pwr.charge);
 	PLAT_enableOverlay(pwr.should_warn && pwr.charge <= PWR_LOW_CHARGE);
+	return pwr.is_charging != was_charging || pwr.charge != had_charge;
 }
 
 /**
- * Battery monitoring worker thread.
+ * Battery monitor task.
  *
- * Polls battery status every 5 seconds and updates the UI overlay.
- * Runs continuously in the background.
+ * Updates battery status and picks the next poll interval: quick near low
+ * charge or after a change, slower while stable and slowest in game, where
+ * only the low battery warning is visible. Suspended during sleep.
  *
- * @param arg Unused thread argument
- * @return Never returns (infinite loop)
+ * @return Milliseconds until the next poll
  */
-static void* PWR_monitorBattery(void* arg) {
-	while (1) {
-		// TODO: the frequency of checking could depend on whether
-		// we're in game (less frequent) or menu (more frequent)
-		sleep(5);
-		PWR_updateBatteryStatus();
-	}
-	return NULL;
+static uint32_t PWR_monitorBattery(void) {
+	int changed = PWR_updateBatteryStatus();
+	return MON_batteryInterval(pwr.charge, pwr.is_charging, changed, pwr.should_warn);
 }
 
 /**
  * Initializes the power management subsystem.
  *
- * Sets up battery monitoring, initializes overlay, starts background thread.
+ * Sets up battery monitoring, initializes overlay, registers the battery
+ * task with the shared monitor.
  * Configures default power management flags (sleep/poweroff enabled).
  */
 void PWR_init(void) {
@@ -2569,25 +2677,31 @@ void PWR_init(void) {
 	PWR_initOverlay();
 
 	PWR_updateBatteryStatus();
-	pthread_create(&pwr.battery_pt, NULL, &PWR_monitorBattery, NULL);
+	pwr.battery_task = MON_addTask(PWR_monitorBattery, MON_BATTERY_ACTIVE_MS);
 	pwr.initialized = 1;
 }
 
 /**
  * Shuts down the power management subsystem.
  *
- * Terminates battery monitoring thread and frees overlay resources.
+ * Removes the battery monitor task and frees overlay resources.
  * Safe to call even if not initialized.
  */
 void PWR_quit(void) {
 	if (!pwr.initialized)
 		return;
 
+	// stop battery task before its overlay goes away
+	MON_removeTask(pwr.battery_task);
 	PLAT_quitOverlay();
 
-	// cancel battery thread
-	pthread_cancel(pwr.battery_pt);
-	pthread_join(pwr.battery_pt, NULL);
+	free(pwr.resume_frame);
+	pwr.resume_frame = NULL;
+	pwr.resume_size = 0;
+	pwr.has_resume_frame = 0;
+	pwr.presented = NULL;
+	pwr.presented_renderer = NULL;
+	pwr.initialized = 0;
 }
 
 /**
@@ -2596,6 +2710,8 @@ void PWR_quit(void) {
  * @param enable 1 to show warning when battery low, 0 to hide
  */
 void PWR_warn(int enable) {
+	if (pwr.should_warn != enable)
+		MON_wake(pwr.battery_task); // entering or leaving game changes the poll interval
 	pwr.should_warn = enable;
 	PLAT_enableOverlay(pwr.should_warn && pwr.charge <= PWR_LOW_CHARGE);
 }
@@ -2724,11 +2840,17 @@ void PWR_update(int* _dirty, int* _show_setting, PWR_callback_t before_sleep,
 		}
 	}
 
-	int muted = GetMute();
-	if ((uint32_t)muted != was_muted) {
-		was_muted = muted;
-		show_setting = 2;
-		setting_shown_at = now;
+	// mute is toggled by keymon, only re-read it after settings changed
+	static unsigned settings_seen;
+	unsigned generation = GetSettingsGeneration();
+	if (generation != settings_seen) {
+		settings_seen = generation;
+		int muted = GetMute();
+		if ((uint32_t)muted != was_muted) {
+			was_muted = muted;
+			show_setting = 2;
+			setting_shown_at = now;
+		}
 	}
 
 	if (show_setting)
@@ -2817,27 +2939,135 @@ static void PWR_enterSleep(void) {
 		SetRawVolume(MUTE_VOLUME_RAW);
 		PLAT_enableBacklight(0);
 	}
-	system("killall -STOP keymon.elf");
+	signalProcess("keymon.elf", SIGSTOP);
+	MON_suspend();
 
 	sync();
 }
 
+#define WAKE_FADE_MS 50 // Audio fade in after waking
+
+/**
+ * Draws the frame a renderer presented into a screen sized buffer.
+ *
+ * The SDL2 platforms scale renderer frames on the GPU straight from the
+ * renderer's source, so the screen surface never holds them. This places
+ * the frame the way their PLAT_flip() does, with nearest neighbor
+ * sampling and without sharpness or effects, which is close enough for
+ * the moment until the next frame.
+ *
+ * @param renderer Renderer of the presented frame
+ * @param pixels RGB565 buffer to draw into
+ * @param width Buffer width in pixels
+ * @param height Buffer height in pixels
+ * @param pitch Buffer row stride in bytes
+ */
+static void PWR_drawRendererFrame(const GFX_Renderer* renderer, void* pixels, int width,
+                                  int height, int pitch) {
+	memset(pixels, 0, (size_t)pitch * height);
+	if (!renderer->src || renderer->src_w <= 0 || renderer->src_h <= 0)
+		return;
+
+	int dst_w = width;
+	int dst_h = height;
+	if (renderer->aspect == 0) { // native or cropped
+		int scale = renderer->scale > 0 ? renderer->scale : 1;
+		dst_w = renderer->src_w * scale;
+		dst_h = renderer->src_h * scale;
+	} else if (renderer->aspect > 0) { // aspect
+		dst_w = height * renderer->aspect;
+		if (dst_w > width) {
+			dst_w = width;
+			dst_h = width / renderer->aspect;
+		}
+	}
+	int dst_x = (width - dst_w) / 2;
+	int dst_y = (height - dst_h) / 2;
+
+	for (int y = MAX(0, -dst_y); y < dst_h && dst_y + y < height; y++) {
+		int src_y = renderer->src_y + y * renderer->src_h / dst_h;
+		const uint16_t* src =
+		    (const uint16_t*)((const uint8_t*)renderer->src + (size_t)src_y * renderer->src_p) +
+		    renderer->src_x;
+		uint16_t* dst = (uint16_t*)((uint8_t*)pixels + (size_t)(dst_y + y) * pitch) + dst_x;
+		for (int x = MAX(0, -dst_x); x < dst_w && dst_x + x < width; x++)
+			dst[x] = src[x * renderer->src_w / dst_w];
+	}
+}
+
+/**
+ * Keeps a copy of the last presented frame to show again on wake.
+ *
+ * Copies from the pixels GFX_flip() presented, not screen->pixels, which
+ * is the back page by now on page-flipping platforms. When the platform
+ * presented a renderer frame from elsewhere (a core frame on the SDL2
+ * platforms), the frame is redrawn from the renderer's source instead.
+ *
+ * The buffer is reused across sleeps and only reallocated when the
+ * screen size changes.
+ */
+static void PWR_saveResumeFrame(void) {
+	pwr.has_resume_frame = 0;
+	SDL_Surface* screen = gfx.screen;
+	if (!pwr.presented && !pwr.presented_renderer)
+		return;
+
+	size_t size = pwr.presented ? pwr.presented_size : (size_t)screen->pitch * screen->h;
+	if (size != pwr.resume_size) {
+		free(pwr.resume_frame);
+		pwr.resume_frame = malloc(size);
+		pwr.resume_size = pwr.resume_frame ? size : 0;
+	}
+	if (!pwr.resume_frame)
+		return;
+
+	if (pwr.presented)
+		memcpy(pwr.resume_frame, pwr.presented, size);
+	else
+		PWR_drawRendererFrame(pwr.presented_renderer, pwr.resume_frame, screen->w, screen->h,
+		                      screen->pitch);
+	pwr.has_resume_frame = 1;
+}
+
+/**
+ * Presents the frame saved by PWR_saveResumeFrame() without waiting for
+ * the app (or core) to render a new one.
+ */
+static void PWR_showResumeFrame(void) {
+	SDL_Surface* screen = gfx.screen;
+	if (!pwr.has_resume_frame || pwr.resume_size != (size_t)screen->pitch * screen->h)
+		return;
+
+	memcpy(screen->pixels, pwr.resume_frame, pwr.resume_size);
+	PLAT_flip(screen, 0);
+	LOG_info("wake: resume frame after %ims", (int)((getMicroseconds() - pwr.woke_at) / 1000));
+}
+
 /**
  * Exits sleep mode and restores normal operation.
  *
- * Restores backlight, volume, resumes keymon, and unpauses audio.
+ * Presents the last frame before turning the backlight back on, fades
+ * audio back in, then resumes the monitor, which isn't needed for the
+ * first frame. Keymon is resumed before the volume is written, since it
+ * may have been stopped in the middle of its own settings update.
+ *
+ * Nothing is synced here, PWR_enterSleep() already did and nothing is
+ * written while asleep, so the next frame doesn't wait on the SD card.
  */
 static void PWR_exitSleep(void) {
-	system("killall -CONT keymon.elf");
+	PWR_showResumeFrame();
+	signalProcess("keymon.elf", SIGCONT);
 	if (GetHDMI()) {
 		// buh
 	} else {
 		PLAT_enableBacklight(1);
 		SetVolume(GetVolume());
 	}
+	SND_fadeIn(WAKE_FADE_MS);
 	SDL_PauseAudio(0);
 
-	sync();
+	MON_resume();
+	MON_wake(pwr.battery_task); // charge may have changed a lot while asleep
 }
 
 /**
@@ -2856,6 +3086,7 @@ static void PWR_waitForWake(void) {
 		SDL_Delay(200);
 		if (pwr.can_poweroff &&
 		    SDL_GetTicks() - sleep_ticks >= 120000) { // increased to two minutes
+			PWR_updateBatteryStatus(); // monitor is suspended while asleep
 			if (pwr.is_charging)
 				sleep_ticks += 60000; // check again in a minute
 			else
@@ -2869,15 +3100,20 @@ static void PWR_waitForWake(void) {
 /**
  * Performs a "fake sleep" by entering and exiting sleep mode.
  *
- * Clears screen, resets input, enters sleep, waits for wake,
- * then exits sleep and resets input again. This is the main
+ * Saves the last frame, clears screen, resets input, enters sleep, waits
+ * for wake, then exits sleep and resets input again. This is the main
  * sleep function called by applications.
+ *
+ * Time from wake to the resume frame and to the first newly rendered
+ * frame is logged.
  */
 void PWR_fauxSleep(void) {
+	PWR_saveResumeFrame();
 	GFX_clear(gfx.screen);
 	PAD_reset();
 	PWR_enterSleep();
 	PWR_waitForWake();
+	pwr.woke_at = getMicroseconds();
 	PWR_exitSleep();
 	PAD_reset();
 }
@@ -436,6 +436,9 @@ void GFX_setMode(int mode);
 /**
  * Checks if HDMI connection state has changed.
  *
+ * Cheap enough to call every frame, the state is only re-read after a
+ * settings change.
+ *
  * @return 1 if HDMI state changed, 0 otherwise
  */
 int GFX_hdmiChanged(void);
@@ -541,7 +544,7 @@ int GFX_wrapText(TTF_Font* font, char* str, int max_width, int max_lines);
  * Blits a renderer's output to the screen.
  * @param renderer Rendering context
  */
-#define GFX_blitRenderer PLAT_blitRenderer
+void GFX_blitRenderer(GFX_Renderer* renderer);
 
 /**
  * Gets anti-aliased scaler for smooth scaling operations.
@@ -920,6 +923,31 @@ extern PAD_Context pad;
  */
 void PAD_setAnalog(int neg, int pos, int value, int repeat_at);
 
+/**
+ * Starts a new input frame (clears transient state, fires auto-repeat).
+ *
+ * @param tick Current timestamp in milliseconds
+ */
+void PAD_beginFrame(uint32_t tick);
+
+/**
+ * Applies a digital button press or release (internal use by platform implementations).
+ *
+ * @param id Button ID (BTN_ID_A, etc.), BTN_ID_NONE is ignored
+ * @param pressed 1 for press, 0 for release
+ * @param tick Current timestamp in milliseconds
+ */
+void PAD_setButton(int id, int pressed, uint32_t tick);
+
+/**
+ * Applies an evdev hat (d-pad) axis value (internal use by platform implementations).
+ *
+ * @param vertical 1 for up/down, 0 for left/right
+ * @param value Hat value (-1, 0 or 1)
+ * @param tick Current timestamp in milliseconds
+ */
+void PAD_setHat(int vertical, int value, uint32_t tick);
+
 /**
  * Resets all button states to unpressed.
  */
@@ -1092,7 +1120,9 @@ int PWR_isPoweringOff(void);
 /**
  * Enters a low-power state without actually sleeping.
  *
- * Used to reduce power consumption during idle periods.
+ * Used to reduce power consumption during idle periods. On wake the last
+ * presented frame is shown again immediately, before the caller renders
+ * a new one.
  */
 void PWR_fauxSleep(void);
 
@@ -1288,6 +1318,14 @@ void PLAT_blitRenderer(GFX_Renderer* renderer);
  */
 void PLAT_flip(SDL_Surface* screen, int sync);
 
+/**
+ * Platform-specific check for where a frame is presented from.
+ *
+ * @param blitted 1 if the frame was drawn by PLAT_blitRenderer()
+ * @return 1 if the screen surface's pixels hold the frame about to be flipped
+ */
+int PLAT_screenHoldsFrame(int blitted);
+
 /**
  * Platform-specific overscan support check.
  *
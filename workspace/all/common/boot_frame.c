@@ -0,0 +1,181 @@
+/**
+ * boot_frame.c - Launcher screen snapshot shown at startup
+ */
+
+#include "boot_frame.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fb.h>
+#endif
+
+int BootFrame_capture(BootFrame* frame, const void* pixels, int width, int height, int pitch) {
+	if (!frame->pixels || frame->width != width || frame->height != height) {
+		free(frame->pixels);
+		frame->pixels = malloc((size_t)width * height * sizeof(uint16_t));
+		if (!frame->pixels) {
+			frame->width = frame->height = 0;
+			return -1;
+		}
+		frame->width = width;
+		frame->height = height;
+		frame->changed = 1;
+	}
+
+	size_t row_size = (size_t)width * sizeof(uint16_t);
+	for (int y = 0; y < height; y++) {
+		uint16_t* dst = frame->pixels + (size_t)y * width;
+		const uint8_t* src = (const uint8_t*)pixels + (size_t)y * pitch;
+		// rows match until the first difference, everything after is copied
+		if (!frame->changed && !memcmp(dst, src, row_size))
+			continue;
+		memcpy(dst, src, row_size);
+		frame->changed = 1;
+	}
+	return 0;
+}
+
+int BootFrame_save(const BootFrame* frame, const char* path) {
+	if (!frame->pixels)
+		return -1;
+
+	char tmp_path[512];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	FILE* file = fopen(tmp_path, "wb");
+	if (!file)
+		return -1;
+
+	uint32_t header[3] = {BOOT_FRAME_MAGIC, (uint32_t)frame->width, (uint32_t)frame->height};
+	size_t count = (size_t)frame->width * frame->height;
+	int ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+	         fwrite(frame->pixels, sizeof(uint16_t), count, file) == count;
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok || rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+int BootFrame_load(BootFrame* frame, const char* path) {
+	memset(frame, 0, sizeof(BootFrame));
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return -1;
+
+	uint32_t header[3];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != BOOT_FRAME_MAGIC ||
+	    header[1] == 0 || header[2] == 0 || header[1] > 4096 || header[2] > 4096) {
+		fclose(file);
+		return -1;
+	}
+
+	size_t count = (size_t)header[1] * header[2];
+	frame->pixels = malloc(count * sizeof(uint16_t));
+	if (!frame->pixels || fread(frame->pixels, sizeof(uint16_t), count, file) != count) {
+		fclose(file);
+		BootFrame_free(frame);
+		return -1;
+	}
+	fclose(file);
+
+	frame->width = (int)header[1];
+	frame->height = (int)header[2];
+	return 0;
+}
+
+void BootFrame_free(BootFrame* frame) {
+	free(frame->pixels);
+	frame->pixels = NULL;
+	frame->width = 0;
+	frame->height = 0;
+}
+
+int BootFrame_blit(const BootFrame* frame, const BootFrame_Target* target) {
+	if (!frame->pixels || frame->width != target->width || frame->height != target->height)
+		return -1;
+
+	for (int y = 0; y < frame->height; y++) {
+		const uint16_t* src = frame->pixels + (size_t)y * frame->width;
+		uint8_t* row = (uint8_t*)target->pixels + (size_t)y * target->pitch;
+
+		if (target->bpp == 16) {
+			if (target->red_shift != 11)
+				return -1; // BGR565
+			memcpy(row, src, (size_t)frame->width * sizeof(uint16_t));
+			continue;
+		}
+		if (target->bpp != 32)
+			return -1;
+
+		uint32_t alpha = target->alpha_shift >= 0 ? 0xffu << target->alpha_shift : 0;
+		uint32_t* dst = (uint32_t*)row;
+		for (int x = 0; x < frame->width; x++) {
+			uint16_t c = src[x];
+			uint32_t r = (c >> 11) & 0x1f;
+			uint32_t g = (c >> 5) & 0x3f;
+			uint32_t b = c & 0x1f;
+			r = (r << 3) | (r >> 2);
+			g = (g << 2) | (g >> 4);
+			b = (b << 3) | (b >> 2);
+			dst[x] = (r << target->red_shift) | (g << target->green_shift) |
+			         (b << target->blue_shift) | alpha;
+		}
+	}
+	return 0;
+}
+
+int BootFrame_show(const BootFrame* frame, const char* device) {
+#ifndef __linux__
+	return -1; // desktop builds have no fbdev
+#else
+	int fd = open(device, O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	struct fb_var_screeninfo var;
+	struct fb_fix_screeninfo fix;
+	if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0 || ioctl(fd, FBIOGET_FSCREENINFO, &fix) < 0 ||
+	    (int)var.xres != frame->width || (int)var.yres != frame->height) {
+		close(fd);
+		return -1;
+	}
+
+	// only the visible page, a double buffered framebuffer may be taller
+	size_t offset = (size_t)var.yoffset * fix.line_length;
+	size_t size = offset + (size_t)var.yres * fix.line_length;
+	if (size > fix.smem_len) {
+		close(fd);
+		return -1;
+	}
+
+	uint8_t* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	BootFrame_Target target = {
+	    .pixels = map + offset,
+	    .width = (int)var.xres,
+	    .height = (int)var.yres,
+	    .pitch = (int)fix.line_length,
+	    .bpp = (int)var.bits_per_pixel,
+	    .red_shift = (int)var.red.offset,
+	    .green_shift = (int)var.green.offset,
+	    .blue_shift = (int)var.blue.offset,
+	    .alpha_shift = var.transp.length ? (int)var.transp.offset : -1,
+	};
+	int result = BootFrame_blit(frame, &target);
+	munmap(map, size);
+	return result;
+#endif
+}
@@ -0,0 +1,117 @@
+/**
+ * boot_frame.h - Launcher screen snapshot shown at startup
+ *
+ * On a cold start minui loads settings, fonts and assets, opens input and
+ * scans the root directory before it can draw anything, so the screen
+ * stays dark for most of a second. Instead, minui keeps a copy of the last
+ * root screen it rendered and saves it on exit. On the next start that
+ * snapshot is written straight to the framebuffer before anything else is
+ * initialized, and live rendering takes over once the launcher is ready.
+ *
+ * File layout (native endianness, the file never leaves the device):
+ *   uint32_t magic (BOOT_FRAME_MAGIC)
+ *   uint32_t width, height
+ *   uint16_t pixels[width * height] (RGB565, tightly packed rows)
+ */
+
+#ifndef __BOOT_FRAME_H__
+#define __BOOT_FRAME_H__
+
+#include <stdint.h>
+
+#define BOOT_FRAME_MAGIC 0x464e424d // "MBNF"
+
+/**
+ * Snapshot of an RGB565 screen.
+ */
+typedef struct BootFrame {
+	int width;
+	int height;
+	uint16_t* pixels; // width * height, tightly packed
+	int changed; // Set by BootFrame_capture() when the pixels differ from before
+} BootFrame;
+
+/**
+ * Describes a destination framebuffer.
+ *
+ * 16bpp targets must be RGB565 (red_shift 11), frames are copied as is.
+ * 32bpp targets place each 8-bit channel at the given bit offset, alpha
+ * is set opaque when alpha_shift is not negative.
+ */
+typedef struct BootFrame_Target {
+	void* pixels;
+	int width;
+	int height;
+	int pitch; // Bytes per row
+	int bpp; // Bits per pixel, 16 or 32
+	int red_shift;
+	int green_shift;
+	int blue_shift;
+	int alpha_shift;
+} BootFrame_Target;
+
+/**
+ * Copies a rendered screen into a snapshot.
+ *
+ * Reuses the snapshot's buffer when the size hasn't changed. Sets changed
+ * unless the screen matches what the snapshot already held, so a snapshot
+ * that was loaded or saved only needs saving again once it's set.
+ *
+ * @param frame Snapshot to fill (zero-initialized before first use)
+ * @param pixels RGB565 screen pixels
+ * @param width Screen width in pixels
+ * @param height Screen height in pixels
+ * @param pitch Screen row stride in bytes
+ * @return 0 on success, -1 if out of memory
+ */
+int BootFrame_capture(BootFrame* frame, const void* pixels, int width, int height, int pitch);
+
+/**
+ * Writes a snapshot to disk.
+ *
+ * Writes to a temporary file and renames it, so a power cut never leaves
+ * a truncated snapshot behind.
+ *
+ * @param frame Snapshot to save
+ * @param path Destination file
+ * @return 0 on success, -1 on error
+ */
+int BootFrame_save(const BootFrame* frame, const char* path);
+
+/**
+ * Reads a snapshot from disk.
+ *
+ * @param frame Snapshot to fill, free with BootFrame_free()
+ * @param path Snapshot file
+ * @return 0 on success, -1 if missing or invalid
+ */
+int BootFrame_load(BootFrame* frame, const char* path);
+
+/**
+ * Releases a snapshot's pixels.
+ *
+ * @param frame Snapshot to free
+ */
+void BootFrame_free(BootFrame* frame);
+
+/**
+ * Draws a snapshot into a framebuffer, converting the pixel format.
+ *
+ * @param frame Snapshot to draw
+ * @param target Destination framebuffer
+ * @return 0 on success, -1 if sizes differ or the format is unsupported
+ */
+int BootFrame_blit(const BootFrame* frame, const BootFrame_Target* target);
+
+/**
+ * Draws a snapshot directly to the visible page of a Linux framebuffer
+ * device, without SDL.
+ *
+ * @param frame Snapshot to draw
+ * @param device Framebuffer device, e.g. "/dev/fb0"
+ * @return 0 on success, -1 if the device is unavailable or doesn't match
+ *         the snapshot (different size, rotated panel, unsupported depth)
+ */
+int BootFrame_show(const BootFrame* frame, const char* device);
+
+#endif // __BOOT_FRAME_H__
@@ -72,6 +72,10 @@ COMMON_SOURCE = \
 	$(COMMON_DIR)/log.c \
 	$(COMMON_DIR)/collections.c \
 	$(COMMON_DIR)/pad.c \
+	$(COMMON_DIR)/evdev.c \
+	$(COMMON_DIR)/sysfs.c \
+	$(COMMON_DIR)/latency.c \
+	$(COMMON_DIR)/monitor.c \
 	$(COMMON_DIR)/gfx_text.c \
 	$(COMMON_DIR)/scaler.c \
 	$(PLATFORM_DIR)/platform.c
@@ -0,0 +1,149 @@
+/**
+ * config_store.c - Hash-indexed minarch config files
+ */
+
+#include "config_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////
+// Key index
+///////////////////////////////
+
+uint32_t KeyIndex_hash(const char* key) {
+	uint32_t hash = 2166136261u;
+	for (const unsigned char* c = (const unsigned char*)key; *c; c++) {
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+int KeyIndex_init(KeyIndex* index, int capacity) {
+	memset(index, 0, sizeof(KeyIndex));
+
+	// keep the table at most half full so probe chains stay short
+	uint32_t size = 8;
+	while (size < (uint32_t)capacity * 2)
+		size <<= 1;
+
+	index->slots = calloc(size, sizeof(KeyIndex_Slot));
+	if (!index->slots)
+		return -1;
+	index->mask = size - 1;
+	return 0;
+}
+
+int KeyIndex_add(KeyIndex* index, const char* key, int id) {
+	if (!index->slots || (uint32_t)index->count >= index->mask)
+		return -1;
+
+	uint32_t hash = KeyIndex_hash(key);
+	for (uint32_t i = hash & index->mask;; i = (i + 1) & index->mask) {
+		KeyIndex_Slot* slot = &index->slots[i];
+		if (!slot->key) {
+			slot->key = key;
+			slot->hash = hash;
+			slot->id = id;
+			index->count += 1;
+			return 0;
+		}
+		if (slot->hash == hash && !strcmp(slot->key, key))
+			return -1;
+	}
+}
+
+int KeyIndex_find(const KeyIndex* index, const char* key) {
+	if (!index->slots)
+		return -1;
+
+	uint32_t hash = KeyIndex_hash(key);
+	for (uint32_t i = hash & index->mask;; i = (i + 1) & index->mask) {
+		const KeyIndex_Slot* slot = &index->slots[i];
+		if (!slot->key)
+			return -1;
+		if (slot->hash == hash && !strcmp(slot->key, key))
+			return slot->id;
+	}
+}
+
+void KeyIndex_free(KeyIndex* index) {
+	free(index->slots);
+	memset(index, 0, sizeof(KeyIndex));
+}
+
+///////////////////////////////
+// Config store
+///////////////////////////////
+
+ConfigStore* ConfigStore_new(char* text) {
+	if (!text)
+		return NULL;
+
+	ConfigStore* store = calloc(1, sizeof(ConfigStore));
+	if (!store) {
+		free(text);
+		return NULL;
+	}
+	store->text = text;
+
+	int lines = 1;
+	for (char* c = text; *c; c++) {
+		if (*c == '\n')
+			lines += 1;
+	}
+
+	store->entries = calloc(lines, sizeof(ConfigStore_Entry));
+	if (!store->entries || KeyIndex_init(&store->index, lines) != 0) {
+		ConfigStore_free(store);
+		return NULL;
+	}
+
+	char* line = text;
+	while (line) {
+		char* next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
+		size_t len = strlen(line);
+		if (len && line[len - 1] == '\r')
+			line[len - 1] = '\0';
+
+		char* separator = strstr(line, " = ");
+		if (separator && separator != line) {
+			*separator = '\0';
+			ConfigStore_Entry* entry = &store->entries[store->count];
+			entry->locked = line[0] == '-';
+			entry->key = entry->locked ? line + 1 : line;
+			entry->value = separator + 3;
+			if (KeyIndex_add(&store->index, entry->key, store->count) == 0)
+				store->count += 1;
+		}
+		line = next;
+	}
+	return store;
+}
+
+const char* ConfigStore_get(const ConfigStore* store, const char* key, int* locked) {
+	if (!store)
+		return NULL;
+
+	int id = KeyIndex_find(&store->index, key);
+	if (id < 0)
+		return NULL;
+
+	const ConfigStore_Entry* entry = &store->entries[id];
+	if (locked && entry->locked)
+		*locked = 1;
+	return entry->value;
+}
+
+void ConfigStore_free(ConfigStore* store) {
+	if (!store)
+		return;
+	KeyIndex_free(&store->index);
+	free(store->entries);
+	free(store->text);
+	free(store);
+}
@@ -0,0 +1,138 @@
+/**
+ * config_store.h - Hash-indexed minarch config files
+ *
+ * minarch configs are plain text, one setting per line:
+ *
+ *   minarch_screen_scaling = Aspect
+ *   -gpsp_frameskip = disabled
+ *   bind Up = UP
+ *
+ * A leading `-` locks the setting, hiding it from the options menu. Each
+ * file is tokenized once into a ConfigStore whose keys are indexed by
+ * hash, so looking up every frontend and core option costs one probe per
+ * key instead of a scan of the whole file.
+ *
+ * KeyIndex is the open-addressing table underneath, usable on its own to
+ * index any array of string keys.
+ */
+
+#ifndef __CONFIG_STORE_H__
+#define __CONFIG_STORE_H__
+
+#include <stdint.h>
+
+///////////////////////////////
+// Key index
+///////////////////////////////
+
+typedef struct KeyIndex_Slot {
+	const char* key; // Not owned, NULL if the slot is empty
+	uint32_t hash;
+	int id;
+} KeyIndex_Slot;
+
+/**
+ * Maps string keys to integer ids.
+ */
+typedef struct KeyIndex {
+	KeyIndex_Slot* slots;
+	uint32_t mask; // Slot count - 1, slot count is a power of two
+	int count;
+} KeyIndex;
+
+/**
+ * Hashes a key (FNV-1a).
+ */
+uint32_t KeyIndex_hash(const char* key);
+
+/**
+ * Allocates an empty index.
+ *
+ * The index doesn't grow, keep adding at most capacity keys.
+ *
+ * @param index Index to initialize
+ * @param capacity Number of keys that will be added
+ * @return 0 on success, -1 if out of memory
+ */
+int KeyIndex_init(KeyIndex* index, int capacity);
+
+/**
+ * Adds a key.
+ *
+ * The key string must outlive the index. Duplicate keys keep their first
+ * id.
+ *
+ * @param index Index to add to
+ * @param key Key to add
+ * @param id Value returned by KeyIndex_find() for this key
+ * @return 0 if added, -1 if the key already exists or the index is full
+ */
+int KeyIndex_add(KeyIndex* index, const char* key, int id);
+
+/**
+ * Looks up a key.
+ *
+ * @param index Index to search, may be empty (zero-initialized)
+ * @param key Key to find
+ * @return The key's id, -1 if not found
+ */
+int KeyIndex_find(const KeyIndex* index, const char* key);
+
+/**
+ * Releases an index's slots.
+ *
+ * @param index Index to free
+ */
+void KeyIndex_free(KeyIndex* index);
+
+///////////////////////////////
+// Config store
+///////////////////////////////
+
+typedef struct ConfigStore_Entry {
+	const char* key;
+	const char* value;
+	int locked; // Key was prefixed with `-`
+} ConfigStore_Entry;
+
+/**
+ * Parsed config file.
+ */
+typedef struct ConfigStore {
+	char* text; // Owned copy of the file, keys and values point into it
+	ConfigStore_Entry* entries; // In file order
+	int count;
+	KeyIndex index;
+} ConfigStore;
+
+/**
+ * Parses config text.
+ *
+ * Takes ownership of text, which is modified in place. Lines without
+ * " = " are skipped, the first of duplicate keys wins.
+ *
+ * @param text Heap allocated config text (e.g. from allocFile()), or NULL
+ * @return New store, or NULL if text is NULL or out of memory (text is
+ *         freed either way)
+ */
+ConfigStore* ConfigStore_new(char* text);
+
+/**
+ * Looks up a value.
+ *
+ * @param store Store to search, or NULL
+ * @param key Key to find
+ * @param locked Set to 1 if the setting is locked, left untouched
+ *               otherwise (may be NULL)
+ * @return Value, or NULL if the key isn't set
+ */
+const char* ConfigStore_get(const ConfigStore* store, const char* key, int* locked);
+
+/**
+ * Releases a store and its text.
+ *
+ * @param store Store to free, or NULL
+ */
+void ConfigStore_free(ConfigStore* store);
+
+#endif // __CONFIG_STORE_H__
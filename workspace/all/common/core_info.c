@@ -0,0 +1,169 @@
+/**
+ * core_info.c - Cached libretro core metadata
+ */
+
+#include "core_info.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MIN_SIZE_CLASS 4096
+
+static int statCore(const char* so_path, int64_t* mtime, int64_t* size) {
+	struct stat st;
+	if (stat(so_path, &st) != 0 || !S_ISREG(st.st_mode))
+		return -1;
+	*mtime = (int64_t)st.st_mtime;
+	*size = (int64_t)st.st_size;
+	return 0;
+}
+
+int CoreInfo_init(CoreInfo* info, const char* so_path) {
+	memset(info, 0, sizeof(CoreInfo));
+	snprintf(info->so_path, sizeof(info->so_path), "%s", so_path);
+	return statCore(so_path, &info->so_mtime, &info->so_size);
+}
+
+int CoreInfo_isFresh(const CoreInfo* info) {
+	int64_t mtime, size;
+	if (!info->so_path[0] || statCore(info->so_path, &mtime, &size) != 0)
+		return 0;
+	return mtime == info->so_mtime && size == info->so_size;
+}
+
+int CoreInfo_equals(const CoreInfo* a, const CoreInfo* b) {
+	return !strcmp(a->so_path, b->so_path) && a->so_mtime == b->so_mtime &&
+	       a->so_size == b->so_size && !strcmp(a->library_name, b->library_name) &&
+	       !strcmp(a->library_version, b->library_version) &&
+	       !strcmp(a->valid_extensions, b->valid_extensions) &&
+	       a->extensions_truncated == b->extensions_truncated &&
+	       a->need_fullpath == b->need_fullpath && a->state_size_class == b->state_size_class;
+}
+
+int CoreInfo_read(CoreInfo* info, const char* path) {
+	memset(info, 0, sizeof(CoreInfo));
+
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return -1;
+
+	int truncated = 0;
+	char line[1024];
+	while (fgets(line, sizeof(line), file)) {
+		size_t len = strcspn(line, "\r\n");
+		int cut = !line[len] && !feof(file);
+		line[len] = '\0';
+		// drop the rest of a line too long for the buffer, its value is cut short anyway
+		if (cut) {
+			int c;
+			while ((c = fgetc(file)) != EOF && c != '\n')
+				;
+		}
+
+		char* value = strchr(line, '=');
+		if (!value)
+			continue;
+		*value++ = '\0';
+
+		if (!strcmp(line, "so_path"))
+			snprintf(info->so_path, sizeof(info->so_path), "%s", value);
+		else if (!strcmp(line, "so_mtime"))
+			info->so_mtime = strtoll(value, NULL, 10);
+		else if (!strcmp(line, "so_size"))
+			info->so_size = strtoll(value, NULL, 10);
+		else if (!strcmp(line, "library_name"))
+			snprintf(info->library_name, sizeof(info->library_name), "%s", value);
+		else if (!strcmp(line, "library_version"))
+			snprintf(info->library_version, sizeof(info->library_version), "%s", value);
+		else if (!strcmp(line, "valid_extensions")) {
+			CoreInfo_setExtensions(info, value);
+			truncated |= info->extensions_truncated || cut;
+		} else if (!strcmp(line, "extensions_truncated"))
+			truncated |= atoi(value) != 0;
+		else if (!strcmp(line, "need_fullpath"))
+			info->need_fullpath = atoi(value);
+		else if (!strcmp(line, "state_size_class"))
+			info->state_size_class = (size_t)strtoull(value, NULL, 10);
+	}
+	fclose(file);
+	info->extensions_truncated = truncated;
+
+	if (!info->so_path[0] || !info->so_size) {
+		memset(info, 0, sizeof(CoreInfo));
+		return -1;
+	}
+	return 0;
+}
+
+int CoreInfo_write(const CoreInfo* info, const char* path) {
+	char tmp_path[512];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	FILE* file = fopen(tmp_path, "w");
+	if (!file)
+		return -1;
+
+	fprintf(file, "so_path=%s\n", info->so_path);
+	fprintf(file, "so_mtime=%lld\n", (long long)info->so_mtime);
+	fprintf(file, "so_size=%lld\n", (long long)info->so_size);
+	fprintf(file, "library_name=%s\n", info->library_name);
+	fprintf(file, "library_version=%s\n", info->library_version);
+	fprintf(file, "valid_extensions=%s\n", info->valid_extensions);
+	fprintf(file, "extensions_truncated=%i\n", info->extensions_truncated);
+	fprintf(file, "need_fullpath=%i\n", info->need_fullpath);
+	fprintf(file, "state_size_class=%llu\n", (unsigned long long)info->state_size_class);
+
+	int ok = !ferror(file);
+	ok = fclose(file) == 0 && ok;
+	if (!ok || rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+void CoreInfo_setExtensions(CoreInfo* info, const char* extensions) {
+	int len = snprintf(info->valid_extensions, sizeof(info->valid_extensions), "%s",
+	                   extensions ? extensions : "");
+	info->extensions_truncated = len >= (int)sizeof(info->valid_extensions);
+}
+
+int CoreInfo_supportsFile(const CoreInfo* info, const char* filename) {
+	// a cut list could be missing the file's extension
+	if (!info->valid_extensions[0] || info->extensions_truncated)
+		return 1;
+
+	const char* base = strrchr(filename, '/');
+	base = base ? base + 1 : filename;
+	const char* ext = strrchr(base, '.');
+	if (!ext || !ext[1])
+		return 0;
+	ext += 1;
+	size_t ext_len = strlen(ext);
+
+	const char* start = info->valid_extensions;
+	while (*start) {
+		size_t len = strcspn(start, "|");
+		if (len == ext_len && !strncasecmp(start, ext, len))
+			return 1;
+		start += len;
+		if (*start == '|')
+			start += 1;
+	}
+	return 0;
+}
+
+size_t CoreInfo_sizeClass(size_t size) {
+	if (!size)
+		return 0;
+	size_t size_class = MIN_SIZE_CLASS;
+	while (size_class < size) {
+		if (size_class > SIZE_MAX / 2)
+			return size;
+		size_class <<= 1;
+	}
+	return size_class;
+}
@@ -0,0 +1,131 @@
+/**
+ * core_info.h - Cached libretro core metadata
+ *
+ * Everything minarch learns from retro_get_system_info() is fixed for a
+ * given core binary, but the only way to get it is to dlopen the core.
+ * minarch writes what it learned to a small per-system cache file after
+ * opening a core, so minui can use a core's real file extensions without
+ * ever loading it.
+ *
+ * Entries are keyed by the core's path, modification time and size, and
+ * are treated as missing once the .so on disk changes.
+ *
+ * File layout (one key=value pair per line):
+ *   so_path=/mnt/SDCARD/.system/<platform>/cores/gambatte_libretro.so
+ *   so_mtime=1700000000
+ *   so_size=1234567
+ *   library_name=Gambatte
+ *   library_version=v0.5.0
+ *   valid_extensions=gb|gbc|dmg
+ *   extensions_truncated=0
+ *   need_fullpath=0
+ *   state_size_class=131072
+ */
+
+#ifndef __CORE_INFO_H__
+#define __CORE_INFO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Metadata for a single core binary.
+ */
+typedef struct CoreInfo {
+	char so_path[512];
+	int64_t so_mtime;
+	int64_t so_size;
+
+	char library_name[128];
+	char library_version[128];
+	char valid_extensions[256]; // '|' separated, no dots, e.g. "gb|gbc|dmg"
+	int extensions_truncated; // The core listed more than valid_extensions holds
+	int need_fullpath;
+
+	size_t state_size_class; // Save state size rounded up by CoreInfo_sizeClass(), 0 if unknown
+} CoreInfo;
+
+/**
+ * Records the identity (path, mtime, size) of a core binary.
+ *
+ * Clears all other fields.
+ *
+ * @param info Entry to fill
+ * @param so_path Path to the core .so
+ * @return 0 on success, -1 if the core can't be stat'ed
+ */
+int CoreInfo_init(CoreInfo* info, const char* so_path);
+
+/**
+ * Checks whether an entry still describes the core on disk.
+ *
+ * @param info Entry to check
+ * @return 1 if the .so exists with the recorded mtime and size, 0 otherwise
+ */
+int CoreInfo_isFresh(const CoreInfo* info);
+
+/**
+ * Checks whether two entries hold the same metadata.
+ *
+ * @return 1 if every field matches, 0 otherwise
+ */
+int CoreInfo_equals(const CoreInfo* a, const CoreInfo* b);
+
+/**
+ * Reads an entry from disk.
+ *
+ * Unknown keys are ignored so newer fields can be added without
+ * invalidating existing files.
+ *
+ * @param info Entry to fill
+ * @param path Cache file
+ * @return 0 on success, -1 if missing or lacking the core's identity
+ */
+int CoreInfo_read(CoreInfo* info, const char* path);
+
+/**
+ * Writes an entry to disk.
+ *
+ * Writes to a temporary file and renames it, so readers never see a
+ * partially written entry.
+ *
+ * @param info Entry to save
+ * @param path Cache file
+ * @return 0 on success, -1 on error
+ */
+int CoreInfo_write(const CoreInfo* info, const char* path);
+
+/**
+ * Stores a core's valid extensions.
+ *
+ * A list that doesn't fit is cut short and flagged as truncated.
+ *
+ * @param info Entry to fill
+ * @param extensions '|' separated list, NULL for none
+ */
+void CoreInfo_setExtensions(CoreInfo* info, const char* extensions);
+
+/**
+ * Checks whether a core accepts a file, by extension.
+ *
+ * Case-insensitive. A core without any valid extensions, or whose list
+ * was truncated, accepts everything.
+ *
+ * @param info Core metadata
+ * @param filename File name or path
+ * @return 1 if the extension is listed, 0 otherwise
+ */
+int CoreInfo_supportsFile(const CoreInfo* info, const char* filename);
+
+/**
+ * Rounds a save state size up to its size class.
+ *
+ * Cores may report a slightly different size per game, so the cache
+ * keeps the next power of two (at least 4 KiB) instead.
+ *
+ * @param size Size in bytes
+ * @return Size class in bytes, 0 for 0
+ */
+size_t CoreInfo_sizeClass(size_t size);
+
+#endif // __CORE_INFO_H__
@@ -0,0 +1,109 @@
+/**
+ * cpu_governor.c - Frame-time-driven CPU speed selection
+ */
+
+#include "cpu_governor.h"
+
+#include <string.h>
+
+static int clampLevel(int level) {
+	if (level < 0)
+		return 0;
+	if (level >= CPU_GOVERNOR_LEVELS)
+		return CPU_GOVERNOR_LEVELS - 1;
+	return level;
+}
+
+void CpuGovernor_init(CpuGovernor* governor, double fps, int level) {
+	memset(governor, 0, sizeof(CpuGovernor));
+	governor->level = clampLevel(level);
+	governor->idle_required = CPU_GOVERNOR_IDLE_WINDOWS;
+	governor->since_down = -1;
+	CpuGovernor_setFrameRate(governor, fps);
+}
+
+void CpuGovernor_setFrameRate(CpuGovernor* governor, double fps) {
+	governor->frame_us = fps > 0 ? (uint32_t)(1000000.0 / fps) : 0;
+	CpuGovernor_reset(governor);
+}
+
+void CpuGovernor_reset(CpuGovernor* governor) {
+	governor->frames = 0;
+	governor->tight_frames = 0;
+	governor->peak_us = 0;
+	governor->idle_windows = 0;
+}
+
+static void stepUp(CpuGovernor* governor) {
+	// giving back a step down this soon means the lower level can't keep up
+	if (governor->since_down >= 0 && governor->since_down < CPU_GOVERNOR_REVERT_WINDOWS) {
+		governor->idle_required *= 2;
+		if (governor->idle_required > CPU_GOVERNOR_MAX_IDLE_WINDOWS)
+			governor->idle_required = CPU_GOVERNOR_MAX_IDLE_WINDOWS;
+	}
+	governor->since_down = -1;
+	governor->level += 1;
+	CpuGovernor_reset(governor);
+}
+
+static void stepDown(CpuGovernor* governor) {
+	governor->since_down = 0;
+	governor->level -= 1;
+	CpuGovernor_reset(governor);
+}
+
+int CpuGovernor_addSample(CpuGovernor* governor, uint32_t work_us) {
+	if (!governor->frame_us)
+		return 0;
+
+	governor->level_frames[governor->level] += 1;
+	governor->frames += 1;
+	if (work_us > governor->peak_us)
+		governor->peak_us = work_us;
+
+	uint64_t scaled = (uint64_t)work_us * 100;
+	if (scaled > (uint64_t)governor->frame_us * CPU_GOVERNOR_BUSY_PERCENT) {
+		governor->tight_frames += 1;
+		if (governor->tight_frames >= CPU_GOVERNOR_TIGHT_FRAMES &&
+		    governor->level < CPU_GOVERNOR_LEVELS - 1) {
+			stepUp(governor);
+			return 1;
+		}
+	}
+
+	if (governor->frames < CPU_GOVERNOR_WINDOW)
+		return 0;
+
+	// end of window
+	int idle = governor->tight_frames == 0 &&
+	           (uint64_t)governor->peak_us * 100 <
+	               (uint64_t)governor->frame_us * CPU_GOVERNOR_IDLE_PERCENT;
+	int idle_windows = idle ? governor->idle_windows + 1 : 0;
+	if (governor->since_down >= 0)
+		governor->since_down += 1;
+
+	if (idle_windows >= governor->idle_required && governor->level > 0) {
+		stepDown(governor);
+		return 1;
+	}
+
+	CpuGovernor_reset(governor);
+	governor->idle_windows = idle_windows;
+	return 0;
+}
+
+int CpuGovernor_getLevel(const CpuGovernor* governor) {
+	return governor->level;
+}
+
+int CpuGovernor_getLearnedLevel(const CpuGovernor* governor) {
+	int learned = governor->level;
+	uint32_t most = 0;
+	for (int level = 0; level < CPU_GOVERNOR_LEVELS; level++) {
+		if (governor->level_frames[level] && governor->level_frames[level] >= most) {
+			most = governor->level_frames[level];
+			learned = level;
+		}
+	}
+	return learned;
+}
@@ -0,0 +1,136 @@
+/**
+ * cpu_governor.h - Frame-time-driven CPU speed selection
+ *
+ * minarch offers fixed CPU speed levels (powersave, normal, performance)
+ * and the right one depends on the game: easy games waste battery at
+ * normal while heavy ones stutter. The governor picks the level from
+ * measured frame work (core.run() start until the frame is handed to
+ * GFX_flip) against the frame budget:
+ *
+ * - A few tight frames (work above CPU_GOVERNOR_BUSY_PERCENT of the
+ *   budget) within one window steps up immediately.
+ * - Only a sustained run of light windows (peak work under
+ *   CPU_GOVERNOR_IDLE_PERCENT) steps down.
+ * - When a step down has to be reverted shortly after, the governor waits
+ *   twice as long before trying again, so it doesn't oscillate on games
+ *   that sit right at a level's limit.
+ *
+ * The level that ran the most frames is reported as the learned level,
+ * which minarch saves per game and uses as the next starting point.
+ *
+ * Extracted as pure logic so the policy can be tested without a core.
+ */
+
+#ifndef __CPU_GOVERNOR_H__
+#define __CPU_GOVERNOR_H__
+
+#include <stdint.h>
+
+/**
+ * Number of speed levels (0=powersave, 1=normal, 2=performance).
+ */
+#define CPU_GOVERNOR_LEVELS 3
+
+/**
+ * Frames per evaluation window (~1s at 60fps).
+ */
+#define CPU_GOVERNOR_WINDOW 60
+
+/**
+ * A frame is tight when its work exceeds this share of the budget.
+ */
+#define CPU_GOVERNOR_BUSY_PERCENT 85
+
+/**
+ * Tight frames within one window that trigger a step up.
+ */
+#define CPU_GOVERNOR_TIGHT_FRAMES 3
+
+/**
+ * A window is idle when its peak work stays under this share of the budget.
+ */
+#define CPU_GOVERNOR_IDLE_PERCENT 50
+
+/**
+ * Consecutive idle windows required before stepping down.
+ */
+#define CPU_GOVERNOR_IDLE_WINDOWS 5
+
+/**
+ * A step up within this many windows of a step down reverts it.
+ */
+#define CPU_GOVERNOR_REVERT_WINDOWS 10
+
+/**
+ * Upper bound for the idle window requirement after repeated reverts.
+ */
+#define CPU_GOVERNOR_MAX_IDLE_WINDOWS 60
+
+/**
+ * CPU governor state.
+ */
+typedef struct CpuGovernor {
+	uint32_t frame_us; // Target frame time
+	int level; // Current speed level
+	int frames; // Samples in the current window
+	int tight_frames; // Tight samples in the current window
+	uint32_t peak_us; // Heaviest sample in the current window
+	int idle_windows; // Consecutive idle windows so far
+	int idle_required; // Idle windows needed to step down
+	int since_down; // Windows since the last step down, -1 if none pending
+	uint32_t level_frames[CPU_GOVERNOR_LEVELS]; // Frames run at each level
+} CpuGovernor;
+
+/**
+ * Initializes the governor.
+ *
+ * @param governor Governor to initialize
+ * @param fps Core frame rate (e.g. 60.0988)
+ * @param level Starting level, usually the learned level from last time
+ */
+void CpuGovernor_init(CpuGovernor* governor, double fps, int level);
+
+/**
+ * Updates the frame budget after the core changed its timing.
+ *
+ * Keeps the current level and learned statistics.
+ *
+ * @param governor Governor to update
+ * @param fps New core frame rate
+ */
+void CpuGovernor_setFrameRate(CpuGovernor* governor, double fps);
+
+/**
+ * Discards the current window, e.g. after the menu or a state load.
+ *
+ * @param governor Governor to reset
+ */
+void CpuGovernor_reset(CpuGovernor* governor);
+
+/**
+ * Adds a frame work measurement.
+ *
+ * @param governor Governor to update
+ * @param work_us Time from core.run() start to the frame being presented
+ * @return 1 if the level changed and the CPU speed should be applied
+ */
+int CpuGovernor_addSample(CpuGovernor* governor, uint32_t work_us);
+
+/**
+ * Gets the current speed level.
+ *
+ * @param governor Governor to query
+ * @return Level from 0 to CPU_GOVERNOR_LEVELS-1
+ */
+int CpuGovernor_getLevel(const CpuGovernor* governor);
+
+/**
+ * Gets the level worth starting at next time.
+ *
+ * @param governor Governor to query
+ * @return Level that ran the most frames (the higher one on a tie), or the
+ *         current level before any frames ran
+ */
+int CpuGovernor_getLearnedLevel(const CpuGovernor* governor);
+
+#endif // __CPU_GOVERNOR_H__
@@ -98,6 +98,18 @@
  */
 #define AUTO_RESUME_PATH SHARED_USERDATA_PATH "/.minui/auto_resume.txt"
 
+/**
+ * Snapshot of the launcher's root screen, shown first on the next start.
+ * Per platform since it's a raw framebuffer image.
+ */
+#define BOOT_FRAME_PATH USERDATA_PATH "/boot_frame.bin"
+
+/**
+ * Cached core metadata, one <tag>.txt per system (see core_info.h).
+ * Per platform since it describes that platform's core binaries.
+ */
+#define CORE_INFO_PATH USERDATA_PATH "/.core_info"
+
 /**
  * Save state slot used for auto-resume feature.
  */
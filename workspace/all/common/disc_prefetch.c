@@ -0,0 +1,175 @@
+/**
+ * disc_prefetch.c - Page cache warming for the next disc of multi-disc games
+ */
+
+#include "disc_prefetch.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+int DiscPrefetch_getNextDisc(M3U_Disc** discs, int count, const char* current) {
+	for (int i = 0; i < count - 1; i++) {
+		if (!strcmp(discs[i]->path, current))
+			return i + 1;
+	}
+	return -1;
+}
+
+/**
+ * Extracts the file name from a cue sheet FILE line, quoted or not.
+ */
+static int parseCueFile(const char* line, char* name, size_t size) {
+	while (isspace((unsigned char)*line))
+		line++;
+	if (strncasecmp(line, "FILE", 4) || !isspace((unsigned char)line[4]))
+		return -1;
+	line += 5;
+	while (isspace((unsigned char)*line))
+		line++;
+
+	const char* end;
+	if (*line == '"') {
+		line += 1;
+		end = strchr(line, '"');
+	} else
+		end = strpbrk(line, " \t\r\n");
+	if (!end)
+		end = line + strlen(line);
+
+	size_t len = end - line;
+	if (!len || len >= size)
+		return -1;
+	memcpy(name, line, len);
+	name[len] = '\0';
+	return 0;
+}
+
+int DiscPrefetch_listFiles(const char* disc_path, char files[][512], int max) {
+	if (max < 1)
+		return 0;
+	snprintf(files[0], 512, "%s", disc_path);
+	int count = 1;
+
+	const char* ext = strrchr(disc_path, '.');
+	if (!ext || strcasecmp(ext, ".cue"))
+		return count;
+
+	FILE* file = fopen(disc_path, "r");
+	if (!file)
+		return count;
+
+	const char* slash = strrchr(disc_path, '/');
+	int dir_len = slash ? (int)(slash - disc_path + 1) : 0;
+
+	char line[512];
+	char name[256];
+	while (count < max && fgets(line, sizeof(line), file)) {
+		if (parseCueFile(line, name, sizeof(name)) != 0)
+			continue;
+		if (name[0] == '/')
+			snprintf(files[count], 512, "%s", name);
+		else
+			snprintf(files[count], 512, "%.*s%s", dir_len, disc_path, name);
+		count += 1;
+	}
+	fclose(file);
+	return count;
+}
+
+size_t DiscPrefetch_warmFile(const char* path, size_t limit, int* cancel) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+
+	char* buffer = malloc(DISC_PREFETCH_CHUNK);
+	if (!buffer) {
+		close(fd);
+		return 0;
+	}
+
+	size_t warmed = 0;
+	while (warmed < limit) {
+		if (cancel && __atomic_load_n(cancel, __ATOMIC_ACQUIRE))
+			break;
+
+		size_t chunk = limit - warmed < DISC_PREFETCH_CHUNK ? limit - warmed : DISC_PREFETCH_CHUNK;
+#ifdef POSIX_FADV_WILLNEED
+		// queue the next chunk while this one is read
+		if (warmed + chunk < limit)
+			posix_fadvise(fd, (off_t)(warmed + chunk), DISC_PREFETCH_CHUNK, POSIX_FADV_WILLNEED);
+#endif
+		ssize_t count = pread(fd, buffer, chunk, (off_t)warmed);
+		if (count <= 0)
+			break;
+		warmed += (size_t)count;
+	}
+
+	free(buffer);
+	close(fd);
+	return warmed;
+}
+
+/**
+ * Moves the calling thread to the idle I/O class, so warming only uses
+ * the card when the game isn't reading from it.
+ */
+static void setIdleIOPriority(void) {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+	const int who_process = 1; // IOPRIO_WHO_PROCESS, 0 means the calling thread
+	const int class_idle = 3; // IOPRIO_CLASS_IDLE
+	syscall(SYS_ioprio_set, who_process, 0, class_idle << 13);
+#endif
+}
+
+static void* prefetchThread(void* arg) {
+	DiscPrefetch* prefetch = arg;
+	setIdleIOPriority();
+
+	int disc_count = 0;
+	M3U_Disc** discs = M3U_getAllDiscs(prefetch->m3u_path, &disc_count);
+	int next = DiscPrefetch_getNextDisc(discs, disc_count, prefetch->current);
+	if (next >= 0) {
+		char files[DISC_PREFETCH_MAX_FILES][512];
+		int file_count =
+		    DiscPrefetch_listFiles(discs[next]->path, files, DISC_PREFETCH_MAX_FILES);
+		size_t warmed = 0;
+		for (int i = 0; i < file_count && warmed < prefetch->limit; i++) {
+			warmed += DiscPrefetch_warmFile(files[i], prefetch->limit - warmed, &prefetch->cancel);
+			__atomic_store_n(&prefetch->warmed, warmed, __ATOMIC_RELEASE);
+		}
+	}
+	if (discs)
+		M3U_freeDiscs(discs, disc_count);
+	return NULL;
+}
+
+int DiscPrefetch_start(DiscPrefetch* prefetch, const char* m3u_path, const char* current,
+                       size_t limit) {
+	memset(prefetch, 0, sizeof(DiscPrefetch));
+	snprintf(prefetch->m3u_path, sizeof(prefetch->m3u_path), "%s", m3u_path);
+	snprintf(prefetch->current, sizeof(prefetch->current), "%s", current);
+	prefetch->limit = limit;
+
+	if (pthread_create(&prefetch->thread, NULL, prefetchThread, prefetch) != 0)
+		return -1;
+	prefetch->running = 1;
+	return 0;
+}
+
+void DiscPrefetch_stop(DiscPrefetch* prefetch) {
+	if (!prefetch->running)
+		return;
+
+	__atomic_store_n(&prefetch->cancel, 1, __ATOMIC_RELEASE);
+	pthread_join(prefetch->thread, NULL);
+	prefetch->running = 0;
+}
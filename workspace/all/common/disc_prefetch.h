@@ -0,0 +1,106 @@
+/**
+ * disc_prefetch.h - Page cache warming for the next disc of multi-disc games
+ *
+ * Swapping discs in a multi-disc game (e.g. a PS1 RPG asking for disc 2)
+ * makes the core read the new image cold from the SD card, which stalls
+ * the game for seconds on slow cards. While the current disc is played,
+ * a background thread reads the start of the next disc listed in the
+ * game's m3u into the page cache at idle I/O priority, so the swap mostly
+ * hits memory.
+ *
+ * Only the first DISC_PREFETCH_BYTES of the next disc are warmed: that is
+ * what the core and game read right after a swap, and warming a whole
+ * 700MB image would only evict the current disc from the cache.
+ */
+
+#ifndef __DISC_PREFETCH_H__
+#define __DISC_PREFETCH_H__
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "m3u_parser.h"
+
+#define DISC_PREFETCH_BYTES (32 * 1024 * 1024)
+#define DISC_PREFETCH_MAX_FILES 16 // Per disc, e.g. a cue sheet and its track bins
+#define DISC_PREFETCH_CHUNK (128 * 1024) // Read between cancel checks
+
+/**
+ * Background warmer for one game's next disc.
+ */
+typedef struct DiscPrefetch {
+	char m3u_path[512];
+	char current[512]; // Disc being played
+	size_t limit; // Maximum bytes to warm
+	pthread_t thread;
+	int running; // Thread was started
+	int cancel; // Accessed atomically
+	size_t warmed; // Bytes read so far, accessed atomically
+} DiscPrefetch;
+
+/**
+ * Finds the disc played after the current one.
+ *
+ * @param discs Discs from M3U_getAllDiscs()
+ * @param count Number of discs
+ * @param current Path of the disc being played
+ * @return Index of the next disc, -1 if current is the last one or isn't
+ *         in the list
+ */
+int DiscPrefetch_getNextDisc(M3U_Disc** discs, int count, const char* current);
+
+/**
+ * Lists the files that make up a disc image.
+ *
+ * A cue sheet is listed with the track files it references (resolved
+ * relative to the cue sheet), any other image is a single file.
+ *
+ * @param disc_path Disc image
+ * @param files Output paths
+ * @param max Capacity of files
+ * @return Number of files listed
+ */
+int DiscPrefetch_listFiles(const char* disc_path, char files[][512], int max);
+
+/**
+ * Reads the start of a file into the page cache.
+ *
+ * Hints the kernel one chunk ahead and reads chunk by chunk, so at idle
+ * I/O priority the warming keeps pace with the card instead of flooding
+ * its queue. Chunks are kept small since cancel is only checked between
+ * them.
+ *
+ * @param path File to warm
+ * @param limit Maximum bytes to read
+ * @param cancel Stops early when set to non-zero (may be NULL)
+ * @return Bytes read
+ */
+size_t DiscPrefetch_warmFile(const char* path, size_t limit, int* cancel);
+
+/**
+ * Starts warming the disc after current in the background.
+ *
+ * The m3u is read on the thread, which exits right away if the game has
+ * no next disc.
+ *
+ * @param prefetch Prefetch to start (zero-initialized or stopped)
+ * @param m3u_path Game's m3u playlist
+ * @param current Path of the disc being played
+ * @param limit Maximum bytes to warm
+ * @return 0 if started, -1 otherwise
+ */
+int DiscPrefetch_start(DiscPrefetch* prefetch, const char* m3u_path, const char* current,
+                       size_t limit);
+
+/**
+ * Cancels warming and waits for the thread to exit.
+ *
+ * Waits for at most the chunk being read. An idle priority read can be
+ * held back for as long as the game keeps the card busy, so chunks are
+ * small enough for that to be one short read.
+ *
+ * @param prefetch Prefetch to stop, may have never been started
+ */
+void DiscPrefetch_stop(DiscPrefetch* prefetch);
+
+#endif // __DISC_PREFETCH_H__
@@ -0,0 +1,365 @@
+/**
+ * evdev.c - Shared Linux evdev input backend
+ *
+ * All registered devices share one epoll instance. Each device's epoll
+ * data carries its slot index, and the inotify descriptor uses the
+ * reserved index EVDEV_MAX_DEVICES, so a single epoll_wait() reports both
+ * input and hotplug activity.
+ *
+ * Hotplug devices are matched by file name within their watched directory.
+ * IN_ATTRIB is handled like IN_CREATE because device nodes are often
+ * created before their permissions are fixed up, so the first open() can
+ * fail with EACCES.
+ */
+
+#include "evdev.h"
+#include "log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/input.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(EVDEV_Event) == sizeof(struct input_event),
+               "EVDEV_Event must match the kernel's input_event");
+
+///////////////////////////////
+// Device registry
+///////////////////////////////
+
+#define EVDEV_INOTIFY_SLOT EVDEV_MAX_DEVICES
+#define EVDEV_PATH_MAX 256
+
+typedef struct EVDEV_Device {
+	char path[EVDEV_PATH_MAX];
+	const char* name; // points into path, after the last '/'
+	int fd;
+	int hotplug;
+	int watch; // inotify watch descriptor, -1 if not watched
+	int in_use;
+} EVDEV_Device;
+
+static struct {
+	EVDEV_Device devices[EVDEV_MAX_DEVICES];
+	int epoll_fd;
+	int inotify_fd;
+	EVDEV_HotplugCallback hotplug_callback;
+	void* hotplug_userdata;
+	uint32_t types; // EVDEV_TYPE() mask of dispatched event types
+} evdev = {
+    .epoll_fd = -1,
+    .inotify_fd = -1,
+    .types = EVDEV_TYPES_DEFAULT,
+};
+
+/**
+ * Opens a device and adds it to the epoll set.
+ *
+ * @return 1 if the device is now open, 0 otherwise
+ */
+static int openDevice(int index) {
+	EVDEV_Device* device = &evdev.devices[index];
+	if (device->fd >= 0)
+		return 1;
+
+	int fd = open(device->path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)index};
+	if (epoll_ctl(evdev.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		LOG_errno("Failed to add %s to epoll", device->path);
+		close(fd);
+		return 0;
+	}
+
+	// stamp events with CLOCK_MONOTONIC so they can be compared with our own clocks
+	int clock = CLOCK_MONOTONIC;
+	if (ioctl(fd, EVIOCSCLOCKID, &clock) < 0)
+		LOG_warn("evdev: %s keeps wall-clock event times", device->path);
+
+	device->fd = fd;
+	LOG_info("evdev: opened %s", device->path);
+	if (device->hotplug && evdev.hotplug_callback)
+		evdev.hotplug_callback(index, 1, evdev.hotplug_userdata);
+	return 1;
+}
+
+/**
+ * Removes a device from the epoll set and closes it.
+ */
+static void closeDevice(int index) {
+	EVDEV_Device* device = &evdev.devices[index];
+	if (device->fd < 0)
+		return;
+
+	epoll_ctl(evdev.epoll_fd, EPOLL_CTL_DEL, device->fd, NULL);
+	close(device->fd);
+	device->fd = -1;
+	LOG_info("evdev: closed %s", device->path);
+	if (device->hotplug && evdev.hotplug_callback)
+		evdev.hotplug_callback(index, 0, evdev.hotplug_userdata);
+}
+
+///////////////////////////////
+// Lifecycle
+///////////////////////////////
+
+int EVDEV_init(void) {
+	if (evdev.epoll_fd >= 0)
+		return 0;
+
+	for (int i = 0; i < EVDEV_MAX_DEVICES; i++) {
+		evdev.devices[i].fd = -1;
+		evdev.devices[i].watch = -1;
+		evdev.devices[i].in_use = 0;
+	}
+
+	evdev.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (evdev.epoll_fd < 0) {
+		LOG_errno("Failed to create epoll instance");
+		return -1;
+	}
+
+	// hotplug is optional, input still works without it
+	evdev.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (evdev.inotify_fd >= 0) {
+		struct epoll_event ev = {.events = EPOLLIN, .data.u32 = EVDEV_INOTIFY_SLOT};
+		if (epoll_ctl(evdev.epoll_fd, EPOLL_CTL_ADD, evdev.inotify_fd, &ev) < 0) {
+			close(evdev.inotify_fd);
+			evdev.inotify_fd = -1;
+		}
+	}
+	if (evdev.inotify_fd < 0)
+		LOG_errno_warn("evdev: hotplug detection unavailable");
+
+	return 0;
+}
+
+void EVDEV_quit(void) {
+	for (int i = 0; i < EVDEV_MAX_DEVICES; i++) {
+		EVDEV_Device* device = &evdev.devices[i];
+		if (!device->in_use)
+			continue;
+		if (device->fd >= 0) {
+			close(device->fd);
+			device->fd = -1;
+		}
+		device->in_use = 0;
+		device->watch = -1;
+	}
+
+	if (evdev.inotify_fd >= 0) {
+		close(evdev.inotify_fd); // also drops all watches
+		evdev.inotify_fd = -1;
+	}
+	if (evdev.epoll_fd >= 0) {
+		close(evdev.epoll_fd);
+		evdev.epoll_fd = -1;
+	}
+	evdev.hotplug_callback = NULL;
+	evdev.hotplug_userdata = NULL;
+	evdev.types = EVDEV_TYPES_DEFAULT;
+}
+
+int EVDEV_addDevice(const char* path, int hotplug) {
+	if (evdev.epoll_fd < 0 || !path || strlen(path) >= EVDEV_PATH_MAX)
+		return -1;
+
+	int index = -1;
+	for (int i = 0; i < EVDEV_MAX_DEVICES; i++) {
+		if (!evdev.devices[i].in_use) {
+			index = i;
+			break;
+		}
+	}
+	if (index < 0) {
+		LOG_warn("evdev: no free slot for %s", path);
+		return -1;
+	}
+
+	EVDEV_Device* device = &evdev.devices[index];
+	strcpy(device->path, path);
+	char* slash = strrchr(device->path, '/');
+	device->name = slash ? slash + 1 : device->path;
+	device->fd = -1;
+	device->watch = -1;
+	device->hotplug = hotplug;
+	device->in_use = 1;
+
+	if (hotplug && evdev.inotify_fd >= 0) {
+		char dir[EVDEV_PATH_MAX] = ".";
+		if (slash == device->path) {
+			strcpy(dir, "/");
+		} else if (slash) {
+			size_t len = (size_t)(slash - device->path);
+			memcpy(dir, device->path, len);
+			dir[len] = '\0';
+		}
+		// inotify returns the existing descriptor when a directory is watched twice
+		device->watch = inotify_add_watch(evdev.inotify_fd, dir, IN_CREATE | IN_DELETE | IN_ATTRIB);
+		if (device->watch < 0)
+			LOG_errno_warn("evdev: unable to watch %s", dir);
+	}
+
+	openDevice(index);
+	return index;
+}
+
+int EVDEV_isConnected(int device) {
+	if (device < 0 || device >= EVDEV_MAX_DEVICES)
+		return 0;
+	return evdev.devices[device].in_use && evdev.devices[device].fd >= 0;
+}
+
+const char* EVDEV_getPath(int device) {
+	if (device < 0 || device >= EVDEV_MAX_DEVICES || !evdev.devices[device].in_use)
+		return NULL;
+	return evdev.devices[device].path;
+}
+
+void EVDEV_setHotplugCallback(EVDEV_HotplugCallback callback, void* userdata) {
+	evdev.hotplug_callback = callback;
+	evdev.hotplug_userdata = userdata;
+}
+
+void EVDEV_setEventTypes(uint32_t types) {
+	evdev.types = types;
+}
+
+int EVDEV_getFD(void) {
+	return evdev.epoll_fd;
+}
+
+///////////////////////////////
+// Event dispatch
+///////////////////////////////
+
+/**
+ * Applies pending inotify events to hotplug devices.
+ */
+static void handleHotplug(void) {
+	// aligned as required by inotify(7)
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	for (;;) {
+		ssize_t len = read(evdev.inotify_fd, buffer, sizeof(buffer));
+		if (len <= 0)
+			break;
+
+		for (char* ptr = buffer; ptr < buffer + len;) {
+			const struct inotify_event* ev = (const struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + ev->len;
+			if (!ev->len)
+				continue;
+
+			for (int i = 0; i < EVDEV_MAX_DEVICES; i++) {
+				EVDEV_Device* device = &evdev.devices[i];
+				if (!device->in_use || !device->hotplug || device->watch != ev->wd ||
+				    strcmp(device->name, ev->name) != 0)
+					continue;
+
+				if (ev->mask & IN_DELETE)
+					closeDevice(i);
+				else if (ev->mask & (IN_CREATE | IN_ATTRIB))
+					openDevice(i);
+			}
+		}
+	}
+}
+
+/**
+ * Drains a ready device in batches.
+ *
+ * @return Number of events dispatched
+ */
+static int drainDevice(int index, EVDEV_EventCallback callback, void* userdata) {
+	static EVDEV_Event events[EVDEV_BATCH_SIZE];
+	int count = 0;
+
+	for (;;) {
+		int fd = evdev.devices[index].fd;
+		if (fd < 0)
+			break;
+
+		ssize_t len = read(fd, events, sizeof(events));
+		if (len < 0) {
+			// a removed device reports ENODEV until it is closed
+			if (errno == ENODEV)
+				closeDevice(index);
+			break;
+		}
+		if (len == 0)
+			break;
+
+		int n = (int)(len / (ssize_t)sizeof(EVDEV_Event));
+		for (int i = 0; i < n; i++) {
+			const EVDEV_Event* event = &events[i];
+			if (event->type >= 32 || !(evdev.types & EVDEV_TYPE(event->type)))
+				continue;
+			if (callback)
+				callback(index, event, userdata);
+			count += 1;
+		}
+
+		// a short read means the device queue is empty
+		if (n < EVDEV_BATCH_SIZE)
+			break;
+	}
+	return count;
+}
+
+int EVDEV_wait(EVDEV_EventCallback callback, void* userdata, int timeout_ms) {
+	if (evdev.epoll_fd < 0)
+		return -1;
+
+	struct epoll_event ready[EVDEV_MAX_DEVICES + 1];
+	int n = epoll_wait(evdev.epoll_fd, ready, EVDEV_MAX_DEVICES + 1, timeout_ms);
+	if (n < 0)
+		return errno == EINTR ? 0 : -1;
+
+	// apply hotplug first so devices closed this round aren't read
+	for (int i = 0; i < n; i++) {
+		if (ready[i].data.u32 == EVDEV_INOTIFY_SLOT)
+			handleHotplug();
+	}
+
+	int count = 0;
+	for (int i = 0; i < n; i++) {
+		uint32_t index = ready[i].data.u32;
+		if (index >= EVDEV_MAX_DEVICES)
+			continue;
+		if (ready[i].events & EPOLLIN)
+			count += drainDevice((int)index, callback, userdata);
+		if (ready[i].events & EPOLLERR)
+			closeDevice((int)index);
+	}
+	return count;
+}
+
+int EVDEV_poll(EVDEV_EventCallback callback, void* userdata) {
+	return EVDEV_wait(callback, userdata, 0);
+}
+
+///////////////////////////////
+// Helpers
+///////////////////////////////
+
+int EVDEV_mapCode(const EVDEV_Mapping* map, int code) {
+	if (!map)
+		return -1;
+	for (; map->code != -1; map++) {
+		if (map->code == code)
+			return map->id;
+	}
+	return -1;
+}
+
+uint64_t EVDEV_eventTime(const EVDEV_Event* event) {
+	return (uint64_t)event->sec * 1000000 + (uint64_t)event->usec;
+}
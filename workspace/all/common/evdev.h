@@ -0,0 +1,227 @@
+/**
+ * evdev.h - Shared Linux evdev input backend
+ *
+ * Event-driven replacement for the per-platform loops that opened every
+ * /dev/input/eventN and read() one input_event at a time. All devices are
+ * registered with a single epoll instance, so an idle poll costs one
+ * epoll_wait() instead of one read() per device, and ready devices are
+ * drained in batches of EVDEV_BATCH_SIZE events per read().
+ *
+ * Devices added with hotplug enabled are watched through inotify on their
+ * parent directory (normally /dev/input), so external gamepads are opened
+ * and closed as their nodes appear and disappear rather than being probed
+ * with stat() from the frame loop.
+ *
+ * Platforms translate events to buttons with EVDEV_Mapping tables, so a
+ * PLAT_pollInput implementation reduces to a mapping table plus the
+ * handful of axes the device exposes.
+ */
+
+#ifndef __EVDEV_H__
+#define __EVDEV_H__
+
+#include <stdint.h>
+
+/**
+ * Maximum number of input devices tracked at once.
+ */
+#define EVDEV_MAX_DEVICES 8
+
+/**
+ * Maximum number of events read from a device per read() call.
+ */
+#define EVDEV_BATCH_SIZE 64
+
+/**
+ * Event types used by the platforms.
+ *
+ * Mirrors <linux/input.h>, which can't be included alongside platform.h
+ * because its BTN_* constants conflict with ours.
+ */
+#define EVDEV_EV_SYN 0x00
+#define EVDEV_EV_KEY 0x01
+#define EVDEV_EV_ABS 0x03
+#define EVDEV_EV_SW 0x05
+
+/**
+ * Builds an event type mask for EVDEV_setEventTypes().
+ */
+#define EVDEV_TYPE(type) (1u << (type))
+
+/**
+ * Event types dispatched unless changed with EVDEV_setEventTypes().
+ */
+#define EVDEV_TYPES_DEFAULT (EVDEV_TYPE(EVDEV_EV_KEY) | EVDEV_TYPE(EVDEV_EV_ABS))
+
+/**
+ * Common absolute axis codes.
+ */
+#define EVDEV_ABS_HAT0X 0x10
+#define EVDEV_ABS_HAT0Y 0x11
+
+/**
+ * A single input event.
+ *
+ * Same layout as the kernel's struct input_event so events can be read
+ * straight from the device without conversion. The kernel writes the
+ * timestamp as two longs, which struct timeval no longer matches on
+ * 32-bit targets built with a 64-bit time_t.
+ */
+typedef struct EVDEV_Event {
+	unsigned long sec;
+	unsigned long usec;
+	uint16_t type;
+	uint16_t code;
+	int32_t value;
+} EVDEV_Event;
+
+/**
+ * Maps a raw key code to a button ID.
+ *
+ * Tables are terminated by EVDEV_MAPPING_END. When a code appears
+ * more than once the first entry wins.
+ */
+typedef struct EVDEV_Mapping {
+	int code; // Raw evdev key code
+	int id; // BTN_ID_* value
+} EVDEV_Mapping;
+
+#define EVDEV_MAPPING_END {-1, -1}
+
+/**
+ * Called for every EV_KEY/EV_ABS event read during EVDEV_poll().
+ *
+ * @param device Device index returned by EVDEV_addDevice()
+ * @param event The event
+ * @param userdata Pointer passed to EVDEV_poll()
+ */
+typedef void (*EVDEV_EventCallback)(int device, const EVDEV_Event* event, void* userdata);
+
+/**
+ * Called when a hotplug device is connected or disconnected.
+ *
+ * @param device Device index returned by EVDEV_addDevice()
+ * @param connected 1 if the device was opened, 0 if it was closed
+ * @param userdata Pointer passed to EVDEV_setHotplugCallback()
+ */
+typedef void (*EVDEV_HotplugCallback)(int device, int connected, void* userdata);
+
+/**
+ * Initializes the backend (epoll instance and inotify watch).
+ *
+ * @return 0 on success, -1 on failure
+ */
+int EVDEV_init(void);
+
+/**
+ * Closes all devices, releases the epoll and inotify descriptors and
+ * restores the default event types.
+ */
+void EVDEV_quit(void);
+
+/**
+ * Registers an input device.
+ *
+ * The device is opened immediately if it exists. With hotplug enabled the
+ * parent directory is watched and the device is (re)opened or closed as
+ * its node is created or removed.
+ *
+ * @param path Device node path (e.g. "/dev/input/event3")
+ * @param hotplug 1 to watch for connect/disconnect, 0 for a fixed device
+ * @return Device index, or -1 if no slot is available
+ */
+int EVDEV_addDevice(const char* path, int hotplug);
+
+/**
+ * Checks if a registered device is currently open.
+ *
+ * @param device Device index
+ * @return 1 if open, 0 otherwise
+ */
+int EVDEV_isConnected(int device);
+
+/**
+ * Gets the path a device was registered with.
+ *
+ * @param device Device index
+ * @return Device path, or NULL for an invalid index
+ */
+const char* EVDEV_getPath(int device);
+
+/**
+ * Sets the hotplug callback.
+ *
+ * Invoked from EVDEV_poll() (and from EVDEV_addDevice() for devices that
+ * are already present) so platforms can identify the connected device.
+ *
+ * @param callback Callback, or NULL to disable
+ * @param userdata Passed through to the callback
+ */
+void EVDEV_setHotplugCallback(EVDEV_HotplugCallback callback, void* userdata);
+
+/**
+ * Selects which event types are passed to callbacks.
+ *
+ * Platform handlers treat every non-key event as an axis, so switch
+ * events (headphone jack, mute slider) are only dispatched on request.
+ *
+ * @param types Mask of EVDEV_TYPE() values, e.g. EVDEV_TYPES_DEFAULT
+ */
+void EVDEV_setEventTypes(uint32_t types);
+
+/**
+ * Gets the epoll descriptor.
+ *
+ * Becomes readable whenever any device has pending events or a hotplug
+ * change occurred, so it can be nested in another epoll set or poll().
+ *
+ * @return epoll file descriptor, or -1 if not initialized
+ */
+int EVDEV_getFD(void);
+
+/**
+ * Dispatches all pending events without blocking.
+ *
+ * Handles hotplug changes first, then drains every ready device.
+ * Only EV_KEY and EV_ABS events are passed to the callback, unless
+ * changed with EVDEV_setEventTypes().
+ *
+ * @param callback Event callback
+ * @param userdata Passed through to the callback
+ * @return Number of events dispatched, or -1 on error
+ */
+int EVDEV_poll(EVDEV_EventCallback callback, void* userdata);
+
+/**
+ * Waits up to timeout_ms for input, then dispatches pending events.
+ *
+ * @param callback Event callback
+ * @param userdata Passed through to the callback
+ * @param timeout_ms Maximum wait in milliseconds (-1 waits forever)
+ * @return Number of events dispatched, or -1 on error
+ */
+int EVDEV_wait(EVDEV_EventCallback callback, void* userdata, int timeout_ms);
+
+/**
+ * Looks up a raw key code in a mapping table.
+ *
+ * @param map Table terminated by EVDEV_MAPPING_END
+ * @param code Raw evdev key code
+ * @return Button ID, or -1 (BTN_ID_NONE) if the code isn't mapped
+ */
+int EVDEV_mapCode(const EVDEV_Mapping* map, int code);
+
+/**
+ * Converts an event timestamp to microseconds.
+ *
+ * Devices are switched to CLOCK_MONOTONIC when opened, so this is
+ * directly comparable with LAT_now() and clock_gettime(CLOCK_MONOTONIC).
+ * A device that refuses the switch (logged when it is opened) keeps
+ * wall-clock timestamps, which read as far in the future.
+ *
+ * @param event The event
+ * @return Kernel timestamp in microseconds
+ */
+uint64_t EVDEV_eventTime(const EVDEV_Event* event);
+
+#endif // __EVDEV_H__
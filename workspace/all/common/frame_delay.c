@@ -0,0 +1,36 @@
+/**
+ * frame_delay.c - Automatic frame delay scheduling
+ */
+
+#include "frame_delay.h"
+
+void FrameDelay_init(FrameDelay* delay, double fps) {
+	delay->frame_us = fps > 0 ? (uint32_t)(1000000.0 / fps) : 0;
+	FrameDelay_reset(delay);
+}
+
+void FrameDelay_reset(FrameDelay* delay) {
+	delay->work_us = 0;
+	delay->has_sample = 0;
+}
+
+void FrameDelay_addSample(FrameDelay* delay, uint32_t work_us) {
+	if (!delay->has_sample || work_us >= delay->work_us) {
+		delay->work_us = work_us;
+		delay->has_sample = 1;
+		return;
+	}
+
+	uint32_t decayed = delay->work_us - delay->work_us / FRAME_DELAY_DECAY;
+	delay->work_us = decayed > work_us ? decayed : work_us;
+}
+
+uint32_t FrameDelay_getDelay(const FrameDelay* delay) {
+	if (!delay->has_sample)
+		return 0;
+
+	uint32_t busy = delay->work_us + FRAME_DELAY_MARGIN_US;
+	if (busy >= delay->frame_us)
+		return 0;
+	return delay->frame_us - busy;
+}
@@ -0,0 +1,73 @@
+/**
+ * frame_delay.h - Automatic frame delay scheduling
+ *
+ * With vsync the frontend loop wakes right after a flip and immediately runs
+ * the core, so input is sampled almost a full frame before the result can
+ * be shown. Frame delay sleeps first and runs the core as late as possible,
+ * moving the input poll closer to the next vsync.
+ *
+ * The delay is derived from measured frame work (core.run() start until the
+ * frame is handed to GFX_flip). The estimate rises immediately on a slow
+ * frame and decays slowly, so a single heavy frame backs the delay off right
+ * away while it takes a sustained stretch of light frames to creep back.
+ *
+ * Extracted as pure logic so the estimator can be tested without a core.
+ */
+
+#ifndef __FRAME_DELAY_H__
+#define __FRAME_DELAY_H__
+
+#include <stdint.h>
+
+/**
+ * Safety margin kept between estimated work and the frame deadline.
+ */
+#define FRAME_DELAY_MARGIN_US 2000
+
+/**
+ * Estimate decays by 1/FRAME_DELAY_DECAY per sample (~1s half-life at 60fps).
+ */
+#define FRAME_DELAY_DECAY 64
+
+/**
+ * Frame delay estimator state.
+ */
+typedef struct FrameDelay {
+	uint32_t frame_us; // Target frame time
+	uint32_t work_us; // Decaying maximum of recent frame work
+	int has_sample; // 1 once work_us holds a real measurement
+} FrameDelay;
+
+/**
+ * Initializes the estimator for a frame rate.
+ *
+ * @param delay Estimator to initialize
+ * @param fps Core frame rate (e.g. 60.0988)
+ */
+void FrameDelay_init(FrameDelay* delay, double fps);
+
+/**
+ * Forgets all measurements, e.g. after a state load or menu exit.
+ *
+ * @param delay Estimator to reset
+ */
+void FrameDelay_reset(FrameDelay* delay);
+
+/**
+ * Adds a frame work measurement.
+ *
+ * @param delay Estimator to update
+ * @param work_us Time from core.run() start to the frame being presented
+ */
+void FrameDelay_addSample(FrameDelay* delay, uint32_t work_us);
+
+/**
+ * Gets the time to sleep before running the next frame.
+ *
+ * @param delay Estimator to query
+ * @return Delay in microseconds, 0 until a measurement is available or
+ *         when the frame work leaves no room
+ */
+uint32_t FrameDelay_getDelay(const FrameDelay* delay);
+
+#endif // __FRAME_DELAY_H__
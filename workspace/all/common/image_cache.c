@@ -0,0 +1,258 @@
+/**
+ * image_cache.c - Images decoded in the background and kept by path
+ */
+
+#include "image_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ImageCache_Entry* findEntry(ImageCache* cache, const char* path) {
+	for (int i = 0; i < cache->size; i++) {
+		ImageCache_Entry* entry = &cache->entries[i];
+		if (entry->path[0] && !strcmp(entry->path, path))
+			return entry;
+	}
+	return NULL;
+}
+
+/**
+ * Returns the entry for path, recycling the least recently used one if
+ * it isn't cached. Must hold the mutex.
+ */
+static ImageCache_Entry* useEntry(ImageCache* cache, const char* path) {
+	ImageCache_Entry* entry = findEntry(cache, path);
+	if (!entry) {
+		entry = &cache->entries[0];
+		for (int i = 1; i < cache->size; i++) {
+			if (cache->entries[i].used < entry->used)
+				entry = &cache->entries[i];
+		}
+		if (entry->image)
+			cache->free_image(entry->image);
+		entry->image = NULL;
+		snprintf(entry->path, sizeof(entry->path), "%s", path);
+		entry->state = IMAGE_NONE;
+	}
+	entry->used = ++cache->clock;
+	return entry;
+}
+
+static int isMissing(ImageCache* cache, const char* path) {
+	int id = KeyIndex_find(&cache->missing_index, path);
+	return id >= 0 && cache->paths[id].missing;
+}
+
+/**
+ * Remembers whether path is missing. Must hold the mutex.
+ */
+static void setMissing(ImageCache* cache, const char* path, int missing) {
+	int id = KeyIndex_find(&cache->missing_index, path);
+	if (id >= 0) {
+		cache->paths[id].missing = missing;
+		return;
+	}
+	if (!missing)
+		return;
+
+	// the index doesn't grow, rebuild it twice as large when full
+	if (cache->path_count == cache->path_capacity) {
+		int capacity = cache->path_capacity ? cache->path_capacity * 2 : 16;
+		ImageCache_Path* paths = realloc(cache->paths, capacity * sizeof(ImageCache_Path));
+		if (!paths)
+			return;
+		cache->paths = paths;
+		cache->path_capacity = capacity;
+
+		KeyIndex_free(&cache->missing_index);
+		if (KeyIndex_init(&cache->missing_index, capacity) != 0)
+			return;
+		for (int i = 0; i < cache->path_count; i++)
+			KeyIndex_add(&cache->missing_index, cache->paths[i].path, i);
+	}
+
+	char* copy = strdup(path);
+	if (!copy)
+		return;
+	cache->paths[cache->path_count].path = copy;
+	cache->paths[cache->path_count].missing = 1;
+	KeyIndex_add(&cache->missing_index, copy, cache->path_count);
+	cache->path_count += 1;
+}
+
+/**
+ * Returns the next free job slot, NULL if the queue is full. Must hold
+ * the mutex.
+ */
+static ImageCache_Job* pushJob(ImageCache* cache, const char* path, void* image) {
+	if (cache->count == IMAGE_QUEUE_SIZE)
+		return NULL;
+
+	ImageCache_Job* job = &cache->jobs[(cache->head + cache->count) % IMAGE_QUEUE_SIZE];
+	snprintf(job->path, sizeof(job->path), "%s", path);
+	job->image = image;
+	cache->count += 1;
+	pthread_cond_broadcast(&cache->cond);
+	return job;
+}
+
+static void* workerThread(void* arg) {
+	ImageCache* cache = arg;
+
+	pthread_mutex_lock(&cache->mutex);
+	while (1) {
+		while (!cache->count && !cache->quit)
+			pthread_cond_wait(&cache->cond, &cache->mutex);
+		if (!cache->count)
+			break;
+
+		// the head job stays queued until done, so its slot isn't reused meanwhile
+		ImageCache_Job* job = &cache->jobs[cache->head];
+		if (job->image) {
+			pthread_mutex_unlock(&cache->mutex);
+
+			int result = cache->save_image(job->image, job->path, cache->userdata);
+			cache->free_image(job->image);
+
+			pthread_mutex_lock(&cache->mutex);
+			job->image = NULL;
+			if (result == 0)
+				cache->saves += 1;
+			else
+				cache->errors += 1;
+		} else if (!cache->quit) {
+			ImageCache_Entry* entry = findEntry(cache, job->path);
+			if (entry && entry->state == IMAGE_LOADING) {
+				cache->loads += 1;
+				pthread_mutex_unlock(&cache->mutex);
+
+				void* image = cache->load_image(job->path, cache->userdata);
+
+				pthread_mutex_lock(&cache->mutex);
+				// the entry may have been recycled or stored over since
+				entry = findEntry(cache, job->path);
+				if (entry && entry->state == IMAGE_LOADING) {
+					entry->image = image;
+					entry->state = image ? IMAGE_READY : IMAGE_MISSING;
+					if (!image)
+						setMissing(cache, job->path, 1);
+				} else if (image)
+					cache->free_image(image);
+			}
+		}
+
+		cache->head = (cache->head + 1) % IMAGE_QUEUE_SIZE;
+		cache->count -= 1;
+		pthread_cond_broadcast(&cache->cond);
+	}
+	pthread_mutex_unlock(&cache->mutex);
+	return NULL;
+}
+
+int ImageCache_start(ImageCache* cache, int size, ImageCache_LoadFunction load_image,
+                     ImageCache_SaveFunction save_image, ImageCache_FreeFunction free_image,
+                     void* userdata) {
+	memset(cache, 0, sizeof(ImageCache));
+	cache->size = size < 1 ? 1 : size > IMAGE_CACHE_SIZE ? IMAGE_CACHE_SIZE : size;
+	cache->load_image = load_image;
+	cache->save_image = save_image;
+	cache->free_image = free_image;
+	cache->userdata = userdata;
+
+	pthread_mutex_init(&cache->mutex, NULL);
+	pthread_cond_init(&cache->cond, NULL);
+	if (pthread_create(&cache->thread, NULL, workerThread, cache) != 0) {
+		pthread_cond_destroy(&cache->cond);
+		pthread_mutex_destroy(&cache->mutex);
+		return -1;
+	}
+	cache->running = 1;
+	return 0;
+}
+
+int ImageCache_request(ImageCache* cache, const char* path, void** image) {
+	if (image)
+		*image = NULL;
+	if (!cache->running)
+		return IMAGE_NONE;
+
+	pthread_mutex_lock(&cache->mutex);
+	ImageCache_Entry* entry = useEntry(cache, path);
+	if (entry->state == IMAGE_NONE) {
+		if (isMissing(cache, path))
+			entry->state = IMAGE_MISSING;
+		else if (pushJob(cache, path, NULL))
+			entry->state = IMAGE_LOADING;
+	}
+	int state = entry->state;
+	if (state == IMAGE_READY && image)
+		*image = entry->image;
+	pthread_mutex_unlock(&cache->mutex);
+	return state;
+}
+
+int ImageCache_store(ImageCache* cache, const char* path, void* image, void* copy) {
+	if (!cache->running)
+		return -1;
+
+	pthread_mutex_lock(&cache->mutex);
+	while (cache->count == IMAGE_QUEUE_SIZE)
+		pthread_cond_wait(&cache->cond, &cache->mutex);
+
+	ImageCache_Entry* entry = useEntry(cache, path);
+	if (entry->image)
+		cache->free_image(entry->image);
+	entry->image = image;
+	entry->state = IMAGE_READY;
+	setMissing(cache, path, 0);
+	pushJob(cache, path, copy);
+	pthread_mutex_unlock(&cache->mutex);
+	return 0;
+}
+
+void ImageCache_retry(ImageCache* cache, const char* path) {
+	if (!cache->running)
+		return;
+
+	pthread_mutex_lock(&cache->mutex);
+	setMissing(cache, path, 0);
+	ImageCache_Entry* entry = findEntry(cache, path);
+	if (entry && entry->state == IMAGE_MISSING)
+		entry->state = IMAGE_NONE;
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void ImageCache_flush(ImageCache* cache) {
+	if (!cache->running)
+		return;
+
+	pthread_mutex_lock(&cache->mutex);
+	while (cache->count)
+		pthread_cond_wait(&cache->cond, &cache->mutex);
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void ImageCache_stop(ImageCache* cache) {
+	if (!cache->running)
+		return;
+
+	// a load in progress finishes, the queued ones are dropped, writes aren't
+	pthread_mutex_lock(&cache->mutex);
+	cache->quit = 1;
+	pthread_cond_broadcast(&cache->cond);
+	pthread_mutex_unlock(&cache->mutex);
+	pthread_join(cache->thread, NULL);
+
+	pthread_cond_destroy(&cache->cond);
+	pthread_mutex_destroy(&cache->mutex);
+	for (int i = 0; i < cache->size; i++) {
+		if (cache->entries[i].image)
+			cache->free_image(cache->entries[i].image);
+	}
+	for (int i = 0; i < cache->path_count; i++)
+		free(cache->paths[i].path);
+	free(cache->paths);
+	KeyIndex_free(&cache->missing_index);
+	memset(cache, 0, sizeof(ImageCache));
+}
@@ -0,0 +1,189 @@
+/**
+ * image_cache.h - Images decoded in the background and kept by path
+ *
+ * minui-list used to check every item's background image with access()
+ * while loading the list, and decoded and scaled the selected item's
+ * image again on every redraw. Images are now loaded by a worker thread
+ * the first time they're shown (or prefetched for the neighbouring
+ * items), through a caller supplied function that can also scale them to
+ * the size they're drawn at. The most recently used ones stay in memory,
+ * and which paths turned out to be missing is remembered for as long as
+ * the cache runs, so scrolling back doesn't stat them again.
+ *
+ * The worker can also write images, for callers that create them (minarch
+ * save state previews): a stored image shows right away and its copy is
+ * written to disk in the background.
+ *
+ * Images are opaque to the cache, it only hands them to the caller's
+ * functions. All functions except the worker itself are meant to be
+ * called from a single thread (the UI).
+ */
+
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "config_store.h"
+
+#define IMAGE_CACHE_SIZE 8 // Most entries a cache can have, the selected item, a few neighbors and spares
+#define IMAGE_QUEUE_SIZE 4
+
+enum {
+	IMAGE_NONE, // Not requested yet, or couldn't be queued
+	IMAGE_LOADING,
+	IMAGE_READY,
+	IMAGE_MISSING, // No such file, or it couldn't be decoded
+};
+
+/**
+ * Loads an image, called on the worker thread.
+ *
+ * @param path Image file
+ * @param userdata As given to ImageCache_start()
+ * @return The image, or NULL if it's missing or invalid
+ */
+typedef void* (*ImageCache_LoadFunction)(const char* path, void* userdata);
+
+/**
+ * Writes an image, called on the worker thread.
+ *
+ * @param image Image passed to ImageCache_store() as the copy
+ * @param path Image file
+ * @param userdata As given to ImageCache_start()
+ * @return 0 on success, -1 on failure
+ */
+typedef int (*ImageCache_SaveFunction)(void* image, const char* path, void* userdata);
+
+/**
+ * Frees an image, called on either thread.
+ */
+typedef void (*ImageCache_FreeFunction)(void* image);
+
+typedef struct ImageCache_Entry {
+	char path[512]; // Empty if the entry is unused
+	int state;
+	uint32_t used; // Last use, for LRU eviction
+	void* image; // Only set when READY
+} ImageCache_Entry;
+
+typedef struct ImageCache_Job {
+	char path[512];
+	void* image; // Copy to write to path, NULL to load path
+} ImageCache_Job;
+
+typedef struct ImageCache_Path {
+	char* path; // Owned, indexed by the cache's missing_index
+	int missing; // Cleared when the path is retried or stored
+} ImageCache_Path;
+
+/**
+ * Image LRU cache and its worker thread.
+ */
+typedef struct ImageCache {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int running; // Thread was started
+	int size; // Entries in use, at most IMAGE_CACHE_SIZE
+	ImageCache_LoadFunction load_image;
+	ImageCache_SaveFunction save_image;
+	ImageCache_FreeFunction free_image;
+	void* userdata;
+
+	// guarded by mutex
+	ImageCache_Entry entries[IMAGE_CACHE_SIZE];
+	ImageCache_Job jobs[IMAGE_QUEUE_SIZE]; // Ring, the head job stays queued while it runs
+	int head;
+	int count;
+	int quit;
+	uint32_t clock; // Use counter for LRU
+	int loads; // Images the load function was called for
+	int saves; // Completed writes
+	int errors; // Failed writes
+
+	// Paths that were ever found missing, unlike entries never evicted
+	ImageCache_Path* paths;
+	int path_count;
+	int path_capacity;
+	KeyIndex missing_index; // Path to index in paths, rebuilt when it fills up
+} ImageCache;
+
+/**
+ * Starts the worker thread.
+ *
+ * @param cache Cache to start
+ * @param size Images kept in memory, clamped to IMAGE_CACHE_SIZE
+ * @param load_image Loads an image on the worker thread
+ * @param save_image Writes an image on the worker thread, may be NULL if
+ * nothing is ever stored
+ * @param free_image Frees an image
+ * @param userdata Passed to load_image and save_image
+ * @return 0 on success, -1 if the thread couldn't be started
+ */
+int ImageCache_start(ImageCache* cache, int size, ImageCache_LoadFunction load_image,
+                     ImageCache_SaveFunction save_image, ImageCache_FreeFunction free_image,
+                     void* userdata);
+
+/**
+ * Looks up an image, queueing a background load on a miss.
+ *
+ * Never blocks. Keep calling while it returns IMAGE_LOADING (or
+ * IMAGE_NONE, when the queue was full). The returned image stays valid
+ * until the next call to ImageCache_request() or ImageCache_store().
+ *
+ * Paths found missing once stay IMAGE_MISSING without touching the disk,
+ * even after their entry was evicted, until ImageCache_retry().
+ *
+ * Loads whose entry was evicted before the worker got to them are
+ * skipped, so prefetching while scrolling quickly doesn't pile up work.
+ *
+ * @param cache Running cache
+ * @param path Image file
+ * @param image Set to the image when READY (may be NULL to prefetch)
+ * @return IMAGE_* state of the image
+ */
+int ImageCache_request(ImageCache* cache, const char* path, void** image);
+
+/**
+ * Caches a new image and queues writing it to disk.
+ *
+ * Replaces whatever was cached or being loaded for path. Waits only if
+ * the queue is full.
+ *
+ * @param cache Running cache
+ * @param path Image file
+ * @param image Cached right away, owned by the cache from now on
+ * @param copy Written by save_image and then freed on the worker thread,
+ * owned by the cache from now on
+ * @return 0 if queued, -1 if not running (the caller still owns both)
+ */
+int ImageCache_store(ImageCache* cache, const char* path, void* image, void* copy);
+
+/**
+ * Forgets that an image was missing, so the next request loads it again.
+ *
+ * For images that are still being written by another process.
+ *
+ * @param cache Running cache
+ * @param path Image file
+ */
+void ImageCache_retry(ImageCache* cache, const char* path);
+
+/**
+ * Waits until every queued job has finished.
+ *
+ * @param cache Cache to wait for
+ */
+void ImageCache_flush(ImageCache* cache);
+
+/**
+ * Drops queued loads, finishes queued writes, stops the thread and frees
+ * all images.
+ *
+ * @param cache Cache to stop, may have never been started
+ */
+void ImageCache_stop(ImageCache* cache);
+
+#endif // __IMAGE_CACHE_H__
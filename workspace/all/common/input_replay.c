@@ -0,0 +1,156 @@
+/**
+ * input_replay.c - Deterministic input recordings for benchmarks
+ */
+
+#include "input_replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADER_WORDS 5
+#define MAX_RUNS (1u << 22) // 64MB of runs, days of play
+
+///////////////////////////////
+// Recording
+///////////////////////////////
+
+static int writeHeader(InputRecorder* recorder) {
+	uint32_t header[HEADER_WORDS] = {INPUT_REPLAY_MAGIC, INPUT_REPLAY_VERSION, recorder->state_size,
+	                                 recorder->frame_count, recorder->run_count};
+	return fwrite(header, sizeof(header), 1, recorder->file) == 1 ? 0 : -1;
+}
+
+int InputRecorder_open(InputRecorder* recorder, const char* path, const void* state,
+                       uint32_t state_size) {
+	memset(recorder, 0, sizeof(InputRecorder));
+	recorder->state_size = state_size;
+
+	recorder->file = fopen(path, "wb");
+	if (!recorder->file)
+		return -1;
+
+	// counts are filled in on close
+	if (writeHeader(recorder) != 0 ||
+	    (state_size && fwrite(state, state_size, 1, recorder->file) != 1)) {
+		fclose(recorder->file);
+		recorder->file = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+int InputRecorder_add(InputRecorder* recorder, const InputReplay_Frame* frame) {
+	if (!recorder->file)
+		return -1;
+
+	recorder->frame_count += 1;
+	if (recorder->run.count &&
+	    !memcmp(&recorder->run.frame, frame, sizeof(InputReplay_Frame))) {
+		recorder->run.count += 1;
+		return 0;
+	}
+
+	int result = 0;
+	if (recorder->run.count) {
+		if (fwrite(&recorder->run, sizeof(InputReplay_Run), 1, recorder->file) != 1)
+			result = -1;
+		recorder->run_count += 1;
+	}
+	recorder->run.count = 1;
+	recorder->run.frame = *frame;
+	return result;
+}
+
+int InputRecorder_close(InputRecorder* recorder) {
+	if (!recorder->file)
+		return 0;
+
+	int ok = 1;
+	if (recorder->run.count) {
+		ok = fwrite(&recorder->run, sizeof(InputReplay_Run), 1, recorder->file) == 1;
+		recorder->run_count += 1;
+		recorder->run.count = 0;
+	}
+	ok = fseek(recorder->file, 0, SEEK_SET) == 0 && writeHeader(recorder) == 0 && ok;
+	ok = fclose(recorder->file) == 0 && ok;
+	recorder->file = NULL;
+	return ok ? 0 : -1;
+}
+
+///////////////////////////////
+// Replay
+///////////////////////////////
+
+int InputReplay_load(InputReplay* replay, const char* path) {
+	memset(replay, 0, sizeof(InputReplay));
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return -1;
+
+	uint32_t header[HEADER_WORDS];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != INPUT_REPLAY_MAGIC ||
+	    header[1] != INPUT_REPLAY_VERSION || header[4] > header[3] ||
+	    header[4] > MAX_RUNS) {
+		fclose(file);
+		return -1;
+	}
+	replay->state_size = header[2];
+	replay->frame_count = header[3];
+	replay->run_count = header[4];
+
+	replay->state = malloc(replay->state_size ? replay->state_size : 1);
+	replay->runs = malloc(replay->run_count ? replay->run_count * sizeof(InputReplay_Run) : 1);
+	int ok = replay->state && replay->runs &&
+	         fread(replay->state, 1, replay->state_size, file) == replay->state_size &&
+	         fread(replay->runs, sizeof(InputReplay_Run), replay->run_count, file) ==
+	             replay->run_count;
+	fclose(file);
+
+	// the runs must add up to the frame count, or the file was cut short
+	uint32_t frames = 0;
+	for (uint32_t i = 0; ok && i < replay->run_count; i++)
+		frames += replay->runs[i].count;
+	if (!ok || frames != replay->frame_count) {
+		InputReplay_free(replay);
+		return -1;
+	}
+	return 0;
+}
+
+int InputReplay_next(InputReplay* replay, InputReplay_Frame* frame) {
+	while (replay->run_index < replay->run_count) {
+		InputReplay_Run* run = &replay->runs[replay->run_index];
+		if (replay->run_offset < run->count) {
+			replay->run_offset += 1;
+			*frame = run->frame;
+			return 0;
+		}
+		replay->run_index += 1;
+		replay->run_offset = 0;
+	}
+	return -1;
+}
+
+void InputReplay_free(InputReplay* replay) {
+	free(replay->state);
+	free(replay->runs);
+	memset(replay, 0, sizeof(InputReplay));
+}
+
+uint64_t InputReplay_hashFrame(uint64_t hash, const void* pixels, size_t row_bytes, int height,
+                               size_t pitch) {
+	const uint64_t prime = 0x100000001b3ull;
+	for (int y = 0; y < height; y++) {
+		const uint8_t* row = (const uint8_t*)pixels + (size_t)y * pitch;
+		size_t x = 0;
+		for (; x + 8 <= row_bytes; x += 8) {
+			uint64_t word;
+			memcpy(&word, row + x, 8);
+			hash = (hash ^ word) * prime;
+		}
+		for (; x < row_bytes; x++)
+			hash = (hash ^ row[x]) * prime;
+	}
+	return hash;
+}
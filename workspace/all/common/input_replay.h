@@ -0,0 +1,145 @@
+/**
+ * input_replay.h - Deterministic input recordings for benchmarks
+ *
+ * Comparing performance between builds needs identical workloads, but
+ * gameplay is interactive. A recording captures the save state a session
+ * started from and the input the core saw on every frame, so a later run
+ * can restore the state, feed the same input back without anyone at the
+ * controls and compare frame hashes and timings.
+ *
+ * File layout (native endianness, recordings are compared on the device
+ * they were made on):
+ *   uint32_t magic (INPUT_REPLAY_MAGIC)
+ *   uint32_t version (INPUT_REPLAY_VERSION)
+ *   uint32_t state_size
+ *   uint32_t frame_count
+ *   uint32_t run_count
+ *   uint8_t  state[state_size]
+ *   InputReplay_Run runs[run_count]
+ *
+ * Input is run-length encoded: a held or idle pad is one run however many
+ * frames it lasts, so a minute of play is usually a few kilobytes.
+ */
+
+#ifndef __INPUT_REPLAY_H__
+#define __INPUT_REPLAY_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define INPUT_REPLAY_MAGIC 0x5052494d // "MIRP"
+#define INPUT_REPLAY_VERSION 1
+#define INPUT_REPLAY_HASH_SEED 0xcbf29ce484222325ull
+
+/**
+ * Input for one frame.
+ */
+typedef struct InputReplay_Frame {
+	uint32_t buttons; // RETRO_DEVICE_ID_JOYPAD_* flags
+	int16_t axes[4]; // Left x, left y, right x, right y
+} InputReplay_Frame;
+
+/**
+ * Identical input over consecutive frames.
+ */
+typedef struct InputReplay_Run {
+	uint32_t count; // Number of frames
+	InputReplay_Frame frame;
+} InputReplay_Run;
+
+///////////////////////////////
+// Recording
+///////////////////////////////
+
+typedef struct InputRecorder {
+	FILE* file;
+	InputReplay_Run run; // Current run, not written yet
+	uint32_t frame_count;
+	uint32_t run_count;
+	uint32_t state_size;
+} InputRecorder;
+
+/**
+ * Creates a recording.
+ *
+ * @param recorder Recorder to open
+ * @param path Recording file
+ * @param state Save state the session starts from
+ * @param state_size Size of the state in bytes
+ * @return 0 on success, -1 on error
+ */
+int InputRecorder_open(InputRecorder* recorder, const char* path, const void* state,
+                       uint32_t state_size);
+
+/**
+ * Records one frame's input.
+ *
+ * @param recorder Open recorder
+ * @param frame Input the core saw this frame
+ * @return 0 on success, -1 on write error
+ */
+int InputRecorder_add(InputRecorder* recorder, const InputReplay_Frame* frame);
+
+/**
+ * Writes the last run and the final counts, and closes the file.
+ *
+ * @param recorder Recorder to close, may be closed already
+ * @return 0 on success, -1 on write error
+ */
+int InputRecorder_close(InputRecorder* recorder);
+
+///////////////////////////////
+// Replay
+///////////////////////////////
+
+typedef struct InputReplay {
+	void* state;
+	uint32_t state_size;
+	uint32_t frame_count;
+	InputReplay_Run* runs;
+	uint32_t run_count;
+	uint32_t run_index; // Run the next frame comes from
+	uint32_t run_offset; // Frames of that run already replayed
+} InputReplay;
+
+/**
+ * Reads a recording.
+ *
+ * @param replay Replay to fill, free with InputReplay_free()
+ * @param path Recording file
+ * @return 0 on success, -1 if missing, truncated or invalid
+ */
+int InputReplay_load(InputReplay* replay, const char* path);
+
+/**
+ * Returns the next frame's input.
+ *
+ * @param replay Loaded replay
+ * @param frame Set to the input
+ * @return 0 on success, -1 once every frame was replayed
+ */
+int InputReplay_next(InputReplay* replay, InputReplay_Frame* frame);
+
+/**
+ * Releases a replay.
+ *
+ * @param replay Replay to free
+ */
+void InputReplay_free(InputReplay* replay);
+
+/**
+ * Folds a video frame into a running hash (64-bit FNV-1a over words).
+ *
+ * Only the visible bytes of each row are hashed, padding is skipped.
+ *
+ * @param hash Hash so far, INPUT_REPLAY_HASH_SEED for the first frame
+ * @param pixels Frame pixels
+ * @param row_bytes Visible bytes per row
+ * @param height Number of rows
+ * @param pitch Row stride in bytes
+ * @return Updated hash
+ */
+uint64_t InputReplay_hashFrame(uint64_t hash, const void* pixels, size_t row_bytes, int height,
+                               size_t pitch);
+
+#endif // __INPUT_REPLAY_H__
@@ -0,0 +1,429 @@
+/**
+ * json_stream.c - Incremental JSON tokenizer
+ */
+
+#include "json_stream.h"
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// What the grammar allows next
+enum {
+	EXPECT_VALUE, // Document start, after ':' or after ',' in an array
+	EXPECT_VALUE_OR_END, // After '['
+	EXPECT_KEY, // After ',' in an object
+	EXPECT_KEY_OR_END, // After '{'
+	EXPECT_COLON, // After a key
+	EXPECT_COMMA_OR_END, // After a value in a container
+	EXPECT_DONE, // After the root value
+	EXPECT_NOTHING, // After END or ERROR
+};
+
+#define NUMBER_MAX 64 // Longest number literal, parson's strtod accepts more but nothing sane is longer
+
+///////////////////////////////
+// Input
+///////////////////////////////
+
+static int refill(JsonStream* stream) {
+	if (stream->eof)
+		return 0;
+
+	ssize_t count;
+	do {
+		count = read(stream->fd, stream->buffer, sizeof(stream->buffer));
+	} while (count < 0 && errno == EINTR);
+
+	stream->position = 0;
+	stream->length = count > 0 ? (size_t)count : 0;
+	if (count <= 0) {
+		stream->eof = 1;
+		if (count < 0)
+			stream->error = "read error";
+		return 0;
+	}
+	return 1;
+}
+
+// Returns the next byte without consuming it, -1 at end of input
+static inline int peek(JsonStream* stream) {
+	if (stream->position == stream->length && !refill(stream))
+		return -1;
+	return (unsigned char)stream->buffer[stream->position];
+}
+
+static inline int get(JsonStream* stream) {
+	int c = peek(stream);
+	if (c >= 0)
+		stream->position += 1;
+	return c;
+}
+
+// Skips whitespace and comments, returns the next byte without consuming it
+static int skipSpace(JsonStream* stream) {
+	for (;;) {
+		int c = peek(stream);
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+			stream->position += 1;
+			continue;
+		}
+		if (c != '/')
+			return c;
+
+		stream->position += 1;
+		c = get(stream);
+		if (c == '/') {
+			while ((c = get(stream)) >= 0 && c != '\n')
+				;
+		} else if (c == '*') {
+			int last = 0;
+			while ((c = get(stream)) >= 0 && !(last == '*' && c == '/'))
+				last = c;
+			if (c < 0)
+				return -2; // unterminated comment
+		} else {
+			return -2; // a lone '/'
+		}
+	}
+}
+
+///////////////////////////////
+// Tokens
+///////////////////////////////
+
+static JsonStream_Token fail(JsonStream* stream, const char* error) {
+	if (!stream->error)
+		stream->error = error;
+	stream->expect = EXPECT_NOTHING;
+	return JSON_STREAM_ERROR;
+}
+
+static int appendString(JsonStream* stream, const char* bytes, size_t count) {
+	if (stream->string_length + count + 1 > stream->string_capacity) {
+		size_t capacity = stream->string_capacity ? stream->string_capacity : 64;
+		while (capacity < stream->string_length + count + 1)
+			capacity *= 2;
+		char* string = realloc(stream->string, capacity);
+		if (!string)
+			return -1;
+		stream->string = string;
+		stream->string_capacity = capacity;
+	}
+	memcpy(stream->string + stream->string_length, bytes, count);
+	stream->string_length += count;
+	stream->string[stream->string_length] = '\0';
+	return 0;
+}
+
+static int readHex(JsonStream* stream, unsigned* value) {
+	*value = 0;
+	for (int i = 0; i < 4; i++) {
+		int c = get(stream);
+		int digit;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return -1;
+		*value = (*value << 4) | (unsigned)digit;
+	}
+	return 0;
+}
+
+// Reads a \u escape (the backslash and u are consumed) as UTF-8
+static int readUnicode(JsonStream* stream) {
+	unsigned cp;
+	if (readHex(stream, &cp) != 0)
+		return -1;
+
+	if (cp >= 0xDC00 && cp <= 0xDFFF)
+		return -1; // trail surrogate before lead surrogate
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		unsigned trail;
+		if (get(stream) != '\\' || get(stream) != 'u' || readHex(stream, &trail) != 0 ||
+		    trail < 0xDC00 || trail > 0xDFFF)
+			return -1;
+		cp = (((cp - 0xD800) << 10) | (trail - 0xDC00)) + 0x10000;
+	}
+
+	char utf8[4];
+	size_t count;
+	if (cp < 0x80) {
+		utf8[0] = (char)cp;
+		count = 1;
+	} else if (cp < 0x800) {
+		utf8[0] = (char)(0xC0 | (cp >> 6));
+		utf8[1] = (char)(0x80 | (cp & 0x3F));
+		count = 2;
+	} else if (cp < 0x10000) {
+		utf8[0] = (char)(0xE0 | (cp >> 12));
+		utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		utf8[2] = (char)(0x80 | (cp & 0x3F));
+		count = 3;
+	} else {
+		utf8[0] = (char)(0xF0 | (cp >> 18));
+		utf8[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		utf8[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		utf8[3] = (char)(0x80 | (cp & 0x3F));
+		count = 4;
+	}
+	return appendString(stream, utf8, count);
+}
+
+// Reads a string (the opening quote is consumed) into stream->string
+static int readString(JsonStream* stream) {
+	stream->string_length = 0;
+	if (appendString(stream, "", 0) != 0)
+		return -1;
+
+	for (;;) {
+		if (peek(stream) < 0)
+			return -1;
+
+		// copy the plain run in the buffer at once
+		const char* start = stream->buffer + stream->position;
+		const char* end = stream->buffer + stream->length;
+		const char* c = start;
+		while (c < end && *c != '"' && *c != '\\' && (unsigned char)*c >= 0x20)
+			c++;
+		if (c > start && appendString(stream, start, (size_t)(c - start)) != 0)
+			return -1;
+		stream->position += (size_t)(c - start);
+		if (c == end)
+			continue;
+
+		stream->position += 1;
+		if (*c == '"')
+			return 0;
+		if (*c != '\\')
+			return -1; // control characters must be escaped
+
+		int escape = get(stream);
+		char byte;
+		switch (escape) {
+		case '"':
+			byte = '"';
+			break;
+		case '\\':
+			byte = '\\';
+			break;
+		case '/':
+			byte = '/';
+			break;
+		case 'b':
+			byte = '\b';
+			break;
+		case 'f':
+			byte = '\f';
+			break;
+		case 'n':
+			byte = '\n';
+			break;
+		case 'r':
+			byte = '\r';
+			break;
+		case 't':
+			byte = '\t';
+			break;
+		case 'u':
+			if (readUnicode(stream) != 0)
+				return -1;
+			continue;
+		default:
+			return -1;
+		}
+		if (appendString(stream, &byte, 1) != 0)
+			return -1;
+	}
+}
+
+// Reads a number starting with first (already consumed) into stream->number
+static int readNumber(JsonStream* stream, int first) {
+	char text[NUMBER_MAX + 1];
+	size_t length = 0;
+	text[length++] = (char)first;
+	for (;;) {
+		int c = peek(stream);
+		if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+			break;
+		if (length == NUMBER_MAX)
+			return -1;
+		text[length++] = (char)c;
+		stream->position += 1;
+	}
+	text[length] = '\0';
+
+	// the same leading zero rules as parson
+	const char* digits = text[0] == '-' ? text + 1 : text;
+	if (!(digits[0] >= '0' && digits[0] <= '9'))
+		return -1;
+	if (digits[0] == '0' && digits[1] != '\0' && digits[1] != '.' && digits[1] != 'e' &&
+	    digits[1] != 'E')
+		return -1;
+
+	char* end;
+	errno = 0;
+	stream->number = strtod(text, &end);
+	if (*end != '\0' || (errno == ERANGE && isinf(stream->number)))
+		return -1;
+	return 0;
+}
+
+static int readLiteral(JsonStream* stream, const char* rest) {
+	for (; *rest; rest++) {
+		if (get(stream) != *rest)
+			return -1;
+	}
+	return 0;
+}
+
+// Updates the grammar state after a complete value
+static void endValue(JsonStream* stream) {
+	stream->expect = stream->depth ? EXPECT_COMMA_OR_END : EXPECT_DONE;
+}
+
+void JsonStream_open(JsonStream* stream, int fd) {
+	memset(stream, 0, sizeof(JsonStream));
+	stream->fd = fd;
+	stream->expect = EXPECT_VALUE;
+}
+
+JsonStream_Token JsonStream_next(JsonStream* stream) {
+	if (stream->expect == EXPECT_NOTHING)
+		return stream->error ? JSON_STREAM_ERROR : JSON_STREAM_END;
+
+	int c = skipSpace(stream);
+	if (c == -2)
+		return fail(stream, "invalid comment");
+
+	switch (stream->expect) {
+	case EXPECT_DONE:
+		if (c >= 0)
+			return fail(stream, "data after the document");
+		if (stream->error)
+			return fail(stream, stream->error);
+		stream->expect = EXPECT_NOTHING;
+		return JSON_STREAM_END;
+
+	case EXPECT_COLON:
+		if (c != ':')
+			return fail(stream, "expected ':'");
+		stream->position += 1;
+		c = skipSpace(stream);
+		stream->expect = EXPECT_VALUE;
+		break;
+
+	case EXPECT_COMMA_OR_END: {
+		char open = stream->stack[stream->depth - 1];
+		if (c == (open == '{' ? '}' : ']'))
+			break;
+		if (c != ',')
+			return fail(stream, "expected ',' or the end of the container");
+		stream->position += 1;
+		c = skipSpace(stream);
+		stream->expect = open == '{' ? EXPECT_KEY : EXPECT_VALUE;
+		break;
+	}
+
+	default:
+		break;
+	}
+	if (c == -2)
+		return fail(stream, "invalid comment");
+	if (c < 0)
+		return fail(stream, "unexpected end of input");
+	stream->position += 1;
+
+	// closing a container
+	if ((c == '}' || c == ']') && stream->depth > 0 &&
+	    stream->stack[stream->depth - 1] == (c == '}' ? '{' : '[') &&
+	    stream->expect != EXPECT_VALUE && stream->expect != EXPECT_KEY) {
+		stream->depth -= 1;
+		endValue(stream);
+		return c == '}' ? JSON_STREAM_OBJECT_END : JSON_STREAM_ARRAY_END;
+	}
+
+	// object member names
+	if (stream->expect == EXPECT_KEY || stream->expect == EXPECT_KEY_OR_END) {
+		if (c != '"')
+			return fail(stream, "expected a member name");
+		if (readString(stream) != 0)
+			return fail(stream, "invalid string");
+		stream->expect = EXPECT_COLON;
+		return JSON_STREAM_KEY;
+	}
+
+	// values
+	switch (c) {
+	case '{':
+	case '[':
+		if (stream->depth == JSON_STREAM_MAX_DEPTH)
+			return fail(stream, "nested too deeply");
+		stream->stack[stream->depth++] = (char)c;
+		stream->expect = c == '{' ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+		return c == '{' ? JSON_STREAM_OBJECT_BEGIN : JSON_STREAM_ARRAY_BEGIN;
+	case '"':
+		if (readString(stream) != 0)
+			return fail(stream, "invalid string");
+		endValue(stream);
+		return JSON_STREAM_STRING;
+	case 't':
+		if (readLiteral(stream, "rue") != 0)
+			return fail(stream, "invalid literal");
+		endValue(stream);
+		return JSON_STREAM_TRUE;
+	case 'f':
+		if (readLiteral(stream, "alse") != 0)
+			return fail(stream, "invalid literal");
+		endValue(stream);
+		return JSON_STREAM_FALSE;
+	case 'n':
+		if (readLiteral(stream, "ull") != 0)
+			return fail(stream, "invalid literal");
+		endValue(stream);
+		return JSON_STREAM_NULL;
+	default:
+		if (c == '-' || (c >= '0' && c <= '9')) {
+			if (readNumber(stream, c) != 0)
+				return fail(stream, "invalid number");
+			endValue(stream);
+			return JSON_STREAM_NUMBER;
+		}
+		return fail(stream, "unexpected character");
+	}
+}
+
+int JsonStream_skip(JsonStream* stream, JsonStream_Token token) {
+	if (token == JSON_STREAM_ERROR)
+		return -1;
+	if (token != JSON_STREAM_OBJECT_BEGIN && token != JSON_STREAM_ARRAY_BEGIN)
+		return 0;
+
+	int depth = stream->depth - 1;
+	while (stream->depth > depth) {
+		if (JsonStream_next(stream) == JSON_STREAM_ERROR)
+			return -1;
+	}
+	return 0;
+}
+
+int JsonStream_ready(JsonStream* stream) {
+	if (stream->position < stream->length || stream->eof)
+		return 1;
+	struct pollfd fd = {.fd = stream->fd, .events = POLLIN};
+	return poll(&fd, 1, 0) != 0;
+}
+
+void JsonStream_close(JsonStream* stream) {
+	free(stream->string);
+	stream->string = NULL;
+	stream->string_length = 0;
+	stream->string_capacity = 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * json_stream.h - Incremental JSON tokenizer
+ *
+ * Reads a JSON document from a file descriptor in fixed-size chunks and
+ * returns it one token at a time, without building a document tree. Used
+ * by the list utilities to turn large item arrays straight into their own
+ * item storage, and to start drawing before a slow producer (a pak script
+ * writing to stdin) has finished.
+ *
+ * Accepts the same input as parson's *_with_comments parsers: standard
+ * JSON plus C-style block and line comments between tokens.
+ *
+ * Example:
+ *   JsonStream stream;
+ *   JsonStream_open(&stream, fd);
+ *   JsonStream_Token token;
+ *   while ((token = JsonStream_next(&stream)) > JSON_STREAM_END) {
+ *       if (token == JSON_STREAM_KEY && !strcmp(stream.string, "items"))
+ *           ...
+ *   }
+ *   JsonStream_close(&stream);
+ */
+
+#ifndef __JSON_STREAM_H__
+#define __JSON_STREAM_H__
+
+#include <stddef.h>
+
+#define JSON_STREAM_BUFFER_SIZE (16 * 1024)
+#define JSON_STREAM_MAX_DEPTH 256
+
+typedef enum JsonStream_Token {
+	JSON_STREAM_ERROR = -1, // Syntax or read error, see JsonStream.error
+	JSON_STREAM_END = 0, // End of the document
+	JSON_STREAM_OBJECT_BEGIN,
+	JSON_STREAM_OBJECT_END,
+	JSON_STREAM_ARRAY_BEGIN,
+	JSON_STREAM_ARRAY_END,
+	JSON_STREAM_KEY, // Object member name in string
+	JSON_STREAM_STRING, // Value in string
+	JSON_STREAM_NUMBER, // Value in number
+	JSON_STREAM_TRUE,
+	JSON_STREAM_FALSE,
+	JSON_STREAM_NULL,
+} JsonStream_Token;
+
+typedef struct JsonStream {
+	int fd;
+	char buffer[JSON_STREAM_BUFFER_SIZE];
+	size_t position; // Next unread byte in buffer
+	size_t length; // Bytes in buffer
+	int eof; // No more input after buffer
+
+	char* string; // Last KEY or STRING, NUL-terminated, valid until the next token
+	size_t string_length; // Without the terminator, strings may contain NULs
+	size_t string_capacity;
+	double number; // Last NUMBER
+
+	char stack[JSON_STREAM_MAX_DEPTH]; // '{' or '[' for each open container
+	int depth;
+	int expect; // Grammar state, see json_stream.c
+	const char* error; // Why JSON_STREAM_ERROR was returned
+} JsonStream;
+
+/**
+ * Starts reading a document.
+ *
+ * @param stream Stream to initialize
+ * @param fd File descriptor to read, stays owned by the caller
+ */
+void JsonStream_open(JsonStream* stream, int fd);
+
+/**
+ * Reads the next token.
+ *
+ * Blocks until the whole token was read. Once JSON_STREAM_END or
+ * JSON_STREAM_ERROR was returned, every further call returns it again.
+ *
+ * @param stream Open stream
+ * @return Token type
+ */
+JsonStream_Token JsonStream_next(JsonStream* stream);
+
+/**
+ * Skips the rest of a value.
+ *
+ * @param stream Open stream
+ * @param token Token just returned by JsonStream_next(), the start of the
+ *              value to skip; scalars are already complete
+ * @return 0 on success, -1 on error
+ */
+int JsonStream_skip(JsonStream* stream, JsonStream_Token token);
+
+/**
+ * Tells whether input is waiting to be tokenized.
+ *
+ * True when buffered bytes remain or the descriptor is readable (or at
+ * end of file), so JsonStream_next() won't wait on a slow writer for the
+ * first byte of its token.
+ *
+ * @param stream Open stream
+ * @return 1 if input is ready, 0 otherwise
+ */
+int JsonStream_ready(JsonStream* stream);
+
+/**
+ * Releases the stream's memory, the descriptor is not closed.
+ *
+ * @param stream Stream to close
+ */
+void JsonStream_close(JsonStream* stream);
+
+#endif // __JSON_STREAM_H__
@@ -0,0 +1,268 @@
+/**
+ * keymon_core.c - Event-driven core for the keymon daemons
+ */
+
+#include "keymon_core.h"
+#include "evdev.h"
+#include "log.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// epoll data for each descriptor in the loop
+enum {
+	KEYMON_SLOT_INPUT,
+	KEYMON_SLOT_REPEAT,
+	KEYMON_SLOT_POLL,
+	KEYMON_SLOT_QUIT,
+	KEYMON_SLOT_COUNT,
+};
+
+static struct {
+	const KEYMON_Hooks* hooks;
+	int epoll_fd;
+	int repeat_fd;
+	int poll_fd;
+	int quit_fd;
+	int repeat_code; // Key being repeated, -1 if none
+	int stale; // Stale input was dropped during this dispatch
+} km = {
+    .epoll_fd = -1,
+    .repeat_fd = -1,
+    .poll_fd = -1,
+    .quit_fd = -1,
+    .repeat_code = -1,
+};
+
+static volatile sig_atomic_t quit_requested = 0;
+
+static uint64_t KEYMON_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+int KEYMON_isStale(uint64_t event_us, uint64_t now_us) {
+	return event_us <= now_us && now_us - event_us > (uint64_t)KEYMON_STALE_MS * 1000;
+}
+
+///////////////////////////////
+// Repeat
+///////////////////////////////
+
+static void startRepeat(int code, uint64_t pressed_us) {
+	// a device left on wall-clock time would put the first repeat years away
+	uint64_t now_us = KEYMON_now();
+	if (pressed_us > now_us)
+		pressed_us = now_us;
+
+	uint64_t first_us = pressed_us + (uint64_t)KEYMON_REPEAT_DELAY_MS * 1000;
+
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = first_us / 1000000;
+	spec.it_value.tv_nsec = (first_us % 1000000) * 1000;
+	spec.it_interval.tv_sec = KEYMON_REPEAT_INTERVAL_MS / 1000;
+	spec.it_interval.tv_nsec = (KEYMON_REPEAT_INTERVAL_MS % 1000) * 1000000;
+	timerfd_settime(km.repeat_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+	km.repeat_code = code;
+}
+
+static void stopRepeat(void) {
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	timerfd_settime(km.repeat_fd, 0, &spec, NULL);
+	km.repeat_code = -1;
+}
+
+static void resetState(void) {
+	stopRepeat();
+	if (km.hooks->reset)
+		km.hooks->reset();
+}
+
+static void handleRepeatTimer(void) {
+	uint64_t expirations = 0;
+	if (read(km.repeat_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+		return;
+	if (km.repeat_code < 0)
+		return;
+
+	// a backlog this large means we were stopped with the key held
+	if (expirations > KEYMON_STALE_MS / KEYMON_REPEAT_INTERVAL_MS) {
+		resetState();
+		return;
+	}
+
+	for (uint64_t i = 0; i < expirations && km.repeat_code >= 0; i++)
+		km.hooks->handleRepeat(km.repeat_code);
+}
+
+///////////////////////////////
+// Input
+///////////////////////////////
+
+static void handleEvent(int device, const EVDEV_Event* event, void* userdata) {
+	(void)device;
+	uint64_t now_us = *(uint64_t*)userdata;
+	uint64_t event_us = EVDEV_eventTime(event);
+	if (KEYMON_isStale(event_us, now_us)) {
+		km.stale = 1;
+		return;
+	}
+
+	if (event->type == EVDEV_EV_SW) {
+		if (km.hooks->handleSwitch)
+			km.hooks->handleSwitch(event->code, event->value);
+		return;
+	}
+
+	// the core generates its own repeats
+	if (event->type != EVDEV_EV_KEY || event->value > KEYMON_PRESSED)
+		return;
+
+	if (event->value == KEYMON_RELEASED && event->code == km.repeat_code)
+		stopRepeat();
+
+	int repeat = km.hooks->handleKey(event->code, event->value);
+	if (event->value == KEYMON_PRESSED && repeat && km.hooks->handleRepeat)
+		startRepeat(event->code, event_us);
+}
+
+static void handleInput(void) {
+	uint64_t now_us = KEYMON_now();
+	km.stale = 0;
+	EVDEV_poll(handleEvent, &now_us);
+	if (km.stale)
+		resetState();
+}
+
+///////////////////////////////
+// Loop
+///////////////////////////////
+
+static void onSignal(int sig) {
+	(void)sig;
+	KEYMON_quit();
+}
+
+static int addSlot(int fd, int slot) {
+	struct epoll_event event = {.events = EPOLLIN};
+	event.data.u32 = (uint32_t)slot;
+	return epoll_ctl(km.epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static void closeLoop(void) {
+	int* fds[] = {&km.poll_fd, &km.repeat_fd, &km.quit_fd, &km.epoll_fd};
+	for (int i = 0; i < (int)(sizeof(fds) / sizeof(fds[0])); i++) {
+		if (*fds[i] >= 0)
+			close(*fds[i]);
+		*fds[i] = -1;
+	}
+	EVDEV_quit();
+	km.repeat_code = -1;
+	km.hooks = NULL;
+}
+
+static int openLoop(const char* const* inputs) {
+	if (EVDEV_init() < 0)
+		return -1;
+	EVDEV_setEventTypes(EVDEV_TYPES_DEFAULT | EVDEV_TYPE(EVDEV_EV_SW));
+	for (int i = 0; inputs && inputs[i]; i++)
+		EVDEV_addDevice(inputs[i], 0);
+
+	km.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	km.repeat_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	km.quit_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (km.epoll_fd < 0 || km.repeat_fd < 0 || km.quit_fd < 0)
+		return -1;
+
+	if (addSlot(EVDEV_getFD(), KEYMON_SLOT_INPUT) < 0 ||
+	    addSlot(km.repeat_fd, KEYMON_SLOT_REPEAT) < 0 ||
+	    addSlot(km.quit_fd, KEYMON_SLOT_QUIT) < 0)
+		return -1;
+
+	if (km.hooks->poll && km.hooks->poll_ms) {
+		km.poll_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (km.poll_fd < 0 || addSlot(km.poll_fd, KEYMON_SLOT_POLL) < 0)
+			return -1;
+
+		struct itimerspec spec;
+		memset(&spec, 0, sizeof(spec));
+		spec.it_interval.tv_sec = km.hooks->poll_ms / 1000;
+		spec.it_interval.tv_nsec = (km.hooks->poll_ms % 1000) * 1000000;
+		spec.it_value = spec.it_interval;
+		timerfd_settime(km.poll_fd, 0, &spec, NULL);
+	}
+	return 0;
+}
+
+int KEYMON_run(const char* const* inputs, const KEYMON_Hooks* hooks) {
+	if (!hooks || !hooks->handleKey)
+		return -1;
+
+	km.hooks = hooks;
+	if (openLoop(inputs) < 0) {
+		LOG_errno("keymon: unable to set up event loop");
+		closeLoop();
+		return -1;
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = onSignal;
+	sigaction(SIGTERM, &sa, NULL);
+
+	if (hooks->poll)
+		hooks->poll(); // pick up initial hardware state
+
+	while (!quit_requested) {
+		struct epoll_event ready[KEYMON_SLOT_COUNT];
+		int n = epoll_wait(km.epoll_fd, ready, KEYMON_SLOT_COUNT, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			LOG_errno("keymon: epoll_wait failed");
+			break;
+		}
+
+		// input first, so a key released this round doesn't repeat
+		for (int i = 0; i < n; i++) {
+			if (ready[i].data.u32 == KEYMON_SLOT_INPUT)
+				handleInput();
+		}
+		for (int i = 0; i < n; i++) {
+			uint64_t count;
+			switch (ready[i].data.u32) {
+			case KEYMON_SLOT_REPEAT:
+				handleRepeatTimer();
+				break;
+			case KEYMON_SLOT_POLL:
+				if (read(km.poll_fd, &count, sizeof(count)) == sizeof(count))
+					hooks->poll();
+				break;
+			case KEYMON_SLOT_QUIT:
+				(void)!read(km.quit_fd, &count, sizeof(count));
+				break;
+			}
+		}
+	}
+
+	closeLoop();
+	quit_requested = 0;
+	return 0;
+}
+
+void KEYMON_quit(void) {
+	quit_requested = 1;
+	if (km.quit_fd >= 0) {
+		uint64_t one = 1;
+		(void)!write(km.quit_fd, &one, sizeof(one));
+	}
+}
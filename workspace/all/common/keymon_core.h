@@ -0,0 +1,114 @@
+/**
+ * keymon_core.h - Event-driven core for the keymon daemons
+ *
+ * Most platforms' keymon used to wake 60 times a second to read its input
+ * devices and compare timestamps for volume/brightness key repeat, and
+ * many ran a second thread that slept in a loop to poll the battery,
+ * headphone jack or HDMI state. The core replaces all of that with one
+ * epoll loop over:
+ *
+ * - the input devices (through the shared evdev backend)
+ * - a repeat timerfd armed from the press timestamp, so repeats land
+ *   exactly KEYMON_REPEAT_DELAY_MS after the press and every
+ *   KEYMON_REPEAT_INTERVAL_MS after that
+ * - an optional periodic timerfd for hardware polling
+ * - an eventfd used by KEYMON_quit() (SIGTERM)
+ *
+ * With no keys held and no poll hook the daemon sleeps until input arrives.
+ *
+ * Platforms supply a KEYMON_Hooks table and keep only their button policy.
+ * Input older than KEYMON_STALE_MS (queued while the daemon was stopped
+ * during sleep) is dropped and the reset hook is called instead, so held
+ * modifiers don't stick across sleep.
+ */
+
+#ifndef __KEYMON_CORE_H__
+#define __KEYMON_CORE_H__
+
+#include <stdint.h>
+
+/**
+ * Key repeat timing.
+ */
+#define KEYMON_REPEAT_DELAY_MS 300
+#define KEYMON_REPEAT_INTERVAL_MS 100
+
+/**
+ * Input older than this is considered stale (daemon was stopped).
+ */
+#define KEYMON_STALE_MS 1000
+
+/**
+ * Key event values.
+ */
+#define KEYMON_RELEASED 0
+#define KEYMON_PRESSED 1
+
+/**
+ * Platform callbacks. Only handleKey is required.
+ */
+typedef struct KEYMON_Hooks {
+	/**
+	 * Handles a key press or release (kernel autorepeat is filtered out).
+	 *
+	 * @param code Raw evdev key code
+	 * @param value KEYMON_PRESSED or KEYMON_RELEASED
+	 * @return On press, 1 to start repeating this key via handleRepeat
+	 */
+	int (*handleKey)(int code, int value);
+
+	/**
+	 * Handles a repeat of the key that handleKey asked to repeat.
+	 *
+	 * @param code Raw evdev key code
+	 */
+	void (*handleRepeat)(int code);
+
+	/**
+	 * Handles a switch event (headphone jack, mute slider).
+	 *
+	 * @param code Raw evdev switch code
+	 * @param value Switch state
+	 */
+	void (*handleSwitch)(int code, int value);
+
+	/**
+	 * Releases held modifiers after stale input was dropped.
+	 */
+	void (*reset)(void);
+
+	/**
+	 * Polls hardware state every poll_ms (battery, jack, HDMI).
+	 */
+	void (*poll)(void);
+	uint32_t poll_ms;
+} KEYMON_Hooks;
+
+/**
+ * Runs the keymon event loop until KEYMON_quit() or SIGTERM.
+ *
+ * @param inputs NULL-terminated list of input device paths; missing
+ *               devices are skipped
+ * @param hooks Platform callbacks
+ * @return 0 after a clean quit, -1 if the loop couldn't be set up
+ */
+int KEYMON_run(const char* const* inputs, const KEYMON_Hooks* hooks);
+
+/**
+ * Stops KEYMON_run(). Async-signal-safe.
+ */
+void KEYMON_quit(void);
+
+/**
+ * Checks whether an event timestamp is too old to act on.
+ *
+ * Timestamps from the future (a device that ignored the switch to
+ * CLOCK_MONOTONIC) are never considered stale.
+ *
+ * @param event_us Event timestamp (CLOCK_MONOTONIC microseconds)
+ * @param now_us Current time (CLOCK_MONOTONIC microseconds)
+ * @return 1 if stale, 0 otherwise
+ */
+int KEYMON_isStale(uint64_t event_us, uint64_t now_us);
+
+#endif // __KEYMON_CORE_H__
@@ -0,0 +1,175 @@
+/**
+ * latency.c - Input-to-photon latency measurement
+ *
+ * With threaded video the core thread calls LAT_markRead() while the main
+ * thread calls LAT_markPresent(), so the pending timestamps are accessed
+ * atomically. The histograms themselves are only touched by whichever
+ * thread completes a stage, which is fine for a measurement tool.
+ */
+
+#include "latency.h"
+#include "log.h"
+
+#include <string.h>
+#include <time.h>
+
+static struct {
+	int enabled;
+	uint64_t input_at; // pending press time, 0 if none
+	uint32_t button; // pending press button (BTN_* mask)
+	uint64_t read_at; // when the core read it, 0 if not yet
+	LAT_Histogram stages[LAT_STAGE_COUNT];
+} lat;
+
+#define LAT_LOAD(field) __atomic_load_n(&(field), __ATOMIC_ACQUIRE)
+#define LAT_STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELEASE)
+
+///////////////////////////////
+// Histogram
+///////////////////////////////
+
+void LAT_Histogram_add(LAT_Histogram* histogram, uint64_t sample_us) {
+	uint64_t bucket = sample_us / (LAT_BUCKET_MS * 1000);
+	if (bucket >= LAT_BUCKET_COUNT)
+		bucket = LAT_BUCKET_COUNT - 1;
+	histogram->buckets[bucket] += 1;
+
+	if (histogram->count == 0 || sample_us < histogram->min_us)
+		histogram->min_us = sample_us;
+	if (sample_us > histogram->max_us)
+		histogram->max_us = sample_us;
+	histogram->total_us += sample_us;
+	histogram->last_us = sample_us;
+	histogram->count += 1;
+}
+
+int LAT_Histogram_percentile(const LAT_Histogram* histogram, int percent) {
+	if (!histogram || histogram->count == 0)
+		return 0;
+
+	// rank of the sample at this percentile, rounded up (1-based)
+	uint32_t rank = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+	if (rank < 1)
+		rank = 1;
+
+	uint32_t seen = 0;
+	for (int i = 0; i < LAT_BUCKET_COUNT; i++) {
+		seen += histogram->buckets[i];
+		if (seen >= rank)
+			return (i + 1) * LAT_BUCKET_MS;
+	}
+	return LAT_BUCKET_COUNT * LAT_BUCKET_MS;
+}
+
+///////////////////////////////
+// Measurement
+///////////////////////////////
+
+void LAT_setEnabled(int enabled) {
+	LAT_STORE(lat.input_at, 0);
+	LAT_STORE(lat.read_at, 0);
+	LAT_STORE(lat.enabled, enabled ? 1 : 0);
+}
+
+int LAT_isEnabled(void) {
+	return LAT_LOAD(lat.enabled);
+}
+
+uint64_t LAT_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+void LAT_markInput(uint64_t timestamp_us, int id) {
+	if (!LAT_LOAD(lat.enabled) || id < 0 || id >= 32)
+		return;
+
+	// keep the press in flight unless it went stale without being read
+	uint64_t input_at = LAT_LOAD(lat.input_at);
+	if (input_at && timestamp_us - input_at < LAT_TIMEOUT_MS * 1000)
+		return;
+
+	LAT_STORE(lat.read_at, 0);
+	LAT_STORE(lat.button, 1u << id);
+	LAT_STORE(lat.input_at, timestamp_us);
+}
+
+void LAT_markRead(uint32_t pressed) {
+	if (!LAT_LOAD(lat.enabled))
+		return;
+
+	uint64_t input_at = LAT_LOAD(lat.input_at);
+	if (!input_at || LAT_LOAD(lat.read_at) || !(pressed & LAT_LOAD(lat.button)))
+		return;
+
+	uint64_t now = LAT_now();
+	if (now < input_at)
+		now = input_at; // timestamp from a coarser clock than ours
+	LAT_Histogram_add(&lat.stages[LAT_STAGE_READ], now - input_at);
+	LAT_STORE(lat.read_at, now);
+}
+
+void LAT_markPresent(void) {
+	if (!LAT_LOAD(lat.enabled) || !LAT_LOAD(lat.read_at))
+		return;
+
+	uint64_t input_at = LAT_LOAD(lat.input_at);
+	uint64_t now = LAT_now();
+	if (now < input_at)
+		now = input_at;
+	LAT_Histogram_add(&lat.stages[LAT_STAGE_PRESENT], now - input_at);
+
+	LAT_STORE(lat.read_at, 0);
+	LAT_STORE(lat.input_at, 0);
+}
+
+void LAT_reset(void) {
+	LAT_STORE(lat.input_at, 0);
+	LAT_STORE(lat.read_at, 0);
+	memset(lat.stages, 0, sizeof(lat.stages));
+}
+
+const LAT_Histogram* LAT_getHistogram(int stage) {
+	if (stage < 0 || stage >= LAT_STAGE_COUNT)
+		return NULL;
+	return &lat.stages[stage];
+}
+
+///////////////////////////////
+// Reporting
+///////////////////////////////
+
+void LAT_report(void) {
+	for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+		const LAT_Histogram* h = &lat.stages[i];
+		if (!h->count)
+			continue;
+		LOG_info("latency %s: n=%u min=%.1fms avg=%.1fms p50=%ims p95=%ims max=%.1fms",
+		         i == LAT_STAGE_READ ? "read" : "present",
+		         h->count, h->min_us / 1000.0, (h->total_us / h->count) / 1000.0,
+		         LAT_Histogram_percentile(h, 50), LAT_Histogram_percentile(h, 95),
+		         h->max_us / 1000.0);
+	}
+
+	const LAT_Histogram* h = &lat.stages[LAT_STAGE_PRESENT];
+	if (!h->count)
+		return;
+
+	uint32_t peak = 0;
+	for (int i = 0; i < LAT_BUCKET_COUNT; i++) {
+		if (h->buckets[i] > peak)
+			peak = h->buckets[i];
+	}
+
+	for (int i = 0; i < LAT_BUCKET_COUNT; i++) {
+		if (!h->buckets[i])
+			continue;
+		char bar[41];
+		int len = (int)((h->buckets[i] * 40 + peak - 1) / peak);
+		memset(bar, '#', len);
+		bar[len] = '\0';
+		LOG_info("%3i-%3ims%s %5u %s", i * LAT_BUCKET_MS, (i + 1) * LAT_BUCKET_MS,
+		         i == LAT_BUCKET_COUNT - 1 ? "+" : " ", h->buckets[i], bar);
+	}
+}
@@ -0,0 +1,148 @@
+/**
+ * latency.h - Input-to-photon latency measurement
+ *
+ * Measures how long a button press takes to reach the screen, split into
+ * two stages so the frontend's share can be told apart from the core's:
+ *
+ *   press ──(read)──> core reads the input ──(present)──> frame flipped
+ *
+ * - LAT_markInput() is called by PLAT_pollInput with the press timestamp
+ *   (the kernel input_event time on evdev platforms) and the button
+ * - LAT_markRead() is called when the core first sees that button pressed
+ *   (minarch's input_state_callback), other held buttons don't count
+ * - LAT_markPresent() is called after PLAT_flip (from GFX_flip)
+ *
+ * Only one press is tracked at a time. Presses that arrive while one is in
+ * flight are ignored, and a press that is never read is dropped after
+ * LAT_TIMEOUT_MS so it can't be matched against an unrelated frame.
+ *
+ * Everything is a no-op until LAT_setEnabled(1), so the hooks can stay in
+ * the hot paths permanently.
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdint.h>
+
+/**
+ * Histogram bucket width in milliseconds.
+ */
+#define LAT_BUCKET_MS 4
+
+/**
+ * Number of histogram buckets. The last bucket collects everything
+ * at or above (LAT_BUCKET_COUNT - 1) * LAT_BUCKET_MS.
+ */
+#define LAT_BUCKET_COUNT 50
+
+/**
+ * Presses older than this that haven't been read are discarded.
+ */
+#define LAT_TIMEOUT_MS 500
+
+/**
+ * Measurement stages.
+ */
+enum {
+	LAT_STAGE_READ, // press -> core read
+	LAT_STAGE_PRESENT, // press -> frame presented
+	LAT_STAGE_COUNT,
+};
+
+/**
+ * Latency histogram for one stage.
+ */
+typedef struct LAT_Histogram {
+	uint32_t buckets[LAT_BUCKET_COUNT];
+	uint32_t count; // Number of samples
+	uint64_t total_us; // Sum of all samples, for the mean
+	uint64_t min_us;
+	uint64_t max_us;
+	uint64_t last_us; // Most recent sample
+} LAT_Histogram;
+
+/**
+ * Enables or disables measurement.
+ *
+ * Enabling clears any press in flight but keeps existing histograms.
+ *
+ * @param enabled 1 to enable, 0 to disable
+ */
+void LAT_setEnabled(int enabled);
+
+/**
+ * Checks if measurement is enabled.
+ *
+ * @return 1 if enabled, 0 otherwise
+ */
+int LAT_isEnabled(void);
+
+/**
+ * Gets the current time on the clock input timestamps use.
+ *
+ * @return CLOCK_MONOTONIC time in microseconds
+ */
+uint64_t LAT_now(void);
+
+/**
+ * Records a button press.
+ *
+ * @param timestamp_us Press time from LAT_now()'s clock
+ * @param id Button ID (BTN_ID_*) pressed, negative ids are ignored
+ */
+void LAT_markInput(uint64_t timestamp_us, int id);
+
+/**
+ * Records that the core has read the pending press.
+ *
+ * Only the first call that sees the pressed button counts.
+ *
+ * @param pressed Buttons the reader sees pressed (BTN_* mask)
+ */
+void LAT_markRead(uint32_t pressed);
+
+/**
+ * Records that a frame was presented, completing the pending measurement.
+ *
+ * Has no effect unless the pending press has been read.
+ */
+void LAT_markPresent(void);
+
+/**
+ * Clears all histograms and any press in flight.
+ */
+void LAT_reset(void);
+
+/**
+ * Gets the histogram for a stage.
+ *
+ * @param stage LAT_STAGE_READ or LAT_STAGE_PRESENT
+ * @return Histogram, or NULL for an invalid stage
+ */
+const LAT_Histogram* LAT_getHistogram(int stage);
+
+/**
+ * Adds a sample to a histogram.
+ *
+ * @param histogram Histogram to update
+ * @param sample_us Latency in microseconds
+ */
+void LAT_Histogram_add(LAT_Histogram* histogram, uint64_t sample_us);
+
+/**
+ * Estimates a percentile from a histogram.
+ *
+ * @param histogram Histogram to query
+ * @param percent Percentile (0-100)
+ * @return Upper edge of the bucket containing the percentile in ms,
+ *         or 0 if the histogram is empty
+ */
+int LAT_Histogram_percentile(const LAT_Histogram* histogram, int percent);
+
+/**
+ * Logs a summary and the present-stage histogram.
+ */
+void LAT_report(void);
+
+#endif // __LATENCY_H__
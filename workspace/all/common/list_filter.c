@@ -0,0 +1,113 @@
+/**
+ * list_filter.c - Incremental substring filter over item names
+ */
+
+#include "list_filter.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// U+00C0 to U+00FF (UTF-8 0xC3 0x80 to 0xC3 0xBF) without accents, NULL to keep
+static const char* latin1_folds[64] = {
+	"a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+	"d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "ss",
+	"a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+	"d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "y",
+};
+
+size_t ListFilter_fold(char* out, size_t size, const char* text) {
+	const unsigned char* in = (const unsigned char*)text;
+	size_t length = 0;
+	if (!size)
+		return 0;
+
+	while (*in) {
+		const char* fold = NULL;
+		if (in[0] == 0xC3 && in[1] >= 0x80 && in[1] <= 0xBF)
+			fold = latin1_folds[in[1] - 0x80];
+
+		if (fold) {
+			// a fold is never longer than the two bytes it replaces
+			size_t fold_length = strlen(fold);
+			if (length + fold_length >= size)
+				break;
+			memcpy(out + length, fold, fold_length);
+			length += fold_length;
+			in += 2;
+		} else {
+			if (length + 1 >= size)
+				break;
+			out[length++] = (*in >= 'A' && *in <= 'Z') ? *in + ('a' - 'A') : *in;
+			in += 1;
+		}
+	}
+	out[length] = '\0';
+	return length;
+}
+
+int ListFilter_add(ListFilter* filter, const char* name) {
+	if (filter->count == filter->capacity) {
+		size_t capacity = filter->capacity ? filter->capacity * 2 : 256;
+		size_t* offsets = realloc(filter->offsets, capacity * sizeof(size_t));
+		if (!offsets)
+			return -1;
+		filter->offsets = offsets;
+		size_t* matches = realloc(filter->matches, capacity * sizeof(size_t));
+		if (!matches)
+			return -1;
+		filter->matches = matches;
+		filter->capacity = capacity;
+	}
+
+	size_t offset = SIZE_MAX;
+	if (name) {
+		size_t size = strlen(name) + 1;
+		if (filter->names_size + size > filter->names_capacity) {
+			size_t names_capacity = filter->names_capacity ? filter->names_capacity * 2 : 16 * 1024;
+			while (names_capacity < filter->names_size + size)
+				names_capacity *= 2;
+			char* names = realloc(filter->names, names_capacity);
+			if (!names)
+				return -1;
+			filter->names = names;
+			filter->names_capacity = names_capacity;
+		}
+		offset = filter->names_size;
+		filter->names_size += ListFilter_fold(filter->names + offset, size, name) + 1;
+	}
+
+	filter->offsets[filter->count++] = offset;
+	filter->applied = 0;
+	return 0;
+}
+
+size_t ListFilter_apply(ListFilter* filter, const char* query) {
+	char folded[LIST_FILTER_QUERY_SIZE];
+	ListFilter_fold(folded, sizeof(folded), query);
+
+	// anything containing the new query contains the old one, so only the
+	// old matches need checking (e.g. after typing another letter)
+	int narrow = filter->applied && strstr(folded, filter->query) != NULL;
+	size_t candidates = narrow ? filter->match_count : filter->count;
+
+	size_t match_count = 0;
+	for (size_t i = 0; i < candidates; i++) {
+		size_t item = narrow ? filter->matches[i] : i;
+		size_t offset = filter->offsets[item];
+		if (offset != SIZE_MAX && strstr(filter->names + offset, folded))
+			filter->matches[match_count++] = item;
+	}
+
+	filter->match_count = match_count;
+	memcpy(filter->query, folded, sizeof(folded));
+	filter->applied = 1;
+	return match_count;
+}
+
+void ListFilter_free(ListFilter* filter) {
+	free(filter->names);
+	free(filter->offsets);
+	free(filter->matches);
+	memset(filter, 0, sizeof(ListFilter));
+}
@@ -0,0 +1,82 @@
+/**
+ * list_filter.h - Incremental substring filter over item names
+ *
+ * Keeps a folded copy of every name (ASCII lowercase, Latin-1 accents
+ * stripped) in one buffer, built once, so a query only has to fold itself
+ * and scan plain bytes. A query that contains the previous one only
+ * rescans the previous matches, so typing a search one key at a time
+ * gets cheaper with every key.
+ *
+ * Example:
+ *   ListFilter filter = {0};
+ *   for (i = 0; i < count; i++)
+ *       ListFilter_add(&filter, items[i].is_header ? NULL : items[i].name);
+ *   ListFilter_apply(&filter, "mario");
+ *   for (i = 0; i < filter.match_count; i++)
+ *       show(items[filter.matches[i]]);
+ *   ListFilter_free(&filter);
+ */
+
+#ifndef __LIST_FILTER_H__
+#define __LIST_FILTER_H__
+
+#include <stddef.h>
+
+#define LIST_FILTER_QUERY_SIZE 256
+
+typedef struct ListFilter {
+	char* names; // Folded names, each NUL-terminated
+	size_t names_size; // Bytes used in names
+	size_t names_capacity;
+	size_t* offsets; // Each item's folded name in names, SIZE_MAX if it never matches
+	size_t count; // Items added
+	size_t capacity; // Items offsets and matches have room for
+
+	size_t* matches; // Indices of the items matching query, in order
+	size_t match_count;
+	char query[LIST_FILTER_QUERY_SIZE]; // Folded query the matches are for
+	int applied; // Whether matches are up to date with query
+} ListFilter;
+
+/**
+ * Folds text for matching: ASCII letters are lowercased, Latin-1 letters
+ * lose their accents (é -> e, Æ -> ae, ß -> ss), other bytes are kept.
+ *
+ * @param out Buffer for the folded text, always NUL-terminated
+ * @param size Size of out
+ * @param text Text to fold
+ * @return Length of the folded text
+ */
+size_t ListFilter_fold(char* out, size_t size, const char* text);
+
+/**
+ * Adds the next item to the index.
+ *
+ * Items are numbered in the order they're added. Call ListFilter_apply()
+ * again afterwards to include them in the matches.
+ *
+ * @param filter Filter to add to, zeroed before the first item
+ * @param name Item name, or NULL for items that never match (e.g. headers)
+ * @return 0 on success, -1 if out of memory
+ */
+int ListFilter_add(ListFilter* filter, const char* name);
+
+/**
+ * Finds the items whose name contains query, ignoring case and accents.
+ *
+ * An empty query matches every item with a name.
+ *
+ * @param filter Filter to search
+ * @param query Text to look for, longer queries are cut
+ * @return Number of matches, also in filter->match_count
+ */
+size_t ListFilter_apply(ListFilter* filter, const char* query);
+
+/**
+ * Releases the filter's memory and empties it.
+ *
+ * @param filter Filter to free
+ */
+void ListFilter_free(ListFilter* filter);
+
+#endif // __LIST_FILTER_H__
@@ -0,0 +1,383 @@
+/**
+ * monitor.c - Shared background scheduler for hardware monitoring
+ *
+ * The monitor thread takes the due tasks under the mutex and runs them
+ * after unlocking it, so MON_addTask() and friends only wait on a slow
+ * battery read when they need the task to be finished. MON_wake() only
+ * sets a bit and signals the thread, so the frame loop never waits at all.
+ */
+
+#include "monitor.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+///////////////////////////////
+// Scheduler
+///////////////////////////////
+
+static uint64_t MON_dueAt(uint64_t now_ms, uint32_t delay_ms) {
+	if (delay_ms == MON_IDLE)
+		return 0;
+	uint64_t due = now_ms + delay_ms;
+	return due ? due : 1; // 0 means idle
+}
+
+int MON_Scheduler_add(MON_Scheduler* scheduler, MON_TaskFunc func, uint64_t now_ms,
+                      uint32_t delay_ms) {
+	for (int i = 0; i < MON_MAX_TASKS; i++) {
+		if (scheduler->tasks[i])
+			continue;
+		scheduler->tasks[i] = func;
+		scheduler->due_ms[i] = MON_dueAt(now_ms, delay_ms);
+		return i;
+	}
+	return -1;
+}
+
+void MON_Scheduler_remove(MON_Scheduler* scheduler, int id) {
+	if (id < 0 || id >= MON_MAX_TASKS)
+		return;
+	scheduler->tasks[id] = NULL;
+	scheduler->due_ms[id] = 0;
+}
+
+void MON_Scheduler_wake(MON_Scheduler* scheduler, int id, uint64_t now_ms) {
+	if (id < 0 || id >= MON_MAX_TASKS || !scheduler->tasks[id])
+		return;
+	scheduler->due_ms[id] = MON_dueAt(now_ms, 0);
+}
+
+void MON_Scheduler_setSuspended(MON_Scheduler* scheduler, int suspended) {
+	scheduler->suspended = suspended ? 1 : 0;
+}
+
+int64_t MON_Scheduler_timeout(const MON_Scheduler* scheduler, uint64_t now_ms) {
+	if (scheduler->suspended)
+		return -1;
+
+	uint64_t next = 0;
+	for (int i = 0; i < MON_MAX_TASKS; i++) {
+		uint64_t due = scheduler->due_ms[i];
+		if (scheduler->tasks[i] && due && (!next || due < next))
+			next = due;
+	}
+	if (!next)
+		return -1;
+	return next > now_ms ? (int64_t)(next - now_ms) : 0;
+}
+
+int MON_Scheduler_run(MON_Scheduler* scheduler, uint64_t now_ms) {
+	int ids[MON_MAX_TASKS];
+	int count = MON_Scheduler_takeDue(scheduler, now_ms, ids);
+	for (int i = 0; i < count; i++) {
+		MON_TaskFunc func = scheduler->tasks[ids[i]];
+		MON_Scheduler_finish(scheduler, ids[i], func, now_ms, func());
+	}
+	return count;
+}
+
+int MON_Scheduler_takeDue(MON_Scheduler* scheduler, uint64_t now_ms, int* ids) {
+	scheduler->wakeups += 1;
+	if (scheduler->suspended)
+		return 0;
+
+	int count = 0;
+	for (int i = 0; i < MON_MAX_TASKS; i++) {
+		uint64_t due = scheduler->due_ms[i];
+		if (!scheduler->tasks[i] || !due || due > now_ms)
+			continue;
+		scheduler->due_ms[i] = 0; // not due again until finished
+		ids[count++] = i;
+	}
+	return count;
+}
+
+void MON_Scheduler_finish(MON_Scheduler* scheduler, int id, MON_TaskFunc func, uint64_t now_ms,
+                          uint32_t delay_ms) {
+	if (id < 0 || id >= MON_MAX_TASKS || scheduler->tasks[id] != func)
+		return;
+	scheduler->due_ms[id] = MON_dueAt(now_ms, delay_ms);
+}
+
+///////////////////////////////
+// Policies
+///////////////////////////////
+
+uint32_t MON_batteryInterval(int charge, int is_charging, int changed, int in_game) {
+	if (!is_charging && charge <= MON_BATTERY_LOW_CHARGE)
+		return MON_BATTERY_LOW_MS;
+	if (changed)
+		return MON_BATTERY_ACTIVE_MS;
+	return in_game ? MON_BATTERY_GAME_MS : MON_BATTERY_MENU_MS;
+}
+
+///////////////////////////////
+// Runtime
+///////////////////////////////
+
+static struct {
+	pthread_t pt;
+	pthread_mutex_t mx;
+	pthread_cond_t idle; // Signaled when tasks taken by the thread have finished
+	int busy; // Thread is running tasks without the mutex
+	int running;
+	uint64_t started_ms;
+	uint32_t pending; // Bitmask of tasks woken by MON_wake()
+	MON_Scheduler scheduler;
+#ifdef __linux__
+	int timer_fd;
+	int wake_fd;
+	int epoll_fd;
+#else
+	int wake_pipe[2];
+#endif
+} mon = {.mx = PTHREAD_MUTEX_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER};
+
+static uint64_t MON_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#ifdef __linux__
+
+static int MON_openWait(void) {
+	mon.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	mon.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	mon.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (mon.timer_fd < 0 || mon.wake_fd < 0 || mon.epoll_fd < 0)
+		return -1;
+
+	struct epoll_event event = {.events = EPOLLIN};
+	event.data.fd = mon.timer_fd;
+	epoll_ctl(mon.epoll_fd, EPOLL_CTL_ADD, mon.timer_fd, &event);
+	event.data.fd = mon.wake_fd;
+	epoll_ctl(mon.epoll_fd, EPOLL_CTL_ADD, mon.wake_fd, &event);
+	return 0;
+}
+
+static void MON_closeWait(void) {
+	if (mon.epoll_fd >= 0)
+		close(mon.epoll_fd);
+	if (mon.wake_fd >= 0)
+		close(mon.wake_fd);
+	if (mon.timer_fd >= 0)
+		close(mon.timer_fd);
+	mon.epoll_fd = mon.wake_fd = mon.timer_fd = -1;
+}
+
+static void MON_signal(void) {
+	uint64_t one = 1;
+	(void)!write(mon.wake_fd, &one, sizeof(one));
+}
+
+static void MON_waitFor(int64_t timeout_ms) {
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	if (timeout_ms > 0) { // disarmed when -1, so only a wake can end the wait
+		spec.it_value.tv_sec = timeout_ms / 1000;
+		spec.it_value.tv_nsec = (timeout_ms % 1000) * 1000000;
+	}
+	timerfd_settime(mon.timer_fd, 0, &spec, NULL);
+
+	struct epoll_event events[2];
+	int count = epoll_wait(mon.epoll_fd, events, 2, -1);
+	for (int i = 0; i < count; i++) {
+		uint64_t expirations;
+		(void)!read(events[i].data.fd, &expirations, sizeof(expirations));
+	}
+}
+
+#else
+
+static int MON_openWait(void) {
+	if (pipe(mon.wake_pipe) < 0)
+		return -1;
+	fcntl(mon.wake_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(mon.wake_pipe[1], F_SETFL, O_NONBLOCK);
+	return 0;
+}
+
+static void MON_closeWait(void) {
+	close(mon.wake_pipe[0]);
+	close(mon.wake_pipe[1]);
+}
+
+static void MON_signal(void) {
+	char one = 1;
+	(void)!write(mon.wake_pipe[1], &one, sizeof(one));
+}
+
+static void MON_waitFor(int64_t timeout_ms) {
+	struct pollfd pfd = {.fd = mon.wake_pipe[0], .events = POLLIN};
+	if (poll(&pfd, 1, (int)timeout_ms) > 0) {
+		char drain[16];
+		while (read(mon.wake_pipe[0], drain, sizeof(drain)) > 0)
+			;
+	}
+}
+
+#endif
+
+static void MON_applyWakes(uint64_t now_ms) {
+	uint32_t pending = __atomic_exchange_n(&mon.pending, 0, __ATOMIC_ACQ_REL);
+	for (int i = 0; pending; i++, pending >>= 1) {
+		if (pending & 1)
+			MON_Scheduler_wake(&mon.scheduler, i, now_ms);
+	}
+}
+
+/**
+ * Waits until the thread isn't running tasks. Called with the mutex held.
+ */
+static void MON_waitIdle(void) {
+	while (mon.busy)
+		pthread_cond_wait(&mon.idle, &mon.mx);
+}
+
+/**
+ * Runs the due tasks with the mutex released. Called with the mutex held.
+ */
+static void MON_runDue(uint64_t now_ms) {
+	int ids[MON_MAX_TASKS];
+	MON_TaskFunc funcs[MON_MAX_TASKS];
+	uint32_t delays[MON_MAX_TASKS];
+	int count = MON_Scheduler_takeDue(&mon.scheduler, now_ms, ids);
+	if (!count)
+		return;
+
+	for (int i = 0; i < count; i++)
+		funcs[i] = mon.scheduler.tasks[ids[i]];
+	mon.busy = 1;
+	pthread_mutex_unlock(&mon.mx);
+
+	for (int i = 0; i < count; i++)
+		delays[i] = funcs[i]();
+
+	pthread_mutex_lock(&mon.mx);
+	mon.busy = 0;
+	pthread_cond_broadcast(&mon.idle);
+	for (int i = 0; i < count; i++)
+		MON_Scheduler_finish(&mon.scheduler, ids[i], funcs[i], now_ms, delays[i]);
+}
+
+static void* MON_thread(void* arg) {
+	(void)arg;
+	pthread_mutex_lock(&mon.mx);
+	while (mon.running) {
+		MON_applyWakes(MON_now());
+		int64_t timeout = MON_Scheduler_timeout(&mon.scheduler, MON_now());
+		pthread_mutex_unlock(&mon.mx);
+
+		if (timeout != 0)
+			MON_waitFor(timeout);
+
+		pthread_mutex_lock(&mon.mx);
+		if (!mon.running)
+			break;
+		uint64_t now = MON_now();
+		MON_applyWakes(now);
+		MON_runDue(now);
+	}
+	pthread_mutex_unlock(&mon.mx);
+	return NULL;
+}
+
+int MON_addTask(MON_TaskFunc func, uint32_t delay_ms) {
+	pthread_mutex_lock(&mon.mx);
+	if (!mon.running) {
+		memset(&mon.scheduler, 0, sizeof(mon.scheduler));
+		mon.pending = 0;
+		if (MON_openWait() < 0) {
+			LOG_error("monitor: unable to create wait descriptors");
+			MON_closeWait();
+			pthread_mutex_unlock(&mon.mx);
+			return -1;
+		}
+		mon.running = 1;
+		mon.started_ms = MON_now();
+		pthread_create(&mon.pt, NULL, &MON_thread, NULL);
+	}
+	int id = MON_Scheduler_add(&mon.scheduler, func, MON_now(), delay_ms);
+	pthread_mutex_unlock(&mon.mx);
+
+	MON_signal();
+	return id;
+}
+
+void MON_removeTask(int id) {
+	if (id < 0)
+		return;
+
+	pthread_mutex_lock(&mon.mx);
+	if (!mon.running) {
+		pthread_mutex_unlock(&mon.mx);
+		return;
+	}
+	MON_Scheduler_remove(&mon.scheduler, id);
+	MON_waitIdle();
+
+	int remaining = 0;
+	for (int i = 0; i < MON_MAX_TASKS; i++) {
+		if (mon.scheduler.tasks[i])
+			remaining += 1;
+	}
+	if (remaining) {
+		pthread_mutex_unlock(&mon.mx);
+		MON_signal();
+		return;
+	}
+
+	mon.running = 0;
+	pthread_mutex_unlock(&mon.mx);
+	MON_signal();
+	pthread_join(mon.pt, NULL);
+	MON_closeWait();
+
+	uint64_t elapsed = MON_now() - mon.started_ms;
+	if (elapsed >= 1000) {
+		LOG_info("monitor: %u wakeups in %llus (%.1f/min)", mon.scheduler.wakeups,
+		         (unsigned long long)(elapsed / 1000), mon.scheduler.wakeups * 60000.0 / elapsed);
+	}
+}
+
+void MON_wake(int id) {
+	if (id < 0 || id >= MON_MAX_TASKS || !__atomic_load_n(&mon.running, __ATOMIC_ACQUIRE))
+		return;
+	__atomic_fetch_or(&mon.pending, 1u << id, __ATOMIC_ACQ_REL);
+	MON_signal();
+}
+
+void MON_suspend(void) {
+	pthread_mutex_lock(&mon.mx);
+	MON_Scheduler_setSuspended(&mon.scheduler, 1);
+	MON_waitIdle();
+	pthread_mutex_unlock(&mon.mx);
+}
+
+void MON_resume(void) {
+	pthread_mutex_lock(&mon.mx);
+	MON_Scheduler_setSuspended(&mon.scheduler, 0);
+	int running = mon.running;
+	pthread_mutex_unlock(&mon.mx);
+
+	if (running)
+		MON_signal();
+}
+
+uint32_t MON_getWakeups(void) {
+	return mon.scheduler.wakeups;
+}
@@ -0,0 +1,230 @@
+/**
+ * monitor.h - Shared background scheduler for hardware monitoring
+ *
+ * The battery and vibration workers used to run their own threads on fixed
+ * timers: battery every 5 seconds and vibration every 17ms, forever, even
+ * while asleep or with nothing to do. The monitor replaces both with one
+ * thread that sleeps until the next task is due (timerfd + epoll on Linux)
+ * and lets each task choose its own next interval, or park until woken.
+ *
+ * The scheduling itself (MON_Scheduler) is pure logic driven by an explicit
+ * clock, so policies can be tested by simulating time and counting wakeups.
+ * The MON_* runtime wraps a single MON_Scheduler in the background thread.
+ *
+ * Tasks run on the monitor thread without its lock held, so a slow task
+ * never blocks MON_addTask() or the other runtime calls for long. They
+ * must not call MON_addTask(), MON_removeTask(), MON_suspend() or
+ * MON_resume(), which wait for running tasks; MON_wake() is safe from
+ * anywhere.
+ */
+
+#ifndef __MONITOR_H__
+#define __MONITOR_H__
+
+#include <stdint.h>
+
+/**
+ * Maximum number of tasks per scheduler.
+ */
+#define MON_MAX_TASKS 4
+
+/**
+ * Task return value: park until MON_wake() instead of running on a timer.
+ */
+#define MON_IDLE UINT32_MAX
+
+/**
+ * Battery polling intervals in milliseconds (see MON_batteryInterval()).
+ */
+#define MON_BATTERY_LOW_MS 2000 // Discharging near the warning threshold
+#define MON_BATTERY_ACTIVE_MS 5000 // Charge or charger state just changed
+#define MON_BATTERY_MENU_MS 10000 // Stable, battery is on screen
+#define MON_BATTERY_GAME_MS 30000 // Stable, only the low warning is visible
+
+/**
+ * Charge at or below which a discharging battery is polled at
+ * MON_BATTERY_LOW_MS, so the low battery warning appears promptly.
+ */
+#define MON_BATTERY_LOW_CHARGE 20
+
+/**
+ * Task callback.
+ *
+ * @return Milliseconds until the task should run again, or MON_IDLE
+ */
+typedef uint32_t (*MON_TaskFunc)(void);
+
+/**
+ * Clock-driven task scheduler.
+ *
+ * Treat fields as private, use the MON_Scheduler_* functions.
+ */
+typedef struct MON_Scheduler {
+	MON_TaskFunc tasks[MON_MAX_TASKS]; // NULL for unused slots
+	uint64_t due_ms[MON_MAX_TASKS]; // When each task runs next, 0 if idle
+	int suspended; // 1 while no task may run
+	uint32_t wakeups; // Number of MON_Scheduler_run() calls
+} MON_Scheduler;
+
+///////////////////////////////
+// Scheduler
+///////////////////////////////
+
+/**
+ * Adds a task.
+ *
+ * @param scheduler Scheduler to add to
+ * @param func Task callback
+ * @param now_ms Current time
+ * @param delay_ms Delay before the first run, or MON_IDLE to start parked
+ * @return Task id, or -1 if the scheduler is full
+ */
+int MON_Scheduler_add(MON_Scheduler* scheduler, MON_TaskFunc func, uint64_t now_ms,
+                      uint32_t delay_ms);
+
+/**
+ * Removes a task.
+ *
+ * @param scheduler Scheduler to remove from
+ * @param id Task id returned by MON_Scheduler_add()
+ */
+void MON_Scheduler_remove(MON_Scheduler* scheduler, int id);
+
+/**
+ * Makes a task due immediately, whether it was parked or waiting.
+ *
+ * @param scheduler Scheduler owning the task
+ * @param id Task id
+ * @param now_ms Current time
+ */
+void MON_Scheduler_wake(MON_Scheduler* scheduler, int id, uint64_t now_ms);
+
+/**
+ * Suspends or resumes all tasks.
+ *
+ * Deadlines are kept, so tasks that fell due while suspended run as soon
+ * as the scheduler resumes.
+ *
+ * @param scheduler Scheduler to update
+ * @param suspended 1 to suspend, 0 to resume
+ */
+void MON_Scheduler_setSuspended(MON_Scheduler* scheduler, int suspended);
+
+/**
+ * Gets the time until the next task is due.
+ *
+ * @param scheduler Scheduler to query
+ * @param now_ms Current time
+ * @return Milliseconds to sleep (0 if a task is overdue), or -1 to sleep
+ *         until woken (all tasks parked, or suspended)
+ */
+int64_t MON_Scheduler_timeout(const MON_Scheduler* scheduler, uint64_t now_ms);
+
+/**
+ * Runs every due task and reschedules it by its return value.
+ *
+ * Each call counts as one wakeup.
+ *
+ * @param scheduler Scheduler to run
+ * @param now_ms Current time
+ * @return Number of tasks run
+ */
+int MON_Scheduler_run(MON_Scheduler* scheduler, uint64_t now_ms);
+
+/**
+ * Takes every due task, to be run without holding the scheduler's lock.
+ *
+ * Taken tasks aren't due again until MON_Scheduler_finish(). Each call
+ * counts as one wakeup.
+ *
+ * @param scheduler Scheduler to take from
+ * @param now_ms Current time
+ * @param ids Receives the ids of the taken tasks, MON_MAX_TASKS at most
+ * @return Number of tasks taken
+ */
+int MON_Scheduler_takeDue(MON_Scheduler* scheduler, uint64_t now_ms, int* ids);
+
+/**
+ * Reschedules a task taken by MON_Scheduler_takeDue() by its return value.
+ *
+ * Does nothing if the task was removed (or its slot reused) while it ran.
+ *
+ * @param scheduler Scheduler owning the task
+ * @param id Task id
+ * @param func Callback that ran, as it was when the task was taken
+ * @param now_ms Current time
+ * @param delay_ms Value the callback returned
+ */
+void MON_Scheduler_finish(MON_Scheduler* scheduler, int id, MON_TaskFunc func, uint64_t now_ms,
+                          uint32_t delay_ms);
+
+///////////////////////////////
+// Policies
+///////////////////////////////
+
+/**
+ * Chooses the next battery poll interval.
+ *
+ * Polls quickly when discharging near the warning threshold or right after
+ * a change (charger plugged, charge dropped), and backs off while the
+ * reading is stable, more so in game where the battery isn't on screen.
+ *
+ * @param charge Charge just read (0-100)
+ * @param is_charging Charger state just read
+ * @param changed 1 if either differs from the previous reading
+ * @param in_game 1 while a game is running
+ * @return Milliseconds until the next poll
+ */
+uint32_t MON_batteryInterval(int charge, int is_charging, int changed, int in_game);
+
+///////////////////////////////
+// Runtime
+///////////////////////////////
+
+/**
+ * Adds a task to the shared monitor, starting its thread if needed.
+ *
+ * @param func Task callback
+ * @param delay_ms Delay before the first run, or MON_IDLE to start parked
+ * @return Task id, or -1 on failure
+ */
+int MON_addTask(MON_TaskFunc func, uint32_t delay_ms);
+
+/**
+ * Removes a task, stopping the monitor thread after the last one.
+ *
+ * Waits for running tasks, so the removed one is not running on return.
+ *
+ * @param id Task id returned by MON_addTask(), ignored if -1
+ */
+void MON_removeTask(int id);
+
+/**
+ * Runs a task as soon as possible.
+ *
+ * Never blocks, safe to call from the frame loop every frame.
+ *
+ * @param id Task id returned by MON_addTask(), ignored if -1
+ */
+void MON_wake(int id);
+
+/**
+ * Stops running tasks until MON_resume(), e.g. while the device sleeps.
+ *
+ * Waits for running tasks, so none is running on return.
+ */
+void MON_suspend(void);
+
+/**
+ * Resumes running tasks after MON_suspend().
+ */
+void MON_resume(void);
+
+/**
+ * Gets the number of times the monitor thread has woken up.
+ *
+ * @return Wakeups since the thread started
+ */
+uint32_t MON_getWakeups(void);
+
+#endif // __MONITOR_H__
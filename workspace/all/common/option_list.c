@@ -0,0 +1,50 @@
+/**
+ * option_list.c - minarch frontend and core options
+ */
+
+#include "option_list.h"
+
+#include <string.h>
+
+int Option_getValueIndex(Option* item, const char* value) {
+	if (!value)
+		return 0;
+	for (int i = 0; i < item->count; i++) {
+		if (!strcmp(item->values[i], value))
+			return i;
+	}
+	return 0;
+}
+
+void Option_setValue(Option* item, const char* value) {
+	// TODO: store previous value?
+	item->value = Option_getValueIndex(item, value);
+}
+
+Option* OptionList_getOption(OptionList* list, const char* key) {
+	if (list->index.slots) {
+		int i = KeyIndex_find(&list->index, key);
+		return i < 0 ? NULL : &list->options[i];
+	}
+	for (int i = 0; i < list->count; i++) {
+		Option* item = &list->options[i];
+		if (!strcmp(item->key, key))
+			return item;
+	}
+	return NULL;
+}
+
+void OptionList_markChanged(OptionList* list, Option* item, int old_value) {
+	if (item->value == old_value)
+		return;
+	item->dirty = 1;
+	list->changed = 1;
+}
+
+char* OptionList_readValue(OptionList* list, const char* key) {
+	Option* item = OptionList_getOption(list, key);
+	if (!item)
+		return NULL;
+	item->dirty = 0;
+	return item->values[item->value];
+}
@@ -0,0 +1,94 @@
+/**
+ * option_list.h - minarch frontend and core options
+ *
+ * Every option holds an index into its list of values. A core learns its
+ * option values through RETRO_ENVIRONMENT_GET_VARIABLE and polls
+ * RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE to find out whether any changed.
+ * Each option carries a dirty bit, set when its value really changes and
+ * cleared when the core reads it back, so the frontend can tell which
+ * options a raised update flag is about.
+ *
+ * Extracted as pure logic so change tracking can be tested without a core.
+ */
+
+#ifndef __OPTION_LIST_H__
+#define __OPTION_LIST_H__
+
+#include "config_store.h"
+
+typedef struct Option {
+	char* key;
+	char* name; // desc
+	char* desc; // info, truncated
+	char* full; // info, longer but possibly still truncated
+	char* var;
+	int default_value;
+	int value;
+	int count; // TODO: drop this?
+	int lock;
+	int dirty; // Value changed since the core last read it
+	char** values;
+	char** labels;
+} Option;
+
+typedef struct OptionList {
+	int count;
+	int changed;
+	Option* options;
+
+	int enabled_count;
+	Option** enabled_options;
+	KeyIndex index; // Option ids by key, empty for lists that are searched linearly
+	// OptionList_callback_t on_set;
+} OptionList;
+
+/**
+ * Finds the index of a value.
+ *
+ * @param item Option to search
+ * @param value Value string, or NULL
+ * @return Index of value, 0 if it isn't listed
+ */
+int Option_getValueIndex(Option* item, const char* value);
+
+/**
+ * Sets an option by value string, falling back to the first value.
+ *
+ * Doesn't flag the change, see OptionList_markChanged().
+ *
+ * @param item Option to set
+ * @param value Value string, or NULL
+ */
+void Option_setValue(Option* item, const char* value);
+
+/**
+ * Looks up an option.
+ *
+ * @param list List to search, by KeyIndex if it has one
+ * @param key Option key
+ * @return Option, or NULL if not found
+ */
+Option* OptionList_getOption(OptionList* list, const char* key);
+
+/**
+ * Flags an option whose value may have changed, so the core is told
+ * through RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE.
+ *
+ * Setting an option to the value it already has doesn't count.
+ *
+ * @param list List the option belongs to
+ * @param item Option that was set
+ * @param old_value Value index before it was set
+ */
+void OptionList_markChanged(OptionList* list, Option* item, int old_value);
+
+/**
+ * Hands an option's value to the core, clearing its dirty bit.
+ *
+ * @param list List to search
+ * @param key Option key
+ * @return Value string, or NULL if not found
+ */
+char* OptionList_readValue(OptionList* list, const char* key);
+
+#endif // __OPTION_LIST_H__
@@ -76,6 +76,74 @@ void PAD_setAnalog(int neg_id, int pos_id, int value, int repeat_at) {
 	}
 }
 
+/**
+ * Starts a new input frame.
+ *
+ * Clears the transient state and fires auto-repeat for held buttons.
+ * Repeats are scheduled PAD_REPEAT_INTERVAL apart once the initial
+ * PAD_REPEAT_DELAY (set by PAD_setButton) has elapsed.
+ *
+ * @param tick Current timestamp in milliseconds
+ */
+void PAD_beginFrame(uint32_t tick) {
+	// reset transient state
+	pad.just_pressed = BTN_NONE;
+	pad.just_released = BTN_NONE;
+	pad.just_repeated = BTN_NONE;
+
+	for (int i = 0; i < BTN_ID_COUNT; i++) {
+		int btn = 1 << i;
+		if ((pad.is_pressed & btn) && (tick >= pad.repeat_at[i])) {
+			pad.just_repeated |= btn; // set
+			pad.repeat_at[i] += PAD_REPEAT_INTERVAL;
+		}
+	}
+}
+
+/**
+ * Applies a digital button press or release to the pad state.
+ *
+ * @param id Button ID (BTN_ID_A, etc.), BTN_ID_NONE is ignored
+ * @param pressed 1 for press, 0 for release
+ * @param tick Current timestamp in milliseconds (for repeat scheduling)
+ */
+void PAD_setButton(int id, int pressed, uint32_t tick) {
+	if (id < 0 || id >= BTN_ID_COUNT)
+		return;
+
+	int btn = 1 << id;
+	if (!pressed) {
+		pad.is_pressed &= ~btn; // unset
+		pad.just_repeated &= ~btn; // unset
+		pad.just_released |= btn; // set
+	} else if ((pad.is_pressed & btn) == BTN_NONE) {
+		pad.just_pressed |= btn; // set
+		pad.just_repeated |= btn; // set
+		pad.is_pressed |= btn; // set
+		pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
+	}
+}
+
+/**
+ * Applies an evdev hat (d-pad) axis event to the pad state.
+ *
+ * @param vertical 1 for the Y hat axis (up/down), 0 for X (left/right)
+ * @param value Hat value (-1, 0 or 1)
+ * @param tick Current timestamp in milliseconds (for repeat scheduling)
+ */
+void PAD_setHat(int vertical, int value, uint32_t tick) {
+	if (value > 1)
+		return; // ignore repeats
+
+	if (vertical) {
+		PAD_setButton(BTN_ID_DPAD_UP, value == -1, tick);
+		PAD_setButton(BTN_ID_DPAD_DOWN, value == 1, tick);
+	} else {
+		PAD_setButton(BTN_ID_DPAD_LEFT, value == -1, tick);
+		PAD_setButton(BTN_ID_DPAD_RIGHT, value == 1, tick);
+	}
+}
+
 /**
  * Resets all button states to unpressed.
  *
@@ -47,6 +47,14 @@ typedef struct PAD_Context {
 extern PAD_Context pad;
 #endif
 
+#ifndef PAD_REPEAT_DELAY
+/**
+ * Auto-repeat timing constants (also defined by api.h).
+ */
+#define PAD_REPEAT_DELAY 300 // Milliseconds before first repeat
+#define PAD_REPEAT_INTERVAL 100 // Milliseconds between repeats
+#endif
+
 /**
  * Analog stick deadzone (threshold for registering input).
  */
@@ -67,6 +75,42 @@ extern PAD_Context pad;
  */
 void PAD_setAnalog(int neg_id, int pos_id, int value, int repeat_at);
 
+/**
+ * Starts a new input frame.
+ *
+ * Clears the transient state (just_pressed/just_released/just_repeated)
+ * and fires auto-repeat for buttons that have been held long enough.
+ * Every PLAT_pollInput implementation calls this before draining events.
+ *
+ * @param tick Current timestamp in milliseconds
+ */
+void PAD_beginFrame(uint32_t tick);
+
+/**
+ * Applies a digital button press or release to the pad state.
+ *
+ * Presses of an already held button are ignored so a button only
+ * reports just_pressed once; releases always report just_released.
+ *
+ * @param id Button ID (BTN_ID_A, etc.), BTN_ID_NONE is ignored
+ * @param pressed 1 for press, 0 for release
+ * @param tick Current timestamp in milliseconds (for repeat scheduling)
+ */
+void PAD_setButton(int id, int pressed, uint32_t tick);
+
+/**
+ * Applies an evdev hat (d-pad) axis event to the pad state.
+ *
+ * Hat axes report -1/0/1. A value of -1 presses up (or left), 1 presses
+ * down (or right) and 0 releases both directions of that axis. The
+ * opposite direction is always released, matching how a d-pad rocks.
+ *
+ * @param vertical 1 for the Y hat axis (up/down), 0 for X (left/right)
+ * @param value Hat value (-1, 0 or 1)
+ * @param tick Current timestamp in milliseconds (for repeat scheduling)
+ */
+void PAD_setHat(int vertical, int value, uint32_t tick);
+
 /**
  * Resets all button states to unpressed.
  *
@@ -0,0 +1,74 @@
+/**
+ * preview_cache.c - Save state previews written and loaded in the background
+ */
+
+#include "preview_cache.h"
+
+#include <stdlib.h>
+
+static void freePreview(void* image) {
+	BootFrame_free(image);
+	free(image);
+}
+
+static BootFrame* capturePreview(const void* pixels, int width, int height, int pitch) {
+	BootFrame* frame = calloc(1, sizeof(BootFrame));
+	if (frame && BootFrame_capture(frame, pixels, width, height, pitch) != 0) {
+		freePreview(frame);
+		frame = NULL;
+	}
+	return frame;
+}
+
+static void* loadPreview(const char* path, void* userdata) {
+	(void)userdata;
+	BootFrame* frame = calloc(1, sizeof(BootFrame));
+	if (frame && BootFrame_load(frame, path) != 0) {
+		freePreview(frame);
+		frame = NULL;
+	}
+	return frame;
+}
+
+static int savePreview(void* image, const char* path, void* userdata) {
+	(void)userdata;
+	return BootFrame_save(image, path);
+}
+
+int PreviewCache_start(PreviewCache* cache) {
+	return ImageCache_start(cache, PREVIEW_CACHE_SIZE, loadPreview, savePreview, freePreview,
+	                        NULL);
+}
+
+int PreviewCache_save(PreviewCache* cache, const char* path, const void* pixels, int width,
+                      int height, int pitch) {
+	if (!cache->running)
+		return -1;
+
+	BootFrame* frame = capturePreview(pixels, width, height, pitch);
+	BootFrame* copy = capturePreview(pixels, width, height, pitch);
+	if (!frame || !copy || ImageCache_store(cache, path, frame, copy) != 0) {
+		if (frame)
+			freePreview(frame);
+		if (copy)
+			freePreview(copy);
+		return -1;
+	}
+	return 0;
+}
+
+int PreviewCache_request(PreviewCache* cache, const char* path, const BootFrame** frame) {
+	void* image = NULL;
+	int state = ImageCache_request(cache, path, frame ? &image : NULL);
+	if (frame)
+		*frame = image;
+	return state;
+}
+
+void PreviewCache_flush(PreviewCache* cache) {
+	ImageCache_flush(cache);
+}
+
+void PreviewCache_stop(PreviewCache* cache) {
+	ImageCache_stop(cache);
+}
@@ -0,0 +1,89 @@
+/**
+ * preview_cache.h - Save state previews written and loaded in the background
+ *
+ * Saving a state used to write a full resolution, uncompressed BMP of the
+ * game screen on the spot, and the in-game menu decoded that BMP again
+ * every time the selected slot changed. Previews are now downscaled to
+ * the size the menu shows them at by the caller and stored as BootFrame
+ * files (raw RGB565 at preview size). An ImageCache worker writes and
+ * reads them, and the most recently used previews stay in memory, so
+ * neither saving nor switching slots waits on the SD card.
+ *
+ * All functions are meant to be called from a single thread (the menu).
+ */
+
+#ifndef __PREVIEW_CACHE_H__
+#define __PREVIEW_CACHE_H__
+
+#include "boot_frame.h"
+#include "image_cache.h"
+
+#define PREVIEW_CACHE_SIZE 4 // The selected slot, its neighbors and one spare
+
+enum {
+	PREVIEW_NONE = IMAGE_NONE, // Not requested yet, or couldn't be queued
+	PREVIEW_LOADING = IMAGE_LOADING,
+	PREVIEW_READY = IMAGE_READY,
+	PREVIEW_MISSING = IMAGE_MISSING, // No preview file, or it's invalid
+};
+
+/**
+ * Preview cache, an ImageCache of heap allocated BootFrames.
+ */
+typedef ImageCache PreviewCache;
+
+/**
+ * Starts the worker thread.
+ *
+ * @param cache Cache to start
+ * @return 0 on success, -1 if the thread couldn't be started
+ */
+int PreviewCache_start(PreviewCache* cache);
+
+/**
+ * Stores a new preview and queues writing it to disk.
+ *
+ * The pixels are copied, both into the cache (so the preview shows right
+ * away) and into the copy the worker writes. Waits only if the queue is
+ * full.
+ *
+ * @param cache Running cache
+ * @param path Preview file
+ * @param pixels RGB565 pixels at preview size
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param pitch Row stride in bytes
+ * @return 0 if queued, -1 if out of memory or not running
+ */
+int PreviewCache_save(PreviewCache* cache, const char* path, const void* pixels, int width,
+                      int height, int pitch);
+
+/**
+ * Looks up a preview, queueing a background load on a miss.
+ *
+ * Never blocks. Keep calling while it returns PREVIEW_LOADING (or
+ * PREVIEW_NONE, when the queue was full). The returned frame stays valid
+ * until the next call to PreviewCache_request() or PreviewCache_save().
+ *
+ * @param cache Running cache
+ * @param path Preview file
+ * @param frame Set to the preview when READY (may be NULL to prefetch)
+ * @return PREVIEW_* state of the preview
+ */
+int PreviewCache_request(PreviewCache* cache, const char* path, const BootFrame** frame);
+
+/**
+ * Waits until every queued job has finished.
+ *
+ * @param cache Cache to wait for
+ */
+void PreviewCache_flush(PreviewCache* cache);
+
+/**
+ * Finishes queued writes, stops the thread and frees all previews.
+ *
+ * @param cache Cache to stop, may have never been started
+ */
+void PreviewCache_stop(PreviewCache* cache);
+
+#endif // __PREVIEW_CACHE_H__
@@ -0,0 +1,79 @@
+/**
+ * settings_sync.c - Seqlock and change notification for shared settings
+ */
+
+#include "settings_sync.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+///////////////////////////////
+// Writers
+///////////////////////////////
+
+void SettingsSync_beginWrite(SettingsSync* sync) {
+	int32_t self = getpid();
+	for (int attempt = 0;; attempt++) {
+		int32_t owner = __atomic_load_n(&sync->owner, __ATOMIC_RELAXED);
+		if (owner == 0) {
+			if (__atomic_compare_exchange_n(&sync->owner, &owner, self, 0, __ATOMIC_ACQUIRE,
+			                                __ATOMIC_RELAXED))
+				break;
+			continue;
+		}
+
+		// only a dead owner is replaced, a stopped one (keymon while asleep)
+		// still finishes its update once it's resumed
+		if (kill(owner, 0) < 0 && errno == ESRCH &&
+		    __atomic_compare_exchange_n(&sync->owner, &owner, self, 0, __ATOMIC_ACQUIRE,
+		                                __ATOMIC_RELAXED))
+			break;
+
+		if (attempt < SETTINGS_SYNC_MAX_SPINS)
+			sched_yield(); // another writer is mid-update
+		else
+			usleep(1000);
+	}
+
+	// an odd sequence was left by the dead owner, readers already retry on it
+	uint32_t seq = __atomic_load_n(&sync->sequence, __ATOMIC_RELAXED);
+	if (!(seq & 1))
+		__atomic_store_n(&sync->sequence, seq + 1, __ATOMIC_RELAXED);
+
+	// the odd sequence must be visible before any of the data stores that
+	// follow, like smp_wmb() in write_seqcount_begin()
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void SettingsSync_endWrite(SettingsSync* sync) {
+	__atomic_fetch_add(&sync->sequence, 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&sync->owner, 0, __ATOMIC_RELEASE);
+	__atomic_fetch_add(&sync->generation, 1, __ATOMIC_RELEASE);
+}
+
+///////////////////////////////
+// Readers
+///////////////////////////////
+
+void SettingsSync_read(const SettingsSync* sync, void* dst, const void* src, size_t size) {
+	for (int attempt = 0;; attempt++) {
+		uint32_t start = __atomic_load_n(&sync->sequence, __ATOMIC_ACQUIRE);
+		int give_up = attempt >= SETTINGS_SYNC_MAX_SPINS;
+		if ((start & 1) && !give_up) {
+			sched_yield();
+			continue;
+		}
+
+		memcpy(dst, src, size);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&sync->sequence, __ATOMIC_RELAXED) == start || give_up)
+			return;
+	}
+}
+
+uint32_t SettingsSync_getGeneration(const SettingsSync* sync) {
+	return __atomic_load_n(&sync->generation, __ATOMIC_ACQUIRE);
+}
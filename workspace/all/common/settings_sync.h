@@ -0,0 +1,86 @@
+/**
+ * settings_sync.h - Seqlock and change notification for shared settings
+ *
+ * libmsettings shares its Settings struct between keymon, minui, minarch
+ * and the tools through shm_open()+mmap(). Any of them can write, so a
+ * reader could see a half-applied change (GetVolume() reading jack from
+ * one update and the speaker level from another), and the only way to
+ * notice a change was to re-read fields every frame.
+ *
+ * A SettingsSync lives in the same shared mapping, right after the
+ * settings it protects:
+ *
+ * - owner is the pid of the process writing, 0 if none. Writers take it
+ *   with a compare-and-swap, which serializes them.
+ * - sequence is a seqlock. The owner makes it odd for the duration of an
+ *   update, readers copy the settings and retry if it changed underneath
+ *   them.
+ * - generation counts committed updates, so a process can compare it with
+ *   the last one it saw and skip re-reading unchanged state.
+ *
+ * A writer that dies mid-update would leave the lock taken forever, so the
+ * next writer takes it over once kill(owner, 0) says the owner is gone. A
+ * writer that is only stopped (PWR_enterSleep() SIGSTOPs keymon) keeps the
+ * lock, so whoever stopped it must resume it before writing settings.
+ * Readers can't tell the two apart and give up waiting after
+ * SETTINGS_SYNC_MAX_SPINS attempts, carrying on with whatever is in memory.
+ */
+
+#ifndef __SETTINGS_SYNC_H__
+#define __SETTINGS_SYNC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Attempts before readers assume a writer died mid-update, and before
+ * waiting writers back off from yielding to sleeping.
+ */
+#define SETTINGS_SYNC_MAX_SPINS 1000
+
+/**
+ * Synchronization words placed in shared memory. Zero-initialized state
+ * (a fresh ftruncate()d object) is valid.
+ */
+typedef struct SettingsSync {
+	uint32_t sequence; // Seqlock, odd while an update is in progress
+	uint32_t generation; // Committed updates
+	int32_t owner; // Pid of the writing process, 0 if none
+} SettingsSync;
+
+/**
+ * Starts an update, waiting for any other writer to finish.
+ *
+ * Waits for as long as the other writer is alive, stopped included. Must
+ * not be nested.
+ *
+ * @param sync Shared sync state
+ */
+void SettingsSync_beginWrite(SettingsSync* sync);
+
+/**
+ * Commits an update and bumps the generation.
+ *
+ * @param sync Shared sync state
+ */
+void SettingsSync_endWrite(SettingsSync* sync);
+
+/**
+ * Copies a consistent snapshot of the protected data.
+ *
+ * @param sync Shared sync state
+ * @param dst Destination buffer
+ * @param src Protected data in shared memory
+ * @param size Number of bytes to copy
+ */
+void SettingsSync_read(const SettingsSync* sync, void* dst, const void* src, size_t size);
+
+/**
+ * Gets the number of committed updates so far.
+ *
+ * @param sync Shared sync state
+ * @return Current generation
+ */
+uint32_t SettingsSync_getGeneration(const SettingsSync* sync);
+
+#endif // __SETTINGS_SYNC_H__
@@ -0,0 +1,222 @@
+/**
+ * sram_flusher.c - Periodic background writeback of battery saves
+ */
+
+#include "sram_flusher.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LANE_PRIME 0x01000193u // FNV-1a 32-bit prime
+#define MIX_PRIME 0x100000001b3ull // FNV-1a 64-bit prime
+
+uint64_t SramFlusher_hash(const void* data, size_t size) {
+	const uint8_t* bytes = data;
+	uint32_t lanes[4] = {0x811c9dc5u, 0x050c5d1fu, 0x1b873593u, 0x6b43a9b5u};
+
+	size_t blocks = size / 16;
+	for (size_t i = 0; i < blocks; i++) {
+		uint32_t words[4];
+		memcpy(words, bytes + i * 16, 16);
+		for (int lane = 0; lane < 4; lane++)
+			lanes[lane] = (lanes[lane] ^ words[lane]) * LANE_PRIME;
+	}
+	for (size_t i = blocks * 16; i < size; i++)
+		lanes[i & 3] = (lanes[i & 3] ^ bytes[i]) * LANE_PRIME;
+
+	uint64_t hash = size;
+	for (int lane = 0; lane < 4; lane++)
+		hash = (hash ^ lanes[lane]) * MIX_PRIME;
+	return hash;
+}
+
+int SramFlusher_writeFile(const char* path, const void* data, size_t size) {
+	char tmp_path[520];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -1;
+
+	const uint8_t* bytes = data;
+	size_t written = 0;
+	while (written < size) {
+		ssize_t count = write(fd, bytes + written, size - written);
+		if (count <= 0)
+			break;
+		written += (size_t)count;
+	}
+
+	int ok = written == size && fsync(fd) == 0;
+	ok = close(fd) == 0 && ok;
+	if (!ok || rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+
+	// make the rename itself durable
+	char dir_path[520];
+	snprintf(dir_path, sizeof(dir_path), "%s", path);
+	char* slash = strrchr(dir_path, '/');
+	if (slash) {
+		*(slash == dir_path ? slash + 1 : slash) = '\0';
+		int dir_fd = open(dir_path, O_RDONLY | O_CLOEXEC);
+		if (dir_fd >= 0) {
+			fsync(dir_fd);
+			close(dir_fd);
+		}
+	}
+	return 0;
+}
+
+static void* writerThread(void* arg) {
+	SramFlusher* flusher = arg;
+
+	pthread_mutex_lock(&flusher->mutex);
+	while (1) {
+		while (!flusher->has_pending && !flusher->quit)
+			pthread_cond_wait(&flusher->cond, &flusher->mutex);
+		if (!flusher->has_pending)
+			break; // quit, nothing left to write
+
+		void* buffer = flusher->pending;
+		flusher->pending = flusher->writing;
+		flusher->writing = buffer;
+		size_t size = flusher->pending_size;
+		uint64_t hash = flusher->pending_hash;
+		flusher->has_pending = 0;
+		flusher->busy = 1;
+		flusher->writing_hash = hash;
+		pthread_mutex_unlock(&flusher->mutex);
+
+		int result = SramFlusher_writeFile(flusher->path, buffer, size);
+
+		pthread_mutex_lock(&flusher->mutex);
+		flusher->busy = 0;
+		if (result == 0) {
+			flusher->hash = hash;
+			flusher->writes += 1;
+		}
+		else
+			flusher->errors += 1; // hash still differs, the next poll queues it again
+		pthread_cond_broadcast(&flusher->cond);
+	}
+	pthread_mutex_unlock(&flusher->mutex);
+	return NULL;
+}
+
+int SramFlusher_start(SramFlusher* flusher, const char* path, uint32_t interval_ms) {
+	memset(flusher, 0, sizeof(SramFlusher));
+	snprintf(flusher->path, sizeof(flusher->path), "%s", path);
+	flusher->interval_ms = interval_ms;
+
+	pthread_mutex_init(&flusher->mutex, NULL);
+	pthread_cond_init(&flusher->cond, NULL);
+	if (pthread_create(&flusher->thread, NULL, writerThread, flusher) != 0) {
+		pthread_cond_destroy(&flusher->cond);
+		pthread_mutex_destroy(&flusher->mutex);
+		return -1;
+	}
+	flusher->running = 1;
+	return 0;
+}
+
+void SramFlusher_setBaseline(SramFlusher* flusher, const void* data, size_t size) {
+	uint64_t hash = SramFlusher_hash(data, size);
+	if (flusher->running)
+		pthread_mutex_lock(&flusher->mutex);
+	flusher->hash = hash;
+	if (flusher->running)
+		pthread_mutex_unlock(&flusher->mutex);
+	flusher->checked_at = 0;
+}
+
+/**
+ * Makes room for a copy in both buffers, must hold the mutex and the
+ * thread must not be writing.
+ */
+static int reserve(SramFlusher* flusher, size_t size) {
+	if (size <= flusher->capacity)
+		return 0;
+
+	void* pending = realloc(flusher->pending, size);
+	if (pending)
+		flusher->pending = pending;
+	void* writing = realloc(flusher->writing, size);
+	if (writing)
+		flusher->writing = writing;
+	if (!pending || !writing)
+		return -1;
+
+	flusher->capacity = size;
+	return 0;
+}
+
+int SramFlusher_poll(SramFlusher* flusher, const void* data, size_t size, uint64_t now_ms) {
+	if (!flusher->running || !data || !size)
+		return 0;
+	if (flusher->checked_at && now_ms - flusher->checked_at < flusher->interval_ms)
+		return 0;
+	flusher->checked_at = now_ms;
+
+	uint64_t hash = SramFlusher_hash(data, size);
+
+	pthread_mutex_lock(&flusher->mutex);
+	// compare against the newest copy on its way to disk, or on disk
+	uint64_t latest = flusher->has_pending ? flusher->pending_hash
+	                  : flusher->busy      ? flusher->writing_hash
+	                                       : flusher->hash;
+	if (hash == latest) {
+		pthread_mutex_unlock(&flusher->mutex);
+		return 0;
+	}
+	if (size > flusher->capacity && flusher->busy) {
+		// can't grow the buffer being written, try again next poll
+		pthread_mutex_unlock(&flusher->mutex);
+		flusher->checked_at = 0;
+		return 0;
+	}
+	if (reserve(flusher, size) != 0) {
+		pthread_mutex_unlock(&flusher->mutex);
+		return 0;
+	}
+	memcpy(flusher->pending, data, size);
+	flusher->pending_size = size;
+	flusher->pending_hash = hash;
+	flusher->has_pending = 1;
+	pthread_cond_broadcast(&flusher->cond);
+	pthread_mutex_unlock(&flusher->mutex);
+	return 1;
+}
+
+void SramFlusher_flush(SramFlusher* flusher) {
+	if (!flusher->running)
+		return;
+
+	pthread_mutex_lock(&flusher->mutex);
+	while (flusher->has_pending || flusher->busy)
+		pthread_cond_wait(&flusher->cond, &flusher->mutex);
+	pthread_mutex_unlock(&flusher->mutex);
+}
+
+void SramFlusher_stop(SramFlusher* flusher) {
+	if (!flusher->running)
+		return;
+
+	pthread_mutex_lock(&flusher->mutex);
+	flusher->quit = 1;
+	pthread_cond_broadcast(&flusher->cond);
+	pthread_mutex_unlock(&flusher->mutex);
+	pthread_join(flusher->thread, NULL);
+
+	pthread_cond_destroy(&flusher->cond);
+	pthread_mutex_destroy(&flusher->mutex);
+	free(flusher->pending);
+	free(flusher->writing);
+	flusher->pending = flusher->writing = NULL;
+	flusher->capacity = 0;
+	flusher->running = 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * sram_flusher.h - Periodic background writeback of battery saves
+ *
+ * minarch used to write a game's save RAM only when leaving the game or
+ * opening the menu, so a crash or a dead battery lost everything since.
+ * The flusher hashes the core's save RAM every few seconds on the core
+ * thread. When the hash changes, it copies the buffer and a background
+ * thread writes the copy atomically (temp file, fsync, rename), so the
+ * core thread only ever pays for the hash and, on change, one memcpy.
+ */
+
+#ifndef __SRAM_FLUSHER_H__
+#define __SRAM_FLUSHER_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Background save RAM writer for one save file.
+ */
+typedef struct SramFlusher {
+	char path[512];
+	uint32_t interval_ms; // Minimum time between two hashes
+	uint64_t checked_at; // Time of the last hash in ms, 0 to check on the next poll
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int running; // Thread was started
+
+	// guarded by mutex
+	void* pending; // Copy waiting to be written
+	void* writing; // Copy the thread is writing
+	size_t capacity; // Size of both buffers
+	size_t pending_size;
+	uint64_t pending_hash;
+	uint64_t writing_hash;
+	uint64_t hash; // Hash of the contents last written (or read)
+	int has_pending;
+	int busy; // Thread is writing
+	int quit;
+	int writes; // Completed writes
+	int errors; // Failed writes
+} SramFlusher;
+
+/**
+ * Hashes a buffer.
+ *
+ * Four independent lanes over 32-bit words so the loop vectorizes, the
+ * goal is change detection rather than distribution quality.
+ *
+ * @param data Buffer to hash
+ * @param size Size in bytes
+ * @return 64-bit hash
+ */
+uint64_t SramFlusher_hash(const void* data, size_t size);
+
+/**
+ * Writes a file atomically.
+ *
+ * Writes a temporary file next to the destination, fsyncs it and renames
+ * it over the destination, so a power cut leaves either the old or the
+ * new contents. Only this file and its directory are synced, not the
+ * whole filesystem.
+ *
+ * @param path Destination file
+ * @param data Contents
+ * @param size Size in bytes
+ * @return 0 on success, -1 on error
+ */
+int SramFlusher_writeFile(const char* path, const void* data, size_t size);
+
+/**
+ * Starts the writer thread.
+ *
+ * @param flusher Flusher to start (zero-initialized or stopped)
+ * @param path Save file to keep up to date
+ * @param interval_ms Minimum time between two checks
+ * @return 0 on success, -1 if the thread couldn't be started
+ */
+int SramFlusher_start(SramFlusher* flusher, const char* path, uint32_t interval_ms);
+
+/**
+ * Records contents that are already on disk, so they aren't written again.
+ *
+ * @param flusher Flusher to update
+ * @param data Save RAM
+ * @param size Size in bytes
+ */
+void SramFlusher_setBaseline(SramFlusher* flusher, const void* data, size_t size);
+
+/**
+ * Checks the save RAM for changes, queueing a write when it changed.
+ *
+ * Cheap to call every frame: does nothing until interval_ms has passed
+ * since the last check. If the thread is still writing an older copy,
+ * the newer one replaces whatever was queued. A failed write is queued
+ * again on the next check.
+ *
+ * @param flusher Running flusher
+ * @param data Save RAM
+ * @param size Size in bytes
+ * @param now_ms Current time in ms
+ * @return 1 if a write was queued, 0 otherwise
+ */
+int SramFlusher_poll(SramFlusher* flusher, const void* data, size_t size, uint64_t now_ms);
+
+/**
+ * Waits until every queued write has finished.
+ *
+ * @param flusher Flusher to wait for
+ */
+void SramFlusher_flush(SramFlusher* flusher);
+
+/**
+ * Finishes queued writes, stops the thread and frees the buffers.
+ *
+ * @param flusher Flusher to stop, may have never been started
+ */
+void SramFlusher_stop(SramFlusher* flusher);
+
+#endif // __SRAM_FLUSHER_H__
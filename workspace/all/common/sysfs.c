@@ -0,0 +1,120 @@
+/**
+ * sysfs.c - Persistent-fd reader for polled sysfs values
+ *
+ * A refresh is a single pread() on an already open descriptor. If the
+ * read fails (the attribute went away, e.g. a USB gadget was unbound) the
+ * descriptor is closed and reopened on the next refresh.
+ */
+
+#include "sysfs.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Gets monotonic time in milliseconds.
+ */
+static uint64_t getTime(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Re-reads the attribute into the cache if it's stale.
+ */
+static void refresh(SysfsValue* value) {
+	uint64_t now = getTime();
+	if (value->valid && now - value->read_at < value->min_interval)
+		return;
+
+	value->read_at = now;
+	value->valid = 1; // a failed read is cached too, so missing files aren't hammered
+	value->value = 0;
+	value->text[0] = '\0';
+
+	if (value->fd < 0) {
+		value->fd = open(value->path, O_RDONLY | O_CLOEXEC);
+		if (value->fd < 0)
+			return;
+	}
+
+	ssize_t len = pread(value->fd, value->text, SYSFS_TEXT_MAX - 1, 0);
+	if (len < 0) {
+		close(value->fd);
+		value->fd = -1;
+		len = 0;
+	}
+
+	while (len > 0 && (value->text[len - 1] == '\n' || value->text[len - 1] == '\r'))
+		len -= 1;
+	value->text[len] = '\0';
+	value->value = SysfsValue_parseInt(value->text);
+}
+
+int SysfsValue_getInt(SysfsValue* value) {
+	refresh(value);
+	return value->value;
+}
+
+const char* SysfsValue_getString(SysfsValue* value) {
+	refresh(value);
+	return value->text;
+}
+
+void SysfsValue_invalidate(SysfsValue* value) {
+	value->valid = 0;
+}
+
+void SysfsValue_close(SysfsValue* value) {
+	if (value->fd >= 0) {
+		close(value->fd);
+		value->fd = -1;
+	}
+	value->valid = 0;
+}
+
+int SysfsValue_parseInt(const char* text) {
+	if (!text)
+		return 0;
+
+	while (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r')
+		text++;
+
+	int negative = 0;
+	if (*text == '-' || *text == '+') {
+		negative = *text == '-';
+		text++;
+	}
+
+	int base = 10;
+	if (text[0] == '0') {
+		if ((text[1] == 'x' || text[1] == 'X')) {
+			base = 16;
+			text += 2;
+		} else {
+			base = 8;
+		}
+	}
+
+	unsigned int result = 0;
+	for (;; text++) {
+		int digit;
+		char c = *text;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			break;
+		if (digit >= base)
+			break;
+		result = result * (unsigned int)base + (unsigned int)digit;
+	}
+
+	return negative ? -(int)result : (int)result;
+}
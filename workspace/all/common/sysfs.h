@@ -0,0 +1,105 @@
+/**
+ * sysfs.h - Persistent-fd reader for polled sysfs values
+ *
+ * getInt()/getFile() open, read and close their file on every call, which
+ * is fine for one-shot config reads but wasteful for values polled from the
+ * frame loop or the battery thread (lid sensor, charger, capacity, wifi).
+ *
+ * A SysfsValue keeps its file descriptor open and re-reads it with pread()
+ * at offset 0, which sysfs attributes support to fetch a fresh value.
+ * Integers are parsed without stdio, and each value can be rate-limited so
+ * repeated calls within min_interval return the cached result without a
+ * syscall at all.
+ *
+ * Values are declared statically with SYSFS_VALUE() and opened lazily on
+ * first read. A missing file reads as 0 / "" and is retried on the next
+ * refresh, so optional attributes need no separate exists() check.
+ */
+
+#ifndef __SYSFS_H__
+#define __SYSFS_H__
+
+#include <stdint.h>
+
+/**
+ * Maximum text length cached per value (including terminator).
+ */
+#define SYSFS_TEXT_MAX 64
+
+/**
+ * A cached sysfs attribute.
+ *
+ * Treat fields as private, use the SysfsValue_* functions.
+ */
+typedef struct SysfsValue {
+	const char* path; // Attribute path (not copied, must outlive the value)
+	uint32_t min_interval; // Milliseconds between refreshes, 0 to read every call
+	int fd; // Open descriptor, -1 if closed
+	int valid; // 1 once refreshed, failed reads included, 0 to force the next read
+	uint64_t read_at; // Monotonic time of last refresh (ms)
+	int value; // Cached integer value
+	char text[SYSFS_TEXT_MAX]; // Cached text, trailing newline stripped
+} SysfsValue;
+
+/**
+ * Static initializer for a SysfsValue.
+ *
+ * @param path Attribute path (string literal)
+ * @param min_interval Milliseconds between refreshes
+ */
+#define SYSFS_VALUE(path, min_interval) {(path), (min_interval), -1, 0, 0, 0, {0}}
+
+/**
+ * Reads a value as an integer.
+ *
+ * Refreshes from the file if the cache is older than min_interval.
+ * Accepts the same decimal, octal (0-prefix) and hex (0x-prefix) forms
+ * as getInt().
+ *
+ * @param value The value to read
+ * @return Parsed integer, or 0 if the file doesn't exist or is invalid
+ */
+int SysfsValue_getInt(SysfsValue* value);
+
+/**
+ * Reads a value as text.
+ *
+ * Refreshes from the file if the cache is older than min_interval.
+ * The trailing newline sysfs appends is stripped.
+ *
+ * @param value The value to read
+ * @return Cached text, "" if the file doesn't exist (never NULL)
+ *
+ * @note Returned pointer is owned by the value and changes on refresh
+ */
+const char* SysfsValue_getString(SysfsValue* value);
+
+/**
+ * Forces the next read to refresh regardless of min_interval.
+ *
+ * @param value The value to invalidate
+ */
+void SysfsValue_invalidate(SysfsValue* value);
+
+/**
+ * Closes the value's file descriptor and drops the cache.
+ *
+ * The value can still be read afterwards, it will simply reopen.
+ *
+ * @param value The value to close
+ */
+void SysfsValue_close(SysfsValue* value);
+
+/**
+ * Parses an integer the way fscanf("%i") does, without stdio.
+ *
+ * Skips leading whitespace, accepts an optional sign, then decimal,
+ * octal (0-prefix) or hex (0x-prefix) digits. Stops at the first
+ * character that isn't a digit.
+ *
+ * @param text Text to parse
+ * @return Parsed integer, or 0 if no digits were found
+ */
+int SysfsValue_parseInt(const char* text);
+
+#endif // __SYSFS_H__
@@ -11,14 +11,21 @@
 #include "defines.h"
 #include "log.h"
 #include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+extern char** environ;
+
 ///////////////////////////////
 // Timing utilities
 ///////////////////////////////
@@ -381,6 +388,128 @@ void putInt(const char* path, int value) {
 	putFile(path, buffer);
 }
 
+/**
+ * Creates a directory and any missing parents.
+ *
+ * Equivalent to 'mkdir -p' without spawning a shell.
+ *
+ * @param path Directory to create
+ * @return 0 if the directory exists afterwards, -1 otherwise
+ */
+int mkdirs(const char* path) {
+	char tmp[MAX_PATH];
+	size_t len = strlen(path);
+	if (len == 0 || len >= sizeof(tmp))
+		return -1;
+	strcpy(tmp, path);
+
+	for (char* p = tmp + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(tmp, 0755) != 0 && errno != EEXIST)
+			return -1;
+		*p = '/';
+	}
+	if (mkdir(tmp, 0755) != 0 && errno != EEXIST)
+		return -1;
+
+	struct stat st;
+	return stat(tmp, &st) == 0 && S_ISDIR(st.st_mode) ? 0 : -1;
+}
+
+/**
+ * Fills a device with zeros.
+ *
+ * Equivalent to 'cat /dev/zero > path' without spawning a shell. Writing
+ * stops when the device reports it is full.
+ */
+int zeroDevice(const char* path) {
+	int fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	static const char zeros[4096];
+	while (write(fd, zeros, sizeof(zeros)) > 0)
+		;
+	close(fd);
+	return 0;
+}
+
+///////////////////////////////
+// Process utilities
+///////////////////////////////
+
+/**
+ * Sends a signal to every process with the given name.
+ *
+ * Equivalent to 'killall -SIG name' without spawning a shell, matching
+ * against /proc/<pid>/comm (which the kernel truncates to 15 characters).
+ *
+ * @param name Process name, e.g. "keymon.elf"
+ * @param sig Signal to send, e.g. SIGSTOP
+ * @return Number of processes signaled
+ */
+int signalProcess(const char* name, int sig) {
+	if (!name || !name[0])
+		return 0;
+
+	DIR* proc = opendir("/proc");
+	if (!proc)
+		return 0;
+
+	char wanted[16]; // comm length including terminator
+	snprintf(wanted, sizeof(wanted), "%s", name);
+
+	int count = 0;
+	struct dirent* entry;
+	while ((entry = readdir(proc)) != NULL) {
+		char* end;
+		long pid = strtol(entry->d_name, &end, 10);
+		if (*end != '\0' || pid <= 0)
+			continue;
+
+		// procfs files report a size of 0, so read directly instead of getFile()
+		char path[64];
+		char comm[32] = {0};
+		snprintf(path, sizeof(path), "/proc/%ld/comm", pid);
+		FILE* file = fopen(path, "r");
+		if (!file)
+			continue; // exited while scanning
+		if (!fgets(comm, sizeof(comm), file))
+			comm[0] = '\0';
+		fclose(file);
+		trimTrailingNewlines(comm);
+
+		if (exactMatch(comm, wanted) && kill((pid_t)pid, sig) == 0)
+			count += 1;
+	}
+	closedir(proc);
+	return count;
+}
+
+/**
+ * Runs a program and waits for it to exit.
+ *
+ * Equivalent to system() for a plain command line, but posix_spawnp()
+ * starts the program directly, without a /bin/sh in between.
+ */
+int runProgram(char* const argv[]) {
+	if (!argv || !argv[0])
+		return -1;
+
+	pid_t pid;
+	if (posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ) != 0)
+		return -1;
+
+	int status;
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return -1;
+	}
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
 ///////////////////////////////
 // Name processing utilities
 ///////////////////////////////
@@ -218,6 +218,54 @@ void putInt(const char* path, int value);
  */
 int getInt(const char* path);
 
+/**
+ * Creates a directory and any missing parents.
+ *
+ * Equivalent to 'mkdir -p' without spawning a shell.
+ *
+ * @param path Directory to create
+ * @return 0 if the directory exists afterwards, -1 otherwise
+ */
+int mkdirs(const char* path);
+
+/**
+ * Fills a device with zeros, such as /dev/fb0 to blank the screen.
+ *
+ * Equivalent to 'cat /dev/zero > path' without spawning a shell. Only
+ * meant for fixed-size devices, a regular file would grow until the
+ * disk is full.
+ *
+ * @param path Device to fill
+ * @return 0 once the device is full, -1 if it couldn't be opened
+ */
+int zeroDevice(const char* path);
+
+///////////////////////////////
+// Process utilities
+///////////////////////////////
+
+/**
+ * Sends a signal to every process with the given name.
+ *
+ * Equivalent to 'killall -SIG name' without spawning a shell.
+ *
+ * @param name Process name as shown in /proc/<pid>/comm, e.g. "keymon.elf"
+ * @param sig Signal to send, e.g. SIGSTOP
+ * @return Number of processes signaled
+ */
+int signalProcess(const char* name, int sig);
+
+/**
+ * Runs a program and waits for it to exit.
+ *
+ * Equivalent to system() for a plain command line, but spawns the
+ * program directly instead of going through /bin/sh.
+ *
+ * @param argv NULL-terminated argument list, argv[0] is looked up in PATH
+ * @return Exit status of the program, or -1 if it couldn't be run
+ */
+int runProgram(char* const argv[]);
+
 ///////////////////////////////
 // Name processing utilities
 ///////////////////////////////
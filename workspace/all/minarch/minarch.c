@@ -47,16 +47,27 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <pthread.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <zlib.h>
 
 #include "api.h"
+#include "config_store.h"
+#include "core_info.h"
+#include "cpu_governor.h"
 #include "defines.h"
+#include "disc_prefetch.h"
+#include "frame_delay.h"
+#include "input_replay.h"
+#include "latency.h"
 #include "libretro.h"
 #include "minui_file_utils.h"
+#include "option_list.h"
+#include "preview_cache.h"
 #include "scaler.h"
+#include "sram_flusher.h"
 #include "utils.h"
 
 ///////////////////////////////////////
@@ -71,6 +82,10 @@ static int quit = 0; // Set to 1 to exit main loop
 static int show_menu = 0; // Set to 1 to display in-game menu
 static int simple_mode = 0; // Simplified interface mode (fewer options)
 
+// Benchmark input recording, see Input Recording and Replay
+enum { REPLAY_OFF, REPLAY_RECORD, REPLAY_PLAY };
+static int replay_mode = REPLAY_OFF;
+
 // Threading
 static int thread_video = 0; // Enable threaded video rendering
 static int was_threaded = 0; // Previous threading state (for fast-forward toggle)
@@ -147,8 +162,13 @@ static enum retro_pixel_format pixel_format =
 // Performance Settings
 static int show_debug = 0; // Display FPS/CPU usage overlay
 static int max_ff_speed = 3; // Fast-forward speed (0=2x, 3=4x)
+static int frame_delay = 0; // Run the core late to sample input closer to vsync
+static FrameDelay frame_delay_state; // Frame work estimate driving frame_delay
+static uint64_t frame_ready_at = 0; // When the last frame was handed to GFX_flip
 static int fast_forward = 0; // Currently fast-forwarding
-static int overclock = 1; // CPU speed (0=underclock, 1=normal, 2=overclock)
+static int overclock = 1; // CPU speed (0=underclock, 1=normal, 2=overclock, 3=auto)
+static CpuGovernor cpu_governor; // Frame work driven speed level for OVERCLOCK_AUTO
+#define OVERCLOCK_AUTO 3
 
 // Input Settings
 static int has_custom_controllers = 0; // Custom controller mappings defined
@@ -369,23 +389,97 @@ static struct Game {
 	char tmp_path[MAX_PATH]; // Temporary file path (extracted from ZIP)
 	void* data; // ROM data in memory (if !need_fullpath)
 	size_t size; // Size of ROM data in bytes
+	int is_mapped; // data is an mmap() of the file rather than a malloc() copy
 	int is_open; // Successfully loaded
 } game;
 
 /**
- * Opens and prepares a game for loading into the core.
+ * Maps a ROM file into memory for the core.
+ *
+ * Pages come straight from the page cache instead of being copied into
+ * a heap buffer. The mapping is private and writable so a core that
+ * patches its ROM buffer in place only copies the pages it touches.
+ * MAP_POPULATE isn't used since it would copy every page of a writable
+ * private mapping up front; the whole file is queued for read ahead
+ * instead.
+ *
+ * @param path ROM file
+ * @return 0 on success, -1 if the file can't be mapped
+ */
+static int Game_mapFile(const char* path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return -1;
+	}
+
+	void* data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return -1;
+	madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+
+	game.data = data;
+	game.size = (size_t)st.st_size;
+	game.is_mapped = 1;
+	return 0;
+}
+
+/**
+ * Reads a ROM file into a heap buffer for the core.
+ *
+ * Fallback for files that can't be mapped.
+ *
+ * @param path ROM file
+ * @return 0 on success, -1 on error
+ */
+static int Game_readFile(const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		LOG_error("Error opening game: %s\n\t%s", path, strerror(errno));
+		return -1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	game.size = ftell(file);
+
+	fseek(file, 0, SEEK_SET);
+	game.data = malloc(game.size);
+	if (game.data == NULL) {
+		LOG_error("Couldn't allocate memory for file: %s", path);
+		fclose(file);
+		return -1;
+	}
+
+	fread(game.data, sizeof(uint8_t), game.size, file);
+
+	fclose(file);
+	return 0;
+}
+
+/**
+ * Opens and prepares a game for loading into a core.
  *
  * Handles multiple scenarios:
  * 1. ZIP files: Extracts first matching ROM to /tmp if core doesn't support ZIP
  * 2. Multi-disc: Detects and stores .m3u playlist path
  * 3. Memory loading: Reads entire ROM into memory for cores that need it
  *
+ * Only depends on the core's extensions and need_fullpath, so it can run
+ * before the core is loaded (see Game_preload()).
+ *
  * @param path Full path to ROM file or ZIP archive
+ * @param extensions Core's valid extensions, '|' separated
+ * @param need_fullpath Core loads the file itself
  *
  * @note Sets game.is_open = 1 on success, 0 on failure
  * @note For ZIP files, extracts to /tmp/minarch-XXXXXX/ (deleted on close)
  */
-static void Game_open(char* path) {
+static void Game_openFor(char* path, const char* extensions, int need_fullpath) {
 	LOG_info("Game_open");
 	memset(&game, 0, sizeof(game));
 
@@ -399,16 +493,16 @@ static void Game_open(char* path) {
 		int i = 0;
 		char* ext;
 		char exts[128];
-		char* extensions[32];
-		strcpy(exts, core.extensions);
+		char* ext_list[32];
+		strcpy(exts, extensions);
 		while ((ext = strtok(i ? NULL : exts, "|"))) {
-			extensions[i++] = ext;
+			ext_list[i++] = ext;
 			if (!strcmp("zip", ext)) {
 				supports_zip = 1;
 				break;
 			}
 		}
-		extensions[i] = NULL;
+		ext_list[i] = NULL;
 
 		// if the core doesn't support zip files natively
 		if (!supports_zip) {
@@ -450,8 +544,8 @@ static void Game_open(char* path) {
 				next = compressed_size;
 
 				int found = 0;
-				for (i = 0; extensions[i]; i++) {
-					sprintf(extension, ".%s", extensions[i]);
+				for (i = 0; ext_list[i]; i++) {
+					sprintf(extension, ".%s", ext_list[i]);
 					if (suffixMatch(extension, filename)) {
 						found = 1;
 						break;
@@ -502,28 +596,11 @@ static void Game_open(char* path) {
 
 	// some cores handle opening files themselves, eg. pcsx_rearmed
 	// if the frontend tries to load a 500MB file itself bad things happen
-	if (!core.need_fullpath) {
+	if (!need_fullpath) {
 		path = game.tmp_path[0] == '\0' ? game.path : game.tmp_path;
 
-		FILE* file = fopen(path, "r");
-		if (file == NULL) {
-			LOG_error("Error opening game: %s\n\t%s", path, strerror(errno));
-			return;
-		}
-
-		fseek(file, 0, SEEK_END);
-		game.size = ftell(file);
-
-		fseek(file, 0, SEEK_SET);
-		game.data = malloc(game.size);
-		if (game.data == NULL) {
-			LOG_error("Couldn't allocate memory for file: %s", path);
+		if (Game_mapFile(path) != 0 && Game_readFile(path) != 0)
 			return;
-		}
-
-		fread(game.data, sizeof(uint8_t), game.size, file);
-
-		fclose(file);
 	}
 
 	// m3u-based?
@@ -558,6 +635,15 @@ static void Game_open(char* path) {
 	game.is_open = 1;
 }
 
+/**
+ * Opens a game for the loaded core.
+ *
+ * @param path Full path to ROM file or ZIP archive
+ */
+static void Game_open(char* path) {
+	Game_openFor(path, core.extensions, core.need_fullpath);
+}
+
 /**
  * Closes the current game and frees resources.
  *
@@ -567,7 +653,9 @@ static void Game_open(char* path) {
  * - Rumble state
  */
 static void Game_close(void) {
-	if (game.data)
+	if (game.data && game.is_mapped)
+		munmap(game.data, game.size);
+	else if (game.data)
 		free(game.data);
 	if (game.tmp_path[0])
 		remove(game.tmp_path);
@@ -580,6 +668,24 @@ static void Game_close(void) {
 ///////////////////////////////////////
 
 static struct retro_disk_control_ext_callback disk_control_ext;
+static DiscPrefetch disc_prefetch;
+
+/**
+ * Warms the page cache with the start of the disc after the current one,
+ * so a disc swap doesn't read the new image cold from the SD card.
+ *
+ * @note Restarts the prefetch whenever the current disc changed
+ */
+static void Game_prefetchNextDisc(void) {
+	if (!game.m3u_path[0])
+		return;
+	if (disc_prefetch.running && exactMatch(disc_prefetch.current, game.path))
+		return;
+
+	DiscPrefetch_stop(&disc_prefetch);
+	if (DiscPrefetch_start(&disc_prefetch, game.m3u_path, game.path, DISC_PREFETCH_BYTES) != 0)
+		LOG_error("Unable to start disc prefetch");
+}
 
 /**
  * Changes the active disc for multi-disc games.
@@ -606,6 +712,8 @@ static void Game_changeDisc(char* path) {
 
 	disk_control_ext.replace_image_index(0, &game_info);
 	putFile(CHANGE_DISC_PATH, path); // MinUI still needs to know this to update recents.txt
+
+	Game_prefetchNextDisc();
 }
 
 ///////////////////////////////////////
@@ -614,6 +722,10 @@ static void Game_changeDisc(char* path) {
 // Handles persistent save RAM for games with battery-backed saves
 // (e.g., Pokémon, Zelda, RPGs). Stored as .sav files in /mnt/SDCARD/Saves/<platform>/
 
+#define SRAM_FLUSH_INTERVAL_MS 5000
+
+static SramFlusher sram_flusher;
+
 static void SRAM_getPath(char* filename) {
 	sprintf(filename, "%s/%s.sav", core.saves_dir, game.name);
 }
@@ -648,39 +760,73 @@ static void SRAM_read(void) {
 	fclose(sram_file);
 }
 
+/**
+ * Starts writing save RAM back in the background whenever it changes.
+ *
+ * Called after SRAM_read() so the contents just loaded aren't written
+ * straight back.
+ */
+static void SRAM_startFlusher(void) {
+	if (replay_mode == REPLAY_PLAY)
+		return;
+
+	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
+	void* sram = core.get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	if (!sram_size || !sram)
+		return;
+
+	char filename[MAX_PATH];
+	SRAM_getPath(filename);
+	if (SramFlusher_start(&sram_flusher, filename, SRAM_FLUSH_INTERVAL_MS) != 0) {
+		LOG_error("Unable to start SRAM flusher");
+		return;
+	}
+	SramFlusher_setBaseline(&sram_flusher, sram, sram_size);
+}
+
+/**
+ * Queues a background write if save RAM changed since the last check.
+ *
+ * Called on the core thread after every frame, only hashes once per
+ * SRAM_FLUSH_INTERVAL_MS.
+ */
+static void SRAM_poll(void) {
+	if (!sram_flusher.running)
+		return;
+	SramFlusher_poll(&sram_flusher, core.get_memory_data(RETRO_MEMORY_SAVE_RAM),
+	                 core.get_memory_size(RETRO_MEMORY_SAVE_RAM), getMicroseconds() / 1000);
+}
+
 /**
  * Writes battery-backed save RAM from core memory to disk.
  *
  * Called when unloading a game. Persists in-game save data so it
- * can be restored on next launch. Calls sync() to ensure data is
- * flushed to SD card.
+ * can be restored on next launch. Waits for any background write, then
+ * writes atomically and fsyncs the file so it survives a power cut.
  *
  * @note Silently skips if core doesn't support SRAM
+ * @note Skipped during a replay, which must not overwrite the player's save
  */
 static void SRAM_write(void) {
 	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
-	if (!sram_size)
+	if (!sram_size || replay_mode == REPLAY_PLAY)
 		return;
 
 	char filename[MAX_PATH];
 	SRAM_getPath(filename);
 	LOG_debug("sav path (write): %s", filename);
 
-	FILE* sram_file = fopen(filename, "w");
-	if (!sram_file) {
-		LOG_error("Error opening SRAM file: %s", strerror(errno));
-		return;
-	}
-
 	void* sram = core.get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	if (!sram)
+		return;
 
-	if (!sram || sram_size != fwrite(sram, 1, sram_size, sram_file)) {
-		LOG_error("Error writing SRAM data to file");
+	SramFlusher_flush(&sram_flusher);
+	if (SramFlusher_writeFile(filename, sram, sram_size) != 0) {
+		LOG_error("Error writing SRAM file: %s", strerror(errno));
+		return;
 	}
-
-	fclose(sram_file);
-
-	sync();
+	if (sram_flusher.running)
+		SramFlusher_setBaseline(&sram_flusher, sram, sram_size);
 }
 
 ///////////////////////////////////////
@@ -724,10 +870,11 @@ static void RTC_read(void) {
  * Writes real-time clock data from core memory to disk.
  *
  * @note Silently skips if core doesn't support RTC
+ * @note Skipped during a replay, which must not change persisted state
  */
 static void RTC_write(void) {
 	size_t rtc_size = core.get_memory_size(RETRO_MEMORY_RTC);
-	if (!rtc_size)
+	if (!rtc_size || replay_mode == REPLAY_PLAY)
 		return;
 
 	char filename[MAX_PATH];
@@ -751,6 +898,86 @@ static void RTC_write(void) {
 	sync();
 }
 
+///////////////////////////////////////
+// CPU Speed Learning
+///////////////////////////////////////
+// With CPU Speed set to Auto the governor remembers which level each game
+// mostly ran at and starts there next time instead of relearning it.
+
+static void CPU_getPath(char* filename) {
+	sprintf(filename, "%s/%s.cpu", core.config_dir, game.name);
+}
+
+/**
+ * Loads the speed level the governor learned for this game.
+ *
+ * @return Learned level, or 1 (normal) if the game hasn't run on Auto yet
+ */
+static int CPU_readLearnedLevel(void) {
+	char filename[MAX_PATH];
+	CPU_getPath(filename);
+	if (!exists(filename))
+		return 1;
+	return getInt(filename);
+}
+
+/**
+ * Saves the level the governor spent most of this session at.
+ *
+ * @note Skipped unless CPU Speed is set to Auto, and during a replay
+ */
+static void CPU_writeLearnedLevel(void) {
+	if (overclock != OVERCLOCK_AUTO || !game.is_open || replay_mode == REPLAY_PLAY)
+		return;
+
+	char filename[MAX_PATH];
+	CPU_getPath(filename);
+	putInt(filename, CpuGovernor_getLearnedLevel(&cpu_governor));
+}
+
+///////////////////////////////////////
+// Startup Profiling
+///////////////////////////////////////
+// Logs how long each phase of startup takes, from main() to the first
+// frame on screen, to keep an eye on the launch critical path.
+//
+// On miyoomini, rg35xx and my282 the CPU speed set in main() still starts
+// overclock.elf, spawned directly rather than through a shell. It runs on
+// the CPU speed worker, so the phases don't include it.
+
+static uint64_t startup_at = 0; // main() entry, 0 once the first frame was presented
+static uint64_t startup_phase_at = 0; // End of the previous phase
+
+/**
+ * Starts timing startup phases.
+ */
+static void Startup_begin(void) {
+	startup_at = startup_phase_at = getMicroseconds();
+}
+
+/**
+ * Logs the time spent since the previous phase ended.
+ *
+ * @param phase Name of the phase that just finished
+ */
+static void Startup_mark(const char* phase) {
+	if (!startup_at)
+		return;
+
+	uint64_t now = getMicroseconds();
+	LOG_info("startup: %-14s %5ims (total %ims)", phase, (int)((now - startup_phase_at) / 1000),
+	         (int)((now - startup_at) / 1000));
+	startup_phase_at = now;
+}
+
+/**
+ * Logs the first presented frame and stops timing.
+ */
+static void Startup_end(void) {
+	Startup_mark("first frame");
+	startup_at = 0;
+}
+
 ///////////////////////////////////////
 // Save State System
 ///////////////////////////////////////
@@ -886,8 +1113,12 @@ error:
  * by temporarily switching to slot 9, saving, then restoring original slot.
  *
  * @note AUTO_RESUME_SLOT is typically 9
+ * @note Skipped during a replay, which doesn't reflect the player's progress
  */
 static void State_autosave(void) {
+	if (replay_mode == REPLAY_PLAY)
+		return;
+
 	int last_state_slot = state_slot;
 	state_slot = AUTO_RESUME_SLOT;
 	State_write();
@@ -917,34 +1148,13 @@ static void State_resume(void) {
 
 ///////////////////////////////
 
-typedef struct Option {
-	char* key;
-	char* name; // desc
-	char* desc; // info, truncated
-	char* full; // info, longer but possibly still truncated
-	char* var;
-	int default_value;
-	int value;
-	int count; // TODO: drop this?
-	int lock;
-	char** values;
-	char** labels;
-} Option;
-typedef struct OptionList {
-	int count;
-	int changed;
-	Option* options;
-
-	int enabled_count;
-	Option** enabled_options;
-	// OptionList_callback_t on_set;
-} OptionList;
 
 static char* onoff_labels[] = {"Off", "On", NULL};
 static char* scaling_labels[] = {"Native", "Aspect", "Fullscreen", "Cropped", NULL};
 static char* effect_labels[] = {"None", "Line", "Grid", NULL};
 static char* sharpness_labels[] = {"Sharp", "Crisp", "Soft", NULL};
 static char* tearing_labels[] = {"Off", "Lenient", "Strict", NULL};
+static char* frame_delay_labels[] = {"Off", "Auto", NULL};
 static char* max_ff_labels[] = {
     "None", "2x", "3x", "4x", "5x", "6x", "7x", "8x", NULL,
 };
@@ -960,6 +1170,7 @@ enum {
 	FE_OPT_THREAD,
 	FE_OPT_DEBUG,
 	FE_OPT_MAXFF,
+	FE_OPT_FRAME_DELAY,
 	FE_OPT_COUNT,
 };
 
@@ -1222,6 +1433,7 @@ static char* overclock_labels[] = {
     "Powersave",
     "Normal",
     "Performance",
+    "Auto",
     NULL,
 };
 
@@ -1258,9 +1470,9 @@ static inline int getScreenScalingCount(void) {
 
 
 static struct Config {
-	char* system_cfg; // system.cfg based on system limitations
-	char* default_cfg; // pak.cfg based on platform limitations
-	char* user_cfg; // minarch.cfg or game.cfg based on user preference
+	ConfigStore* system_cfg; // system.cfg based on system limitations
+	ConfigStore* default_cfg; // pak.cfg based on platform limitations
+	ConfigStore* user_cfg; // minarch.cfg or game.cfg based on user preference
 	char* device_tag;
 	OptionList frontend;
 	OptionList core;
@@ -1344,12 +1556,13 @@ static struct Config {
                                 .key = "minarch_cpu_speed",
                                 .name = "CPU Speed",
                                 .desc = "Over- or underclock the CPU to prioritize\npure "
-                                        "performance or power savings.",
+                                        "performance or power savings.\nAuto adjusts to "
+                                        "each game.",
                                 .full = NULL,
                                 .var = NULL,
                                 .default_value = 1,
                                 .value = 1,
-                                .count = 3,
+                                .count = 4,
                                 .lock = 0,
                                 .values = overclock_labels,
                                 .labels = overclock_labels,
@@ -1374,7 +1587,7 @@ static struct Config {
                                 .key = "minarch_debug_hud",
                                 .name = "Debug HUD",
                                 .desc = "Show frames per second, cpu load,\nresolution, and scaler "
-                                        "information.",
+                                        "info.\nLogs input latency on exit.",
                                 .full = NULL,
                                 .var = NULL,
                                 .default_value = 0,
@@ -1399,6 +1612,21 @@ static struct Config {
                                 .values = max_ff_labels,
                                 .labels = max_ff_labels,
                             },
+                        [FE_OPT_FRAME_DELAY] =
+                            {
+                                .key = "minarch_frame_delay",
+                                .name = "Frame Delay",
+                                .desc = "Run the emulator later in each frame\nto reduce input "
+                                        "lag. Needs Prevent\nTearing and may cost frames.",
+                                .full = NULL,
+                                .var = NULL,
+                                .default_value = 0,
+                                .value = 0,
+                                .count = 2,
+                                .lock = 0,
+                                .values = frame_delay_labels,
+                                .labels = frame_delay_labels,
+                            },
                         [FE_OPT_COUNT] =
                             {
                                 .key = NULL,
@@ -1494,43 +1722,110 @@ static struct Config {
     .loaded = 0,
     .initialized = 0,
 };
-static int Config_getValue(char* cfg, const char* key, char* out_value,
-                           int* lock) { // gets value from string
-	char* tmp = cfg;
-	while ((tmp = strstr(tmp, key))) {
-		if (lock != NULL && tmp > cfg && *(tmp - 1) == '-')
-			*lock = 1; // prefixed with a `-` means lock
-		tmp += strlen(key);
-		if (!strncmp(tmp, " = ", 3))
-			break; // matched
-	};
-	if (!tmp)
+static int Config_getValue(ConfigStore* cfg, const char* key, char* out_value,
+                           int* lock) { // gets value from parsed config
+	const char* value = ConfigStore_get(cfg, key, lock); // prefixed with a `-` means lock
+	if (!value)
 		return 0;
-	tmp += 3;
 
-	strncpy(out_value, tmp, 256);
-	out_value[256 - 1] = '\0';
-	tmp = strchr(out_value, '\n');
-	if (!tmp)
-		tmp = strchr(out_value, '\r');
-	if (tmp)
-		*tmp = '\0';
+	snprintf(out_value, 256, "%s", value);
 
 	// LOG_info("\t%s = %s (%s)", key, out_value, (lock && *lock) ? "hidden":"shown");
 	return 1;
 }
 
+///////////////////////////////////////
+// CPU Speed Worker
+///////////////////////////////////////
+// On miyoomini, rg35xx and my282 PLAT_setCPUSpeed() runs overclock.elf,
+// which still costs a process spawn. Auto steps up exactly when frames
+// are already tight, so speed changes are applied on a worker thread
+// instead of the frame path. Only the latest request matters, a
+// request made while the worker is busy replaces any pending one.
+
+static struct {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int requested; // CPU_SPEED_* to apply next, -1 if none
+	int started;
+	int quit;
+} cpu_speed = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .requested = -1,
+};
+
+static void* CPU_speedThread(void* arg) {
+	pthread_mutex_lock(&cpu_speed.mutex);
+	while (1) {
+		while (cpu_speed.requested < 0 && !cpu_speed.quit)
+			pthread_cond_wait(&cpu_speed.cond, &cpu_speed.mutex);
+		if (cpu_speed.requested < 0)
+			break; // quitting with nothing left to apply
+
+		int speed = cpu_speed.requested;
+		cpu_speed.requested = -1;
+		pthread_mutex_unlock(&cpu_speed.mutex);
+		PWR_setCPUSpeed(speed);
+		pthread_mutex_lock(&cpu_speed.mutex);
+	}
+	pthread_mutex_unlock(&cpu_speed.mutex);
+	return NULL;
+}
+
+/**
+ * Requests a CPU speed without waiting for it to be applied.
+ *
+ * Starts the worker on first use (main() sets the speed before any other
+ * thread runs), and applies the speed directly if the worker can't be
+ * started.
+ *
+ * @param speed CPU_SPEED_* value
+ */
+static void CPU_setSpeed(int speed) {
+	if (!cpu_speed.started)
+		cpu_speed.started = pthread_create(&cpu_speed.thread, NULL, CPU_speedThread, NULL) == 0;
+	if (!cpu_speed.started) {
+		PWR_setCPUSpeed(speed);
+		return;
+	}
+
+	pthread_mutex_lock(&cpu_speed.mutex);
+	cpu_speed.requested = speed;
+	pthread_cond_signal(&cpu_speed.cond);
+	pthread_mutex_unlock(&cpu_speed.mutex);
+}
+
+/**
+ * Applies any pending speed and stops the worker.
+ */
+static void CPU_stopSpeedThread(void) {
+	if (!cpu_speed.started)
+		return;
+
+	pthread_mutex_lock(&cpu_speed.mutex);
+	cpu_speed.quit = 1;
+	pthread_cond_signal(&cpu_speed.cond);
+	pthread_mutex_unlock(&cpu_speed.mutex);
+	pthread_join(cpu_speed.thread, NULL);
+	cpu_speed.started = 0;
+	cpu_speed.quit = 0;
+}
+
 static void setOverclock(int i) {
 	overclock = i;
+	if (i == OVERCLOCK_AUTO)
+		i = CpuGovernor_getLevel(&cpu_governor);
 	switch (i) {
 	case 0:
-		PWR_setCPUSpeed(CPU_SPEED_POWERSAVE);
+		CPU_setSpeed(CPU_SPEED_POWERSAVE);
 		break;
 	case 1:
-		PWR_setCPUSpeed(CPU_SPEED_NORMAL);
+		CPU_setSpeed(CPU_SPEED_NORMAL);
 		break;
 	case 2:
-		PWR_setCPUSpeed(CPU_SPEED_PERFORMANCE);
+		CPU_setSpeed(CPU_SPEED_PERFORMANCE);
 		break;
 	}
 }
@@ -1574,10 +1869,14 @@ static void Config_syncFrontend(char* key, int value) {
 		i = FE_OPT_OVERCLOCK;
 	} else if (exactMatch(key, config.frontend.options[FE_OPT_DEBUG].key)) {
 		show_debug = value;
+		LAT_setEnabled(show_debug); // measure input latency alongside the HUD
 		i = FE_OPT_DEBUG;
 	} else if (exactMatch(key, config.frontend.options[FE_OPT_MAXFF].key)) {
 		max_ff_speed = value;
 		i = FE_OPT_MAXFF;
+	} else if (exactMatch(key, config.frontend.options[FE_OPT_FRAME_DELAY].key)) {
+		frame_delay = value;
+		i = FE_OPT_FRAME_DELAY;
 	}
 	if (i == -1)
 		return;
@@ -1614,38 +1913,25 @@ static void Config_getPath(char* filename, int override) {
  * before user customization.
  *
  * @note Only runs once (skipped if already initialized)
- * @note Reads "bind" lines from config.default_cfg
+ * @note Reads "bind" lines from config.default_cfg, in file order
  */
 static void Config_init(void) {
 	if (!config.default_cfg || config.initialized)
 		return;
 
 	LOG_info("Config_init");
-	char* tmp = config.default_cfg;
 	char* tmp2;
-	char* key;
 
 	char button_name[128];
 	char button_id[128];
 	int i = 0;
-	while ((tmp = strstr(tmp, "bind "))) {
-		tmp += 5; // tmp now points to the button name (plus the rest of the line)
-		key = tmp;
-		tmp = strstr(tmp, " = ");
-		if (!tmp)
-			break;
-
-		int len = tmp - key;
-		strncpy(button_name, key, len);
-		button_name[len] = '\0';
+	for (int e = 0; e < config.default_cfg->count; e++) {
+		ConfigStore_Entry* entry = &config.default_cfg->entries[e];
+		if (!prefixMatch("bind ", (char*)entry->key))
+			continue;
 
-		tmp += 3;
-		strncpy(button_id, tmp, 128);
-		tmp2 = strchr(button_id, '\n');
-		if (!tmp2)
-			tmp2 = strchr(button_id, '\r');
-		if (tmp2)
-			*tmp2 = '\0';
+		snprintf(button_name, sizeof(button_name), "%s", entry->key + 5);
+		snprintf(button_id, sizeof(button_id), "%s", entry->value);
 
 		int retro_id = -1;
 		int local_id = -1;
@@ -1672,11 +1958,8 @@ static void Config_init(void) {
 			}
 		}
 
-		tmp += strlen(button_id); // prepare to continue search
-
 		LOG_debug("\tbind %s (%s) %i:%i", button_name, button_id, local_id, retro_id);
 
-		// TODO: test this without a final line return
 		tmp2 = calloc(strlen(button_name) + 1, sizeof(char));
 		if (!tmp2) {
 			for (int j = 0; j < i; j++) {
@@ -1701,7 +1984,7 @@ static void Config_quit(void) {
 		free(core_button_mapping[i].name);
 	}
 }
-static void Config_readOptionsString(char* cfg) {
+static void Config_readOptionsStore(ConfigStore* cfg) {
 	if (!cfg)
 		return;
 
@@ -1729,11 +2012,11 @@ static void Config_readOptionsString(char* cfg) {
 		OptionList_setOptionValue(&config.core, option->key, value);
 	}
 }
-static void Config_readControlsString(char* cfg) {
+static void Config_readControlsStore(ConfigStore* cfg) {
 	if (!cfg)
 		return;
 
-	LOG_debug("Config_readControlsString");
+	LOG_debug("Config_readControlsStore");
 
 	char key[256];
 	char value[256];
@@ -1816,9 +2099,9 @@ static void Config_load(void) {
 
 	if (config.device_tag && exists(device_system_path)) {
 		LOG_info("Using device_system_path: %s", device_system_path);
-		config.system_cfg = allocFile(device_system_path);
+		config.system_cfg = ConfigStore_new(allocFile(device_system_path));
 	} else if (exists(system_path))
-		config.system_cfg = allocFile(system_path);
+		config.system_cfg = ConfigStore_new(allocFile(system_path));
 	else
 		config.system_cfg = NULL;
 
@@ -1840,9 +2123,9 @@ static void Config_load(void) {
 
 	if (config.device_tag && exists(device_default_path)) {
 		LOG_info("Using device_default_path: %s", device_default_path);
-		config.default_cfg = allocFile(device_default_path);
+		config.default_cfg = ConfigStore_new(allocFile(device_default_path));
 	} else if (exists(default_path))
-		config.default_cfg = allocFile(default_path);
+		config.default_cfg = ConfigStore_new(allocFile(default_path));
 	else
 		config.default_cfg = NULL;
 
@@ -1858,7 +2141,7 @@ static void Config_load(void) {
 		Config_getPath(path, CONFIG_WRITE_ALL);
 
 	if (exists(path)) {
-		config.user_cfg = allocFile(path);
+		config.user_cfg = ConfigStore_new(allocFile(path));
 		if (!config.user_cfg)
 			return;
 		LOG_info("Loaded user config: %s", path);
@@ -1868,23 +2151,23 @@ static void Config_load(void) {
 	}
 }
 static void Config_free(void) {
-	if (config.system_cfg)
-		free(config.system_cfg);
-	if (config.default_cfg)
-		free(config.default_cfg);
-	if (config.user_cfg)
-		free(config.user_cfg);
+	ConfigStore_free(config.system_cfg);
+	ConfigStore_free(config.default_cfg);
+	ConfigStore_free(config.user_cfg);
+	config.system_cfg = NULL;
+	config.default_cfg = NULL;
+	config.user_cfg = NULL;
 }
 static void Config_readOptions(void) {
-	Config_readOptionsString(config.system_cfg);
-	Config_readOptionsString(config.default_cfg);
-	Config_readOptionsString(config.user_cfg);
+	Config_readOptionsStore(config.system_cfg);
+	Config_readOptionsStore(config.default_cfg);
+	Config_readOptionsStore(config.user_cfg);
 
 	// screen_scaling = SCALE_NATIVE; // TODO: tmp
 }
 static void Config_readControls(void) {
-	Config_readControlsString(config.default_cfg);
-	Config_readControlsString(config.user_cfg);
+	Config_readControlsStore(config.default_cfg);
+	Config_readControlsStore(config.user_cfg);
 }
 static void Config_write(int override) {
 	char path[MAX_PATH];
@@ -1958,9 +2241,10 @@ static void Config_restore(void) {
 	}
 	for (int i = 0; config.core.options[i].key; i++) {
 		Option* option = &config.core.options[i];
+		int old_value = option->value;
 		option->value = option->default_value;
+		OptionList_markChanged(&config.core, option, old_value); // let the core know
 	}
-	config.core.changed = 1; // let the core know
 
 	if (has_custom_controllers) {
 		gamepad_type = 0;
@@ -2015,24 +2299,10 @@ static void Special_render(void) {
 		Special_refreshDMGPalette();
 }
 static void Special_quit(void) {
-	system("rm -f /tmp/dmg_grid_color");
+	unlink("/tmp/dmg_grid_color");
 }
 ///////////////////////////////
 
-static int Option_getValueIndex(Option* item, const char* value) {
-	if (!value)
-		return 0;
-	for (int i = 0; i < item->count; i++) {
-		if (!strcmp(item->values[i], value))
-			return i;
-	}
-	return 0;
-}
-static void Option_setValue(Option* item, const char* value) {
-	// TODO: store previous value?
-	item->value = Option_getValueIndex(item, value);
-}
-
 // TODO: does this also need to be applied to OptionList_vars()?
 static const char* option_key_name[] = {"pcsx_rearmed_analog_combo", "DualShock Toggle Combo",
                                         NULL};
@@ -2045,6 +2315,20 @@ static const char* getOptionNameFromKey(const char* key, const char* name) {
 	return name;
 }
 
+/**
+ * Indexes a list's options by key for OptionList_getOption().
+ *
+ * Lists without an index (or that couldn't get one) are searched linearly.
+ */
+static void OptionList_index(OptionList* list) {
+	if (KeyIndex_init(&list->index, list->count) != 0)
+		return;
+	for (int i = 0; i < list->count; i++) {
+		if (list->options[i].key)
+			KeyIndex_add(&list->index, list->options[i].key, i);
+	}
+}
+
 // the following 3 functions always touch config.core, the rest can operate on arbitrary OptionLists
 static void OptionList_init(const struct retro_core_option_definition* defs) {
 	LOG_debug("OptionList_init");
@@ -2126,6 +2410,7 @@ static void OptionList_init(const struct retro_core_option_definition* defs) {
 
 			// LOG_info("\tINIT %s (%s) TO %s (%s)", item->name, item->key, item->labels[item->value], item->values[item->value]);
 		}
+		OptionList_index(&config.core);
 	}
 	// fflush(stdout);
 }
@@ -2185,6 +2470,7 @@ static void OptionList_vars(const struct retro_variable* vars) {
 			item->default_value = item->value;
 			// printf("SET %s to %s (%i)\n", item->key, default_value, item->value); fflush(stdout);
 		}
+		OptionList_index(&config.core);
 	}
 	// fflush(stdout);
 }
@@ -2219,16 +2505,19 @@ static void OptionList_reset(void) {
 	if (config.core.enabled_options)
 		free(config.core.enabled_options);
 	config.core.enabled_count = 0;
+	KeyIndex_free(&config.core.index);
 	free(config.core.options);
 }
 
-static Option* OptionList_getOption(OptionList* list, const char* key) {
+/**
+ * Logs the options changed since the core last read them.
+ */
+static void OptionList_logChanges(OptionList* list) {
 	for (int i = 0; i < list->count; i++) {
 		Option* item = &list->options[i];
-		if (!strcmp(item->key, key))
-			return item;
+		if (item->dirty)
+			LOG_info("option changed: %s = %s", item->key, item->values[item->value]);
 	}
-	return NULL;
 }
 static char* OptionList_getOptionValue(OptionList* list, const char* key) {
 	Option* item = OptionList_getOption(list, key);
@@ -2243,8 +2532,9 @@ static char* OptionList_getOptionValue(OptionList* list, const char* key) {
 static void OptionList_setOptionRawValue(OptionList* list, const char* key, int value) {
 	Option* item = OptionList_getOption(list, key);
 	if (item) {
+		int old_value = item->value;
 		item->value = value;
-		list->changed = 1;
+		OptionList_markChanged(list, item, old_value);
 		// LOG_info("\tRAW SET %s (%s) TO %s (%s)", item->name, item->key, item->labels[item->value], item->values[item->value]);
 		// if (list->on_set) list->on_set(list, key);
 
@@ -2256,8 +2546,9 @@ static void OptionList_setOptionRawValue(OptionList* list, const char* key, int
 static void OptionList_setOptionValue(OptionList* list, const char* key, const char* value) {
 	Option* item = OptionList_getOption(list, key);
 	if (item) {
+		int old_value = item->value;
 		Option_setValue(item, value);
-		list->changed = 1;
+		OptionList_markChanged(list, item, old_value);
 		// LOG_info("\tSET %s (%s) TO %s (%s)", item->name, item->key, item->labels[item->value], item->values[item->value]);
 		// if (list->on_set) list->on_set(list, key);
 
@@ -2310,28 +2601,41 @@ static int setFastForward(int enable) {
 }
 
 static uint32_t buttons = 0; // Current button state (RETRO_DEVICE_ID_JOYPAD_* flags)
+static uint32_t buttons_local = 0; // Pad buttons (BTN_*) behind buttons, for latency measurement
+static void Replay_applyInput(void);
 static int ignore_menu = 0; // Suppress menu button (used for shortcuts)
 
+static int input_polled = 0; // Core polled input since the last Input_update()
+
 /**
- * Polls input devices and handles frontend shortcuts.
+ * Transient pad state of every poll since the last Input_update().
  *
- * Called by the libretro core before checking input state. Handles:
- * - Power/sleep management
- * - Menu button detection
- * - Fast-forward toggle (MENU + L2/R2)
- * - Save/load state shortcuts
- * - Screenshot capture
- * - Game reset
+ * Each PAD_poll() clears just_pressed/just_released, so a core that polls
+ * more than once per frame would otherwise hide presses from the
+ * shortcuts that only look at the state after core.run().
+ */
+static struct {
+	int just_pressed;
+	int just_released;
+	int just_repeated;
+} input_frame;
+
+/**
+ * Samples input for the core.
  *
- * Also translates platform button presses to libretro button flags.
+ * Called by the libretro core right before it reads input, so it only does
+ * what the core is waiting on: polling the pad and translating platform
+ * button presses to libretro button flags. Power management and frontend
+ * shortcuts run once per frame after presentation in Input_update().
  *
  * @note This is a libretro callback, invoked by core on each frame
  */
 static void input_poll_callback(void) {
 	PAD_poll();
-
-	int show_setting = 0;
-	PWR_update(NULL, &show_setting, Menu_beforeSleep, Menu_afterSleep);
+	input_polled = 1;
+	input_frame.just_pressed |= pad.just_pressed;
+	input_frame.just_released |= pad.just_released;
+	input_frame.just_repeated |= pad.just_repeated;
 
 	// I _think_ this can stay as is...
 	if (PAD_justPressed(BTN_MENU)) {
@@ -2341,6 +2645,93 @@ static void input_poll_callback(void) {
 		ignore_menu = 1;
 	}
 
+	// TODO: figure out how to ignore button when MENU+button is handled first
+	// TODO: array size of LOCAL_ whatever that macro is
+	// TODO: then split it into two loops
+	// TODO: first check for MENU+button
+	// TODO: when found mark button the array
+	// TODO: then check for button
+	// TODO: only modify if absent from array
+	// TODO: the shortcuts loop in Input_update() should also contribute to the array
+
+	buttons = 0;
+	buttons_local = 0;
+	for (int i = 0; config.controls[i].name; i++) {
+		ButtonMapping* mapping = &config.controls[i];
+		int btn = 1 << mapping->local;
+		if (btn == BTN_NONE)
+			continue; // present buttons can still be unbound
+		if (gamepad_type == 0) {
+			switch (btn) {
+			case BTN_DPAD_UP:
+				btn = BTN_UP;
+				break;
+			case BTN_DPAD_DOWN:
+				btn = BTN_DOWN;
+				break;
+			case BTN_DPAD_LEFT:
+				btn = BTN_LEFT;
+				break;
+			case BTN_DPAD_RIGHT:
+				btn = BTN_RIGHT;
+				break;
+			}
+		}
+		if (PAD_isPressed(btn) && (!mapping->mod || PAD_isPressed(BTN_MENU))) {
+			buttons |= 1 << mapping->retro;
+			buttons_local |= btn;
+			if (mapping->mod)
+				ignore_menu = 1;
+		}
+		//  && !PWR_ignoreSettingInput(btn, show_setting)
+	}
+
+	if (replay_mode == REPLAY_PLAY)
+		Replay_applyInput();
+
+	// if (buttons) LOG_info("buttons: %i", buttons);
+}
+
+/**
+ * Handles power management and frontend shortcuts.
+ *
+ * Runs once per frame after the core has presented its frame, on the same
+ * thread as the core, using the pad state sampled by input_poll_callback().
+ * Presses and releases from all of the frame's polls count.
+ * Handles:
+ * - Power/sleep management
+ * - Menu button detection
+ * - Fast-forward toggle (MENU + L2/R2)
+ * - Save/load state shortcuts
+ * - Screenshot capture
+ * - Game reset
+ *
+ * @note Polls input itself if the core didn't this frame (e.g. while a
+ *       core is loading), so sleep and the menu keep working
+ * @note While a replay plays, only the menu button is handled and it
+ *       stops the replay
+ */
+static void Input_update(void) {
+	if (!input_polled)
+		input_poll_callback();
+	input_polled = 0;
+
+	// see the presses of every poll this frame, not just the last one
+	pad.just_pressed = input_frame.just_pressed;
+	pad.just_released = input_frame.just_released;
+	pad.just_repeated = input_frame.just_repeated;
+	memset(&input_frame, 0, sizeof(input_frame));
+
+	if (replay_mode == REPLAY_PLAY) {
+		// sleep and shortcuts would change what's being measured
+		if (PAD_justReleased(BTN_MENU))
+			quit = 1;
+		return;
+	}
+
+	int show_setting = 0;
+	PWR_update(NULL, &show_setting, Menu_beforeSleep, Menu_afterSleep);
+
 	if (PAD_justPressed(BTN_POWER)) {
 		if (thread_video) {
 			// LOG_info("pressed power with threaded core...");
@@ -2430,50 +2821,11 @@ static void input_poll_callback(void) {
 			pthread_mutex_unlock(&core_mx);
 		}
 	}
-
-	// TODO: figure out how to ignore button when MENU+button is handled first
-	// TODO: array size of LOCAL_ whatever that macro is
-	// TODO: then split it into two loops
-	// TODO: first check for MENU+button
-	// TODO: when found mark button the array
-	// TODO: then check for button
-	// TODO: only modify if absent from array
-	// TODO: the shortcuts loop above should also contribute to the array
-
-	buttons = 0;
-	for (int i = 0; config.controls[i].name; i++) {
-		ButtonMapping* mapping = &config.controls[i];
-		int btn = 1 << mapping->local;
-		if (btn == BTN_NONE)
-			continue; // present buttons can still be unbound
-		if (gamepad_type == 0) {
-			switch (btn) {
-			case BTN_DPAD_UP:
-				btn = BTN_UP;
-				break;
-			case BTN_DPAD_DOWN:
-				btn = BTN_DOWN;
-				break;
-			case BTN_DPAD_LEFT:
-				btn = BTN_LEFT;
-				break;
-			case BTN_DPAD_RIGHT:
-				btn = BTN_RIGHT;
-				break;
-			}
-		}
-		if (PAD_isPressed(btn) && (!mapping->mod || PAD_isPressed(BTN_MENU))) {
-			buttons |= 1 << mapping->retro;
-			if (mapping->mod)
-				ignore_menu = 1;
-		}
-		//  && !PWR_ignoreSettingInput(btn, show_setting)
-	}
-
-	// if (buttons) LOG_info("buttons: %i", buttons);
 }
 static int16_t input_state_callback(unsigned port, unsigned device, unsigned index, unsigned id) {
 	if (port == 0 && device == RETRO_DEVICE_JOYPAD && index == 0) {
+		if (buttons)
+			LAT_markRead(buttons_local); // first read of the pressed button, for latency measurement
 		if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
 			return buttons;
 		return (buttons >> id) & 1;
@@ -2492,6 +2844,185 @@ static int16_t input_state_callback(unsigned port, unsigned device, unsigned ind
 	}
 	return 0;
 }
+
+///////////////////////////////////////
+// Input Recording and Replay
+///////////////////////////////////////
+// For benchmarks and regression checks across builds:
+//   minarch.elf <core> <rom> --record <file>  records the session's input
+//   minarch.elf <core> <rom> --replay <file>  plays it back, writing <file>.report
+// A recording starts from a save state of the moment it began, so a replay
+// runs the exact same frames. The report lists a hash of the video output
+// and the core's run time every REPLAY_REPORT_INTERVAL frames. Run time
+// ends when the frame is handed to GFX_flip(), which waits for vsync
+// inside core.run(). Playback is silent, so the timings don't include
+// waiting on audio either. The pad only drives the menu button, which
+// stops the replay.
+
+#define REPLAY_REPORT_INTERVAL 60
+
+static struct {
+	char path[MAX_PATH];
+	InputRecorder recorder;
+	InputReplay replay;
+	InputReplay_Frame frame; // Input of the frame being replayed
+	FILE* report;
+	uint64_t hash; // Of every frame output so far
+	uint64_t run_us; // Total core run time
+	uint64_t interval_us; // Core run time since the last report line
+	uint64_t max_us;
+	uint32_t frames;
+} replay;
+
+/**
+ * Parses --record/--replay from the command line.
+ */
+static void Replay_init(int argc, char* argv[]) {
+	if (argc < 5)
+		return;
+
+	if (exactMatch(argv[3], "--record"))
+		replay_mode = REPLAY_RECORD;
+	else if (exactMatch(argv[3], "--replay"))
+		replay_mode = REPLAY_PLAY;
+	else
+		return;
+	snprintf(replay.path, sizeof(replay.path), "%s", argv[4]);
+}
+
+/**
+ * Starts recording or replaying once the game is loaded.
+ *
+ * Both run the core on the main thread, so input, frames and timings line
+ * up one to one.
+ */
+static void Replay_start(void) {
+	if (replay_mode == REPLAY_OFF)
+		return;
+	thread_video = 0;
+
+	if (replay_mode == REPLAY_RECORD) {
+		size_t state_size = core.serialize_size();
+		void* state = state_size ? calloc(1, state_size) : NULL;
+		if (!state || !core.serialize(state, state_size)) {
+			// a recording that can't restore its start would replay a different game
+			LOG_error("Unable to record input, %s can't save state", core.name);
+			replay_mode = REPLAY_OFF;
+		} else if (InputRecorder_open(&replay.recorder, replay.path, state, state_size) != 0) {
+			LOG_error("Unable to record input to %s", replay.path);
+			replay_mode = REPLAY_OFF;
+		}
+		free(state);
+		return;
+	}
+
+	if (InputReplay_load(&replay.replay, replay.path) != 0) {
+		LOG_error("Unable to read input recording %s", replay.path);
+		replay_mode = REPLAY_OFF;
+		quit = 1;
+		return;
+	}
+	if (replay.replay.state_size &&
+	    !core.unserialize(replay.replay.state, replay.replay.state_size))
+		LOG_error("Unable to restore the recording's save state");
+
+	char report_path[MAX_PATH + 8];
+	snprintf(report_path, sizeof(report_path), "%s.report", replay.path);
+	replay.report = fopen(report_path, "w");
+	if (replay.report)
+		fprintf(replay.report, "core: %s %s\nframes: %u\n", core.name, core.version,
+		        replay.replay.frame_count);
+	replay.hash = INPUT_REPLAY_HASH_SEED;
+	LOG_info("Replaying %u frames from %s", replay.replay.frame_count, replay.path);
+}
+
+/**
+ * Overrides the sampled pad with the replayed frame's input.
+ */
+static void Replay_applyInput(void) {
+	buttons = replay.frame.buttons;
+	buttons_local = 0; // the core sees recorded input, not the pad
+	pad.laxis.x = replay.frame.axes[0];
+	pad.laxis.y = replay.frame.axes[1];
+	pad.raxis.x = replay.frame.axes[2];
+	pad.raxis.y = replay.frame.axes[3];
+}
+
+/**
+ * Loads the next replayed frame's input, quitting after the last one.
+ */
+static void Replay_beforeFrame(void) {
+	if (replay_mode != REPLAY_PLAY)
+		return;
+	if (InputReplay_next(&replay.replay, &replay.frame) != 0) {
+		quit = 1;
+		return;
+	}
+	Replay_applyInput(); // for cores that read input without polling
+}
+
+/**
+ * Records the frame's input, or accounts for the replayed frame.
+ *
+ * @param run_us Time from core.run() start to the frame being presented,
+ *               audio is dropped while playing so it doesn't include
+ *               audio backpressure either
+ */
+static void Replay_afterFrame(uint64_t run_us) {
+	if (replay_mode == REPLAY_RECORD) {
+		InputReplay_Frame frame = {
+		    .buttons = buttons,
+		    .axes = {pad.laxis.x, pad.laxis.y, pad.raxis.x, pad.raxis.y},
+		};
+		InputRecorder_add(&replay.recorder, &frame);
+	} else if (replay_mode == REPLAY_PLAY && !quit) {
+		replay.frames += 1;
+		replay.run_us += run_us;
+		replay.interval_us += run_us;
+		if (run_us > replay.max_us)
+			replay.max_us = run_us;
+		if (replay.report && replay.frames % REPLAY_REPORT_INTERVAL == 0) {
+			fprintf(replay.report, "frame %u hash %016llx run_us %llu\n", replay.frames,
+			        (unsigned long long)replay.hash, (unsigned long long)replay.interval_us);
+			replay.interval_us = 0;
+		}
+	}
+}
+
+/**
+ * Folds a frame the core output into the replay's hash.
+ */
+static void Replay_hashVideo(const void* data, unsigned width, unsigned height, size_t pitch) {
+	if (replay_mode != REPLAY_PLAY)
+		return;
+	size_t bytes_per_pixel = pixel_format == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+	replay.hash = InputReplay_hashFrame(replay.hash, data, width * bytes_per_pixel, height, pitch);
+}
+
+/**
+ * Finishes the recording, or writes the replay's totals.
+ */
+static void Replay_quit(void) {
+	if (replay_mode == REPLAY_RECORD) {
+		if (InputRecorder_close(&replay.recorder) != 0)
+			LOG_error("Error writing input recording %s", replay.path);
+		else
+			LOG_info("Recorded %u frames to %s", replay.recorder.frame_count, replay.path);
+	} else if (replay_mode == REPLAY_PLAY) {
+		if (replay.report) {
+			fprintf(replay.report,
+			        "replayed: %u\nhash: %016llx\nrun_us: %llu\navg_us: %llu\nmax_us: %llu\n",
+			        replay.frames, (unsigned long long)replay.hash,
+			        (unsigned long long)replay.run_us,
+			        (unsigned long long)(replay.frames ? replay.run_us / replay.frames : 0),
+			        (unsigned long long)replay.max_us);
+			fclose(replay.report);
+			replay.report = NULL;
+		}
+		InputReplay_free(&replay.replay);
+	}
+	// the mode stays set so saves skipped during playback stay skipped on exit
+}
 ///////////////////////////////
 
 static void Input_init(const struct retro_input_descriptor* vars) {
@@ -2692,7 +3223,9 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 		// puts("RETRO_ENVIRONMENT_GET_VARIABLE ");
 		struct retro_variable* var = (struct retro_variable*)data;
 		if (var && var->key) {
-			var->value = OptionList_getOptionValue(&config.core, var->key);
+			var->value = OptionList_readValue(&config.core, var->key);
+			if (!var->value)
+				LOG_warn("unknown option %s ", var->key);
 			// printf("\t%s = %s\n", var->key, var->value);
 		}
 		// fflush(stdout);
@@ -2718,6 +3251,8 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 	case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE: { /* 17 */
 		bool* out = (bool*)data;
 		if (out) {
+			if (config.core.changed)
+				OptionList_logChanges(&config.core);
 			*out = config.core.changed;
 			config.core.changed = 0;
 		}
@@ -2793,6 +3328,8 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 		double old_sample_rate = core.sample_rate;
 		core.fps = av_info->timing.fps;
 		core.sample_rate = av_info->timing.sample_rate;
+		FrameDelay_init(&frame_delay_state, core.fps);
+		CpuGovernor_setFrameRate(&cpu_governor, core.fps);
 
 		// Reinitialize audio if sample rate changed
 		if (old_sample_rate != core.sample_rate) {
@@ -3016,13 +3553,7 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 
 static void hdmimon(void) {
 	// handle HDMI change
-	static int had_hdmi = -1;
-	int has_hdmi = GetHDMI();
-	if (had_hdmi == -1)
-		had_hdmi = has_hdmi;
-	if (has_hdmi != had_hdmi) {
-		had_hdmi = has_hdmi;
-
+	if (GFX_hdmiChanged()) {
 		LOG_info("restarting after HDMI change...");
 		Menu_beforeSleep();
 		sleep(4);
@@ -4146,8 +4677,12 @@ static void video_refresh_callback_main(const void* data, unsigned width, unsign
 
 	GFX_blitRenderer(&renderer);
 
-	if (!thread_video)
+	if (!thread_video) {
+		frame_ready_at = getMicroseconds();
 		GFX_flip(screen);
+		if (startup_at)
+			Startup_end();
+	}
 	last_flip_time = SDL_GetTicks();
 }
 
@@ -4171,6 +4706,7 @@ static void video_refresh_callback(const void* data, unsigned width, unsigned he
                                    size_t pitch) {
 	if (!data)
 		return;
+	Replay_hashVideo(data, width, height, pitch);
 
 	if (thread_video) {
 		pthread_mutex_lock(&core_mx);
@@ -4240,10 +4776,11 @@ static void video_refresh_callback(const void* data, unsigned width, unsigned he
  * @param left Left channel sample (-32768 to 32767)
  * @param right Right channel sample (-32768 to 32767)
  *
- * @note Audio disabled during fast-forward for performance
+ * @note Audio disabled during fast-forward for performance, and during
+ *       replay playback so waiting on a full buffer isn't timed as core work
  */
 static void audio_sample_callback(int16_t left, int16_t right) {
-	if (!fast_forward)
+	if (!fast_forward && replay_mode != REPLAY_PLAY)
 		SND_batchSamples(&(const SND_Frame){left, right}, 1);
 }
 
@@ -4257,11 +4794,12 @@ static void audio_sample_callback(int16_t left, int16_t right) {
  * @param frames Number of stereo frames (not individual samples)
  * @return Number of frames consumed (always returns frames)
  *
- * @note Audio disabled during fast-forward for performance
+ * @note Audio disabled during fast-forward for performance, and during
+ *       replay playback so waiting on a full buffer isn't timed as core work
  * @note Data format: int16_t[frames * 2] interleaved stereo
  */
 static size_t audio_sample_batch_callback(const int16_t* data, size_t frames) {
-	if (!fast_forward)
+	if (!fast_forward && replay_mode != REPLAY_PLAY)
 		return SND_batchSamples((const SND_Frame*)data, frames);
 	else
 		return frames;
@@ -4313,6 +4851,84 @@ void MinArch_selectBiosPath(const char* tag, char* bios_dir) {
 	}
 }
 
+// The core binary is dlopen()ed on its own thread while the main thread
+// brings up video, input and power, since relocating a core and running
+// its static constructors is one of the slower steps of a launch.
+
+static pthread_t core_open_pt;
+static int core_open_started = 0; // Core_preload() thread is running or unjoined
+static char core_open_error[256];
+
+static void* Core_openThread(void* arg) {
+	core.handle = dlopen((const char*)arg, RTLD_LAZY);
+	if (!core.handle)
+		snprintf(core_open_error, sizeof(core_open_error), "%s", dlerror());
+	return NULL;
+}
+
+/**
+ * Starts loading the core binary in the background.
+ *
+ * Core_open() waits for it to finish. If the thread can't be started,
+ * Core_open() loads the core itself.
+ *
+ * @param core_path Full path to core .so file, must outlive Core_open()
+ */
+static void Core_preload(const char* core_path) {
+	core_open_started = pthread_create(&core_open_pt, NULL, Core_openThread, (void*)core_path) == 0;
+}
+
+// What Core_open() learns from the core is cached per system so minui can
+// use it without loading the core (see core_info.h).
+
+static CoreInfo core_info; // Metadata of the open core
+
+static void Core_getInfoPath(char* filename, const char* tag) {
+	sprintf(filename, CORE_INFO_PATH "/%s.txt", tag);
+}
+
+static void Core_writeInfo(void) {
+	char filename[MAX_PATH];
+	Core_getInfoPath(filename, core.tag);
+	mkdirs(CORE_INFO_PATH);
+	if (CoreInfo_write(&core_info, filename) != 0)
+		LOG_error("Couldn't write core info: %s", filename);
+}
+
+/**
+ * Refreshes the cached metadata for the open core.
+ *
+ * Only writes when something changed, so a regular launch doesn't touch
+ * the SD card. The save state size class is kept across launches as long
+ * as the core binary is unchanged.
+ *
+ * @param core_path Full path to core .so file
+ * @param info System info reported by the core
+ */
+static void Core_updateInfo(const char* core_path, const struct retro_system_info* info) {
+	char filename[MAX_PATH];
+	Core_getInfoPath(filename, core.tag);
+	CoreInfo cached;
+	int has_cached = CoreInfo_read(&cached, filename) == 0;
+
+	if (CoreInfo_init(&core_info, core_path) != 0)
+		return;
+	snprintf(core_info.library_name, sizeof(core_info.library_name), "%s",
+	         info->library_name ? info->library_name : "");
+	snprintf(core_info.library_version, sizeof(core_info.library_version), "%s",
+	         info->library_version ? info->library_version : "");
+	CoreInfo_setExtensions(&core_info, info->valid_extensions);
+	core_info.need_fullpath = info->need_fullpath;
+
+	if (has_cached && !strcmp(cached.so_path, core_info.so_path) && CoreInfo_isFresh(&cached))
+		core_info.state_size_class = cached.state_size_class;
+
+	if (!has_cached || !CoreInfo_equals(&cached, &core_info)) {
+		LOG_info("core info changed, updating cache");
+		Core_writeInfo();
+	}
+}
+
 /**
  * Loads a libretro core from disk and resolves API functions.
  *
@@ -4330,10 +4946,17 @@ void MinArch_selectBiosPath(const char* tag, char* bios_dir) {
  */
 void Core_open(const char* core_path, const char* tag_name) {
 	LOG_info("Core_open");
-	core.handle = dlopen(core_path, RTLD_LAZY);
+	if (core_open_started) {
+		pthread_join(core_open_pt, NULL);
+		core_open_started = 0;
+	} else if (!core.handle) {
+		core.handle = dlopen(core_path, RTLD_LAZY);
+		if (!core.handle)
+			snprintf(core_open_error, sizeof(core_open_error), "%s", dlerror());
+	}
 
 	if (!core.handle)
-		LOG_error("%s", dlerror());
+		LOG_error("%s", core_open_error);
 
 	core.init = dlsym(core.handle, "retro_init");
 	core.deinit = dlsym(core.handle, "retro_deinit");
@@ -4378,15 +5001,15 @@ void Core_open(const char* core_path, const char* tag_name) {
 
 	LOG_info("core: %s version: %s tag: %s (valid_extensions: %s need_fullpath: %i)", core.name,
 	         core.version, core.tag, info.valid_extensions, info.need_fullpath);
+	Core_updateInfo(core_path, &info);
 
 	sprintf((char*)core.config_dir, USERDATA_PATH "/%s-%s", core.tag, core.name);
 	sprintf((char*)core.states_dir, SHARED_USERDATA_PATH "/%s-%s", core.tag, core.name);
 	sprintf((char*)core.saves_dir, SDCARD_PATH "/Saves/%s", core.tag);
 	MinArch_selectBiosPath(core.tag, (char*)core.bios_dir);
 
-	char cmd[512];
-	sprintf(cmd, "mkdir -p \"%s\"; mkdir -p \"%s\"", core.config_dir, core.states_dir);
-	system(cmd);
+	mkdirs(core.config_dir);
+	mkdirs(core.states_dir);
 
 	set_environment_callback(environment_callback);
 	set_video_refresh_callback(video_refresh_callback);
@@ -4409,9 +5032,18 @@ void Core_load(void) {
 	LOG_info("game path: %s (%i)", game_info.path, game.size);
 
 	core.load_game(&game_info);
+	Startup_mark("load_game");
+
+	size_t state_size_class = CoreInfo_sizeClass(core.serialize_size());
+	if (state_size_class > core_info.state_size_class && core_info.so_size) {
+		core_info.state_size_class = state_size_class;
+		Core_writeInfo();
+	}
 
 	SRAM_read();
+	SRAM_startFlusher();
 	RTC_read();
+	Startup_mark("SRAM_read");
 
 	// NOTE: must be called after core.load_game!
 	struct retro_system_av_info av_info = {};
@@ -4421,6 +5053,8 @@ void Core_load(void) {
 
 	core.fps = av_info.timing.fps;
 	core.sample_rate = av_info.timing.sample_rate;
+	FrameDelay_init(&frame_delay_state, core.fps);
+	CpuGovernor_setFrameRate(&cpu_governor, core.fps); // started in main() at the learned level
 	double a = av_info.geometry.aspect_ratio;
 	if (a <= 0)
 		a = (double)av_info.geometry.base_width / av_info.geometry.base_height;
@@ -4438,6 +5072,7 @@ void Core_unload(void) {
 void Core_quit(void) {
 	if (core.initialized) {
 		SRAM_write();
+		SramFlusher_stop(&sram_flusher);
 		RTC_write();
 		core.unload_game();
 		core.deinit();
@@ -4458,6 +5093,86 @@ void Core_close(void) {
 		dlclose(core.handle);
 }
 
+///////////////////////////////////////
+// Parallel Startup
+///////////////////////////////////////
+// Launching runs three independent chains of work: platform init (video,
+// input, power) on the main thread, loading the core binary (see
+// Core_preload()) and reading or unzipping the ROM. Reading the ROM only
+// needs the core's extensions and need_fullpath, so when the core info
+// cache knows them the ROM is read on a worker thread too. Everything is
+// joined before retro_load_game().
+//
+// What this saves depends on the content. A large plain ROM (a 32 MB GBA
+// game) is read entirely while init runs, so the Game_open phase in the
+// startup log drops to nothing. A zipped one takes longer to inflate than
+// init does, so only the init window is saved. Disc images for
+// need_fullpath cores (PS1) are never read by the frontend, so for those
+// only the core load overlaps.
+
+static struct {
+	pthread_t thread;
+	int started; // Worker is running or unjoined
+	char path[MAX_PATH];
+	char extensions[128]; // What the worker assumed about the core
+	int need_fullpath;
+} game_preload;
+
+static void* Game_preloadThread(void* arg) {
+	Game_openFor(game_preload.path, game_preload.extensions, game_preload.need_fullpath);
+	return NULL;
+}
+
+/**
+ * Starts opening the game in the background, if the core info cache has
+ * a fresh entry for this core with its complete extension list.
+ *
+ * @param rom_path Full path to ROM file or ZIP archive
+ * @param core_path Full path to core .so file
+ * @param tag Platform tag (e.g., "GB", "NES")
+ */
+static void Game_preload(char* rom_path, const char* core_path, const char* tag) {
+	char filename[MAX_PATH];
+	CoreInfo cached;
+	Core_getInfoPath(filename, tag);
+	if (CoreInfo_read(&cached, filename) != 0 || strcmp(cached.so_path, core_path) ||
+	    !CoreInfo_isFresh(&cached))
+		return;
+	// a cut list could leave out the extension inside a zip
+	if (cached.extensions_truncated ||
+	    strlen(cached.valid_extensions) >= sizeof(game_preload.extensions))
+		return;
+
+	snprintf(game_preload.path, sizeof(game_preload.path), "%s", rom_path);
+	snprintf(game_preload.extensions, sizeof(game_preload.extensions), "%s",
+	         cached.valid_extensions);
+	game_preload.need_fullpath = cached.need_fullpath;
+	game_preload.started =
+	    pthread_create(&game_preload.thread, NULL, Game_preloadThread, NULL) == 0;
+}
+
+/**
+ * Opens the game for the loaded core, finishing Game_preload() if it ran.
+ *
+ * Must be called after Core_open(). The game is opened again if the core
+ * reported different extensions or need_fullpath than the cache claimed.
+ *
+ * @param rom_path Full path to ROM file or ZIP archive
+ */
+static void Game_finishOpen(char* rom_path) {
+	if (game_preload.started) {
+		pthread_join(game_preload.thread, NULL);
+		game_preload.started = 0;
+		if (exactMatch(game_preload.extensions, core.extensions) &&
+		    game_preload.need_fullpath == core.need_fullpath)
+			return;
+
+		LOG_info("core info was stale, opening game again");
+		Game_close();
+	}
+	Game_open(rom_path);
+}
+
 ///////////////////////////////////////
 
 #define MENU_ITEM_COUNT 5
@@ -4485,20 +5200,23 @@ enum {
 static struct {
 	SDL_Surface* bitmap;
 	SDL_Surface* overlay;
+	SDL_Surface* preview; // Half screen, reused for every preview
 	char* items[MENU_ITEM_COUNT];
 	char* disc_paths[9]; // up to 9 paths, Arc the Lad Collection is 7 discs
 	char minui_dir[256];
 	char slot_path[256];
 	char base_path[256];
-	char bmp_path[256];
+	char preview_path[256];
+	char bmp_path[256]; // Full size preview written by older versions
 	char txt_path[256];
 	int disc;
 	int total_discs;
 	int slot;
 	int save_exists;
-	int preview_exists;
+	int legacy_preview; // Has a BMP preview but no preview file
 } menu = {.bitmap = NULL,
           .overlay = NULL,
+          .preview = NULL,
           .items =
               {
                   [ITEM_CONT] = "Continue",
@@ -4511,13 +5229,16 @@ static struct {
           .minui_dir = {0},
           .slot_path = {0},
           .base_path = {0},
+          .preview_path = {0},
           .bmp_path = {0},
           .txt_path = {0},
           .disc = -1,
           .total_discs = 0,
           .slot = 0,
           .save_exists = 0,
-          .preview_exists = 0};
+          .legacy_preview = 0};
+
+static PreviewCache preview_cache;
 
 void Menu_init(void) {
 	menu.overlay = SDL_CreateRGBSurface(SDL_SWSURFACE, DEVICE_WIDTH, DEVICE_HEIGHT, FIXED_DEPTH,
@@ -4525,6 +5246,11 @@ void Menu_init(void) {
 	SDLX_SetAlpha(menu.overlay, SDL_SRCALPHA, 0x80);
 	SDL_FillRect(menu.overlay, NULL, 0);
 
+	menu.preview = SDL_CreateRGBSurface(SDL_SWSURFACE, DEVICE_WIDTH / 2, DEVICE_HEIGHT / 2,
+	                                    FIXED_DEPTH, RGBA_MASK_565);
+	if (PreviewCache_start(&preview_cache) != 0)
+		LOG_error("Unable to start preview cache");
+
 	char emu_name[256];
 	getEmuName(game.path, emu_name);
 	sprintf(menu.minui_dir, SHARED_USERDATA_PATH "/.minui/%s", emu_name);
@@ -4571,15 +5297,19 @@ void Menu_init(void) {
 	}
 }
 void Menu_quit(void) {
+	PreviewCache_stop(&preview_cache);
+	SDL_FreeSurface(menu.preview);
 	SDL_FreeSurface(menu.overlay);
 }
 void Menu_beforeSleep(void) {
 	// LOG_info("beforeSleep");
 	SRAM_write();
 	RTC_write();
+	CPU_writeLearnedLevel();
+	PreviewCache_flush(&preview_cache);
 	State_autosave();
 	putFile(AUTO_RESUME_PATH, game.path + strlen(SDCARD_PATH));
-	PWR_setCPUSpeed(CPU_SPEED_MENU);
+	CPU_setSpeed(CPU_SPEED_MENU);
 }
 void Menu_afterSleep(void) {
 	// LOG_info("beforeSleep");
@@ -5778,7 +6508,10 @@ static void Menu_initState(void) {
 		menu.slot = 0;
 
 	menu.save_exists = 0;
-	menu.preview_exists = 0;
+	menu.legacy_preview = 0;
+}
+static void Menu_getPreviewPath(char* path, int slot) {
+	sprintf(path, "%s/%s.%d.preview", menu.minui_dir, game.name, slot);
 }
 static void Menu_updateState(void) {
 	// LOG_info("Menu_updateState");
@@ -5791,14 +6524,15 @@ static void Menu_updateState(void) {
 
 	state_slot = last_slot;
 
+	Menu_getPreviewPath(menu.preview_path, menu.slot);
 	sprintf(menu.bmp_path, "%s/%s.%d.bmp", menu.minui_dir, game.name, menu.slot);
 	sprintf(menu.txt_path, "%s/%s.%d.txt", menu.minui_dir, game.name, menu.slot);
 
 	menu.save_exists = exists(save_path);
-	menu.preview_exists = menu.save_exists && exists(menu.bmp_path);
+	menu.legacy_preview = menu.save_exists && exists(menu.bmp_path);
 
 	// LOG_info("save_path: %s (%i)", save_path, menu.save_exists);
-	// LOG_info("bmp_path: %s txt_path: %s (%i)", menu.bmp_path, menu.txt_path, menu.preview_exists);
+	// LOG_info("bmp_path: %s txt_path: %s (%i)", menu.bmp_path, menu.txt_path, menu.legacy_preview);
 }
 static void Menu_saveState(void) {
 	// LOG_info("Menu_saveState");
@@ -5810,14 +6544,18 @@ static void Menu_saveState(void) {
 		putFile(menu.txt_path, disc_path + strlen(menu.base_path));
 	}
 
+	// downscale now, the preview is written to disk in the background
 	SDL_Surface* bitmap = menu.bitmap;
 	if (!bitmap)
 		bitmap = SDL_CreateRGBSurfaceFrom(renderer.src, renderer.true_w, renderer.true_h,
 		                                  FIXED_DEPTH, renderer.src_p, RGBA_MASK_565);
-	SDL_RWops* out = SDL_RWFromFile(menu.bmp_path, "wb");
-	SDL_SaveBMP_RW(bitmap, out, 1);
-
-	// LOG_info("%s %ix%i", menu.bmp_path, bitmap->w,bitmap->h);
+	SDL_FillRect(menu.preview, NULL, 0);
+	Menu_scale(bitmap, menu.preview);
+	if (PreviewCache_save(&preview_cache, menu.preview_path, menu.preview->pixels,
+	                      menu.preview->w, menu.preview->h, menu.preview->pitch) != 0)
+		LOG_error("Unable to save preview: %s", menu.preview_path);
+	if (menu.legacy_preview)
+		unlink(menu.bmp_path);
 
 	if (bitmap != menu.bitmap)
 		SDL_FreeSurface(bitmap);
@@ -5943,7 +6681,7 @@ static void Menu_loop(void) {
 	PWR_warn(0);
 	if (!HAS_POWER_BUTTON)
 		PWR_enableSleep();
-	PWR_setCPUSpeed(CPU_SPEED_MENU); // set Hz directly
+	CPU_setSpeed(CPU_SPEED_MENU); // bypasses overclock, applied later by the CPU speed worker
 	GFX_setVsync(VSYNC_STRICT);
 	GFX_setEffect(EFFECT_NONE);
 
@@ -5981,10 +6719,7 @@ static void Menu_loop(void) {
 	int dirty = 1;
 	int menu_input_blocked = 0;
 	int menu_start = 0;
-
-	SDL_Surface* preview =
-	    SDL_CreateRGBSurface(SDL_SWSURFACE, DEVICE_WIDTH / 2, DEVICE_HEIGHT / 2, FIXED_DEPTH,
-	                         RGBA_MASK_565); // TODO: retain until changed?
+	int preview_pending = 0; // Redraw once the selected slot's preview has loaded
 
 	while (show_menu) {
 		GFX_startFrame();
@@ -6086,7 +6821,12 @@ static void Menu_loop(void) {
 
 		PWR_update(&dirty, &show_setting, Menu_beforeSleep, Menu_afterSleep);
 
+		if (preview_pending &&
+		    PreviewCache_request(&preview_cache, menu.preview_path, NULL) != PREVIEW_LOADING)
+			dirty = 1;
+
 		if (dirty) {
+			preview_pending = 0;
 			GFX_clear(screen);
 
 			SDL_BlitSurface(backing, NULL, screen, NULL);
@@ -6192,25 +6932,47 @@ static void Menu_loop(void) {
 				ox += DP(WINDOW_RADIUS);
 				oy += DP(WINDOW_RADIUS);
 
-				if (menu.preview_exists) { // has save, has preview
+				// warm up the neighboring slots so switching doesn't wait on the SD card
+				char neighbor_path[256];
+				Menu_getPreviewPath(neighbor_path,
+				                    (menu.slot + MENU_SLOT_COUNT - 1) % MENU_SLOT_COUNT);
+				PreviewCache_request(&preview_cache, neighbor_path, NULL);
+				Menu_getPreviewPath(neighbor_path, (menu.slot + 1) % MENU_SLOT_COUNT);
+				PreviewCache_request(&preview_cache, neighbor_path, NULL);
+
+				const BootFrame* frame = NULL;
+				int preview_state = PREVIEW_MISSING;
+				if (menu.save_exists)
+					preview_state =
+					    PreviewCache_request(&preview_cache, menu.preview_path, &frame);
+				preview_pending = preview_state == PREVIEW_LOADING;
+
+				SDL_Rect preview_rect = {ox, oy, hw, hh};
+				if (frame) { // has save, has preview
+					SDL_Surface* raw_preview = SDL_CreateRGBSurfaceFrom(
+					    frame->pixels, frame->width, frame->height, FIXED_DEPTH,
+					    frame->width * FIXED_BPP, RGBA_MASK_565);
+					SDL_FillRect(screen, &preview_rect, 0);
+					SDL_BlitSurface(raw_preview, &(SDL_Rect){0, 0, hw, hh}, screen,
+					                &(SDL_Rect){ox, oy});
+					SDL_FreeSurface(raw_preview);
+				} else if (preview_state == PREVIEW_MISSING && menu.legacy_preview) {
 					// lotta memory churn here
 					SDL_Surface* bmp = IMG_Load(menu.bmp_path);
 					SDL_Surface* raw_preview =
 					    SDL_ConvertSurface(bmp, screen->format, SDL_SWSURFACE);
 
-					// LOG_info("raw_preview %ix%i", raw_preview->w,raw_preview->h);
-
-					SDL_FillRect(preview, NULL, 0);
-					Menu_scale(raw_preview, preview);
-					SDL_BlitSurface(preview, NULL, screen, &(SDL_Rect){ox, oy});
+					SDL_FillRect(menu.preview, NULL, 0);
+					Menu_scale(raw_preview, menu.preview);
+					SDL_BlitSurface(menu.preview, NULL, screen, &(SDL_Rect){ox, oy});
 					SDL_FreeSurface(raw_preview);
 					SDL_FreeSurface(bmp);
 				} else {
-					SDL_Rect preview_rect = {ox, oy, hw, hh};
+					// stays empty for the few frames a pending load takes
 					SDL_FillRect(screen, &preview_rect, 0);
-					if (menu.save_exists)
+					if (!preview_pending && menu.save_exists)
 						GFX_blitMessage(font.large, "No Preview", screen, &preview_rect);
-					else
+					else if (!preview_pending)
 						GFX_blitMessage(font.large, "Empty Slot", screen, &preview_rect);
 				}
 
@@ -6233,8 +6995,6 @@ static void Menu_loop(void) {
 		hdmimon();
 	}
 
-	SDL_FreeSurface(preview);
-
 	PAD_reset();
 
 	GFX_clearAll();
@@ -6373,6 +7133,53 @@ static void limitFF(void) {
 	last_time = now;
 }
 
+/**
+ * Sleeps before running the next frame when frame delay is enabled.
+ *
+ * The loop wakes right after the previous flip, so sleeping for the slack
+ * left by the measured frame work moves the core's input poll closer to
+ * the vsync that will present its result.
+ *
+ * @note Only meaningful when the flip blocks on vsync and the core runs
+ *       on the main thread
+ */
+static void delayFrame(void) {
+	if (!frame_delay || fast_forward || prevent_tearing == VSYNC_OFF)
+		return;
+
+	uint32_t delay = FrameDelay_getDelay(&frame_delay_state);
+	if (delay >= 1000)
+		SDL_Delay(delay / 1000);
+}
+
+/**
+ * Runs one core frame and records how long it took to produce.
+ *
+ * Work is measured up to the hand-off to GFX_flip so time spent blocked
+ * on vsync doesn't count against the frame delay budget.
+ */
+static void runFrame(void) {
+	Replay_beforeFrame();
+	if (quit)
+		return;
+
+	uint64_t run_start = getMicroseconds();
+	frame_ready_at = 0;
+	core.run();
+	uint64_t run_end = getMicroseconds();
+	// stop at the frame, GFX_flip() waits for vsync inside core.run()
+	Replay_afterFrame((frame_ready_at > run_start ? frame_ready_at : run_end) - run_start);
+	SRAM_poll();
+	if (frame_ready_at <= run_start)
+		return;
+
+	uint32_t work_us = frame_ready_at - run_start;
+	FrameDelay_addSample(&frame_delay_state, work_us);
+	if (overclock == OVERCLOCK_AUTO && !fast_forward &&
+	    CpuGovernor_addSample(&cpu_governor, work_us))
+		setOverclock(overclock);
+}
+
 ///////////////////////////////////////
 // Threading
 ///////////////////////////////////////
@@ -6429,8 +7236,10 @@ static void* coreThread(void* arg) {
 			}
 
 			core.run();
+			SRAM_poll();
 			limitFF();
 			trackFPS();
+			Input_update();
 		}
 	}
 	pthread_exit(NULL);
@@ -6473,6 +7282,7 @@ static void* coreThread(void* arg) {
  * @note Exits early if game fails to load
  */
 int main(int argc, char* argv[]) {
+	Startup_begin();
 	LOG_info("MinArch");
 
 	setOverclock(overclock); // default to normal
@@ -6487,10 +7297,16 @@ int main(int argc, char* argv[]) {
 	strcpy(core_path, argv[1]);
 	strcpy(rom_path, argv[2]);
 	getEmuName(rom_path, tag_name);
+	Replay_init(argc, argv);
 
 	LOG_info("rom_path: %s", rom_path);
 
+	// overlap core and ROM loading with GFX/input/power init, see Parallel Startup
+	Core_preload(core_path);
+	Game_preload(rom_path, core_path, tag_name);
+
 	screen = GFX_init(MODE_MENU);
+	Startup_mark("GFX_init");
 	PAD_init();
 	DEVICE_WIDTH = screen->w;
 	DEVICE_HEIGHT = screen->h;
@@ -6502,13 +7318,21 @@ int main(int argc, char* argv[]) {
 	if (!HAS_POWER_BUTTON)
 		PWR_disableSleep();
 	MSG_init();
+	Startup_mark("input/power");
 
 	// Overrides_init();
 
 	Core_open(core_path, tag_name);
-	Game_open(rom_path); // nes tries to load gamegenie setting before this returns ffs
+	Startup_mark("Core_open");
+	Game_finishOpen(rom_path); // nes tries to load gamegenie setting before this returns ffs
 	if (!game.is_open)
 		goto finish;
+	Startup_mark("Game_open");
+
+	// Auto has to start at the learned level before the first setOverclock(),
+	// or core init and game load would run at the lowest speed, the frame
+	// rate follows in Core_load()
+	CpuGovernor_init(&cpu_governor, 0, CPU_readLearnedLevel());
 
 	simple_mode = exists(SIMPLE_MODE_PATH);
 
@@ -6518,8 +7342,10 @@ int main(int argc, char* argv[]) {
 	Config_readOptions(); // cores with boot logo option (eg. gb) need to load options early
 	setOverclock(overclock);
 	GFX_setVsync(prevent_tearing);
+	Startup_mark("Config_load");
 
 	Core_init();
+	Startup_mark("Core_init");
 
 	// TODO: find a better place to do this
 	// mixing static and loaded data is messy
@@ -6532,12 +7358,18 @@ int main(int argc, char* argv[]) {
 	Config_readOptions(); // but others load and report options later (eg. nes)
 	Config_readControls(); // restore controls (after the core has reported its defaults)
 	Config_free();
+	Startup_mark("controls");
 
 	SND_init(core.sample_rate, core.fps);
 	InitSettings(); // after we initialize audio
+	Startup_mark("audio");
 	Menu_init();
+	Startup_mark("Menu_init");
 	State_resume();
 	Menu_initState(); // make ready for state shortcuts
+	Startup_mark("State_resume");
+	Game_prefetchNextDisc(); // after State_resume, which may have changed discs
+	Replay_start(); // from the resumed state, before the core thread starts
 
 	if (thread_video) {
 		core_mx = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
@@ -6557,6 +7389,8 @@ int main(int argc, char* argv[]) {
 
 	sec_start = SDL_GetTicks();
 	while (!quit) {
+		if (!thread_video)
+			delayFrame();
 		GFX_startFrame();
 
 		// Call frame time callback if registered (per libretro spec)
@@ -6564,8 +7398,9 @@ int main(int argc, char* argv[]) {
 		if (video_state.frame_time_cb) {
 			retro_usec_t now = getMicroseconds();
 			retro_usec_t delta;
-			if (fast_forward) {
+			if (fast_forward || replay_mode != REPLAY_OFF) {
 				// During fast-forward, use the reference frame time
+				// (recordings too, so a replay sees the same deltas)
 				delta = video_state.frame_time_ref;
 			} else if (video_state.frame_time_last == 0) {
 				// First frame - use reference as initial delta
@@ -6590,9 +7425,10 @@ int main(int argc, char* argv[]) {
 				core.audio_buffer_status(true, occupancy, occupancy < 25);
 			}
 
-			core.run();
+			runFrame();
 			limitFF();
 			trackFPS();
+			Input_update();
 		}
 
 		if (thread_video && !quit) {
@@ -6603,13 +7439,18 @@ int main(int argc, char* argv[]) {
 				video_refresh_callback_main(backbuffer->pixels, backbuffer->w, backbuffer->h,
 				                            backbuffer->pitch);
 				GFX_flip(screen);
+				if (startup_at)
+					Startup_end();
 			}
 			core_rq = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
 			pthread_mutex_unlock(&core_mx);
 		}
 
-		if (show_menu)
+		if (show_menu) {
 			Menu_loop();
+			FrameDelay_reset(&frame_delay_state); // menu time isn't frame work
+			CpuGovernor_reset(&cpu_governor);
+		}
 
 		if (toggle_thread) {
 			toggle_thread = 0;
@@ -6645,8 +7486,13 @@ int main(int argc, char* argv[]) {
 	Menu_quit();
 	QuitSettings();
 
+	LAT_report();
+	Replay_quit();
+
 finish:
 
+	CPU_writeLearnedLevel();
+	DiscPrefetch_stop(&disc_prefetch);
 	Game_close();
 	Core_unload();
 
@@ -6657,6 +7503,7 @@ finish:
 
 	Special_quit();
 
+	CPU_stopSpeedThread();
 	MSG_quit();
 	PWR_quit();
 	VIB_quit();
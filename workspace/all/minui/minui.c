@@ -40,7 +40,9 @@
 #include <unistd.h>
 
 #include "api.h"
+#include "boot_frame.h"
 #include "collections.h"
+#include "core_info.h"
 #include "defines.h"
 #include "utils.h"
 
@@ -1321,7 +1323,42 @@ static int getFirstDisc(char* m3u_path, char* disc_path) {
 	return found;
 }
 
+/**
+ * Loads the cached metadata of the core last used for a ROM folder.
+ *
+ * minarch writes this cache the first time it runs a core (see
+ * core_info.h), so systems that were never launched have none.
+ *
+ * @param path ROM folder or subfolder
+ * @param info Output metadata
+ * @return 1 if cached and still matching the core on disk, 0 otherwise
+ */
+static int getCoreInfo(char* path, CoreInfo* info) {
+	if (!prefixMatch(ROMS_PATH "/", path))
+		return 0;
+
+	char emu_name[256];
+	char info_path[256];
+	getEmuName(path, emu_name);
+	sprintf(info_path, "%s/%s.txt", CORE_INFO_PATH, emu_name);
+	return CoreInfo_read(info, info_path) == 0 && CoreInfo_isFresh(info);
+}
+
+/**
+ * Checks if a file can be launched with a core.
+ *
+ * Zip files are unpacked by minarch and m3u playlists are handled by
+ * minui, so both are allowed whatever the core supports.
+ */
+static int isPlayable(const CoreInfo* info, char* path) {
+	return suffixMatch(".zip", path) || suffixMatch(".m3u", path) ||
+	       CoreInfo_supportsFile(info, path);
+}
+
 static void addEntries(Array* entries, char* path) {
+	CoreInfo info;
+	int has_info = getCoreInfo(path, &info); // hide files the core can't open
+
 	DIR* dh = opendir(path);
 	if (dh != NULL) {
 		struct dirent* dp;
@@ -1346,6 +1383,8 @@ static void addEntries(Array* entries, char* path) {
 				if (prefixMatch(COLLECTIONS_PATH, full_path)) {
 					type = ENTRY_DIR; // :shrug:
 				} else {
+					if (has_info && !isPlayable(&info, full_path))
+						continue;
 					type = ENTRY_ROM;
 				}
 			}
@@ -1942,6 +1981,29 @@ static void Menu_quit(void) {
 	DirectoryArray_free(stack);
 }
 
+///////////////////////////////
+// Boot frame
+///////////////////////////////
+
+static BootFrame root_frame; // Last rendered root screen, shown first on the next start
+
+/**
+ * Saves the last rendered root screen for the next start.
+ *
+ * Called on exit and before sleep (which may end in power off). Only
+ * writes when the screen differs from the saved one, since minui exits
+ * for every launch. Frames rendered for HDMI are skipped since they won't
+ * match the panel.
+ */
+static void saveBootFrame(void) {
+	if (!root_frame.pixels || !root_frame.changed || GetHDMI())
+		return;
+	if (BootFrame_save(&root_frame, BOOT_FRAME_PATH) != 0)
+		LOG_warn("Failed to save boot frame");
+	else
+		root_frame.changed = 0;
+}
+
 ///////////////////////////////
 // Main entry point
 ///////////////////////////////
@@ -1977,10 +2039,20 @@ static void Menu_quit(void) {
  * - If a ROM/app was launched, it's queued in /tmp/next
  */
 int main(int argc, char* argv[]) {
+	uint64_t main_begin = getMicroseconds(); // boot timings count from here
+
 	// Check for auto-resume first (fast path)
 	if (autoResume())
 		return 0;
 
+	// Put last session's root screen on the framebuffer before anything
+	// else initializes, live rendering replaces it once the menu is ready
+	BootFrame boot_frame;
+	int showed_boot_frame = BootFrame_load(&boot_frame, BOOT_FRAME_PATH) == 0 &&
+	                        BootFrame_show(&boot_frame, "/dev/fb0") == 0;
+	if (showed_boot_frame)
+		LOG_info("boot frame after %ims", (int)((getMicroseconds() - main_begin) / 1000));
+
 	simple_mode = exists(SIMPLE_MODE_PATH);
 
 	LOG_info("Starting MinUI on %s", PLATFORM);
@@ -1989,6 +2061,25 @@ int main(int argc, char* argv[]) {
 	SDL_Surface* screen = GFX_init(MODE_MAIN);
 	// LOG_info("- graphics init: %lu", SDL_GetTicks() - main_begin);
 
+	// video init may have cleared the framebuffer (or there wasn't one to
+	// write to directly), so present the snapshot through SDL as well
+	BootFrame_Target boot_target = {
+	    .pixels = screen->pixels,
+	    .width = screen->w,
+	    .height = screen->h,
+	    .pitch = screen->pitch,
+	    .bpp = 16,
+	    .red_shift = 11,
+	    .alpha_shift = -1,
+	};
+	if (BootFrame_blit(&boot_frame, &boot_target) == 0) {
+		GFX_flip(screen);
+		if (!showed_boot_frame)
+			LOG_info("boot frame after %ims", (int)((getMicroseconds() - main_begin) / 1000));
+	}
+	// captures compare against the saved frame, so an unchanged one isn't written again
+	root_frame = boot_frame;
+
 	PAD_init();
 	// LOG_info("- input init: %lu", SDL_GetTicks() - main_begin);
 
@@ -2023,7 +2114,7 @@ int main(int argc, char* argv[]) {
 		int total = top->entries->count;
 
 		// Update power management (handles brightness/volume adjustments)
-		PWR_update(&dirty, &show_setting, NULL, NULL);
+		PWR_update(&dirty, &show_setting, saveBootFrame, NULL);
 
 		// Track online status changes (wifi icon)
 		int is_online = PLAT_isOnline();
@@ -2419,26 +2510,26 @@ int main(int argc, char* argv[]) {
 				}
 			}
 
+			if (stack->count == 1 && !show_version && !show_setting)
+				BootFrame_capture(&root_frame, screen->pixels, screen->w, screen->h,
+				                  screen->pitch);
+
 			GFX_flip(screen);
 			dirty = 0;
 		} else
 			GFX_sync();
 
-		// if (!first_draw) {
-		// 	first_draw = SDL_GetTicks();
-		// 	LOG_info("- first draw: %lu", first_draw - main_begin);
-		// }
+		static int first_draw = 1;
+		if (first_draw) {
+			first_draw = 0;
+			LOG_info("first live frame after %ims",
+			         (int)((getMicroseconds() - main_begin) / 1000));
+		}
 
 		// HDMI hotplug detection
 		// When HDMI is connected/disconnected, restart to reinit graphics
 		// with correct resolution. Save state so we return to same position.
-		static int had_hdmi = -1;
-		int has_hdmi = GetHDMI();
-		if (had_hdmi == -1)
-			had_hdmi = has_hdmi;
-		if (has_hdmi != had_hdmi) {
-			had_hdmi = has_hdmi;
-
+		if (GFX_hdmiChanged()) {
 			Entry* entry = top->entries->items[top->selected];
 			LOG_info("restarting after HDMI change... (%s)", entry->path);
 			saveLast(entry->path);
@@ -2450,6 +2541,9 @@ int main(int argc, char* argv[]) {
 	if (version)
 		SDL_FreeSurface(version);
 
+	saveBootFrame();
+	BootFrame_free(&root_frame);
+
 	Menu_quit();
 	PWR_quit();
 	PAD_quit();
@@ -10,6 +10,8 @@
  * - Visual layout mimics physical controller layout
  * - Real-time feedback - buttons highlight when pressed
  * - Exit with SELECT + START combination
+ * - Latency test screen (SELECT + A) that flashes white on each A press
+ *   and reports press-to-flip latency
  *
  * The layout adapts based on platform capabilities defined in platform.h:
  * - Shoulder buttons (L1, L2, R1, R2)
@@ -27,6 +29,7 @@
 
 #include "api.h"
 #include "defines.h"
+#include "latency.h"
 #include "sdl.h"
 #include "utils.h"
 
@@ -96,6 +99,40 @@ static void blitButton(char* label, SDL_Surface* dst, int pressed, int x, int y,
 	SDL_FreeSurface(text);
 }
 
+/**
+ * Renders the latency test screen.
+ *
+ * The flash frame is solid white so it can be picked up by a camera or
+ * photodiode. Other frames are black with the latest press-to-flip stats.
+ *
+ * @param screen Destination surface
+ * @param flash 1 to render the flash frame
+ */
+static void blitLatencyTest(SDL_Surface* screen, int flash) {
+	SDL_FillRect(screen, NULL, flash ? RGB_WHITE : RGB_BLACK);
+	if (flash)
+		return;
+
+	const LAT_Histogram* h = LAT_getHistogram(LAT_STAGE_PRESENT);
+	char line[128];
+	if (h->count)
+		sprintf(line, "Last %ims  Avg %ims  P95 %ims  (%u)", (int)(h->last_us / 1000),
+		        (int)(h->total_us / h->count / 1000), LAT_Histogram_percentile(h, 95), h->count);
+	else
+		strcpy(line, "Press A to flash the screen");
+
+	SDL_Surface* text = TTF_RenderUTF8_Blended(font.small, line, COLOR_WHITE);
+	SDL_BlitSurface(text, NULL, screen,
+	                &(SDL_Rect){(FIXED_WIDTH - text->w) / 2, (FIXED_HEIGHT - text->h) / 2});
+	SDL_FreeSurface(text);
+
+	text = TTF_RenderUTF8_Blended(font.tiny, "SELECT + A: BACK", COLOR_LIGHT_TEXT);
+	SDL_BlitSurface(text, NULL, screen,
+	                &(SDL_Rect){(FIXED_WIDTH - text->w) / 2,
+	                            FIXED_HEIGHT - DP(ui.edge_padding) - text->h});
+	SDL_FreeSurface(text);
+}
+
 /**
  * Main entry point for the input tester application.
  *
@@ -134,6 +171,8 @@ int main(int argc, char* argv[]) {
 
 	int quit = 0;
 	int dirty = 1;
+	int latency_mode = 0;
+	int flash = 0;
 
 	// Main event loop - redraw on any button press/release
 	while (!quit) {
@@ -147,6 +186,31 @@ int main(int argc, char* argv[]) {
 		if (PAD_isPressed(BTN_SELECT) && PAD_isPressed(BTN_START))
 			quit = 1;
 
+		// Toggle latency test on SELECT + A
+		if (PAD_isPressed(BTN_SELECT) && PAD_justPressed(BTN_A)) {
+			latency_mode = !latency_mode;
+			if (latency_mode)
+				LAT_reset();
+			else
+				LAT_report();
+			LAT_setEnabled(latency_mode);
+			dirty = 1;
+		} else if (latency_mode && PAD_justPressed(BTN_A)) {
+			LAT_markRead(BTN_A); // press reached us, the next flip shows it
+			flash = 1;
+		}
+
+		if (latency_mode) {
+			if (dirty || flash) {
+				blitLatencyTest(screen, flash);
+				GFX_flip(screen);
+				dirty = flash; // repaint the stats after the flash frame
+				flash = 0;
+			} else
+				GFX_sync();
+			continue;
+		}
+
 		// Redraw screen if anything changed
 		if (dirty) {
 			GFX_clear(screen);
@@ -364,6 +428,8 @@ int main(int argc, char* argv[]) {
 	}
 
 	// Cleanup
+	if (latency_mode)
+		LAT_report();
 	QuitSettings();
 	PWR_quit();
 	PAD_quit();
@@ -4,6 +4,7 @@
 #include <parson/parson.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 #ifdef USE_SDL2
@@ -14,6 +15,9 @@
 
 #include "defines.h"
 #include "api.h"
+#include "image_cache.h"
+#include "json_stream.h"
+#include "list_filter.h"
 #include "utils.h"
 
 SDL_Surface *screen = NULL;
@@ -36,6 +40,15 @@ enum list_result_t
 typedef int ExitCode;
 
 #define OPTION_PADDING 8
+// number of items read from JSON input per frame while the list is shown
+#define LIST_INGEST_BATCH 1000
+// number of frames a redraw waits for the selected background image to decode
+#define BACKGROUND_IMAGE_WAIT_FRAMES 6
+// how often a missing selected background image is looked for again
+#define BACKGROUND_IMAGE_RETRY_MS 1000
+// size of the filter keyboard
+#define FILTER_KEYBOARD_ROWS 5
+#define FILTER_KEYBOARD_COLUMNS 11
 
 // log_error logs a message to stderr for debugging purposes
 void log_error(const char *msg)
@@ -53,18 +66,25 @@ void log_info(const char *msg)
     printf("%s\n", msg);
 }
 
+// ListItemFeature holds the display features of a list item
+//
+// Records are interned in the list's ListPool and shared by every item with
+// the same features, so they must not be modified in place: copy the record,
+// change the copy and intern it again. The strings come first so that the
+// record has no padding and can be compared with memcmp.
 struct ListItemFeature
 {
     // the background color to use for the list
-    char background_color[1024];
+    const char *background_color;
     // path to the background image to use for the list
-    char background_image[1024];
-    // whether the background image exists
-    bool background_image_exists;
+    const char *background_image;
+    // the confirm text to display on the confirm button
+    const char *confirm_text;
+    // alignment of the item text ('left', 'center', 'right')
+    const char *alignment;
+
     // whether the item can be disabled
     bool can_disable;
-    // the confirm text to display on the confirm button
-    char confirm_text[1024];
     // whether the item is disabled
     bool disabled;
     // whether to draw arrows around the item
@@ -79,8 +99,6 @@ struct ListItemFeature
     bool is_header;
     // whether or not the item is unselectable
     bool unselectable;
-    // alignment of the item text ('left', 'center', 'right')
-    char alignment[1024];
 
     // whether the item has a background_color field
     bool has_background_color;
@@ -106,29 +124,128 @@ struct ListItemFeature
     bool has_unselectable;
     // whether the item has a alignment field
     bool has_alignment;
+
+    // unused, fills what would be padding so memcmp sees only members
+    bool reserved[4];
 };
 
+_Static_assert(sizeof(struct ListItemFeature) == 4 * sizeof(char *) + 24 * sizeof(bool), "struct ListItemFeature must not contain padding");
+
 // ListItem holds the configuration for a list item
 struct ListItem
 {
     // the name of the item
-    char *name;
-    // whether the item has features
-    bool has_features;
-    // whether the item has options field
-    bool has_options;
-    // whether the item has a selected field
-    bool has_selected;
+    const char *name;
+    // a list of char options for the item
+    const char **options;
     // the number of options for the item
     int option_count;
-    // a list of char options for the item
-    char **options;
     // the selected option index
     int selected;
     // the initial selected option index
     int initial_selected;
-    // the features of the item
-    struct ListItemFeature features;
+    // whether the item has features
+    bool has_features;
+    // whether the item has options field
+    bool has_options;
+    // whether the item has a selected field
+    bool has_selected;
+    // the features of the item, shared with other items
+    const struct ListItemFeature *features;
+};
+
+// ListPoolTable is an open-addressing table of interned values
+struct ListPoolTable
+{
+    // the interned values, NULL for empty slots
+    const void **slots;
+    // number of slots, a power of two
+    size_t capacity;
+    // number of interned values
+    size_t count;
+};
+
+// ListPool owns the strings and feature records of a list
+//
+// Generated lists (e.g. ROM pickers) repeat the same background, confirm
+// text and alignment on thousands of items. Names are copied into large
+// blocks instead of one allocation each, and repeated strings and feature
+// records are interned so every item points at one copy.
+struct ListPool
+{
+    // the block strings and records are allocated from
+    char *block;
+    // bytes used in the current block
+    size_t block_used;
+    // size of the current block
+    size_t block_size;
+    // the interned strings
+    struct ListPoolTable strings;
+    // the interned feature records
+    struct ListPoolTable features;
+};
+
+// ListItemInput holds the fields of an item object as read from the input
+struct ListItemInput
+{
+    // the name field, NULL if missing or not a string
+    const char *name;
+    // the options field, values that aren't strings are ""
+    const char **options;
+    // the number of options
+    size_t option_count;
+    // whether the item has a selected field
+    bool has_selected;
+    // the selected field, 0 if not a number
+    double selected;
+    // whether the item has a features field
+    bool has_features;
+    // the string features, NULL if missing or not strings
+    const char *background_image;
+    const char *background_color;
+    const char *alignment;
+    const char *confirm_text;
+    // the boolean features, 1 or 0, -1 if missing or not booleans
+    int can_disable;
+    int disabled;
+    int draw_arrows;
+    int hide_action;
+    int hide_cancel;
+    int hide_confirm;
+    int unselectable;
+    int is_header;
+};
+
+// ListIngest reads the items of a JSON list while the list is shown
+//
+// The first screen of items is read before anything is drawn, the rest
+// a batch per frame, so a long list (or a slow script writing to stdin)
+// doesn't hold up the first frame. Items go straight into the list's
+// pool, there is no document tree.
+struct ListIngest
+{
+    // the tokenizer reading the input
+    JsonStream stream;
+    // whether the input is a file opened by the list, as opposed to stdin
+    bool owns_fd;
+    // the key of the items array in the root object, empty if the root is the items array
+    char item_key[1024];
+    // whether the items array is being read
+    bool in_items;
+    // whether the last member name in the root object was the item key
+    bool at_item_key;
+    // the features every item starts from
+    struct ListItemFeature default_features;
+    // whether a default background image was given
+    bool has_default_background_image;
+    // whether a default background color was given
+    bool has_default_background_color;
+    // the features of the items in a list of strings
+    const struct ListItemFeature *string_features;
+    // scratch space for the options of the item being read
+    const char **options;
+    // number of options the scratch space has room for
+    size_t options_capacity;
 };
 
 // ListState holds the state of the list
@@ -148,6 +265,15 @@ struct ListState
 
     // whether or not any items in the list have options
     bool has_options;
+
+    // the strings and feature records of the items
+    struct ListPool pool;
+    // number of items the items array has room for
+    size_t item_capacity;
+    // number of rows the list shows
+    int visible_rows;
+    // the JSON input still being read, NULL once every item was read
+    struct ListIngest *ingest;
 };
 
 // Fonts holds the fonts for the list
@@ -165,6 +291,36 @@ struct Fonts
     char *medium_font;
 };
 
+// FilterState holds the state of the list filter
+//
+// While a filter is applied, the app shows a second list made of copies
+// of the matching items. Changes made to them (selected options, enabled
+// state) are copied back before the full list is shown or written out.
+struct FilterState
+{
+    // whether the filter keyboard is shown
+    bool editing;
+    // the selected key on the filter keyboard
+    int row;
+    int col;
+    // the text to filter by
+    char query[LIST_FILTER_QUERY_SIZE];
+    // the query when the keyboard was opened, restored on cancel
+    char initial_query[LIST_FILTER_QUERY_SIZE];
+    // the folded item names, built when the keyboard is first opened
+    ListFilter index;
+    // whether index has every item
+    bool indexed;
+    // the list of every item while a filter is applied, NULL otherwise
+    struct ListState *full_list;
+    // the list of matching items
+    struct ListState matches;
+    // the index in full_list of each item in matches
+    size_t *origin;
+    // number of items matches and origin have room for
+    size_t capacity;
+};
+
 // AppState holds the current state of the application
 struct AppState
 {
@@ -198,6 +354,8 @@ struct AppState
     bool disable_auto_sleep;
     // the button to display on the Enable button
     char enable_button[1024];
+    // the button that opens the filter keyboard, empty to disable filtering
+    char filter_button[1024];
     // the path to the JSON file
     char file[1024];
     // the format to read the input from
@@ -216,6 +374,10 @@ struct AppState
     struct Fonts fonts;
     // the state of the list
     struct ListState *list_state;
+    // the decoded and scaled background images
+    ImageCache background_images;
+    // the list filter
+    struct FilterState filter;
 };
 
 bool has_left_button_group(struct AppState *app_state, struct ListState *list_state)
@@ -223,17 +385,17 @@ bool has_left_button_group(struct AppState *app_state, struct ListState *list_st
     bool is_action_hidden = false;
     bool is_enable_hidden = false;
 
-    if (strcmp(app_state->action_button, "") == 0 || list_state->items[list_state->selected].features.hide_action)
+    if (strcmp(app_state->action_button, "") == 0 || list_state->items[list_state->selected].features->hide_action)
     {
         is_action_hidden = true;
     }
 
-    if (strcmp(app_state->enable_button, "") == 0 || !list_state->items[list_state->selected].features.can_disable)
+    if (strcmp(app_state->enable_button, "") == 0 || !list_state->items[list_state->selected].features->can_disable)
     {
         is_enable_hidden = true;
     }
 
-    if (is_action_hidden && is_enable_hidden)
+    if (is_action_hidden && is_enable_hidden && strcmp(app_state->filter_button, "") == 0)
     {
         return false;
     }
@@ -241,6 +403,13 @@ bool has_left_button_group(struct AppState *app_state, struct ListState *list_st
     return true;
 }
 
+// has_title_row tells whether a title row is drawn above the list
+// a filtered list always has one, to show the query
+bool has_title_row(struct AppState *state)
+{
+    return strlen(state->title) > 0 || state->filter.full_list != NULL;
+}
+
 char *read_stdin()
 {
     // Read all of stdin into a string
@@ -317,652 +486,1306 @@ char *read_file(const char *filename)
     return contents;
 }
 
-// ListState_New creates a new ListState from a JSON file
-struct ListState *ListState_New(const char *filename, const char *format, const char *item_key, const char *title, const char *confirm_text, const char *default_background_image, const char *default_background_color, bool show_hardware_group, struct AppState *app_state)
-{
-    struct ListState *state = malloc(sizeof(struct ListState));
+#define LIST_POOL_BLOCK_SIZE (64 * 1024)
 
-    int max_row_count = ui.row_count;
-    if (strlen(title) > 0)
+// ListPool_Alloc allocates memory that lives as long as the list
+void *ListPool_Alloc(struct ListPool *pool, size_t size)
+{
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if (pool->block == NULL || pool->block_used + size > pool->block_size)
     {
-        max_row_count -= 1;
+        // the previous block stays allocated, the items still point into it
+        size_t block_size = size > LIST_POOL_BLOCK_SIZE ? size : LIST_POOL_BLOCK_SIZE;
+        char *block = malloc(block_size);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+        pool->block = block;
+        pool->block_used = 0;
+        pool->block_size = block_size;
     }
-    if (show_hardware_group)
+
+    void *memory = pool->block + pool->block_used;
+    pool->block_used += size;
+    return memory;
+}
+
+// ListPool_CopyString copies length bytes of a string into the pool
+char *ListPool_CopyString(struct ListPool *pool, const char *string, size_t length)
+{
+    char *copy = ListPool_Alloc(pool, length + 1);
+    if (copy == NULL)
     {
-        max_row_count -= 1;
+        return NULL;
     }
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    return copy;
+}
 
-    if (strcmp(format, "text") == 0)
+// list_pool_hash hashes bytes with 32-bit FNV-1a
+uint32_t list_pool_hash(const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
     {
-        char *contents = NULL;
-        if (strcmp(filename, "-") == 0)
-        {
-            contents = read_stdin();
-        }
-        else
-        {
-            contents = read_file(filename);
-        }
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
 
-        if (contents == NULL)
-        {
-            log_error("Failed to read file or stdin");
-            free(state);
-            return NULL;
-        }
+// list_pool_reserve doubles an interning table when it is half full
+bool list_pool_reserve(struct ListPoolTable *table, size_t (*hash)(const void *))
+{
+    if (table->slots != NULL && (table->count + 1) * 2 <= table->capacity)
+    {
+        return true;
+    }
 
-        // Count number of non-empty lines
-        size_t item_count = 0;
-        char *line_start = contents;
-        while (*line_start != '\0')
+    size_t capacity = table->capacity ? table->capacity * 2 : 256;
+    const void **slots = calloc(capacity, sizeof(void *));
+    if (slots == NULL)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        if (table->slots[i] != NULL)
         {
-            char *line_end = strchr(line_start, '\n');
-            if (!line_end)
+            size_t slot = hash(table->slots[i]) & (capacity - 1);
+            while (slots[slot] != NULL)
             {
-                line_end = line_start + strlen(line_start);
+                slot = (slot + 1) & (capacity - 1);
             }
+            slots[slot] = table->slots[i];
+        }
+    }
 
-            // Check if line has non-whitespace content
-            char *p;
-            for (p = line_start; p < line_end && isspace(*p); p++)
-                ;
-            if (p < line_end)
-            {
-                item_count++;
-            }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
 
-            if (*line_end == '\0')
-            {
-                break;
-            }
-            line_start = line_end + 1;
-        }
+size_t list_pool_hash_string(const void *string)
+{
+    return list_pool_hash(string, strlen(string));
+}
 
-        // Allocate array for items
-        state->items = malloc(sizeof(struct ListItem) * item_count);
-        state->item_count = item_count;
-        state->last_visible = (item_count < max_row_count) ? item_count : max_row_count;
-        state->first_visible = 0;
-        state->selected = 0;
+size_t list_pool_hash_features(const void *features)
+{
+    return list_pool_hash(features, sizeof(struct ListItemFeature));
+}
 
-        // Add non-empty lines to items array
-        size_t item_index = 0;
-        line_start = contents;
-        while (*line_start != '\0')
+// ListPool_Intern returns the pool's copy of a string, adding it if needed
+//
+// Equal strings share one copy, so interned strings can be compared by
+// pointer. Returns "" if the pool runs out of memory.
+const char *ListPool_Intern(struct ListPool *pool, const char *string)
+{
+    struct ListPoolTable *table = &pool->strings;
+    if (string == NULL || !list_pool_reserve(table, list_pool_hash_string))
+    {
+        return "";
+    }
+
+    size_t length = strlen(string);
+    size_t slot = list_pool_hash(string, length) & (table->capacity - 1);
+    while (table->slots[slot] != NULL)
+    {
+        if (strcmp(table->slots[slot], string) == 0)
         {
-            char *line_end = strchr(line_start, '\n');
-            if (!line_end)
-            {
-                line_end = line_start + strlen(line_start);
-            }
+            return table->slots[slot];
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
 
-            // Check if line has non-whitespace content
-            char *p;
-            for (p = line_start; p < line_end && isspace(*p); p++)
-                ;
-            if (p < line_end)
-            {
-                size_t line_len = line_end - line_start;
-                char *line = malloc(line_len + 1);
-                memcpy(line, line_start, line_len);
-                line[line_len] = '\0';
-                state->items[item_index].name = line;
-                state->items[item_index].has_features = false;
-                state->items[item_index].has_options = false;
-                state->items[item_index].has_selected = false;
-                state->items[item_index].option_count = 0;
-                state->items[item_index].options = NULL;
-                state->items[item_index].selected = 0;
-                state->items[item_index].initial_selected = 0;
-                state->items[item_index].features = (struct ListItemFeature){
-                    .background_color = "",
-                    .background_image = "",
-                    .background_image_exists = false,
-                    .can_disable = false,
-                    .confirm_text = "",
-                    .disabled = false,
-                    .draw_arrows = false,
-                    .hide_action = false,
-                    .hide_cancel = false,
-                    .hide_confirm = false,
-                    .is_header = false,
-                    .unselectable = false,
-                    .alignment = "",
-                    .has_background_color = false,
-                    .has_background_image = false,
-                    .has_can_disable = false,
-                    .has_confirm_text = false,
-                    .has_draw_arrows = false,
-                    .has_disabled = false,
-                    .has_hide_action = false,
-                    .has_hide_cancel = false,
-                    .has_hide_confirm = false,
-                    .has_is_header = false,
-                    .has_unselectable = false,
-                    .has_alignment = false,
-                };
-                strncpy(state->items[item_index].features.alignment, "left", sizeof(state->items[item_index].features.alignment) - 1);
-                strncpy(state->items[item_index].features.confirm_text, confirm_text, sizeof(state->items[item_index].features.confirm_text) - 1);
-                if (default_background_image != NULL)
-                {
-                    strncpy(state->items[item_index].features.background_image, default_background_image, sizeof(state->items[item_index].features.background_image) - 1);
-                    if (access(default_background_image, F_OK) != -1)
-                    {
-                        state->items[item_index].features.background_image_exists = true;
-                    }
-                }
-                if (default_background_color != NULL)
-                {
-                    strncpy(state->items[item_index].features.background_color, default_background_color, sizeof(state->items[item_index].features.background_color) - 1);
-                }
+    char *copy = ListPool_CopyString(pool, string, length);
+    if (copy == NULL)
+    {
+        return "";
+    }
+    table->slots[slot] = copy;
+    table->count++;
+    return copy;
+}
 
-                item_index++;
-            }
+// ListPool_InternFeatures returns the pool's copy of a feature record, adding it if needed
+//
+// The record's strings are interned first, so they may point anywhere
+// (e.g. into a JSON document that is freed afterwards).
+const struct ListItemFeature *ListPool_InternFeatures(struct ListPool *pool, const struct ListItemFeature *features)
+{
+    static const struct ListItemFeature fallback = {
+        .background_color = "",
+        .background_image = "",
+        .confirm_text = "",
+        .alignment = "left",
+    };
 
-            if (*line_end == '\0')
-            {
-                break;
-            }
-            line_start = line_end + 1;
-        }
+    struct ListItemFeature record = *features;
+    record.background_color = ListPool_Intern(pool, features->background_color);
+    record.background_image = ListPool_Intern(pool, features->background_image);
+    record.confirm_text = ListPool_Intern(pool, features->confirm_text);
+    record.alignment = ListPool_Intern(pool, features->alignment);
 
-        free(contents);
-        return state;
+    struct ListPoolTable *table = &pool->features;
+    if (!list_pool_reserve(table, list_pool_hash_features))
+    {
+        return &fallback;
     }
 
-    JSON_Value *root_value;
-    if (strcmp(filename, "-") == 0)
+    size_t slot = list_pool_hash_features(&record) & (table->capacity - 1);
+    while (table->slots[slot] != NULL)
     {
-        char *contents = read_stdin();
-        if (contents == NULL)
+        if (memcmp(table->slots[slot], &record, sizeof(record)) == 0)
         {
-            log_error("Failed to read stdin");
-            free(state);
-            return NULL;
+            return table->slots[slot];
         }
-
-        root_value = json_parse_string_with_comments(contents);
-        free(contents);
-    }
-    else
-    {
-        root_value = json_parse_file_with_comments(filename);
+        slot = (slot + 1) & (table->capacity - 1);
     }
 
-    if (root_value == NULL)
+    struct ListItemFeature *copy = ListPool_Alloc(pool, sizeof(record));
+    if (copy == NULL)
     {
-        log_error("Failed to parse JSON file");
-        free(state);
-        return NULL;
+        return &fallback;
     }
+    *copy = record;
+    table->slots[slot] = copy;
+    table->count++;
+    return copy;
+}
 
-    JSON_Array *items_array;
-    if (strlen(item_key) == 0)
+// list_ingest_boolean maps a JSON value to 1 or 0, -1 if it isn't a boolean
+int list_ingest_boolean(JsonStream_Token token)
+{
+    if (token == JSON_STREAM_TRUE)
     {
-        items_array = json_value_get_array(root_value);
+        return 1;
     }
-    else
+    if (token == JSON_STREAM_FALSE)
     {
-        items_array = json_value_get_array(json_object_get_value(json_value_get_object(root_value), item_key));
+        return 0;
     }
+    return -1;
+}
 
-    size_t item_count = json_array_get_count(items_array);
-
-    state->items = malloc(sizeof(struct ListItem) * item_count);
-    state->has_options = false;
+// list_ingest_string interns a JSON string value, NULL if it isn't a string
+const char *list_ingest_string(struct ListState *state, JsonStream_Token token)
+{
+    if (token != JSON_STREAM_STRING)
+    {
+        return NULL;
+    }
+    return ListPool_Intern(&state->pool, state->ingest->stream.string);
+}
 
-    if (strlen(item_key) == 0)
-    {
-        for (size_t i = 0; i < item_count; i++)
-        {
-            const char *name = json_array_get_string(items_array, i);
-            state->items[i].name = name ? strdup(name) : "";
-
-            // set defaults for the other fields
-            state->items[i].has_features = false;
-            state->items[i].has_options = false;
-            state->items[i].has_selected = false;
-            state->items[i].option_count = 0;
-            state->items[i].options = NULL;
-            state->items[i].selected = 0;
-            state->items[i].initial_selected = 0;
-            state->items[i].features = (struct ListItemFeature){
-                .background_color = "",
-                .background_image = "",
-                .background_image_exists = false,
-                .can_disable = false,
-                .confirm_text = "",
-                .disabled = false,
-                .draw_arrows = false,
-                .hide_action = false,
-                .hide_cancel = false,
-                .hide_confirm = false,
-                .is_header = false,
-                .unselectable = false,
-                .alignment = "",
-                .has_background_color = false,
-                .has_background_image = false,
-                .has_can_disable = false,
-                .has_confirm_text = false,
-                .has_disabled = false,
-                .has_draw_arrows = false,
-                .has_hide_action = false,
-                .has_hide_cancel = false,
-                .has_hide_confirm = false,
-                .has_is_header = false,
-                .has_unselectable = false,
-                .has_alignment = false,
-            };
-            strncpy(state->items[i].features.alignment, "left", sizeof(state->items[i].features.alignment) - 1);
-            strncpy(state->items[i].features.confirm_text, confirm_text, sizeof(state->items[i].features.confirm_text) - 1);
-            if (default_background_image != NULL)
-            {
-                strncpy(state->items[i].features.background_image, default_background_image, sizeof(state->items[i].features.background_image) - 1);
-                if (access(default_background_image, F_OK) != -1)
-                {
-                    state->items[i].features.background_image_exists = true;
-                }
-            }
-            if (default_background_color != NULL)
+// list_ingest_read_options reads an options array into the scratch space
+// returns false if the input is invalid or memory runs out
+bool list_ingest_read_options(struct ListState *state, struct ListItemInput *input)
+{
+    struct ListIngest *ingest = state->ingest;
+    JsonStream_Token token;
+    input->option_count = 0;
+    while ((token = JsonStream_next(&ingest->stream)) > JSON_STREAM_END && token != JSON_STREAM_ARRAY_END)
+    {
+        if (input->option_count == ingest->options_capacity)
+        {
+            size_t capacity = ingest->options_capacity > 0 ? ingest->options_capacity * 2 : 16;
+            const char **options = realloc(ingest->options, sizeof(char *) * capacity);
+            if (options == NULL)
             {
-                strncpy(state->items[i].features.background_color, default_background_color, sizeof(state->items[i].features.background_color) - 1);
+                return false;
             }
+            ingest->options = options;
+            ingest->options_capacity = capacity;
+        }
+
+        // options repeat across items (e.g. "On"/"Off"), so they are interned
+        const char *option = list_ingest_string(state, token);
+        ingest->options[input->option_count++] = option != NULL ? option : "";
+        if (JsonStream_skip(&ingest->stream, token) != 0)
+        {
+            return false;
         }
     }
-    else
+    input->options = ingest->options;
+    return token == JSON_STREAM_ARRAY_END;
+}
+
+// list_ingest_read_features reads a features object
+// returns false if the input is invalid
+bool list_ingest_read_features(struct ListState *state, struct ListItemInput *input)
+{
+    JsonStream *stream = &state->ingest->stream;
+    JsonStream_Token token;
+    while ((token = JsonStream_next(stream)) == JSON_STREAM_KEY)
     {
-        for (size_t i = 0; i < item_count; i++)
+        char key[32];
+        snprintf(key, sizeof(key), "%s", stream->string);
+        token = JsonStream_next(stream);
+
+        if (strcmp(key, "background_image") == 0)
+        {
+            input->background_image = list_ingest_string(state, token);
+        }
+        else if (strcmp(key, "background_color") == 0)
+        {
+            input->background_color = list_ingest_string(state, token);
+        }
+        else if (strcmp(key, "alignment") == 0)
+        {
+            input->alignment = list_ingest_string(state, token);
+        }
+        else if (strcmp(key, "confirm_text") == 0)
+        {
+            input->confirm_text = list_ingest_string(state, token);
+        }
+        else if (strcmp(key, "can_disable") == 0)
+        {
+            input->can_disable = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "disabled") == 0)
+        {
+            input->disabled = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "draw_arrows") == 0)
         {
-            JSON_Object *item = json_array_get_object(items_array, i);
+            input->draw_arrows = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "hide_action") == 0)
+        {
+            input->hide_action = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "hide_cancel") == 0)
+        {
+            input->hide_cancel = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "hide_confirm") == 0)
+        {
+            input->hide_confirm = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "unselectable") == 0)
+        {
+            input->unselectable = list_ingest_boolean(token);
+        }
+        else if (strcmp(key, "is_header") == 0)
+        {
+            input->is_header = list_ingest_boolean(token);
+        }
 
-            const char *name = json_object_get_string(item, "name");
-            state->items[i].name = name ? strdup(name) : "";
+        if (JsonStream_skip(stream, token) != 0)
+        {
+            return false;
+        }
+    }
+    return token == JSON_STREAM_OBJECT_END;
+}
 
-            // read in the options from the json object
-            // if there are no options, set the options to an empty array
-            // if there are options, treat them as a list of strings
-            JSON_Array *options_array = json_object_get_array(item, "options");
-            size_t options_count = json_array_get_count(options_array);
-            state->items[i].options = malloc(sizeof(char *) * options_count);
-            state->items[i].option_count = options_count;
-            for (size_t j = 0; j < options_count; j++)
-            {
-                const char *option = json_array_get_string(options_array, j);
-                state->items[i].options[j] = option ? strdup(option) : "";
-            }
+// list_ingest_read_item reads one element of the items array
+// elements that aren't objects read as items without any fields
+// returns false if the input is invalid or memory runs out
+bool list_ingest_read_item(struct ListState *state, JsonStream_Token token, struct ListItemInput *input)
+{
+    JsonStream *stream = &state->ingest->stream;
+    *input = (struct ListItemInput){
+        .can_disable = -1,
+        .disabled = -1,
+        .draw_arrows = -1,
+        .hide_action = -1,
+        .hide_cancel = -1,
+        .hide_confirm = -1,
+        .unselectable = -1,
+        .is_header = -1,
+    };
+    if (token != JSON_STREAM_OBJECT_BEGIN)
+    {
+        return JsonStream_skip(stream, token) == 0;
+    }
 
-            if (options_count > 0)
-            {
-                state->has_options = true;
-                state->items[i].has_options = true;
-            }
-            else
-            {
-                state->items[i].has_options = false;
-            }
+    while ((token = JsonStream_next(stream)) == JSON_STREAM_KEY)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "%s", stream->string);
+        token = JsonStream_next(stream);
 
-            // read in the current option index from the json object
-            // if there is no current option index, set it to 0
-            // if there is a current option index, treat it as an integer
-            if (json_object_has_value(item, "selected"))
+        if (strcmp(key, "name") == 0)
+        {
+            input->name = token == JSON_STREAM_STRING ? ListPool_CopyString(&state->pool, stream->string, stream->string_length) : NULL;
+        }
+        else if (strcmp(key, "options") == 0)
+        {
+            input->option_count = 0;
+            if (token == JSON_STREAM_ARRAY_BEGIN)
             {
-                state->items[i].selected = json_object_get_number(item, "selected");
-                if (state->items[i].selected < 0)
+                if (!list_ingest_read_options(state, input))
                 {
-                    char error_message[256];
-                    snprintf(error_message, sizeof(error_message), "Item %s has a selected option index of %d, which is less than 0. Setting to 0.", state->items[i].name, state->items[i].selected);
-                    log_error(error_message);
-                    state->items[i].selected = 0;
+                    return false;
                 }
-                if (state->items[i].selected >= options_count)
-                {
-                    char error_message[256];
-                    snprintf(error_message, sizeof(error_message), "Item %s has a selected option index of %d, which is greater than the number of options %d. Setting to last option.", state->items[i].name, state->items[i].selected, options_count);
-                    log_error(error_message);
-                    state->items[i].selected = options_count - 1;
-                    if (state->items[i].selected < 0)
-                    {
-                        state->items[i].selected = 0;
-                    }
-                }
-                state->items[i].has_selected = true;
+                continue;
             }
-            else
+        }
+        else if (strcmp(key, "selected") == 0)
+        {
+            input->has_selected = true;
+            input->selected = token == JSON_STREAM_NUMBER ? stream->number : 0;
+        }
+        else if (strcmp(key, "features") == 0)
+        {
+            input->has_features = true;
+            if (token == JSON_STREAM_OBJECT_BEGIN)
             {
-                state->items[i].selected = 0;
-                state->items[i].has_selected = false;
-            }
-
-            state->items[i].initial_selected = state->items[i].selected;
-
-            state->items[i].features = (struct ListItemFeature){
-                .background_color = "",
-                .background_image = "",
-                .background_image_exists = false,
-                .can_disable = false,
-                .confirm_text = "",
-                .disabled = false,
-                .draw_arrows = false,
-                .hide_action = false,
-                .hide_cancel = false,
-                .hide_confirm = false,
-                .is_header = false,
-                .unselectable = false,
-                .alignment = "",
-                .has_background_color = false,
-                .has_background_image = false,
-                .has_can_disable = false,
-                .has_confirm_text = false,
-                .has_disabled = false,
-                .has_draw_arrows = false,
-                .has_hide_action = false,
-                .has_hide_cancel = false,
-                .has_hide_confirm = false,
-                .has_is_header = false,
-                .has_unselectable = false,
-                .has_alignment = false,
-            };
-            strncpy(state->items[i].features.alignment, "left", sizeof(state->items[i].features.alignment) - 1);
-            strncpy(state->items[i].features.confirm_text, confirm_text, sizeof(state->items[i].features.confirm_text) - 1);
-            state->items[i].has_features = false;
-            if (json_object_has_value(item, "features"))
-            {
-                state->items[i].has_features = true;
-                JSON_Object *features = json_object_get_object(item, "features");
-
-                // read in the background_image from the json object
-                // if there is no background_image, set it to ""
-                // if there is a background_image, treat it as a string
-                const char *background_image = json_object_get_string(features, "background_image");
-                if (background_image != NULL)
+                if (!list_ingest_read_features(state, input))
                 {
-                    strncpy(state->items[i].features.background_image, background_image, sizeof(state->items[i].features.background_image) - 1);
-                    if (access(background_image, F_OK) != -1)
-                    {
-                        state->items[i].features.background_image_exists = true;
-                    }
-                    state->items[i].features.has_background_image = true;
-                }
-                else
-                {
-                    if (default_background_image != NULL)
-                    {
-                        strncpy(state->items[i].features.background_image, default_background_image, sizeof(state->items[i].features.background_image) - 1);
-                        if (access(default_background_image, F_OK) != -1)
-                        {
-                            state->items[i].features.background_image_exists = true;
-                        }
-                        state->items[i].features.has_background_image = true;
-                    }
-                    else
-                    {
-                        state->items[i].features.has_background_image = false;
-                    }
+                    return false;
                 }
+                continue;
+            }
+        }
 
-                // read in the background_color from the json object
-                // if there is no background_color, set it to ""
-                // if there is a background_color, treat it as a string
-                const char *background_color = json_object_get_string(features, "background_color");
-                if (background_color != NULL)
-                {
-                    strncpy(state->items[i].features.background_color, background_color, sizeof(state->items[i].features.background_color) - 1);
-                    state->items[i].features.has_background_color = true;
-                }
-                else
-                {
-                    if (default_background_color != NULL)
-                    {
-                        strncpy(state->items[i].features.background_color, default_background_color, sizeof(state->items[i].features.background_color) - 1);
-                        state->items[i].features.has_background_color = true;
-                    }
-                    else
-                    {
-                        state->items[i].features.has_background_color = false;
-                    }
-                }
+        if (JsonStream_skip(stream, token) != 0)
+        {
+            return false;
+        }
+    }
+    return token == JSON_STREAM_OBJECT_END;
+}
 
-                // read in the can_disable from the json object
-                // if there is no can_disable, set it to false
-                // if there is a can_disable, treat it as a boolean
-                if (json_object_get_boolean(features, "can_disable") == 1)
-                {
-                    state->items[i].features.can_disable = true;
-                    state->items[i].features.has_can_disable = true;
-                }
-                else if (json_object_get_boolean(features, "can_disable") == 0)
-                {
-                    state->items[i].features.can_disable = false;
-                    state->items[i].features.has_can_disable = true;
-                }
-                else
-                {
-                    state->items[i].features.can_disable = false;
-                    state->items[i].features.has_can_disable = false;
-                }
+// ListState_AddItem appends an item read from a JSON items array
+void ListState_AddItem(struct ListState *state, const struct ListItemInput *input)
+{
+    struct ListItem *item = &state->items[state->item_count];
+    item->name = input->name ? input->name : "";
 
-                // read in the disabled from the json object
-                // if there is no disabled, set it to false
-                // if there is an disabled, treat it as a boolean
-                if (json_object_get_boolean(features, "disabled") == 1)
-                {
-                    state->items[i].features.disabled = true;
-                    state->items[i].features.has_disabled = true;
-                }
-                else if (json_object_get_boolean(features, "disabled") == 0)
-                {
-                    state->items[i].features.disabled = false;
-                    state->items[i].features.has_disabled = true;
-                    if (!state->items[i].features.can_disable)
-                    {
-                        char error_message[256];
-                        snprintf(error_message, sizeof(error_message), "Item %s has no can_disable, but is disabled", state->items[i].name);
-                        log_error(error_message);
-                    }
-                }
-                else
-                {
-                    state->items[i].features.disabled = false;
-                    state->items[i].features.has_disabled = false;
-                }
+    // read in the options from the input
+    // if there are no options, leave the options empty
+    // if there are options, treat them as a list of strings
+    size_t options_count = input->option_count;
+    item->options = options_count > 0 ? ListPool_Alloc(&state->pool, sizeof(char *) * options_count) : NULL;
+    item->option_count = options_count;
+    if (item->options != NULL)
+    {
+        memcpy(item->options, input->options, sizeof(char *) * options_count);
+    }
 
-                // read in the draw_arrows from the json object
-                // if there is no draw_arrows, set it to false
-                // if there is a draw_arrows, treat it as a boolean
-                if (json_object_get_boolean(features, "draw_arrows") == 1)
-                {
-                    state->items[i].features.draw_arrows = true;
-                    state->items[i].features.has_draw_arrows = true;
-                }
-                else if (json_object_get_boolean(features, "draw_arrows") == 0)
-                {
-                    state->items[i].features.draw_arrows = false;
-                    state->items[i].features.has_draw_arrows = true;
-                }
-                else
-                {
-                    state->items[i].features.draw_arrows = false;
-                    state->items[i].features.has_draw_arrows = false;
-                }
+    if (options_count > 0)
+    {
+        state->has_options = true;
+        item->has_options = true;
+    }
+    else
+    {
+        item->has_options = false;
+    }
 
-                // read in the hide_action from the json object
-                // if there is no hide_action, set it to false
-                // if there is a hide_action, treat it as a boolean
-                if (json_object_get_boolean(features, "hide_action") == 1)
-                {
-                    state->items[i].features.hide_action = true;
-                    state->items[i].features.has_hide_action = true;
-                }
-                else if (json_object_get_boolean(features, "hide_action") == 0)
-                {
-                    state->items[i].features.hide_action = false;
-                    state->items[i].features.has_hide_action = true;
-                }
-                else
-                {
-                    state->items[i].features.hide_action = false;
-                    state->items[i].features.has_hide_action = false;
-                }
+    // read in the current option index from the input
+    // if there is no current option index, set it to 0
+    // if there is a current option index, treat it as an integer
+    if (input->has_selected)
+    {
+        item->selected = input->selected;
+        if (item->selected < 0)
+        {
+            char error_message[256];
+            snprintf(error_message, sizeof(error_message), "Item %s has a selected option index of %d, which is less than 0. Setting to 0.", item->name, item->selected);
+            log_error(error_message);
+            item->selected = 0;
+        }
+        if (item->selected >= options_count)
+        {
+            char error_message[256];
+            snprintf(error_message, sizeof(error_message), "Item %s has a selected option index of %d, which is greater than the number of options %d. Setting to last option.", item->name, item->selected, options_count);
+            log_error(error_message);
+            item->selected = options_count - 1;
+            if (item->selected < 0)
+            {
+                item->selected = 0;
+            }
+        }
+        item->has_selected = true;
+    }
+    else
+    {
+        item->selected = 0;
+        item->has_selected = false;
+    }
 
-                // read in the hide_cancel from the json object
-                // if there is no hide_cancel, set it to false
-                // if there is a hide_cancel, treat it as a boolean
-                if (json_object_get_boolean(features, "hide_cancel") == 1)
-                {
-                    state->items[i].features.hide_cancel = true;
-                    state->items[i].features.has_hide_cancel = true;
-                }
-                else if (json_object_get_boolean(features, "hide_cancel") == 0)
-                {
-                    state->items[i].features.hide_cancel = false;
-                    state->items[i].features.has_hide_cancel = true;
-                }
-                else
-                {
-                    state->items[i].features.hide_cancel = false;
-                    state->items[i].features.has_hide_cancel = false;
-                }
+    item->initial_selected = item->selected;
 
-                // read in the hide_confirm from the json object
-                // if there is no hide_confirm, set it to false
-                // if there is a hide_confirm, treat it as a boolean
-                if (json_object_get_boolean(features, "hide_confirm") == 1)
-                {
-                    state->items[i].features.hide_confirm = true;
-                    state->items[i].features.has_hide_confirm = true;
-                }
-                else if (json_object_get_boolean(features, "hide_confirm") == 0)
-                {
-                    state->items[i].features.hide_confirm = false;
-                    state->items[i].features.has_hide_confirm = true;
-                }
-                else
-                {
-                    state->items[i].features.hide_confirm = false;
-                    state->items[i].features.has_hide_confirm = false;
-                }
+    struct ListItemFeature item_features = state->ingest->default_features;
+    item->has_features = false;
+    if (input->has_features)
+    {
+        item->has_features = true;
+        // read in the background_image from the input
+        // if there is no background_image, set it to ""
+        // if there is a background_image, treat it as a string
+        const char *background_image = input->background_image;
+        if (background_image != NULL)
+        {
+            item_features.background_image = background_image;
+            item_features.has_background_image = true;
+        }
+        else
+        {
+            // the default background image is already set
+            item_features.has_background_image = state->ingest->has_default_background_image;
+        }
 
-                // read in the unselectable from the json object
-                // if there is no unselectable, set it to false
-                // if there is a unselectable, treat it as a boolean
-                if (json_object_get_boolean(features, "unselectable") == 1)
-                {
-                    state->items[i].features.unselectable = true;
-                    state->items[i].features.has_unselectable = true;
-                }
-                else if (json_object_get_boolean(features, "unselectable") == 0)
-                {
-                    state->items[i].features.unselectable = false;
-                    state->items[i].features.has_unselectable = true;
-                }
-                else
-                {
-                    state->items[i].features.unselectable = false;
-                    state->items[i].features.has_unselectable = false;
-                }
+        // read in the background_color from the input
+        // if there is no background_color, set it to ""
+        // if there is a background_color, treat it as a string
+        const char *background_color = input->background_color;
+        if (background_color != NULL)
+        {
+            item_features.background_color = background_color;
+            item_features.has_background_color = true;
+        }
+        else
+        {
+            // the default background color is already set
+            item_features.has_background_color = state->ingest->has_default_background_color;
+        }
 
-                // read in the is_header from the json object
-                // if there is no is_header, set it to false
-                // if there is a is_header, treat it as a boolean
-                // headers are not selectable, so this has to go last such that we can set the unselectable flag
-                if (json_object_get_boolean(features, "is_header") == 1)
-                {
-                    state->items[i].features.is_header = true;
-                    state->items[i].features.has_is_header = true;
-                    state->items[i].features.unselectable = true;
-                }
-                else if (json_object_get_boolean(features, "is_header") == 0)
+        // read in the can_disable from the input
+        // if there is no can_disable, set it to false
+        // if there is a can_disable, treat it as a boolean
+        if (input->can_disable == 1)
+        {
+            item_features.can_disable = true;
+            item_features.has_can_disable = true;
+        }
+        else if (input->can_disable == 0)
+        {
+            item_features.can_disable = false;
+            item_features.has_can_disable = true;
+        }
+        else
+        {
+            item_features.can_disable = false;
+            item_features.has_can_disable = false;
+        }
+
+        // read in the disabled from the input
+        // if there is no disabled, set it to false
+        // if there is an disabled, treat it as a boolean
+        if (input->disabled == 1)
+        {
+            item_features.disabled = true;
+            item_features.has_disabled = true;
+        }
+        else if (input->disabled == 0)
+        {
+            item_features.disabled = false;
+            item_features.has_disabled = true;
+            if (!item_features.can_disable)
+            {
+                char error_message[256];
+                snprintf(error_message, sizeof(error_message), "Item %s has no can_disable, but is disabled", item->name);
+                log_error(error_message);
+            }
+        }
+        else
+        {
+            item_features.disabled = false;
+            item_features.has_disabled = false;
+        }
+
+        // read in the draw_arrows from the input
+        // if there is no draw_arrows, set it to false
+        // if there is a draw_arrows, treat it as a boolean
+        if (input->draw_arrows == 1)
+        {
+            item_features.draw_arrows = true;
+            item_features.has_draw_arrows = true;
+        }
+        else if (input->draw_arrows == 0)
+        {
+            item_features.draw_arrows = false;
+            item_features.has_draw_arrows = true;
+        }
+        else
+        {
+            item_features.draw_arrows = false;
+            item_features.has_draw_arrows = false;
+        }
+
+        // read in the hide_action from the input
+        // if there is no hide_action, set it to false
+        // if there is a hide_action, treat it as a boolean
+        if (input->hide_action == 1)
+        {
+            item_features.hide_action = true;
+            item_features.has_hide_action = true;
+        }
+        else if (input->hide_action == 0)
+        {
+            item_features.hide_action = false;
+            item_features.has_hide_action = true;
+        }
+        else
+        {
+            item_features.hide_action = false;
+            item_features.has_hide_action = false;
+        }
+
+        // read in the hide_cancel from the input
+        // if there is no hide_cancel, set it to false
+        // if there is a hide_cancel, treat it as a boolean
+        if (input->hide_cancel == 1)
+        {
+            item_features.hide_cancel = true;
+            item_features.has_hide_cancel = true;
+        }
+        else if (input->hide_cancel == 0)
+        {
+            item_features.hide_cancel = false;
+            item_features.has_hide_cancel = true;
+        }
+        else
+        {
+            item_features.hide_cancel = false;
+            item_features.has_hide_cancel = false;
+        }
+
+        // read in the hide_confirm from the input
+        // if there is no hide_confirm, set it to false
+        // if there is a hide_confirm, treat it as a boolean
+        if (input->hide_confirm == 1)
+        {
+            item_features.hide_confirm = true;
+            item_features.has_hide_confirm = true;
+        }
+        else if (input->hide_confirm == 0)
+        {
+            item_features.hide_confirm = false;
+            item_features.has_hide_confirm = true;
+        }
+        else
+        {
+            item_features.hide_confirm = false;
+            item_features.has_hide_confirm = false;
+        }
+
+        // read in the unselectable from the input
+        // if there is no unselectable, set it to false
+        // if there is a unselectable, treat it as a boolean
+        if (input->unselectable == 1)
+        {
+            item_features.unselectable = true;
+            item_features.has_unselectable = true;
+        }
+        else if (input->unselectable == 0)
+        {
+            item_features.unselectable = false;
+            item_features.has_unselectable = true;
+        }
+        else
+        {
+            item_features.unselectable = false;
+            item_features.has_unselectable = false;
+        }
+
+        // read in the is_header from the input
+        // if there is no is_header, set it to false
+        // if there is a is_header, treat it as a boolean
+        // headers are not selectable, so this has to go last such that we can set the unselectable flag
+        if (input->is_header == 1)
+        {
+            item_features.is_header = true;
+            item_features.has_is_header = true;
+            item_features.unselectable = true;
+        }
+        else if (input->is_header == 0)
+        {
+            item_features.is_header = false;
+            item_features.has_is_header = true;
+        }
+        else
+        {
+            item_features.is_header = false;
+            item_features.has_is_header = false;
+        }
+
+        // read in the alignment from the input
+        // if there is no alignment, set it to 'left'
+        // if there is a alignment, it should be 'left', 'center', or 'right'
+        const char *alignment = input->alignment;
+        if (alignment != NULL)
+        {
+            if (strcmp(alignment, "left") == 0 || strcmp(alignment, "center") == 0 || strcmp(alignment, "right") == 0)
+            {
+                item_features.alignment = alignment;
+                item_features.has_alignment = true;
+            }
+            else
+            {
+                char error_message[256];
+                snprintf(error_message, sizeof(error_message), "Item %s has invalid alignment %s. Must be 'left', 'center', or 'right'. Using default (left).", item->name, alignment);
+                log_error(error_message);
+                item_features.alignment = "left";
+                item_features.has_alignment = false;
+            }
+        }
+        else
+        {
+            item_features.alignment = "left";
+            item_features.has_alignment = false;
+        }
+
+        // read in the alignment from the input
+        // if there is no alignment, set it to 'left'
+        // if there is a alignment, it should be 'left', 'center', or 'right'
+        const char *confirm_text = input->confirm_text;
+        if (confirm_text != NULL)
+        {
+            if (strlen(confirm_text) > 0)
+            {
+                item_features.confirm_text = confirm_text;
+                item_features.has_confirm_text = true;
+            }
+        }
+    }
+    else
+    {
+        item_features.has_background_image = state->ingest->has_default_background_image;
+        item_features.has_background_color = state->ingest->has_default_background_color;
+    }
+
+    // copies the strings out of the input, which is overwritten by the next item
+    item->features = ListPool_InternFeatures(&state->pool, &item_features);
+    state->item_count++;
+}
+
+
+
+// ListState_EndIngest closes the JSON input
+void ListState_EndIngest(struct ListState *state)
+{
+    struct ListIngest *ingest = state->ingest;
+    if (ingest->owns_fd)
+    {
+        close(ingest->stream.fd);
+    }
+    JsonStream_close(&ingest->stream);
+    free(ingest->options);
+    free(ingest);
+    state->ingest = NULL;
+}
+
+// ListState_FailIngest logs why the JSON input couldn't be read and closes it
+bool ListState_FailIngest(struct ListState *state)
+{
+    const char *error = state->ingest->stream.error;
+    char error_message[256];
+    snprintf(error_message, sizeof(error_message), "Failed to parse JSON file: %s", error != NULL ? error : "out of memory");
+    log_error(error_message);
+    ListState_EndIngest(state);
+    return false;
+}
+
+// ListState_Ingest reads up to max_items more items from the JSON input
+//
+// With wait set, blocks until the items were read or the input ended.
+// Otherwise stops early rather than wait on a slow writer, so it can be
+// called once per frame. Returns false if the input is invalid.
+bool ListState_Ingest(struct ListState *state, size_t max_items, bool wait)
+{
+    size_t added = 0;
+    while (state->ingest != NULL && added < max_items)
+    {
+        struct ListIngest *ingest = state->ingest;
+        JsonStream *stream = &ingest->stream;
+        if (!wait && !JsonStream_ready(stream))
+        {
+            break;
+        }
+
+        JsonStream_Token token = JsonStream_next(stream);
+        if (token == JSON_STREAM_ERROR)
+        {
+            return ListState_FailIngest(state);
+        }
+        if (token == JSON_STREAM_END)
+        {
+            ListState_EndIngest(state);
+            break;
+        }
+
+        if (ingest->in_items && token != JSON_STREAM_ARRAY_END)
+        {
+            if (state->item_count == state->item_capacity)
+            {
+                size_t capacity = state->item_capacity > 0 ? state->item_capacity * 2 : 64;
+                struct ListItem *items = realloc(state->items, sizeof(struct ListItem) * capacity);
+                if (items == NULL)
                 {
-                    state->items[i].features.is_header = false;
-                    state->items[i].features.has_is_header = true;
+                    return ListState_FailIngest(state);
                 }
-                else
+                state->items = items;
+                state->item_capacity = capacity;
+            }
+
+            if (strlen(ingest->item_key) == 0)
+            {
+                struct ListItem *item = &state->items[state->item_count++];
+                item->name = token == JSON_STREAM_STRING ? ListPool_CopyString(&state->pool, stream->string, stream->string_length) : NULL;
+                if (item->name == NULL)
                 {
-                    state->items[i].features.is_header = false;
-                    state->items[i].features.has_is_header = false;
+                    item->name = "";
                 }
 
-                // read in the alignment from the json object
-                // if there is no alignment, set it to 'left'
-                // if there is a alignment, it should be 'left', 'center', or 'right'
-                const char *alignment = json_object_get_string(features, "alignment");
-                if (alignment != NULL)
+                // set defaults for the other fields
+                item->has_features = false;
+                item->has_options = false;
+                item->has_selected = false;
+                item->option_count = 0;
+                item->options = NULL;
+                item->selected = 0;
+                item->initial_selected = 0;
+                item->features = ingest->string_features;
+                if (JsonStream_skip(stream, token) != 0)
                 {
-                    if (strcmp(alignment, "left") == 0 || strcmp(alignment, "center") == 0 || strcmp(alignment, "right") == 0)
-                    {
-                        strncpy(state->items[i].features.alignment, alignment, sizeof(state->items[i].features.alignment) - 1);
-                        state->items[i].features.has_alignment = true;
-                    }
-                    else
-                    {
-                        char error_message[256];
-                        snprintf(error_message, sizeof(error_message), "Item %s has invalid alignment %s. Must be 'left', 'center', or 'right'. Using default (left).", state->items[i].name, alignment);
-                        log_error(error_message);
-                        strncpy(state->items[i].features.alignment, "left", sizeof(state->items[i].features.alignment) - 1);
-                        state->items[i].features.has_alignment = false;
-                    }
+                    return ListState_FailIngest(state);
                 }
-                else
+            }
+            else
+            {
+                struct ListItemInput input;
+                if (!list_ingest_read_item(state, token, &input))
                 {
-                    strncpy(state->items[i].features.alignment, "left", sizeof(state->items[i].features.alignment) - 1);
-                    state->items[i].features.has_alignment = false;
+                    return ListState_FailIngest(state);
                 }
+                ListState_AddItem(state, &input);
+            }
+            added++;
+            continue;
+        }
+
+        // outside of the items array, look for it and skip everything else
+        bool at_item_key = ingest->at_item_key;
+        ingest->at_item_key = false;
+        if (token == JSON_STREAM_KEY)
+        {
+            ingest->at_item_key = strcmp(stream->string, ingest->item_key) == 0;
+        }
+        else if (token == JSON_STREAM_ARRAY_BEGIN && (strlen(ingest->item_key) == 0 ? stream->depth == 1 : at_item_key))
+        {
+            ingest->in_items = true;
+        }
+        else if (token == JSON_STREAM_ARRAY_END)
+        {
+            ingest->in_items = false;
+        }
+        else if (token == JSON_STREAM_OBJECT_BEGIN && stream->depth == 1 && strlen(ingest->item_key) > 0)
+        {
+            // the root object holding the items array
+        }
+        else if (token != JSON_STREAM_OBJECT_END && JsonStream_skip(stream, token) != 0)
+        {
+            return ListState_FailIngest(state);
+        }
+
+        // a script may keep its output open after the document,
+        // so stop at the end of the root value instead of waiting for more
+        if (stream->depth == 0)
+        {
+            ListState_EndIngest(state);
+        }
+    }
+
+    // fill the rows that were left empty while the items were missing
+    int rows_end = state->first_visible + state->visible_rows;
+    if (state->last_visible < rows_end)
+    {
+        state->last_visible = (state->item_count < rows_end) ? state->item_count : rows_end;
+    }
+    return true;
+}
+
+// ListState_New creates a new ListState from a JSON file
+//
+// Returns NULL on failure, setting app_state->exit_code to
+// ExitCodeParseError if the input is invalid.
+struct ListState *ListState_New(const char *filename, const char *format, const char *item_key, const char *title, const char *confirm_text, const char *default_background_image, const char *default_background_color, bool show_hardware_group, struct AppState *app_state)
+{
+    struct ListState *state = calloc(1, sizeof(struct ListState));
+
+    int max_row_count = ui.row_count;
+    if (strlen(title) > 0)
+    {
+        max_row_count -= 1;
+    }
+    if (show_hardware_group)
+    {
+        max_row_count -= 1;
+    }
+
+    // the features every item starts from, items without a features
+    // object of their own all share the interned copy of this record
+    struct ListItemFeature default_features = {
+        .background_color = "",
+        .background_image = "",
+        .confirm_text = confirm_text,
+        .alignment = "left",
+    };
+    if (default_background_image != NULL)
+    {
+        default_features.background_image = default_background_image;
+    }
+    if (default_background_color != NULL)
+    {
+        default_features.background_color = default_background_color;
+    }
+
+    if (strcmp(format, "text") == 0)
+    {
+        char *contents = NULL;
+        if (strcmp(filename, "-") == 0)
+        {
+            contents = read_stdin();
+        }
+        else
+        {
+            contents = read_file(filename);
+        }
+
+        if (contents == NULL)
+        {
+            log_error("Failed to read file or stdin");
+            free(state);
+            return NULL;
+        }
+
+        // Count number of non-empty lines
+        size_t item_count = 0;
+        char *line_start = contents;
+        while (*line_start != '\0')
+        {
+            char *line_end = strchr(line_start, '\n');
+            if (!line_end)
+            {
+                line_end = line_start + strlen(line_start);
+            }
+
+            // Check if line has non-whitespace content
+            char *p;
+            for (p = line_start; p < line_end && isspace(*p); p++)
+                ;
+            if (p < line_end)
+            {
+                item_count++;
+            }
+
+            if (*line_end == '\0')
+            {
+                break;
+            }
+            line_start = line_end + 1;
+        }
+
+        // Allocate array for items
+        state->items = malloc(sizeof(struct ListItem) * (item_count > 0 ? item_count : 1));
+        state->item_count = item_count;
+        state->last_visible = (item_count < max_row_count) ? item_count : max_row_count;
+        state->first_visible = 0;
+        state->selected = 0;
+
+        // Add non-empty lines to items array
+        // an empty list keeps a blank item for the selected index to point at
+        const struct ListItemFeature *features = ListPool_InternFeatures(&state->pool, &default_features);
+        state->items[0] = (struct ListItem){.name = "", .features = features};
+        size_t item_index = 0;
+        line_start = contents;
+        while (*line_start != '\0')
+        {
+            char *line_end = strchr(line_start, '\n');
+            if (!line_end)
+            {
+                line_end = line_start + strlen(line_start);
+            }
+
+            // Check if line has non-whitespace content
+            char *p;
+            for (p = line_start; p < line_end && isspace(*p); p++)
+                ;
+            if (p < line_end)
+            {
+                state->items[item_index].name = ListPool_CopyString(&state->pool, line_start, line_end - line_start);
+                state->items[item_index].has_features = false;
+                state->items[item_index].has_options = false;
+                state->items[item_index].has_selected = false;
+                state->items[item_index].option_count = 0;
+                state->items[item_index].options = NULL;
+                state->items[item_index].selected = 0;
+                state->items[item_index].initial_selected = 0;
+                state->items[item_index].features = features;
+
+                item_index++;
+            }
+
+            if (*line_end == '\0')
+            {
+                break;
+            }
+            line_start = line_end + 1;
+        }
+
+        free(contents);
+        return state;
+    }
+
+    state->ingest = calloc(1, sizeof(struct ListIngest));
+    if (state->ingest == NULL)
+    {
+        log_error("Failed to allocate memory for JSON input");
+        free(state);
+        return NULL;
+    }
+
+    int fd = STDIN_FILENO;
+    if (strcmp(filename, "-") != 0)
+    {
+        fd = open(filename, O_RDONLY);
+        if (fd < 0)
+        {
+            log_error("Failed to parse JSON file");
+            free(state->ingest);
+            free(state);
+            return NULL;
+        }
+        state->ingest->owns_fd = true;
+    }
+
+    JsonStream_open(&state->ingest->stream, fd);
+    snprintf(state->ingest->item_key, sizeof(state->ingest->item_key), "%s", item_key);
+    state->ingest->default_features = default_features;
+    state->ingest->has_default_background_image = default_background_image != NULL;
+    state->ingest->has_default_background_color = default_background_color != NULL;
+    state->ingest->string_features = ListPool_InternFeatures(&state->pool, &default_features);
+    state->has_options = false;
+
+    // an empty list keeps a blank item for the selected index to point at
+    state->item_capacity = 64;
+    state->items = malloc(sizeof(struct ListItem) * state->item_capacity);
+    if (state->items == NULL)
+    {
+        log_error("Failed to allocate memory for items");
+        ListState_EndIngest(state);
+        free(state);
+        return NULL;
+    }
+    state->items[0] = (struct ListItem){.name = "", .features = state->ingest->string_features};
+
+    // only the first screen of items is read before the list is shown,
+    // the rest is read a batch per frame by the main loop
+    if (!ListState_Ingest(state, max_row_count, true))
+    {
+        app_state->exit_code = ExitCodeParseError;
+        free(state->items);
+        free(state);
+        return NULL;
+    }
+
+    state->selected = 0;
+
+    if (!show_hardware_group && state->item_count > 0 && has_left_button_group(app_state, state))
+    {
+        max_row_count -= 1;
+    }
+
+    state->first_visible = 0;
+    state->last_visible = (state->item_count < max_row_count) ? state->item_count : max_row_count;
+    state->visible_rows = max_row_count;
+
+    return state;
+}
+
+// filter_keyboard_layout is the filter keyboard, laid out like minui-keyboard's
+// matching ignores case and accents, so there is no shift layout
+const char *filter_keyboard_layout[FILTER_KEYBOARD_ROWS][FILTER_KEYBOARD_COLUMNS] = {
+    {"1", "2", "3", "4", "5", "6", "7", "8", "9", "0", "-"},
+    {"q", "w", "e", "r", "t", "y", "u", "i", "o", "p", "&"},
+    {"a", "s", "d", "f", "g", "h", "j", "k", "l", "'"},
+    {"z", "x", "c", "v", "b", "n", "m", ",", ".", "!"},
+    {"space", "clear", "done"}};
+
+// filter_keyboard_row_length returns the number of keys in a row of the filter keyboard
+int filter_keyboard_row_length(int row)
+{
+    int length = 0;
+    while (length < FILTER_KEYBOARD_COLUMNS && filter_keyboard_layout[row][length] != NULL)
+    {
+        length++;
+    }
+    return length;
+}
+
+// ListState_ShowSelected scrolls a list so that its selected item is visible
+void ListState_ShowSelected(struct ListState *state)
+{
+    int rows = state->visible_rows;
+    if (state->selected < state->first_visible || state->selected >= state->first_visible + rows)
+    {
+        state->first_visible = state->selected;
+    }
+    if (state->first_visible > (int)state->item_count - rows)
+    {
+        state->first_visible = (int)state->item_count - rows;
+    }
+    if (state->first_visible < 0)
+    {
+        state->first_visible = 0;
+    }
+    state->last_visible = ((int)state->item_count < state->first_visible + rows) ? (int)state->item_count : state->first_visible + rows;
+}
+
+// filter_restore shows the full list again, with the changes made to the matching items
+void filter_restore(struct AppState *state)
+{
+    struct FilterState *filter = &state->filter;
+    if (filter->full_list == NULL)
+    {
+        return;
+    }
+
+    struct ListState *full_list = filter->full_list;
+    for (size_t i = 0; i < filter->matches.item_count; i++)
+    {
+        full_list->items[filter->origin[i]].selected = filter->matches.items[i].selected;
+        full_list->items[filter->origin[i]].features = filter->matches.items[i].features;
+    }
+    full_list->selected = filter->origin[filter->matches.selected];
+    ListState_ShowSelected(full_list);
+
+    state->list_state = full_list;
+    filter->full_list = NULL;
+}
+
+// filter_show shows the items matching the filter query, or every item if the query is empty
+void filter_show(struct AppState *state)
+{
+    struct FilterState *filter = &state->filter;
+    filter_restore(state);
+    if (filter->query[0] == '\0')
+    {
+        return;
+    }
+
+    struct ListState *full_list = state->list_state;
+    size_t count = ListFilter_apply(&filter->index, filter->query);
+    if (count == 0)
+    {
+        return;
+    }
+    if (count > filter->capacity)
+    {
+        // the full list is complete once indexed, so this happens once
+        struct ListItem *items = realloc(filter->matches.items, sizeof(struct ListItem) * full_list->item_count);
+        if (items != NULL)
+        {
+            filter->matches.items = items;
+        }
+        size_t *origin = realloc(filter->origin, sizeof(size_t) * full_list->item_count);
+        if (origin != NULL)
+        {
+            filter->origin = origin;
+        }
+        if (items == NULL || origin == NULL)
+        {
+            log_error("Failed to allocate memory for the filtered items");
+            return;
+        }
+        filter->capacity = full_list->item_count;
+    }
+
+    // keep the selected item selected if it matches
+    struct ListState *matches = &filter->matches;
+    matches->selected = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t index = filter->index.matches[i];
+        matches->items[i] = full_list->items[index];
+        filter->origin[i] = index;
+        if ((int)index == full_list->selected)
+        {
+            matches->selected = i;
+        }
+    }
+    matches->item_count = count;
+    matches->item_capacity = filter->capacity;
+    matches->has_options = full_list->has_options;
+    matches->visible_rows = full_list->visible_rows;
+    if (strlen(state->title) == 0)
+    {
+        // the query takes the title row
+        matches->visible_rows -= 1;
+    }
+    matches->first_visible = 0;
+    ListState_ShowSelected(matches);
 
-                // read in the alignment from the json object
-                // if there is no alignment, set it to 'left'
-                // if there is a alignment, it should be 'left', 'center', or 'right'
-                const char *confirm_text = json_object_get_string(features, "confirm_text");
-                if (confirm_text != NULL)
-                {
-                    if (strlen(confirm_text) > 0)
-                    {
-                        strncpy(state->items[i].features.confirm_text, confirm_text, sizeof(state->items[i].features.confirm_text) - 1);
-                        state->items[i].features.has_confirm_text = true;
-                    }
-                }
-            }
-            else
-            {
-                if (default_background_image != NULL)
-                {
-                    strncpy(state->items[i].features.background_image, default_background_image, sizeof(state->items[i].features.background_image) - 1);
-                    if (access(default_background_image, F_OK) != -1)
-                    {
-                        state->items[i].features.background_image_exists = true;
-                    }
-                    state->items[i].features.has_background_image = true;
-                }
-                else
-                {
-                    state->items[i].features.has_background_image = false;
-                }
+    filter->full_list = full_list;
+    state->list_state = matches;
+}
 
-                if (default_background_color != NULL)
-                {
-                    strncpy(state->items[i].features.background_color, default_background_color, sizeof(state->items[i].features.background_color) - 1);
-                    state->items[i].features.has_background_color = true;
-                }
-                else
-                {
-                    state->items[i].features.has_background_color = false;
-                }
+// filter_open shows the filter keyboard
+//
+// Every item is read and indexed the first time, so typing only has to
+// scan the index. Returns false if the rest of the input is invalid.
+bool filter_open(struct AppState *state)
+{
+    struct FilterState *filter = &state->filter;
+    if (!filter->indexed)
+    {
+        struct ListState *full_list = state->list_state;
+        if (!ListState_Ingest(full_list, SIZE_MAX, true))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < full_list->item_count; i++)
+        {
+            const struct ListItem *item = &full_list->items[i];
+            bool selectable = !item->features->is_header && !item->features->unselectable;
+            if (ListFilter_add(&filter->index, selectable ? item->name : NULL) != 0)
+            {
+                log_error("Failed to allocate memory for the filter");
+                ListFilter_free(&filter->index);
+                return true;
             }
         }
+        filter->indexed = true;
     }
 
-    state->selected = 0;
+    strncpy(filter->initial_query, filter->query, sizeof(filter->initial_query) - 1);
+    ListFilter_apply(&filter->index, filter->query);
+    filter->editing = true;
+    return true;
+}
 
-    if (!show_hardware_group && has_left_button_group(app_state, state))
+// filter_close hides the filter keyboard, showing the matching items if apply is set
+void filter_close(struct AppState *state, bool apply)
+{
+    struct FilterState *filter = &state->filter;
+    if (!apply)
     {
-        max_row_count -= 1;
+        strncpy(filter->query, filter->initial_query, sizeof(filter->query) - 1);
+        filter->editing = false;
+        return;
     }
 
-    state->first_visible = 0;
-    state->last_visible = (item_count < max_row_count) ? item_count : max_row_count;
-    state->item_count = item_count;
+    // a query without matches would leave nothing to show
+    if (filter->query[0] != '\0' && filter->index.match_count == 0)
+    {
+        return;
+    }
+    filter->editing = false;
+    filter_show(state);
+}
 
-    json_value_free(root_value);
-    return state;
+// filter_button_released tells whether the filter button was just released
+bool filter_button_released(struct AppState *state)
+{
+    if (strcmp(state->filter_button, "SELECT") == 0)
+    {
+        return PAD_justReleased(BTN_SELECT);
+    }
+    if (strcmp(state->filter_button, "START") == 0)
+    {
+        return PAD_justReleased(BTN_START);
+    }
+    return false;
+}
+
+// handle_filter_input interprets input events while the filter keyboard is shown
+void handle_filter_input(struct AppState *state)
+{
+    struct FilterState *filter = &state->filter;
+
+    // redraw unless a key was not pressed
+    state->redraw = 1;
+
+    int row_length = filter_keyboard_row_length(filter->row);
+    size_t query_length = strlen(filter->query);
+    bool query_changed = false;
+    if (PAD_justReleased(BTN_MENU))
+    {
+        state->redraw = 0;
+        state->quitting = 1;
+        state->exit_code = ExitCodeMenuButton;
+        return;
+    }
+    else if (PAD_justRepeated(BTN_UP) || PAD_justRepeated(BTN_DOWN))
+    {
+        // keep the cursor about as far along the row, rows have different lengths
+        int step = PAD_justRepeated(BTN_UP) ? FILTER_KEYBOARD_ROWS - 1 : 1;
+        filter->row = (filter->row + step) % FILTER_KEYBOARD_ROWS;
+        int next_row_length = filter_keyboard_row_length(filter->row);
+        filter->col = (filter->col * next_row_length + row_length / 2) / row_length;
+        if (filter->col >= next_row_length)
+        {
+            filter->col = next_row_length - 1;
+        }
+    }
+    else if (PAD_justRepeated(BTN_LEFT))
+    {
+        filter->col = (filter->col + row_length - 1) % row_length;
+    }
+    else if (PAD_justRepeated(BTN_RIGHT))
+    {
+        filter->col = (filter->col + 1) % row_length;
+    }
+    else if (PAD_justReleased(BTN_A))
+    {
+        const char *key = filter_keyboard_layout[filter->row][filter->col];
+        if (strcmp(key, "done") == 0)
+        {
+            filter_close(state, true);
+        }
+        else if (strcmp(key, "clear") == 0)
+        {
+            filter->query[0] = '\0';
+            query_changed = true;
+        }
+        else
+        {
+            const char *text = strcmp(key, "space") == 0 ? " " : key;
+            if (query_length + strlen(text) < sizeof(filter->query))
+            {
+                strcat(filter->query, text);
+                query_changed = true;
+            }
+        }
+    }
+    else if (PAD_justReleased(BTN_B))
+    {
+        if (query_length > 0)
+        {
+            filter->query[query_length - 1] = '\0';
+            query_changed = true;
+        }
+    }
+    else if (PAD_justReleased(BTN_X) || filter_button_released(state))
+    {
+        filter_close(state, true);
+    }
+    else if (PAD_justReleased(BTN_Y))
+    {
+        filter_close(state, false);
+    }
+    else
+    {
+        // do not redraw if no key was pressed
+        state->redraw = 0;
+    }
+
+    // each key narrows (or widens) the matches right away, for the count
+    if (query_changed)
+    {
+        ListFilter_apply(&filter->index, filter->query);
+    }
 }
 
 // handle_input interprets input events and mutates app state
@@ -971,20 +1794,40 @@ void handle_input(struct AppState *state)
     // do not redraw by default
     state->redraw = 0;
 
-    if (!state->list_state->items[state->list_state->selected].features.background_image_exists && state->list_state->items[state->list_state->selected].features.background_image != NULL)
+    PAD_poll();
+
+    if (state->filter.editing)
+    {
+        handle_filter_input(state);
+        return;
+    }
+
+    if (filter_button_released(state))
     {
-        if (access(state->list_state->items[state->list_state->selected].features.background_image, F_OK) != -1)
+        if (!filter_open(state))
         {
-            state->list_state->items[state->list_state->selected].features.background_image_exists = true;
-            state->redraw = 1;
+            state->quitting = 1;
+            state->exit_code = ExitCodeParseError;
+            return;
         }
+        state->redraw = 1;
+        return;
     }
 
-    PAD_poll();
+    // moving around needs to know where the list ends
+    if (state->list_state->ingest != NULL && (PAD_justRepeated(BTN_UP) || PAD_justRepeated(BTN_DOWN) || PAD_justRepeated(BTN_LEFT) || PAD_justRepeated(BTN_RIGHT)))
+    {
+        if (!ListState_Ingest(state->list_state, SIZE_MAX, true))
+        {
+            state->quitting = 1;
+            state->exit_code = ExitCodeParseError;
+            return;
+        }
+    }
 
     // discount the title from the max row count
     int max_row_count = ui.row_count;
-    if (strlen(state->title) > 0)
+    if (has_title_row(state))
     {
         max_row_count -= 1;
     }
@@ -1070,7 +1913,7 @@ void handle_input(struct AppState *state)
         }
     }
 
-    if (is_action_button_pressed && !state->list_state->items[state->list_state->selected].features.hide_action)
+    if (is_action_button_pressed && !state->list_state->items[state->list_state->selected].features->hide_action)
     {
         state->redraw = 0;
         state->quitting = 1;
@@ -1078,7 +1921,16 @@ void handle_input(struct AppState *state)
         return;
     }
 
-    if (is_cancel_button_pressed && !state->list_state->items[state->list_state->selected].features.hide_cancel)
+    // cancelling a filtered list goes back to the full list
+    if (is_cancel_button_pressed && state->filter.full_list != NULL)
+    {
+        state->filter.query[0] = '\0';
+        filter_show(state);
+        state->redraw = 1;
+        return;
+    }
+
+    if (is_cancel_button_pressed && !state->list_state->items[state->list_state->selected].features->hide_cancel)
     {
         state->redraw = 0;
         state->quitting = 1;
@@ -1092,7 +1944,7 @@ void handle_input(struct AppState *state)
         force_hide_confirm = true;
     }
 
-    if (state->list_state->items[state->list_state->selected].features.hide_confirm)
+    if (state->list_state->items[state->list_state->selected].features->hide_confirm)
     {
         force_hide_confirm = true;
     }
@@ -1108,10 +1960,15 @@ void handle_input(struct AppState *state)
     // if the enable button is pressed, toggle the enabled state of the currently selected item
     if (is_enable_button_pressed)
     {
-        if (state->list_state->items[state->list_state->selected].features.can_disable)
+        if (state->list_state->items[state->list_state->selected].features->can_disable)
         {
             state->redraw = 1;
-            state->list_state->items[state->list_state->selected].features.disabled = !state->list_state->items[state->list_state->selected].features.disabled;
+            // feature records are shared, so switch the item to one with the toggled state
+            struct ListItemFeature features = *state->list_state->items[state->list_state->selected].features;
+            features.disabled = !features.disabled;
+            // the full list owns the records, also while a filter shows copies of its items
+            struct ListState *owner = state->filter.full_list != NULL ? state->filter.full_list : state->list_state;
+            state->list_state->items[state->list_state->selected].features = ListPool_InternFeatures(&owner->pool, &features);
         }
         return;
     }
@@ -1133,7 +1990,7 @@ void handle_input(struct AppState *state)
         else
         {
             state->list_state->selected -= 1;
-            while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+            while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
             {
                 state->list_state->selected -= 1;
                 if (state->list_state->selected < 0)
@@ -1145,7 +2002,7 @@ void handle_input(struct AppState *state)
             if (state->list_state->selected < 0)
             {
                 state->list_state->selected = state->list_state->item_count - 1;
-                while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+                while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
                 {
                     state->list_state->selected -= 1;
                 }
@@ -1171,7 +2028,7 @@ void handle_input(struct AppState *state)
         else
         {
             state->list_state->selected += 1;
-            while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+            while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
             {
                 state->list_state->selected += 1;
                 if (state->list_state->selected >= state->list_state->item_count)
@@ -1183,7 +2040,7 @@ void handle_input(struct AppState *state)
             if (state->list_state->selected >= state->list_state->item_count)
             {
                 state->list_state->selected = 0;
-                while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+                while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
                 {
                     state->list_state->selected += 1;
                 }
@@ -1204,7 +2061,7 @@ void handle_input(struct AppState *state)
         // if the state has options, cycle through the options
         if (state->list_state->has_options)
         {
-            if (!state->list_state->items[state->list_state->selected].features.disabled)
+            if (!state->list_state->items[state->list_state->selected].features->disabled)
             {
                 state->list_state->items[state->list_state->selected].selected -= 1;
                 if (state->list_state->items[state->list_state->selected].selected < 0)
@@ -1221,7 +2078,7 @@ void handle_input(struct AppState *state)
                 state->list_state->selected = 0;
             }
 
-            while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+            while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
             {
                 state->list_state->selected -= 1;
                 if (state->list_state->selected < 0)
@@ -1233,7 +2090,7 @@ void handle_input(struct AppState *state)
 
             if (state->list_state->selected == 0)
             {
-                while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+                while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
                 {
                     state->list_state->selected += 1;
                     if (state->list_state->selected >= state->list_state->item_count)
@@ -1267,7 +2124,7 @@ void handle_input(struct AppState *state)
         // if the state has options, cycle through the options
         if (state->list_state->has_options)
         {
-            if (!state->list_state->items[state->list_state->selected].features.disabled)
+            if (!state->list_state->items[state->list_state->selected].features->disabled)
             {
                 state->list_state->items[state->list_state->selected].selected += 1;
                 if (state->list_state->items[state->list_state->selected].selected >= state->list_state->items[state->list_state->selected].option_count)
@@ -1279,7 +2136,7 @@ void handle_input(struct AppState *state)
         else
         {
             state->list_state->selected += max_row_count;
-            while (state->list_state->items[state->list_state->selected].features.is_header || state->list_state->items[state->list_state->selected].features.unselectable)
+            while (state->list_state->items[state->list_state->selected].features->is_header || state->list_state->items[state->list_state->selected].features->unselectable)
             {
                 state->list_state->selected += 1;
             }
@@ -1400,80 +2257,260 @@ SDL_Surface *scale_surface(SDL_Surface *surface,
     return scaled;
 }
 
+// load_background_image decodes an image and scales it to the size it is drawn at
+//
+// Runs on the image cache's worker thread, so scrolling through a list
+// doesn't wait for PNGs to decode, and redraws only have to blit.
+void *load_background_image(const char *path, void *userdata)
+{
+    SDL_Surface *surface = IMG_Load(path);
+    if (surface == NULL)
+    {
+        return NULL;
+    }
+
+    int imgW = surface->w, imgH = surface->h;
+    if (imgW == FIXED_WIDTH && imgH == FIXED_HEIGHT)
+    {
+        return surface;
+    }
+
+    // Compute scale factor
+    float scaleX = (float)(FIXED_WIDTH - 2 * DP(ui.edge_padding)) / imgW;
+    float scaleY = (float)(FIXED_HEIGHT - 2 * DP(ui.edge_padding)) / imgH;
+    float scale = (scaleX < scaleY) ? scaleX : scaleY;
+
+    // Ensure upscaling only when the image is smaller than the screen
+    if (imgW * scale < FIXED_WIDTH - 2 * DP(ui.edge_padding) && imgH * scale < FIXED_HEIGHT - 2 * DP(ui.edge_padding))
+    {
+        scale = (scaleX > scaleY) ? scaleX : scaleY;
+    }
+
+    // Compute target dimensions
+    int dstW = imgW * scale;
+    int dstH = imgH * scale;
+    if (dstW == imgW && dstH == imgH)
+    {
+        return surface;
+    }
+
+#ifdef USE_SDL2
+    // scale in 32-bit, which keeps the alpha channel and handles paletted images
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surface);
+    if (converted == NULL)
+    {
+        return NULL;
+    }
+    SDL_Surface *scaled = SDL_CreateRGBSurface(0, dstW, dstH, 32, converted->format->Rmask, converted->format->Gmask, converted->format->Bmask, converted->format->Amask);
+    if (scaled != NULL)
+    {
+        // copy the pixels as they are, they are blended when drawn
+        SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(converted, NULL, scaled, NULL);
+    }
+    SDL_FreeSurface(converted);
+#else
+    SDL_Surface *scaled = scale_surface(surface, dstW, dstH);
+    SDL_FreeSurface(surface);
+#endif
+    return scaled;
+}
+
+// free_background_image frees an image returned by load_background_image
+void free_background_image(void *image)
+{
+    SDL_FreeSurface(image);
+}
+
+// selected_background_image returns the selected item's background image, NULL if it has none
+const char *selected_background_image(struct AppState *state)
+{
+    const char *background_image = state->list_state->items[state->list_state->selected].features->background_image;
+    if (background_image == NULL || background_image[0] == '\0')
+    {
+        return NULL;
+    }
+    return background_image;
+}
+
+// background_image_state returns the IMAGE_* state of the selected item's background image
+int background_image_state(struct AppState *state)
+{
+    const char *background_image = selected_background_image(state);
+    if (background_image == NULL || !state->background_images.running)
+    {
+        return IMAGE_MISSING;
+    }
+    return ImageCache_request(&state->background_images, background_image, NULL);
+}
+
+// prefetch_background_image starts decoding an item's background image
+void prefetch_background_image(struct AppState *state, int index)
+{
+    if (index < 0 || (size_t)index >= state->list_state->item_count)
+    {
+        return;
+    }
+
+    const char *background_image = state->list_state->items[index].features->background_image;
+    if (background_image != NULL && background_image[0] != '\0')
+    {
+        ImageCache_request(&state->background_images, background_image, NULL);
+    }
+}
+
 // draw_background draws the background of the list
 bool draw_background(SDL_Surface *screen, struct AppState *state)
 {
     // render a background color
     char hex_color[1024] = "#000000";
-    if (state->list_state->items[state->list_state->selected].features.background_color != NULL)
+    if (state->list_state->items[state->list_state->selected].features->background_color != NULL)
     {
-        strncpy(hex_color, state->list_state->items[state->list_state->selected].features.background_color, sizeof(hex_color));
+        strncpy(hex_color, state->list_state->items[state->list_state->selected].features->background_color, sizeof(hex_color));
     }
 
     SDL_Color background_color = hex_to_sdl_color(hex_color);
     uint32_t color = SDL_MapRGBA(screen->format, background_color.r, background_color.g, background_color.b, 255);
     SDL_FillRect(screen, NULL, color);
 
+    // the image is only drawn once it has been decoded, and already has its final size
     bool should_draw_background_image = false;
-    if (state->list_state->items[state->list_state->selected].features.background_image_exists && access(state->list_state->items[state->list_state->selected].features.background_image, F_OK) != -1)
+    const char *background_image = selected_background_image(state);
+    SDL_Surface *surface = NULL;
+    if (background_image != NULL && ImageCache_request(&state->background_images, background_image, (void **)&surface) == IMAGE_READY)
     {
+        SDL_Rect dstRect = {(FIXED_WIDTH - surface->w) / 2, (FIXED_HEIGHT - surface->h) / 2, surface->w, surface->h};
+        SDL_BlitSurface(surface, NULL, screen, &dstRect);
         should_draw_background_image = true;
     }
 
-    // check if there is an image and it is accessible
-    if (should_draw_background_image)
-    {
-        SDL_Surface *surface = IMG_Load(state->list_state->items[state->list_state->selected].features.background_image);
-        if (surface)
-        {
-            int imgW = surface->w, imgH = surface->h;
-
-            // Compute scale factor
-            float scaleX = (float)(FIXED_WIDTH - 2 * DP(ui.edge_padding)) / imgW;
-            float scaleY = (float)(FIXED_HEIGHT - 2 * DP(ui.edge_padding)) / imgH;
-            float scale = (scaleX < scaleY) ? scaleX : scaleY;
-
-            // Ensure upscaling only when the image is smaller than the screen
-            if (imgW * scale < FIXED_WIDTH - 2 * DP(ui.edge_padding) && imgH * scale < FIXED_HEIGHT - 2 * DP(ui.edge_padding))
-            {
-                scale = (scaleX > scaleY) ? scaleX : scaleY;
-            }
-
-            // Compute target dimensions
-            int dstW = imgW * scale;
-            int dstH = imgH * scale;
+    // the next item either way is likely to be shown next
+    prefetch_background_image(state, state->list_state->selected - 1);
+    prefetch_background_image(state, state->list_state->selected + 1);
 
-            int dstX = (FIXED_WIDTH - dstW) / 2;
-            int dstY = (FIXED_HEIGHT - dstH) / 2;
-            if (imgW == FIXED_WIDTH && imgH == FIXED_HEIGHT)
-            {
-                dstW = FIXED_WIDTH;
-                dstH = FIXED_HEIGHT;
-                dstX = 0;
-                dstY = 0;
-            }
+    return should_draw_background_image;
+}
 
-            // Compute destination rectangle
-            SDL_Rect dstRect = {dstX, dstY, dstW, dstH};
-#ifdef USE_SDL2
-            SDL_BlitScaled(surface, NULL, screen, &dstRect);
-#else
-            if (imgW == FIXED_WIDTH && imgH == FIXED_HEIGHT)
-            {
-                SDL_BlitSurface(surface, NULL, screen, &dstRect);
-            }
-            else
-            {
-                SDL_Surface *scaled = scale_surface(surface, dstW, dstH);
-                SDL_BlitSurface(scaled, NULL, screen, &dstRect);
-                SDL_FreeSurface(scaled);
-            }
-#endif
-            SDL_FreeSurface(surface);
+// draw_filter draws the filter keyboard, laid out like minui-keyboard's
+void draw_filter(SDL_Surface *screen, struct AppState *state)
+{
+    struct FilterState *filter = &state->filter;
+
+    // draw the button group on the bottom-right
+    GFX_blitButtonGroup((char *[]){"Y", "CANCEL", "X", "DONE", NULL}, 1, screen, 1);
+
+    // draw the title
+    const char *title_text = strlen(state->title) > 0 ? state->title : "FILTER";
+    SDL_Surface *title = TTF_RenderUTF8_Blended(state->fonts.large, title_text, COLOR_WHITE);
+    if (title != NULL)
+    {
+        SDL_Rect title_pos = {
+            (screen->w - title->w) / 2, // center horizontally
+            20,                         // 20px from top
+            title->w,
+            title->h};
+        SDL_BlitSurface(title, NULL, screen, &title_pos);
+        SDL_FreeSurface(title);
+    }
+
+    // draw the input field with the query
+    int line_height = TTF_FontHeight(state->fonts.medium);
+    SDL_Rect input_bg = {
+        40,
+        line_height * 2,
+        screen->w - 80,
+        line_height};
+    SDL_FillRect(screen, &input_bg, SDL_MapRGB(screen->format, TRIAD_DARK_GRAY));
+    if (filter->query[0] != '\0')
+    {
+        SDL_Surface *input = TTF_RenderUTF8_Blended(state->fonts.medium, filter->query, COLOR_WHITE);
+        if (input != NULL)
+        {
+            SDL_Rect input_pos = {
+                (screen->w - input->w) / 2,
+                line_height * 2,
+                input->w,
+                input->h};
+            SDL_BlitSurface(input, NULL, screen, &input_pos);
+            SDL_FreeSurface(input);
+        }
+    }
+
+    // draw how many items match below the input field
+    char count_text[64] = "No matches";
+    if (filter->index.match_count > 0)
+    {
+        snprintf(count_text, sizeof(count_text), "%zu of %zu", filter->index.match_count, filter->index.count);
+    }
+    SDL_Surface *count = TTF_RenderUTF8_Blended(state->fonts.medium, count_text, COLOR_GRAY);
+    if (count != NULL)
+    {
+        SDL_Rect count_pos = {
+            (screen->w - count->w) / 2,
+            line_height * 3,
+            count->w,
+            count->h};
+        SDL_BlitSurface(count, NULL, screen, &count_pos);
+        SDL_FreeSurface(count);
+    }
+
+    // draw the keyboard
+    int start_y = line_height * 4 + line_height / 2;
+    int key_width;
+    TTF_SizeUTF8(state->fonts.medium, "p", &key_width, NULL);
+    int key_size = (key_width > line_height) ? key_width : line_height;
+    int row_spacing = 5;
+    int column_spacing = 5;
+
+    // the last row's keys are words, so they are as wide as the widest of them
+    int space_width, clear_width, done_width;
+    TTF_SizeUTF8(state->fonts.medium, "space", &space_width, NULL);
+    TTF_SizeUTF8(state->fonts.medium, "clear", &clear_width, NULL);
+    TTF_SizeUTF8(state->fonts.medium, "done", &done_width, NULL);
+    int word_key_width = space_width;
+    word_key_width = (clear_width > word_key_width) ? clear_width : word_key_width;
+    word_key_width = (done_width > word_key_width) ? done_width : word_key_width;
+    word_key_width += column_spacing * 4;
+
+    for (int row = 0; row < FILTER_KEYBOARD_ROWS; row++)
+    {
+        int length = filter_keyboard_row_length(row);
+        int current_key_width = (row == FILTER_KEYBOARD_ROWS - 1) ? word_key_width : key_size;
+        int total_width = (length * current_key_width) + ((length - 1) * column_spacing);
+        int start_x = (screen->w - total_width) / 2;
+
+        for (int col = 0; col < length; col++)
+        {
+            bool is_selected = row == filter->row && col == filter->col;
+            SDL_Rect key_pos = {
+                start_x + (col * (current_key_width + column_spacing)),
+                start_y + (row * (key_size + row_spacing)),
+                current_key_width,
+                key_size};
+
+            // draw the key background
+            Uint32 bg_color = is_selected ? SDL_MapRGB(screen->format, TRIAD_WHITE) : SDL_MapRGB(screen->format, TRIAD_DARK_GRAY);
+            SDL_FillRect(screen, &key_pos, bg_color);
+
+            // center the text in the key
+            SDL_Surface *key_text = TTF_RenderUTF8_Blended(state->fonts.medium, filter_keyboard_layout[row][col], is_selected ? COLOR_BLACK : COLOR_WHITE);
+            if (key_text == NULL)
+            {
+                continue;
+            }
+            SDL_Rect text_pos = {
+                key_pos.x + (current_key_width - key_text->w) / 2,
+                key_pos.y + (key_size - key_text->h) / 2,
+                key_text->w,
+                key_text->h};
+            SDL_BlitSurface(key_text, NULL, screen, &text_pos);
+            SDL_FreeSurface(key_text);
         }
     }
 
-    return should_draw_background_image;
+    // don't forget to reset the should_redraw flag
+    state->redraw = 0;
 }
 
 // draw_screen interprets the app state and draws it to the screen
@@ -1485,7 +2522,7 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         force_hide_confirm = true;
     }
 
-    if (state->list_state->items[state->list_state->selected].features.hide_confirm)
+    if (state->list_state->items[state->list_state->selected].features->hide_confirm)
     {
         force_hide_confirm = true;
     }
@@ -1494,28 +2531,42 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
     // only two buttons can be displayed at a time
     if (force_hide_confirm)
     {
-        if (!state->list_state->items[state->list_state->selected].features.hide_cancel)
+        if (!state->list_state->items[state->list_state->selected].features->hide_cancel)
         {
             GFX_blitButtonGroup((char *[]){state->cancel_button, state->cancel_text, NULL}, 1, screen, 1);
         }
     }
-    else if (state->list_state->items[state->list_state->selected].features.hide_cancel)
+    else if (state->list_state->items[state->list_state->selected].features->hide_cancel)
     {
-        GFX_blitButtonGroup((char *[]){state->confirm_button, state->list_state->items[state->list_state->selected].features.confirm_text, NULL}, 1, screen, 1);
+        GFX_blitButtonGroup((char *[]){state->confirm_button, (char *)state->list_state->items[state->list_state->selected].features->confirm_text, NULL}, 1, screen, 1);
     }
     else
     {
-        GFX_blitButtonGroup((char *[]){state->cancel_button, state->cancel_text, state->confirm_button, state->list_state->items[state->list_state->selected].features.confirm_text, NULL}, 1, screen, 1);
+        GFX_blitButtonGroup((char *[]){state->cancel_button, state->cancel_text, state->confirm_button, (char *)state->list_state->items[state->list_state->selected].features->confirm_text, NULL}, 1, screen, 1);
     }
 
     // if there is a title specified, compute the space needed for it
     int initial_list_y_padding = 0;
-    if (strlen(state->title) > 0)
+    if (has_title_row(state))
     {
         // Truncate title to avoid battery/wifi icon interference
         int title_available_width = ui.screen_width_px - DP(ui.edge_padding * 2 + ui.padding) - ow; // edge padding on left/right, internal padding between title and icon pill
+        // a filtered list says what it is filtered by
+        char title_text[1024];
+        if (state->filter.full_list == NULL)
+        {
+            snprintf(title_text, sizeof(title_text), "%s", state->title);
+        }
+        else if (strlen(state->title) > 0)
+        {
+            snprintf(title_text, sizeof(title_text), "%s: %s", state->title, state->filter.query);
+        }
+        else
+        {
+            snprintf(title_text, sizeof(title_text), "%s", state->filter.query);
+        }
         char truncated_title_text[256];
-        int title_width = GFX_truncateText(state->fonts.medium, state->title, truncated_title_text, title_available_width, DP(ui.button_padding * 2));
+        int title_width = GFX_truncateText(state->fonts.medium, title_text, truncated_title_text, title_available_width, DP(ui.button_padding * 2));
 
         // compute the x position of the title based on the alignment
         int title_x_pos;
@@ -1588,7 +2639,7 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
     for (int i = state->list_state->first_visible, j = 0; i < state->list_state->last_visible; i++, j++)
     {
         int available_width = (ui.screen_width_px) - DP(ui.edge_padding * 2);
-        bool in_top_row_no_title = (j == 0 && strlen(state->title) == 0);
+        bool in_top_row_no_title = (j == 0 && !has_title_row(state));
         // Account for the space taken up by ow and it's padding
         if (in_top_row_no_title)
         {
@@ -1602,17 +2653,17 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         // item.name
         char display_text[256];
         char display_selected_text[256];
-        char *alignment = state->list_state->items[i].features.alignment;
+        const char *alignment = state->list_state->items[i].features->alignment;
         bool is_hex_color = false;
         strncpy(display_selected_text, "", sizeof(display_selected_text));
         if (state->list_state->items[i].option_count > 0)
         {
-            char *selected = state->list_state->items[i].options[state->list_state->items[i].selected];
+            const char *selected = state->list_state->items[i].options[state->list_state->items[i].selected];
             is_hex_color = detect_hex_color(selected);
             if (strcmp(alignment, "left") == 0)
             {
                 snprintf(display_text, sizeof(display_text), "%s", state->list_state->items[i].name);
-                if (state->list_state->items[i].features.draw_arrows)
+                if (state->list_state->items[i].features->draw_arrows)
                 {
                     snprintf(display_selected_text, sizeof(display_selected_text), "‹ %s ›", selected);
                 }
@@ -1623,7 +2674,7 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
             }
             else
             {
-                if (state->list_state->items[i].features.draw_arrows)
+                if (state->list_state->items[i].features->draw_arrows)
                 {
                     snprintf(display_text, sizeof(display_text), "%s: ‹ %s ›", state->list_state->items[i].name, selected);
                 }
@@ -1639,11 +2690,11 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         }
 
         SDL_Color text_color = COLOR_WHITE;
-        if (state->list_state->items[i].features.disabled)
+        if (state->list_state->items[i].features->disabled)
         {
             text_color = (SDL_Color){TRIAD_DARK_GRAY};
         }
-        if (state->list_state->items[i].features.is_header || state->list_state->items[i].features.unselectable)
+        if (state->list_state->items[i].features->is_header || state->list_state->items[i].features->unselectable)
         {
             text_color = COLOR_LIGHT_TEXT;
         }
@@ -1667,17 +2718,17 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         if (j == selected_row)
         {
             text_color = COLOR_BLACK;
-            current_item_is_enabled = state->list_state->items[i].features.disabled;
-            if (state->list_state->items[i].features.disabled)
+            current_item_is_enabled = state->list_state->items[i].features->disabled;
+            if (state->list_state->items[i].features->disabled)
             {
                 text_color = (SDL_Color){TRIAD_LIGHT_GRAY};
             }
-            if (state->list_state->items[i].features.is_header || state->list_state->items[i].features.unselectable)
+            if (state->list_state->items[i].features->is_header || state->list_state->items[i].features->unselectable)
             {
                 current_item_is_header = true;
                 text_color = COLOR_LIGHT_TEXT;
             }
-            if (state->list_state->items[i].features.can_disable)
+            if (state->list_state->items[i].features->can_disable)
             {
                 current_item_supports_enabling = true;
             }
@@ -1792,10 +2843,10 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         if (strcmp(display_selected_text, "") != 0)
         {
             initial_cube_x_pos = ui.screen_width_px - DP(ui.edge_padding + OPTION_PADDING) - color_box_space;
-            if (j != 0 || strlen(state->title) > 0)
+            if (j != 0 || has_title_row(state))
             {
                 SDL_Color selected_text_color = COLOR_WHITE;
-                if (state->list_state->items[i].features.disabled || state->list_state->items[i].features.unselectable)
+                if (state->list_state->items[i].features->disabled || state->list_state->items[i].features->unselectable)
                 {
                     selected_text_color = COLOR_LIGHT_TEXT;
                 }
@@ -1811,7 +2862,7 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
         if (is_hex_color)
         {
             // get the hex color from the options array
-            char *hex_color = state->list_state->items[i].options[state->list_state->items[i].selected];
+            const char *hex_color = state->list_state->items[i].options[state->list_state->items[i].selected];
             SDL_Color current_color = hex_to_sdl_color(hex_color);
             uint32_t color = SDL_MapRGBA(screen->format, current_color.r, current_color.g, current_color.b, 255);
 
@@ -1839,22 +2890,32 @@ void draw_screen(SDL_Surface *screen, struct AppState *state, int ow, bool shoul
     }
 
     // draw the button group on the left
-    // this should only display the enable button if the current item supports enabling
-    // and should only display the action button if it is assigned to a button
+    // this should only display the enable button if the current item supports enabling,
+    // the action button if it is assigned to a button and the filter button if filtering
+    // is enabled, keeping the first two of those since only two buttons fit
+    char *left_pairs[5] = {NULL};
+    int left_pair_count = 0;
     if (current_item_supports_enabling && strcmp(state->enable_button, "") != 0)
     {
-        if (strcmp(state->action_button, "") != 0 && !state->list_state->items[state->list_state->selected].features.hide_action)
-        {
-            GFX_blitButtonGroup((char *[]){state->enable_button, enable_button_text, state->action_button, state->action_text, NULL}, 0, screen, 0);
-        }
-        else
-        {
-            GFX_blitButtonGroup((char *[]){state->enable_button, enable_button_text, NULL}, 0, screen, 0);
-        }
+        left_pairs[left_pair_count * 2] = state->enable_button;
+        left_pairs[left_pair_count * 2 + 1] = enable_button_text;
+        left_pair_count++;
+    }
+    if (strcmp(state->action_button, "") != 0 && !state->list_state->items[state->list_state->selected].features->hide_action)
+    {
+        left_pairs[left_pair_count * 2] = state->action_button;
+        left_pairs[left_pair_count * 2 + 1] = state->action_text;
+        left_pair_count++;
+    }
+    if (strcmp(state->filter_button, "") != 0 && left_pair_count < 2)
+    {
+        left_pairs[left_pair_count * 2] = state->filter_button;
+        left_pairs[left_pair_count * 2 + 1] = "FILTER";
+        left_pair_count++;
     }
-    else if (strcmp(state->action_button, "") != 0 && !state->list_state->items[state->list_state->selected].features.hide_action)
+    if (left_pair_count > 0)
     {
-        GFX_blitButtonGroup((char *[]){state->action_button, state->action_text, NULL}, 0, screen, 0);
+        GFX_blitButtonGroup(left_pairs, 0, screen, 0);
     }
 
     // don't forget to reset the should_redraw flag
@@ -2011,6 +3072,7 @@ void signal_handler(int signal)
 // - --cancel-button <button> (default: "B")
 // - --cancel-text <text> (default: "BACK")
 // - --enable-button <button> (default: "Y")
+// - --filter-button <button> (default: empty string)
 // - --disable-auto-sleep (default: false)
 // - --font-default <path> (default: empty string)
 // - --font-large <path> (default: empty string)
@@ -2035,6 +3097,7 @@ bool parse_arguments(struct AppState *state, int argc, char *argv[])
         {"cancel-text", required_argument, 0, 'D'},
         {"enable-button", required_argument, 0, 'e'},
         {"file", required_argument, 0, 'f'},
+        {"filter-button", required_argument, 0, 'S'},
         {"font-default", required_argument, 0, 'l'},
         {"font-large", required_argument, 0, 'L'},
         {"font-medium", required_argument, 0, 'M'},
@@ -2052,7 +3115,7 @@ bool parse_arguments(struct AppState *state, int argc, char *argv[])
     char *font_path_default = NULL;
     char *font_path_large = NULL;
     char *font_path_medium = NULL;
-    while ((opt = getopt_long(argc, argv, "a:A:b:B:c:C:d:D:e:f:F:l:L:M:K:t:T:w:W:UH", long_options, NULL)) != -1)
+    while ((opt = getopt_long(argc, argv, "a:A:b:B:c:C:d:D:e:f:F:l:L:M:K:S:t:T:w:W:UH", long_options, NULL)) != -1)
     {
         switch (opt)
         {
@@ -2086,6 +3149,9 @@ bool parse_arguments(struct AppState *state, int argc, char *argv[])
         case 'f':
             strncpy(state->file, optarg, sizeof(state->file) - 1);
             break;
+        case 'S':
+            strncpy(state->filter_button, optarg, sizeof(state->filter_button) - 1);
+            break;
         case 'F':
             strncpy(state->format, optarg, sizeof(state->format) - 1);
             break;
@@ -2325,6 +3391,12 @@ bool parse_arguments(struct AppState *state, int argc, char *argv[])
         log_error("Invalid cancel button provided");
         return false;
     }
+    // the face buttons all have a meaning on the filter keyboard
+    if (strcmp(state->filter_button, "") != 0 && strcmp(state->filter_button, "SELECT") != 0 && strcmp(state->filter_button, "START") != 0)
+    {
+        log_error("Invalid filter button provided");
+        return false;
+    }
 
     if (strlen(state->file) == 0)
     {
@@ -2435,90 +3507,90 @@ int write_output(struct AppState *state)
             return ExitCodeSerializeError;
         }
 
-        if (state->list_state->items[i].features.has_alignment)
+        if (state->list_state->items[i].features->has_alignment)
         {
-            if (json_object_dotset_string(features, "alignment", state->list_state->items[i].features.alignment) == JSONFailure)
+            if (json_object_dotset_string(features, "alignment", state->list_state->items[i].features->alignment) == JSONFailure)
             {
                 log_error("Failed to set alignment");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_confirm_text)
+        if (state->list_state->items[i].features->has_confirm_text)
         {
-            if (json_object_dotset_string(features, "confirm_text", state->list_state->items[i].features.confirm_text) == JSONFailure)
+            if (json_object_dotset_string(features, "confirm_text", state->list_state->items[i].features->confirm_text) == JSONFailure)
             {
                 log_error("Failed to set confirm_text");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_can_disable)
+        if (state->list_state->items[i].features->has_can_disable)
         {
-            if (json_object_dotset_boolean(features, "can_disable", state->list_state->items[i].features.can_disable) == JSONFailure)
+            if (json_object_dotset_boolean(features, "can_disable", state->list_state->items[i].features->can_disable) == JSONFailure)
             {
                 log_error("Failed to set can_disable");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_disabled || state->list_state->items[i].features.has_can_disable)
+        if (state->list_state->items[i].features->has_disabled || state->list_state->items[i].features->has_can_disable)
         {
-            if (json_object_dotset_boolean(features, "disabled", state->list_state->items[i].features.disabled))
+            if (json_object_dotset_boolean(features, "disabled", state->list_state->items[i].features->disabled))
             {
                 log_error("Failed to set enabled");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_draw_arrows)
+        if (state->list_state->items[i].features->has_draw_arrows)
         {
-            if (json_object_dotset_boolean(features, "draw_arrows", state->list_state->items[i].features.draw_arrows))
+            if (json_object_dotset_boolean(features, "draw_arrows", state->list_state->items[i].features->draw_arrows))
             {
                 log_error("Failed to set draw_arrows");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_hide_action)
+        if (state->list_state->items[i].features->has_hide_action)
         {
-            if (json_object_dotset_boolean(features, "hide_action", state->list_state->items[i].features.hide_action))
+            if (json_object_dotset_boolean(features, "hide_action", state->list_state->items[i].features->hide_action))
             {
                 log_error("Failed to set hide_action");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_hide_cancel)
+        if (state->list_state->items[i].features->has_hide_cancel)
         {
-            if (json_object_dotset_boolean(features, "hide_cancel", state->list_state->items[i].features.hide_cancel))
+            if (json_object_dotset_boolean(features, "hide_cancel", state->list_state->items[i].features->hide_cancel))
             {
                 log_error("Failed to set hide_cancel");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_hide_confirm)
+        if (state->list_state->items[i].features->has_hide_confirm)
         {
-            if (json_object_dotset_boolean(features, "hide_confirm", state->list_state->items[i].features.hide_confirm))
+            if (json_object_dotset_boolean(features, "hide_confirm", state->list_state->items[i].features->hide_confirm))
             {
                 log_error("Failed to set hide_confirm");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_is_header)
+        if (state->list_state->items[i].features->has_is_header)
         {
-            if (json_object_dotset_boolean(features, "is_header", state->list_state->items[i].features.is_header))
+            if (json_object_dotset_boolean(features, "is_header", state->list_state->items[i].features->is_header))
             {
                 log_error("Failed to set is_header");
                 return ExitCodeSerializeError;
             }
         }
 
-        if (state->list_state->items[i].features.has_unselectable)
+        if (state->list_state->items[i].features->has_unselectable)
         {
-            if (json_object_dotset_boolean(features, "unselectable", state->list_state->items[i].features.unselectable))
+            if (json_object_dotset_boolean(features, "unselectable", state->list_state->items[i].features->unselectable))
             {
                 log_error("Failed to set unselectable");
                 return ExitCodeSerializeError;
@@ -2664,28 +3736,41 @@ int main(int argc, char *argv[])
     if (state.list_state == NULL)
     {
         log_error("Failed to create list state");
-        return ExitCodeError;
+        return state.exit_code == ExitCodeParseError ? ExitCodeParseError : ExitCodeError;
     }
 
-    if (state.list_state->item_count > 0)
+    // if there are items in the list,
+    // validate that at least one item is not a header and is selectable
+    // reading further into the input until one turns up
+    bool has_selectable = false;
+    size_t i = 0;
+    while (!has_selectable)
     {
-        // if there are items in the list,
-        // validate that at least one item is not a header and is selectable
-        bool has_selectable = false;
-        for (size_t i = 0; i < state.list_state->item_count; i++)
+        if (i == state.list_state->item_count)
         {
-            state.list_state->selected = i;
-            if (!state.list_state->items[i].features.is_header && !state.list_state->items[i].features.unselectable)
+            if (state.list_state->ingest == NULL)
             {
-                has_selectable = true;
                 break;
             }
+            if (!ListState_Ingest(state.list_state, LIST_INGEST_BATCH, true))
+            {
+                log_error("Failed to create list state");
+                return ExitCodeParseError;
+            }
+            continue;
         }
-        if (!has_selectable)
+
+        state.list_state->selected = i;
+        if (!state.list_state->items[i].features->is_header && !state.list_state->items[i].features->unselectable)
         {
-            log_error("No selectable items found");
-            return ExitCodeError;
+            has_selectable = true;
         }
+        i++;
+    }
+    if (state.list_state->item_count > 0 && !has_selectable)
+    {
+        log_error("No selectable items found");
+        return ExitCodeError;
     }
 
     // swallow all stdout from init calls
@@ -2713,6 +3798,22 @@ int main(int argc, char *argv[])
         PWR_disableAutosleep();
     }
 
+    // background images are decoded on a worker thread, the first time
+    // their item is shown or is next to the selected one; without the
+    // thread, items are drawn without their images
+    if (ImageCache_start(&state.background_images, IMAGE_CACHE_SIZE, load_background_image, NULL, free_background_image, NULL) != 0)
+    {
+        log_error("Failed to start the background image loader");
+    }
+
+    // a redraw waits a few frames for the selected item's background image,
+    // so scrolling doesn't flash the layout used without one
+    bool redraw_held = false;
+    int held_frames = 0;
+    // whether the screen shows the selected item without its image, which is still loading
+    bool drawn_without_image = false;
+    uint32_t image_checked_at = 0;
+
     while (!state.quitting)
     {
         // start the frame to ensure GFX_sync() works
@@ -2741,6 +3842,22 @@ int main(int argc, char *argv[])
         // handle any input events
         handle_input(&state);
 
+        // read the next batch of items if the input has them ready
+        // and show the ones that landed in empty rows
+        if (!state.quitting && state.list_state->ingest != NULL)
+        {
+            int last_visible = state.list_state->last_visible;
+            if (!ListState_Ingest(state.list_state, LIST_INGEST_BATCH, false))
+            {
+                state.quitting = 1;
+                state.exit_code = ExitCodeParseError;
+            }
+            if (state.list_state->last_visible != last_visible)
+            {
+                state.redraw = 1;
+            }
+        }
+
         // force a redraw if the screen was never drawn
         if (!was_ever_drawn && !state.redraw)
         {
@@ -2754,16 +3871,55 @@ int main(int argc, char *argv[])
             state.redraw = 1;
         }
 
+        // the filter keyboard has no background image
+        int image_state = state.filter.editing ? IMAGE_MISSING : background_image_state(&state);
+        bool image_loading = image_state == IMAGE_LOADING || image_state == IMAGE_NONE;
+
+        // a missing image may still be on its way (e.g. downloaded by the pak),
+        // so look for the selected one again now and then
+        if (image_state == IMAGE_MISSING && selected_background_image(&state) != NULL && SDL_GetTicks() - image_checked_at >= BACKGROUND_IMAGE_RETRY_MS)
+        {
+            image_checked_at = SDL_GetTicks();
+            ImageCache_retry(&state.background_images, selected_background_image(&state));
+            drawn_without_image = true;
+        }
+
+        if (state.redraw)
+        {
+            redraw_held = true;
+        }
+        if (redraw_held)
+        {
+            if (image_loading && held_frames < BACKGROUND_IMAGE_WAIT_FRAMES)
+            {
+                state.redraw = 0;
+                held_frames++;
+            }
+            else
+            {
+                state.redraw = 1;
+                redraw_held = false;
+                held_frames = 0;
+                drawn_without_image = image_loading;
+            }
+        }
+        else if (drawn_without_image && !image_loading)
+        {
+            // redraw once the image is decoded
+            drawn_without_image = false;
+            state.redraw = image_state == IMAGE_READY;
+        }
+
         // redraw the screen if there has been a change
         if (state.redraw)
         {
             // clear the screen at the beginning of each loop
             GFX_clear(screen);
 
-            bool should_draw_background_image = draw_background(screen, &state);
+            bool should_draw_background_image = !state.filter.editing && draw_background(screen, &state);
 
             int ow = 0;
-            if (state.show_hardware_group)
+            if (state.show_hardware_group && !state.filter.editing)
             {
                 // draw the hardware information in the top-right
                 ow = GFX_blitHardwareGroup(screen, state.show_brightness_setting);
@@ -2783,7 +3939,14 @@ int main(int argc, char *argv[])
             }
 
             // your draw logic goes here
-            draw_screen(screen, &state, ow, should_draw_background_image);
+            if (state.filter.editing)
+            {
+                draw_filter(screen, &state);
+            }
+            else
+            {
+                draw_screen(screen, &state, ow, should_draw_background_image);
+            }
 
             // Takes the screen buffer and displays it on the screen
             GFX_flip(screen);
@@ -2796,7 +3959,27 @@ int main(int argc, char *argv[])
         }
     }
 
+    ImageCache_stop(&state.background_images);
+
+    // the output is written from the full list, with the changes made while filtered
+    filter_restore(&state);
+
+    // the output has every item, including the ones not read yet
+    bool writes_items = strcmp(state.write_value, "selected") != 0 || state.exit_code == ExitCodeSuccess || state.exit_code == ExitCodeActionButton;
+    if (writes_items && !ListState_Ingest(state.list_state, SIZE_MAX, true))
+    {
+        state.exit_code = ExitCodeParseError;
+    }
+    if (state.exit_code == ExitCodeParseError)
+    {
+        return ExitCodeParseError;
+    }
+
+    // the output document is built, written and thrown away in one go,
+    // so it comes from an arena instead of a malloc per value
+    json_arena_begin();
     int exit_code = write_output(&state);
+    json_arena_end();
     if (exit_code != ExitCodeSuccess)
     {
         return exit_code;
@@ -1,7 +1,6 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <msettings.h>
-#include <parson/parson.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdatomic.h>
@@ -19,6 +18,7 @@
 
 #include "defines.h"
 #include "api.h"
+#include "json_stream.h"
 #include "utils.h"
 
 SDL_Surface *screen = NULL;
@@ -209,202 +209,224 @@ void strtrim(char *s)
     memmove(s, p, l + 1);
 }
 
-char *read_stdin()
+// read_item reads one element of the items array into item, which holds the defaults
+// returns false if the element is invalid, after logging why
+bool read_item(JsonStream *stream, JsonStream_Token token, size_t index, struct Item *item)
 {
-    // Read all of stdin into a string
-    char *stdin_contents = NULL;
-    size_t stdin_size = 0;
-    size_t stdin_used = 0;
-    char buffer[4096];
-    size_t bytes_read;
+    char buff[1024];
+    if (token != JSON_STREAM_OBJECT_BEGIN)
+    {
+        JsonStream_skip(stream, token);
+        snprintf(buff, sizeof(buff), "Failed to get item %zu", index);
+        log_error(buff);
+        return false;
+    }
 
-    while ((bytes_read = fread(buffer, 1, sizeof(buffer), stdin)) > 0)
+    bool has_text = false;
+    bool valid_show_pill = true;
+    bool valid_alignment = true;
+    while ((token = JsonStream_next(stream)) == JSON_STREAM_KEY)
     {
-        if (stdin_contents == NULL)
+        char key[32];
+        snprintf(key, sizeof(key), "%s", stream->string);
+        token = JsonStream_next(stream);
+
+        if (strcmp(key, "text") == 0)
         {
-            stdin_size = bytes_read * 2;
-            stdin_contents = malloc(stdin_size);
+            has_text = token == JSON_STREAM_STRING;
+            if (has_text)
+            {
+                item->text = strdup(stream->string);
+            }
         }
-        else if (stdin_used + bytes_read > stdin_size)
+        else if (strcmp(key, "background_image") == 0 && token == JSON_STREAM_STRING)
         {
-            stdin_size *= 2;
-            stdin_contents = realloc(stdin_contents, stdin_size);
+            item->background_image = strdup(stream->string);
+            item->image_exists = access(stream->string, F_OK) != -1;
         }
-
-        memcpy(stdin_contents + stdin_used, buffer, bytes_read);
-        stdin_used += bytes_read;
-    }
-
-    // Null terminate the string
-    if (stdin_contents)
-    {
-        if (stdin_used == stdin_size)
+        else if (strcmp(key, "background_color") == 0 && token == JSON_STREAM_STRING)
         {
-            stdin_contents = realloc(stdin_contents, stdin_size + 1);
+            item->background_color = strdup(stream->string);
         }
-        stdin_contents[stdin_used] = '\0';
-    }
-
-    return stdin_contents;
-}
-
-// hydrate_display_states hydrates the display states from a file or stdin
-struct ItemsState *ItemsState_New(const char *filename, const char *item_key, const char *default_background_image, const char *default_background_color, bool default_show_pill, enum MessageAlignment default_alignment)
-{
-    struct ItemsState *state = malloc(sizeof(struct ItemsState));
-
-    JSON_Value *root_value;
-    if (strcmp(filename, "-") == 0)
-    {
-        char *contents = read_stdin();
-        if (contents == NULL)
+        else if (strcmp(key, "show_pill") == 0)
         {
-            log_error("Failed to read stdin");
-            return NULL;
+            valid_show_pill = token == JSON_STREAM_TRUE || token == JSON_STREAM_FALSE;
+            item->show_pill = token == JSON_STREAM_TRUE;
+        }
+        else if (strcmp(key, "alignment") == 0 && token == JSON_STREAM_STRING)
+        {
+            valid_alignment = true;
+            if (strcmp(stream->string, "top") == 0)
+            {
+                item->alignment = MessageAlignmentTop;
+            }
+            else if (strcmp(stream->string, "bottom") == 0)
+            {
+                item->alignment = MessageAlignmentBottom;
+            }
+            else if (strcmp(stream->string, "middle") == 0)
+            {
+                item->alignment = MessageAlignmentMiddle;
+            }
+            else
+            {
+                valid_alignment = false;
+            }
         }
 
-        root_value = json_parse_string_with_comments(contents);
-        free(contents);
-    }
-    else
-    {
-        root_value = json_parse_file_with_comments(filename);
+        if (JsonStream_skip(stream, token) != 0)
+        {
+            break;
+        }
     }
 
-    if (root_value == NULL)
+    if (token != JSON_STREAM_OBJECT_END)
     {
         log_error("Failed to parse JSON file");
-        return NULL;
+        return false;
     }
-
-    JSON_Object *root_object = json_value_get_object(root_value);
-    if (root_object == NULL)
+    if (!has_text)
     {
-        json_value_free(root_value);
-        return NULL;
+        snprintf(buff, sizeof(buff), "Failed to get text for item %zu", index);
+        log_error(buff);
+        return false;
     }
-
-    JSON_Array *items = json_object_get_array(root_object, item_key);
-    if (items == NULL)
+    if (!valid_show_pill)
     {
-        json_value_free(root_value);
-        return NULL;
+        snprintf(buff, sizeof(buff), "Invalid show_pill value provided for item %zu", index);
+        log_error(buff);
+        return false;
     }
-
-    size_t item_count = json_array_get_count(items);
-    if (item_count == 0)
+    if (!valid_alignment)
     {
-        json_value_free(root_value);
-        return NULL;
+        snprintf(buff, sizeof(buff), "Invalid alignment provided for item %zu", index);
+        log_error(buff);
+        return false;
     }
+    return true;
+}
 
-    state->items = malloc(sizeof(struct Item) * item_count);
+// hydrate_display_states hydrates the display states from a file or stdin
+//
+// The items are read straight from the input as it arrives, without
+// holding the whole document in memory.
+struct ItemsState *ItemsState_New(const char *filename, const char *item_key, const char *default_background_image, const char *default_background_color, bool default_show_pill, enum MessageAlignment default_alignment)
+{
+    struct ItemsState *state = malloc(sizeof(struct ItemsState));
 
-    for (size_t i = 0; i < item_count; i++)
+    int fd = STDIN_FILENO;
+    if (strcmp(filename, "-") != 0)
     {
-        JSON_Object *item = json_array_get_object(items, i);
-        if (item == NULL)
+        fd = open(filename, O_RDONLY);
+        if (fd < 0)
         {
-            char buff[1024];
-            snprintf(buff, sizeof(buff), "Failed to get item %zu", i);
-            log_error(buff);
-            json_value_free(root_value);
+            log_error("Failed to parse JSON file");
             return NULL;
         }
+    }
 
-        const char *text = json_object_get_string(item, "text");
-        if (text == NULL)
-        {
-            char buff[1024];
-            snprintf(buff, sizeof(buff), "Failed to get text for item %zu", i);
-            log_error(buff);
-            json_value_free(root_value);
-            return NULL;
-        }
+    JsonStream *stream = malloc(sizeof(JsonStream));
+    JsonStream_open(stream, fd);
 
-        state->items[i].text = strdup(text);
+    size_t item_count = 0;
+    size_t item_capacity = 0;
+    double selected = 0;
+    bool has_items = false;
+    bool valid = true;
+    state->items = NULL;
 
-        const char *background_image = json_object_get_string(item, "background_image");
-        state->items[i].background_image = strdup(default_background_image);
-        state->items[i].image_exists = default_background_image != NULL && access(default_background_image, F_OK) != -1;
-        if (background_image != NULL)
+    // the root must be an object holding the items array
+    JsonStream_Token token = JsonStream_next(stream);
+    if (token != JSON_STREAM_OBJECT_BEGIN)
+    {
+        // any other valid document just has no items
+        if (token == JSON_STREAM_ERROR || JsonStream_skip(stream, token) != 0)
         {
-            state->items[i].background_image = strdup(background_image);
-            state->items[i].image_exists = access(background_image, F_OK) != -1;
+            log_error("Failed to parse JSON file");
         }
+        valid = false;
+    }
 
-        const char *background_color = json_object_get_string(item, "background_color");
-        state->items[i].background_color = strdup(default_background_color);
-        if (background_color != NULL)
+    while (valid && (token = JsonStream_next(stream)) == JSON_STREAM_KEY)
+    {
+        bool is_items = strcmp(stream->string, item_key) == 0;
+        bool is_selected = strcmp(stream->string, "selected") == 0;
+        token = JsonStream_next(stream);
+
+        if (is_selected)
         {
-            state->items[i].background_color = strdup(background_color);
+            selected = token == JSON_STREAM_NUMBER ? stream->number : 0;
         }
-
-        state->items[i].show_pill = default_show_pill;
-        if (json_object_has_value(item, "show_pill"))
+        else if (is_items && token == JSON_STREAM_ARRAY_BEGIN)
         {
-            if (json_object_get_boolean(item, "show_pill") == 1)
+            has_items = true;
+            item_count = 0;
+            while (valid && (token = JsonStream_next(stream)) > JSON_STREAM_END && token != JSON_STREAM_ARRAY_END)
             {
-                state->items[i].show_pill = true;
-            }
-            else if (json_object_get_boolean(item, "show_pill") == 0)
-            {
-                state->items[i].show_pill = false;
+                if (item_count == item_capacity)
+                {
+                    item_capacity = item_capacity > 0 ? item_capacity * 2 : 16;
+                    state->items = realloc(state->items, sizeof(struct Item) * item_capacity);
+                }
+
+                struct Item *item = &state->items[item_count];
+                item->text = NULL;
+                item->background_image = strdup(default_background_image);
+                item->image_exists = default_background_image != NULL && access(default_background_image, F_OK) != -1;
+                item->background_color = strdup(default_background_color);
+                item->show_pill = default_show_pill;
+                item->alignment = default_alignment;
+                valid = read_item(stream, token, item_count, item);
+                item_count++;
             }
-            else
+            if (valid && token != JSON_STREAM_ARRAY_END)
             {
-                char buff[1024];
-                snprintf(buff, sizeof(buff), "Invalid show_pill value provided for item %zu", i);
-                log_error(buff);
-                json_value_free(root_value);
-                return NULL;
+                log_error("Failed to parse JSON file");
+                valid = false;
             }
+            continue;
         }
-
-        const char *alignment = json_object_get_string(item, "alignment");
-        if (alignment == NULL)
-        {
-            state->items[i].alignment = default_alignment;
-        }
-        else if (strcmp(alignment, "top") == 0)
-        {
-            state->items[i].alignment = MessageAlignmentTop;
-        }
-        else if (strcmp(alignment, "bottom") == 0)
-        {
-            state->items[i].alignment = MessageAlignmentBottom;
-        }
-        else if (strcmp(alignment, "middle") == 0)
+        else if (is_items)
         {
-            state->items[i].alignment = MessageAlignmentMiddle;
+            has_items = false;
         }
-        else
+
+        if (JsonStream_skip(stream, token) != 0)
         {
-            char buff[1024];
-            snprintf(buff, sizeof(buff), "Invalid alignment provided for item %zu", i);
-            log_error(buff);
-            json_value_free(root_value);
-            return NULL;
+            break;
         }
     }
 
-    state->item_count = item_count;
-    state->selected = 0;
+    // reading stops at the end of the root object, a script may keep its output open after it
+    if (valid && token != JSON_STREAM_OBJECT_END)
+    {
+        log_error("Failed to parse JSON file");
+        valid = false;
+    }
 
-    if (json_object_has_value(root_object, "selected"))
+    JsonStream_close(stream);
+    free(stream);
+    if (fd != STDIN_FILENO)
     {
-        state->selected = json_object_get_number(root_object, "selected");
-        if (state->selected < 0)
-        {
-            state->selected = 0;
-        }
-        else if (state->selected >= item_count)
-        {
-            state->selected = item_count - 1;
-        }
+        close(fd);
+    }
+
+    if (!valid || !has_items || item_count == 0)
+    {
+        return NULL;
+    }
+
+    state->item_count = item_count;
+    state->selected = selected;
+    if (state->selected < 0)
+    {
+        state->selected = 0;
+    }
+    else if (state->selected >= item_count)
+    {
+        state->selected = item_count - 1;
     }
 
-    json_value_free(root_value);
     return state;
 }
 
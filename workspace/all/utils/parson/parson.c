@@ -78,7 +78,8 @@
 
 #define SIZEOF_TOKEN(a)       (sizeof(a) - 1)
 #define SKIP_CHAR(str)        ((*str)++)
-#define SKIP_WHITESPACES(str) while (isspace((unsigned char)(**str))) { SKIP_CHAR(str); }
+#define IS_SPACE(c)           ((c) == ' ' || ((c) >= '\t' && (c) <= '\r')) /* isspace() in the C locale, without the call */
+#define SKIP_WHITESPACES(str) while (IS_SPACE(**str)) { SKIP_CHAR(str); }
 #define MAX(a, b)             ((a) > (b) ? (a) : (b))
 
 #undef malloc
@@ -95,6 +96,22 @@
 static JSON_Malloc_Function parson_malloc = malloc;
 static JSON_Free_Function parson_free = free;
 
+/* Arena mode, see json_arena_begin() */
+#define ARENA_ALIGNMENT  8
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct json_arena_block {
+    struct json_arena_block *next;
+    size_t used;
+    size_t size;
+} JSON_Arena_Block;
+
+#define ARENA_HEADER_SIZE ((sizeof(JSON_Arena_Block) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+static JSON_Arena_Block *parson_arena = NULL;
+static JSON_Malloc_Function parson_arena_malloc = NULL;
+static JSON_Free_Function parson_arena_free = NULL;
+
 static int parson_escape_slashes = 1;
 
 static char *parson_float_format = NULL;
@@ -149,6 +166,9 @@ struct json_array_t {
 };
 
 /* Various */
+static void * arena_malloc(size_t n);
+static void   arena_free(void *ptr);
+static int    arena_owns(const void *ptr);
 static char * read_file(const char *filename);
 static void   remove_comments(char *string, const char *start_token, const char *end_token);
 static char * parson_strndup(const char *string, size_t n);
@@ -851,19 +871,47 @@ static JSON_Status parse_utf16(const char **unprocessed, char **processed) {
 }
 
 
+/* Returns how many bytes from the start of input need no processing:
+   no escapes, control characters or \0. Checks a word at a time, the
+   length keeps the reads inside the string. */
+static size_t plain_run_length(const char *input, size_t length) {
+    const size_t ones = (size_t)-1 / 0xFF; /* 0x0101... */
+    const size_t highs = ones * 0x80;
+    size_t i = 0;
+    size_t word = 0, escaped = 0;
+    for (i = 0; i + sizeof(size_t) <= length; i += sizeof(size_t)) {
+        memcpy(&word, input + i, sizeof(size_t));
+        /* a byte below 0x20, or a zero byte after xor with '\\' */
+        escaped = word ^ (ones * '\\');
+        if ((((word - ones * 0x20) & ~word) | ((escaped - ones) & ~escaped)) & highs) {
+            break;
+        }
+    }
+    while (i < length && (unsigned char)input[i] >= 0x20 && input[i] != '\\') {
+        i++;
+    }
+    return i;
+}
+
 /* Copies and processes passed string up to supplied length.
 Example: "\u006Corem ipsum" -> lorem ipsum */
 static char* process_string(const char *input, size_t input_len, size_t *output_len) {
     const char *input_ptr = input;
     size_t initial_size = (input_len + 1) * sizeof(char);
-    size_t final_size = 0;
-    char *output = NULL, *output_ptr = NULL, *resized_output = NULL;
+    char *output = NULL, *output_ptr = NULL;
     output = (char*)parson_malloc(initial_size);
     if (output == NULL) {
         goto error;
     }
     output_ptr = output;
     while ((*input_ptr != '\0') && (size_t)(input_ptr - input) < input_len) {
+        size_t plain_len = plain_run_length(input_ptr, input_len - (size_t)(input_ptr - input));
+        if (plain_len > 0) {
+            memcpy(output_ptr, input_ptr, plain_len);
+            output_ptr += plain_len;
+            input_ptr += plain_len;
+            continue;
+        }
         if (*input_ptr == '\\') {
             input_ptr++;
             switch (*input_ptr) {
@@ -892,17 +940,9 @@ static char* process_string(const char *input, size_t input_len, size_t *output_
         input_ptr++;
     }
     *output_ptr = '\0';
-    /* resize to new length */
-    final_size = (size_t)(output_ptr-output) + 1;
-    /* todo: don't resize if final_size == initial_size */
-    resized_output = (char*)parson_malloc(final_size);
-    if (resized_output == NULL) {
-        goto error;
-    }
-    memcpy(resized_output, output, final_size);
-    *output_len = final_size - 1;
-    parson_free(output);
-    return resized_output;
+    /* escapes only shrink the string, keep the few spare bytes rather than copy it again */
+    *output_len = (size_t)(output_ptr - output);
+    return output;
 error:
     parson_free(output);
     return NULL;
@@ -1099,6 +1139,20 @@ static JSON_Value * parse_boolean_value(const char **string) {
 static JSON_Value * parse_number_value(const char **string) {
     char *end;
     double number = 0;
+    parson_bool_t negative = **string == '-';
+    const char *digits = *string + negative;
+    size_t digit_count = 0;
+    double integer = 0;
+    /* integers of up to 15 digits are exact in a double, no need for strtod */
+    while (digit_count < 16 && digits[digit_count] >= '0' && digits[digit_count] <= '9') {
+        integer = integer * 10 + (digits[digit_count] - '0');
+        digit_count++;
+    }
+    if (digit_count > 0 && digit_count < 16 && (digits[0] != '0' || digit_count == 1)
+        && (digits[digit_count] == '\0' || !strchr(".eExX", digits[digit_count]))) {
+        *string = digits + digit_count;
+        return json_value_init_number(negative ? -integer : integer);
+    }
     errno = 0;
     number = strtod(*string, &end);
     if (errno == ERANGE && (number <= -HUGE_VAL || number >= HUGE_VAL)) {
@@ -1597,6 +1651,9 @@ JSON_Value * json_value_get_parent (const JSON_Value *value) {
 }
 
 void json_value_free(JSON_Value *value) {
+    if (parson_free == arena_free && arena_owns(value)) {
+        return; /* nothing to walk, the arena releases the whole tree */
+    }
     switch (json_value_get_type(value)) {
         case JSONObject:
             json_object_free(value->value.object);
@@ -2465,6 +2522,77 @@ void json_set_allocation_functions(JSON_Malloc_Function malloc_fun, JSON_Free_Fu
     parson_free = free_fun;
 }
 
+static void * arena_malloc(size_t n) {
+    JSON_Arena_Block *block = parson_arena;
+    n = (n + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (block == NULL || block->size - block->used < n) {
+        size_t size = MAX(n, ARENA_BLOCK_SIZE);
+        block = (JSON_Arena_Block*)parson_arena_malloc(ARENA_HEADER_SIZE + size);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->used = 0;
+        block->size = size;
+        if (parson_arena != NULL && n > ARENA_BLOCK_SIZE / 4) {
+            /* big allocations get a block of their own, behind the one being filled */
+            block->next = parson_arena->next;
+            parson_arena->next = block;
+        } else {
+            block->next = parson_arena;
+            parson_arena = block;
+        }
+    }
+    block->used += n;
+    return (char*)block + ARENA_HEADER_SIZE + block->used - n;
+}
+
+static int arena_owns(const void *ptr) {
+    const JSON_Arena_Block *block = NULL;
+    const char *start = NULL;
+    for (block = parson_arena; block != NULL; block = block->next) {
+        start = (const char*)block + ARENA_HEADER_SIZE;
+        if ((const char*)ptr >= start && (const char*)ptr < start + block->size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void arena_free(void *ptr) {
+    /* arena memory is released with the whole arena, anything allocated before it began isn't */
+    if (ptr != NULL && !arena_owns(ptr)) {
+        parson_arena_free(ptr);
+    }
+}
+
+JSON_Status json_arena_begin(void) {
+    if (parson_arena_malloc != NULL) {
+        return JSONFailure;
+    }
+    parson_arena_malloc = parson_malloc;
+    parson_arena_free = parson_free;
+    parson_malloc = arena_malloc;
+    parson_free = arena_free;
+    return JSONSuccess;
+}
+
+void json_arena_end(void) {
+    JSON_Arena_Block *block = parson_arena, *next = NULL;
+    if (parson_arena_malloc == NULL) {
+        return;
+    }
+    while (block != NULL) {
+        next = block->next;
+        parson_arena_free(block);
+        block = next;
+    }
+    parson_arena = NULL;
+    parson_malloc = parson_arena_malloc;
+    parson_free = parson_arena_free;
+    parson_arena_malloc = NULL;
+    parson_arena_free = NULL;
+}
+
 void json_set_escape_slashes(int escape_slashes) {
     parson_escape_slashes = escape_slashes;
 }
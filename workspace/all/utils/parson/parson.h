@@ -77,6 +77,16 @@ typedef int (*JSON_Number_Serialization_Function)(double num, char *buf);
    from stdlib will be used for all allocations */
 void json_set_allocation_functions(JSON_Malloc_Function malloc_fun, JSON_Free_Function free_fun);
 
+/* Arena mode: until json_arena_end() is called, everything parson allocates comes from
+   a few large blocks and frees are ignored, so parsing or building a big document costs
+   a handful of mallocs. json_arena_end() releases all of it at once; values and strings
+   created in between must not be used or freed after that. Values created before it began
+   can still be freed while it is active, but must not be added to values created in it.
+   Uses the allocation functions set when it starts. Returns JSONFailure if an arena is
+   already active. Not thread safe. */
+JSON_Status json_arena_begin(void);
+void json_arena_end(void);
+
 /* Sets if slashes should be escaped or not when serializing JSON. By default slashes are escaped.
  This function sets a global setting and is not thread safe. */
 void json_set_escape_slashes(int escape_slashes);
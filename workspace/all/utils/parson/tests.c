@@ -69,6 +69,8 @@ void test_failing_allocations(void);
 void test_custom_number_format(void);
 void test_custom_number_serialization_function(void);
 void test_object_clear(void);
+void test_arena(void);
+void test_number_fast_path(void);
 
 void print_commits_info(const char *username, const char *repo);
 void persistence_example(void);
@@ -140,6 +142,8 @@ int tests_main(int argc, char *argv[]) {
     test_custom_number_format();
     test_custom_number_serialization_function();
     test_object_clear();
+    test_arena();
+    test_number_fast_path();
 
     printf("Tests failed: %d\n", g_tests_failed);
     printf("Tests passed: %d\n", g_tests_passed);
@@ -756,6 +760,54 @@ void test_object_clear(void) {
     TEST(g_malloc_count == 0);
 }
 
+void test_arena(void) {
+    JSON_Value *heap_val = NULL, *arena_val = NULL;
+    char *serialized = NULL;
+    int malloc_count = 0;
+    g_malloc_count = 0;
+    heap_val = json_parse_file(get_file_path("test_1_1.txt"));
+    malloc_count = g_malloc_count;
+    TEST(json_arena_begin() == JSONSuccess);
+    TEST(json_arena_begin() == JSONFailure); /* already active */
+    arena_val = json_parse_file(get_file_path("test_1_1.txt"));
+    TEST(arena_val != NULL);
+    TEST(json_value_equals(arena_val, heap_val));
+    TEST(json_array_append_string(json_value_get_array(arena_val), "appended") == JSONSuccess); /* grows, frees the old items */
+    serialized = json_serialize_to_string(arena_val);
+    TEST(serialized != NULL);
+    json_free_serialized_string(serialized);
+    json_value_free(arena_val); /* ignored */
+    TEST(g_malloc_count > malloc_count && g_malloc_count < malloc_count + 4); /* a few blocks instead of one per value */
+    json_arena_end();
+    TEST(g_malloc_count == malloc_count);
+    json_arena_end(); /* no arena, no-op */
+    json_value_free(heap_val);
+    TEST(g_malloc_count == 0);
+}
+
+void test_number_fast_path(void) {
+    JSON_Value *val = json_parse_string("[0, -0, 7, -42, 123456789012345, -123456789012345, 1234567890123456, 12345678901234567890, 0.5, 1e3, -2E-2]");
+    JSON_Array *arr = json_value_get_array(val);
+    TEST(json_array_get_count(arr) == 11);
+    TEST(json_array_get_number(arr, 0) == 0.0);
+    TEST(json_array_get_number(arr, 1) == 0.0 && 1.0 / json_array_get_number(arr, 1) < 0); /* -0 keeps its sign */
+    TEST(json_array_get_number(arr, 2) == 7.0);
+    TEST(json_array_get_number(arr, 3) == -42.0);
+    TEST(json_array_get_number(arr, 4) == 123456789012345.0);
+    TEST(json_array_get_number(arr, 5) == -123456789012345.0);
+    TEST(json_array_get_number(arr, 6) == 1234567890123456.0);
+    TEST(json_array_get_number(arr, 7) == 12345678901234567890.0);
+    TEST(json_array_get_number(arr, 8) == 0.5);
+    TEST(json_array_get_number(arr, 9) == 1000.0);
+    TEST(json_array_get_number(arr, 10) == -0.02);
+    json_value_free(val);
+    TEST(json_parse_string("01") == NULL);
+    TEST(json_parse_string("-01") == NULL);
+    TEST(json_parse_string("0x10") == NULL);
+    TEST((val = json_parse_string("42")) != NULL && json_value_get_number(val) == 42.0);
+    json_value_free(val);
+}
+
 void print_commits_info(const char *username, const char *repo) {
     JSON_Value *root_value;
     JSON_Array *commits;
@@ -108,4 +108,14 @@ void SetHDMI(int value);
  */
 int GetMute(void);
 
+/**
+ * Gets the settings generation.
+ *
+ * Incremented every time any process changes a setting, so callers can
+ * skip re-reading settings that haven't changed.
+ *
+ * @return Current generation
+ */
+unsigned GetSettingsGeneration(void);
+
 #endif // __msettings_h__
@@ -63,6 +63,10 @@ int GetMute(void) {
 	return 0;
 }
 
+unsigned GetSettingsGeneration(void) {
+	return 0;
+}
+
 ///////////////////////////////
 // Input
 ///////////////////////////////
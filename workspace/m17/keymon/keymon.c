@@ -7,10 +7,11 @@
  * - START+L1/R1: Adjust brightness
  * - SELECT+L1/R1: Adjust volume
  *
- * Also monitors headphone jack state in a separate thread and updates
- * audio routing accordingly.
+ * Also polls headphone jack state once a second and updates audio routing
+ * accordingly.
  *
- * Runs continuously at 60Hz polling multiple input devices.
+ * Built on the shared keymon core, which sleeps until input arrives or a
+ * timer is due and ignores stale input after system sleep.
  */
 
 #include <stdio.h>
@@ -18,21 +19,12 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <string.h>
-#include <fcntl.h>
-#include <dirent.h>
-#include <linux/input.h>
-#include <pthread.h>
 
 #include "../../all/common/log.h"
+#include "../../all/common/keymon_core.h"
 
 #include <msettings.h>
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/ioctl.h>
-
-// #include "defines.h"
-
 #define VOLUME_MIN 		0
 #define VOLUME_MAX 		20
 #define BRIGHTNESS_MIN 	0
@@ -46,17 +38,20 @@
 #define CODE_L1		 	 38
 #define CODE_R1		 	 19
 
-// Input event values
-#define RELEASED	0
-#define PRESSED		1
-
-#define INPUT_COUNT 4
-static int inputs[INPUT_COUNT];
-static struct input_event ev;
+static const char* inputs[] = {
+	"/dev/input/event0",
+	"/dev/input/event1",
+	"/dev/input/event2",
+	"/dev/input/event3",
+	NULL,
+};
 
-static pthread_t ports_pt;
 #define JACK_STATE_PATH "/sys/devices/virtual/switch/h2w/state" // 0 or 2
 
+static int start_pressed = 0;
+static int select_pressed = 0;
+static int had_headphones = -1;
+
 /**
  * Reads an integer value from a sysfs file.
  *
@@ -65,7 +60,7 @@ static pthread_t ports_pt;
  * @param path Path to sysfs file
  * @return Integer value read from file, or 0 if file cannot be opened
  */
-int getInt(char* path) {
+static int getInt(char* path) {
 	int i = 0;
 	FILE *file = fopen(path, "r");
 	if (file!=NULL) {
@@ -76,165 +71,115 @@ int getInt(char* path) {
 }
 
 /**
- * Background thread that monitors headphone jack state.
- *
- * Polls the headphone jack sysfs interface every second and updates
- * audio routing when the state changes (headphones plugged/unplugged).
+ * Checks headphone jack state.
  *
- * @param arg Thread argument (unused)
- * @return Never returns (runs infinite loop)
+ * Called once a second by the keymon core and updates audio routing when
+ * headphones are plugged or unplugged (the first call always applies it).
  */
-static void* watchPorts(void *arg) {
-	int has_headphones,had_headphones;
-
-	// Initialize headphone state
-	has_headphones = had_headphones = getInt(JACK_STATE_PATH);
-	SetJack(has_headphones);
-
-	while(1) {
-		sleep(1);
-
-		// Check for headphone state changes
-		has_headphones = getInt(JACK_STATE_PATH);
-		if (had_headphones!=has_headphones) {
-			had_headphones = has_headphones;
-			SetJack(has_headphones);
-		}
+static void watchPorts(void) {
+	int has_headphones = getInt(JACK_STATE_PATH);
+	if (had_headphones!=has_headphones) {
+		had_headphones = has_headphones;
+		SetJack(has_headphones);
 	}
+}
 
-	return 0;
+/**
+ * Reapplies the volume after the hardware volume buttons were used.
+ *
+ * Resets the scaled flag and re-applies the volume setting. This is a
+ * platform-specific workaround for hardware quirks.
+ */
+static void resyncVolume(void) {
+	system("echo 0 > /sys/devices/platform/0gpio-keys/scaled");
+	SetVolume(GetVolume());
 }
 
 /**
- * Main event loop for hardware button monitoring.
+ * Handles R1/L1 presses and repeats.
  *
- * Continuously polls multiple input devices for button events and handles:
- * - START+R1: Increase brightness
- * - START+L1: Decrease brightness
- * - SELECT+R1: Increase volume
- * - SELECT+L1: Decrease volume
- * - PLUS/MINUS: Re-applies volume setting (hardware workaround)
+ * START+R1/L1 steps brightness, SELECT+R1/L1 steps volume, PLUS/MINUS
+ * re-applies the volume.
  *
- * Also starts background thread to monitor headphone jack state.
+ * @param code Key code
+ */
+static void stepSetting(int code) {
+	int val;
+	if (code==CODE_PLUS || code==CODE_MINUS) {
+		resyncVolume();
+	}
+	else if (start_pressed) {
+		val = GetBrightness();
+		if (code==CODE_R1 && val<BRIGHTNESS_MAX) SetBrightness(++val);
+		else if (code==CODE_L1 && val>BRIGHTNESS_MIN) SetBrightness(--val);
+	}
+	else if (select_pressed) {
+		val = GetVolume();
+		if (code==CODE_R1 && val<VOLUME_MAX) SetVolume(++val);
+		else if (code==CODE_L1 && val>VOLUME_MIN) SetVolume(--val);
+	}
+}
+
+/**
+ * Handles hardware button presses and releases.
  *
- * Implements repeat functionality (initial 300ms delay, then 100ms interval).
+ * @param code Key code
+ * @param value KEYMON_PRESSED or KEYMON_RELEASED
+ * @return 1 to repeat R1/L1/PLUS/MINUS while held
+ */
+static int handleKey(int code, int value) {
+	switch (code) {
+		case CODE_START:
+			start_pressed = value;
+		break;
+		case CODE_SELECT:
+			select_pressed = value;
+		break;
+		case CODE_PLUS:
+		case CODE_MINUS:
+			// also re-applied on release
+			if (value==KEYMON_RELEASED) resyncVolume();
+			// fall through
+		case CODE_R1:
+		case CODE_L1:
+			if (value==KEYMON_PRESSED) {
+				stepSetting(code);
+				return 1;
+			}
+		break;
+		default:
+		break;
+	}
+	return 0;
+}
+
+/**
+ * Releases the START/SELECT modifiers after stale input was dropped.
+ */
+static void resetKeys(void) {
+	start_pressed = 0;
+	select_pressed = 0;
+}
+
+/**
+ * Runs the keymon event loop.
  *
  * @param argc Argument count (unused)
  * @param argv Argument values (unused)
- * @return Never returns (runs infinite loop)
+ * @return 0 on clean exit
+ *
+ * @note Uses event0-3 input devices
  */
 int main (int argc, char *argv[]) {
 	printf("keymon\n"); fflush(stdout);
 	InitSettings();
 
-	// Start headphone jack monitoring thread
-	pthread_create(&ports_pt, NULL, &watchPorts, NULL);
-
-	// Open all input devices (event0-event3)
-	char path[256];
-	for (int i=0; i<INPUT_COUNT; i++) {
-		sprintf(path, "/dev/input/event%i", i);
-		inputs[i] = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-	}
-
-	// TODO: make sure manually handling repeat is necessary on this device
-	uint32_t val;
-	uint32_t start_pressed = 0;
-	uint32_t select_pressed = 0;
-
-	// Track R1 button state for repeat handling
-	uint32_t up_pressed = 0;
-	uint32_t up_just_pressed = 0;
-	uint32_t up_repeat_at = 0;
-
-	// Track L1 button state for repeat handling
-	uint32_t down_pressed = 0;
-	uint32_t down_just_pressed = 0;
-	uint32_t down_repeat_at = 0;
-
-	uint32_t now;
-	struct timeval tod;
-	
-	while (1) {
-		gettimeofday(&tod, NULL);
-		now = tod.tv_sec * 1000 + tod.tv_usec / 1000;
-
-		int input;
-		static struct input_event event;
-
-		// Poll all input devices for button events
-		for (int i=0; i<INPUT_COUNT; i++) {
-			input = inputs[i];
-
-			while(read(input, &ev, sizeof(ev))==sizeof(ev)) {
-				if (ev.type != EV_KEY ) continue;
-				val = ev.value;
-
-				// Process hardware button events
-				switch (ev.code) {
-					case CODE_START:
-						start_pressed = val;
-					break;
-					case CODE_SELECT:
-						select_pressed = val;
-					break;
-					case CODE_R1:
-						// R1 button (brightness/volume up when combined)
-						up_pressed = up_just_pressed = val;
-						if (val) up_repeat_at = now + 300; // 300ms initial delay
-					break;
-					case CODE_L1:
-						// L1 button (brightness/volume down when combined)
-						down_pressed = down_just_pressed = val;
-						if (val) down_repeat_at = now + 300; // 300ms initial delay
-					break;
-					case CODE_PLUS:
-					case CODE_MINUS:
-						// Hardware volume buttons: reset scaled flag and re-apply volume
-						// This is a platform-specific workaround for hardware quirks
-						system("echo 0 > /sys/devices/platform/0gpio-keys/scaled");
-						SetVolume(GetVolume());
-					break;
-					default:
-					break;
-				}
-			}
-		}
-		
-		// Handle R1 button (initial press or repeat after delay)
-		if (up_just_pressed || (up_pressed && now>=up_repeat_at)) {
-			if (start_pressed) {
-				// START+R1: Brightness up
-				val = GetBrightness();
-				if (val<BRIGHTNESS_MAX) SetBrightness(++val);
-			}
-			else if (select_pressed) {
-				// SELECT+R1: Volume up
-				val = GetVolume();
-				if (val<VOLUME_MAX) SetVolume(++val);
-			}
-
-			if (up_just_pressed) up_just_pressed = 0;
-			else up_repeat_at += 100; // 100ms repeat interval
-		}
-
-		// Handle L1 button (initial press or repeat after delay)
-		if (down_just_pressed || (down_pressed && now>=down_repeat_at)) {
-			if (start_pressed) {
-				// START+L1: Brightness down
-				val = GetBrightness();
-				if (val>BRIGHTNESS_MIN) SetBrightness(--val);
-			}
-			else if (select_pressed) {
-				// SELECT+L1: Volume down
-				val = GetVolume();
-				if (val>VOLUME_MIN) SetVolume(--val);
-			}
-
-			if (down_just_pressed) down_just_pressed = 0;
-			else down_repeat_at += 100; // 100ms repeat interval
-		}
-
-		usleep(16666); // 60Hz polling rate
-	}
+	KEYMON_Hooks hooks = {
+		.handleKey = handleKey,
+		.handleRepeat = stepSetting,
+		.reset = resetKeys,
+		.poll = watchPorts,
+		.poll_ms = 1000,
+	};
+	return KEYMON_run(inputs, &hooks) < 0 ? 1 : 0;
 }
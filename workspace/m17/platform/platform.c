@@ -32,7 +32,10 @@
 
 #include "api.h"
 #include "defines.h"
+#include "evdev.h"
+#include "latency.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -62,162 +65,84 @@
 #define RAW_MENU1 RAW_PLUS
 #define RAW_MENU2 RAW_MINUS
 
-#define INPUT_COUNT 4
-static int inputs[INPUT_COUNT];
+// MENU shares its code with PLUS, so PLUS resolves to MENU (first match wins)
+static const EVDEV_Mapping button_mapping[] = {
+    {RAW_UP, BTN_ID_DPAD_UP},
+    {RAW_DOWN, BTN_ID_DPAD_DOWN},
+    {RAW_LEFT, BTN_ID_DPAD_LEFT},
+    {RAW_RIGHT, BTN_ID_DPAD_RIGHT},
+    {RAW_A, BTN_ID_A},
+    {RAW_B, BTN_ID_B},
+    {RAW_X, BTN_ID_X},
+    {RAW_Y, BTN_ID_Y},
+    {RAW_START, BTN_ID_START},
+    {RAW_SELECT, BTN_ID_SELECT},
+    {RAW_MENU, BTN_ID_MENU},
+    {RAW_MENU1, BTN_ID_MENU},
+    {RAW_MENU2, BTN_ID_MENU},
+    {RAW_L1, BTN_ID_L1},
+    {RAW_L2, BTN_ID_L2},
+    {RAW_R1, BTN_ID_R1},
+    {RAW_R2, BTN_ID_R2},
+    EVDEV_MAPPING_END,
+};
 
 /**
- * Initializes input system by opening evdev devices.
+ * Initializes input system by registering evdev devices.
  *
- * Opens 4 event devices for reading button/key events.
+ * Adds 4 event devices to the evdev backend for button/key events.
  */
 void PLAT_initInput(void) {
 	char path[256];
-	for (int i = 0; i < INPUT_COUNT; i++) {
+	EVDEV_init();
+	for (int i = 0; i < 4; i++) {
 		sprintf(path, "/dev/input/event%i", i);
-		inputs[i] = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		EVDEV_addDevice(path, 0);
 	}
 }
 /**
  * Closes input system and cleans up resources.
  */
 void PLAT_quitInput(void) {
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		close(inputs[i]);
-	}
+	EVDEV_quit();
 }
 
-// Struct from <linux/input.h> which has BTN_ constants that conflict with platform.h
-struct input_event {
-	struct timeval time;
-	__u16 type;
-	__u16 code;
-	__s32 value;
-};
-#define EV_KEY 0x01
-#define EV_ABS 0x03
+/**
+ * Translates a single evdev key event to button state.
+ */
+static void handleEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type != EVDEV_EV_KEY || event->value > 1)
+		return; // ignore repeats (and axes, no analog sticks)
+
+	// LOG_info("key event: %i (%i)\n", event->code,event->value); // no L3/R3
+	uint32_t tick = *(uint32_t*)userdata;
+	int id = EVDEV_mapCode(button_mapping, event->code);
+	if (event->value == 1)
+		LAT_markInput(EVDEV_eventTime(event), id);
+	PAD_setButton(id, event->value, tick);
+}
 
 /**
  * Polls input devices and updates global pad state.
  *
- * Reads events from all input devices and translates hardware button codes
- * to MinUI button constants. Handles button repeat timing based on PAD_REPEAT_DELAY
- * and PAD_REPEAT_INTERVAL.
+ * Drains pending events through the evdev backend and translates hardware
+ * button codes to MinUI button constants. Handles button repeat timing based
+ * on PAD_REPEAT_DELAY and PAD_REPEAT_INTERVAL.
  */
 void PLAT_pollInput(void) {
-	// reset transient state
-	pad.just_pressed = BTN_NONE;
-	pad.just_released = BTN_NONE;
-	pad.just_repeated = BTN_NONE;
-
 	uint32_t tick = SDL_GetTicks();
-	for (int i = 0; i < BTN_ID_COUNT; i++) {
-		int btn = 1 << i;
-		if ((pad.is_pressed & btn) && (tick >= pad.repeat_at[i])) {
-			pad.just_repeated |= btn; // set
-			pad.repeat_at[i] += PAD_REPEAT_INTERVAL;
-		}
-	}
+	PAD_beginFrame(tick);
 
-	// the actual poll
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type != EV_KEY && event.type != EV_ABS)
-				continue;
-
-			int btn = BTN_NONE;
-			int pressed = 0; // 0=up,1=down
-			int id = -1;
-			int type = event.type;
-			int code = event.code;
-			int value = event.value;
-
-			// TODO: tmp, hardcoded, missing some buttons
-			if (type == EV_KEY) {
-				if (value > 1)
-					continue; // ignore repeats
-
-				pressed = value;
-				// LOG_info("key event: %i (%i)\n", code,pressed); // no L3/R3
-				if (code == RAW_UP) {
-					btn = BTN_DPAD_UP;
-					id = BTN_ID_DPAD_UP;
-				} else if (code == RAW_DOWN) {
-					btn = BTN_DPAD_DOWN;
-					id = BTN_ID_DPAD_DOWN;
-				} else if (code == RAW_LEFT) {
-					btn = BTN_DPAD_LEFT;
-					id = BTN_ID_DPAD_LEFT;
-				} else if (code == RAW_RIGHT) {
-					btn = BTN_DPAD_RIGHT;
-					id = BTN_ID_DPAD_RIGHT;
-				} else if (code == RAW_A) {
-					btn = BTN_A;
-					id = BTN_ID_A;
-				} else if (code == RAW_B) {
-					btn = BTN_B;
-					id = BTN_ID_B;
-				} else if (code == RAW_X) {
-					btn = BTN_X;
-					id = BTN_ID_X;
-				} else if (code == RAW_Y) {
-					btn = BTN_Y;
-					id = BTN_ID_Y;
-				} else if (code == RAW_START) {
-					btn = BTN_START;
-					id = BTN_ID_START;
-				} else if (code == RAW_SELECT) {
-					btn = BTN_SELECT;
-					id = BTN_ID_SELECT;
-				} else if (code == RAW_MENU) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_MENU1) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_MENU2) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_L1) {
-					btn = BTN_L1;
-					id = BTN_ID_L1;
-				} else if (code == RAW_L2) {
-					btn = BTN_L2;
-					id = BTN_ID_L2;
-				} else if (code == RAW_R1) {
-					btn = BTN_R1;
-					id = BTN_ID_R1;
-				} else if (code == RAW_R2) {
-					btn = BTN_R2;
-					id = BTN_ID_R2;
-				}
-			} else if (type == EV_ABS) {
-				// LOG_info("axis: %i (%i)\n",code,value);
-				// else if (code==RAW_LSX) pad.laxis.x = (value * 32767) / 4096;
-				// else if (code==RAW_LSY) pad.laxis.y = (value * 32767) / 4096;
-				// else if (code==RAW_RSX) pad.raxis.x = (value * 32767) / 4096;
-				// else if (code==RAW_RSY) pad.raxis.y = (value * 32767) / 4096;
-
-				btn = BTN_NONE; // already handled, force continue
-			}
-
-			if (btn == BTN_NONE)
-				continue;
-
-			if (!pressed) {
-				pad.is_pressed &= ~btn; // unset
-				pad.just_repeated &= ~btn; // unset
-				pad.just_released |= btn; // set
-			} else if ((pad.is_pressed & btn) == BTN_NONE) {
-				pad.just_pressed |= btn; // set
-				pad.just_repeated |= btn; // set
-				pad.is_pressed |= btn; // set
-				pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
-			}
-		}
-	}
+	EVDEV_poll(handleEvent, &tick);
+}
+
+/**
+ * Checks for a menu button release while asleep.
+ */
+static void handleWakeEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type == EVDEV_EV_KEY && (event->code == RAW_MENU1 || event->code == RAW_MENU2) &&
+	    event->value == 0)
+		*(int*)userdata = 1;
 }
 
 /**
@@ -226,17 +151,9 @@ void PLAT_pollInput(void) {
  * @return 1 if menu button was released, 0 otherwise
  */
 int PLAT_shouldWake(void) {
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type == EV_KEY && (event.code == RAW_MENU1 || event.code == RAW_MENU2) &&
-			    event.value == 0)
-				return 1;
-		}
-	}
-	return 0;
+	int wake = 0;
+	EVDEV_poll(handleWakeEvent, &wake);
+	return wake;
 }
 
 ///////////////////////////////
@@ -373,7 +290,7 @@ void PLAT_quitVideo(void) {
 	SDL_DestroyWindow(vid.window);
 	SDL_Quit();
 
-	system("cat /dev/zero > /dev/fb0 2>/dev/null");
+	zeroDevice("/dev/fb0");
 }
 
 /**
@@ -553,6 +470,9 @@ void PLAT_flip(SDL_Surface* IGNORED, int ignored) {
 // Power management
 ///////////////////////////////
 
+static SysfsValue usb_state = SYSFS_VALUE("/sys/class/udc/10180000.usb/state", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/battery/capacity", 0);
+
 /**
  * Reads battery status from sysfs.
  *
@@ -566,10 +486,8 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// *charge = PWR_LOW_CHARGE;
 	// return;
 
-	char state[256];
-
 	// works with old model
-	getFile("/sys/class/udc/10180000.usb/state", state, 256);
+	const char* state = SysfsValue_getString(&usb_state);
 	*is_charging = strncmp(
 	    "not attached", state,
 	    strlen(
@@ -579,7 +497,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// getFile("/sys/class/power_supply/battery/status", state, 256);
 	// *is_charging = exactMatch(state,"Charging\n");
 
-	int i = getInt("/sys/class/power_supply/battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// worry less about battery and more about the game you're playing
 	if (i > 80)
 		*charge = 100;
@@ -34,7 +34,10 @@
 
 #include "api.h"
 #include "defines.h"
+#include "evdev.h"
+#include "latency.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -76,8 +79,32 @@
 #define RAW_MENU1 RAW_L3
 #define RAW_MENU2 RAW_R3
 
-#define INPUT_COUNT 3
-static int inputs[INPUT_COUNT];
+// MENU1/MENU2 are L3/R3, so stick clicks resolve to MENU (first match wins)
+static const EVDEV_Mapping button_mapping[] = {
+    {RAW_UP, BTN_ID_DPAD_UP},
+    {RAW_DOWN, BTN_ID_DPAD_DOWN},
+    {RAW_LEFT, BTN_ID_DPAD_LEFT},
+    {RAW_RIGHT, BTN_ID_DPAD_RIGHT},
+    {RAW_A, BTN_ID_A},
+    {RAW_B, BTN_ID_B},
+    {RAW_X, BTN_ID_X},
+    {RAW_Y, BTN_ID_Y},
+    {RAW_START, BTN_ID_START},
+    {RAW_SELECT, BTN_ID_SELECT},
+    {RAW_MENU, BTN_ID_MENU},
+    {RAW_MENU1, BTN_ID_MENU},
+    {RAW_MENU2, BTN_ID_MENU},
+    {RAW_L1, BTN_ID_L1},
+    {RAW_L2, BTN_ID_L2},
+    {RAW_L3, BTN_ID_L3},
+    {RAW_R1, BTN_ID_R1},
+    {RAW_R2, BTN_ID_R2},
+    {RAW_R3, BTN_ID_R3},
+    {RAW_PLUS, BTN_ID_PLUS},
+    {RAW_MINUS, BTN_ID_MINUS},
+    {RAW_POWER, BTN_ID_POWER},
+    EVDEV_MAPPING_END,
+};
 
 ///////////////////////////////
 // Input Initialization
@@ -86,222 +113,88 @@ static int inputs[INPUT_COUNT];
 /**
  * Initializes input devices for the MagicX XU Mini M.
  *
- * Opens three input event devices:
+ * Registers three input event devices with the evdev backend:
  * - event0: Power button
  * - event2: Gamepad (buttons and analog sticks)
  * - event3: Volume buttons
- *
- * All devices are opened with O_NONBLOCK to prevent blocking reads
- * and O_CLOEXEC to prevent inheritance by child processes.
  */
 void PLAT_initInput(void) {
-	inputs[0] = open("/dev/input/event0", O_RDONLY | O_NONBLOCK | O_CLOEXEC); // power
-	inputs[1] = open("/dev/input/event2", O_RDONLY | O_NONBLOCK | O_CLOEXEC); // gamepad
-	inputs[2] = open("/dev/input/event3", O_RDONLY | O_NONBLOCK | O_CLOEXEC); // volume
+	EVDEV_init();
+	EVDEV_addDevice("/dev/input/event0", 0); // power
+	EVDEV_addDevice("/dev/input/event2", 0); // gamepad
+	EVDEV_addDevice("/dev/input/event3", 0); // volume
 }
 
 /**
  * Closes all input device file descriptors.
  */
 void PLAT_quitInput(void) {
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		close(inputs[i]);
-	}
+	EVDEV_quit();
 }
 
-// from <linux/input.h> which has BTN_ constants that conflict with platform.h
-struct input_event {
-	struct timeval time;
-	__u16 type;
-	__u16 code;
-	__s32 value;
-};
-#define EV_KEY 0x01
-#define EV_ABS 0x03
+///////////////////////////////
+// Input Polling
+///////////////////////////////
 
 /**
- * Updates button state in the pad structure based on press/release events.
- *
- * Manages three button states:
- * - is_pressed: Currently held buttons
- * - just_pressed: Buttons pressed this frame (transient)
- * - just_repeated: Buttons eligible for repeat this frame (transient)
- * - just_released: Buttons released this frame (transient)
+ * Translates a single evdev event to button/axis state.
  *
- * @param btn Button mask (e.g., BTN_A, BTN_B)
- * @param id Button ID for repeat timing array indexing
- * @param pressed 1 if button pressed, 0 if released
- * @param tick Current tick count for scheduling next repeat
- *
- * @note If btn is BTN_NONE, this function does nothing
+ * The left analog stick generates digital button presses via PAD_setAnalog().
  */
-static void updateButton(int btn, int id, int pressed, uint32_t tick) {
-	if (btn == BTN_NONE)
+static void handleEvent(int device, const EVDEV_Event* event, void* userdata) {
+	uint32_t tick = *(uint32_t*)userdata;
+	int code = event->code;
+	int value = event->value;
+
+	if (event->type == EVDEV_EV_KEY) {
+		if (value > 1)
+			return; // ignore kernel key repeats (we handle repeats ourselves)
+
+		// LOG_info("key event: %i (%i)\n", code,value);
+		int id = EVDEV_mapCode(button_mapping, code);
+		if (value == 1)
+			LAT_markInput(EVDEV_eventTime(event), id);
+		PAD_setButton(id, value, tick);
 		return;
-
-	if (!pressed) {
-		pad.is_pressed &= ~btn; // unset
-		pad.just_repeated &= ~btn; // unset
-		pad.just_released |= btn; // set
-	} else if ((pad.is_pressed & btn) == BTN_NONE) {
-		pad.just_pressed |= btn; // set
-		pad.just_repeated |= btn; // set
-		pad.is_pressed |= btn; // set
-		pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
 	}
-}
 
-///////////////////////////////
-// Input Polling
-///////////////////////////////
+	// EV_ABS
+	// LOG_info("abs event: %i (%i)\n", code, value);
+	if (code == RAW_LSX) {
+		pad.laxis.x = value;
+		PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x, tick + PAD_REPEAT_DELAY);
+	} else if (code == RAW_LSY) {
+		pad.laxis.y = value;
+		PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y, tick + PAD_REPEAT_DELAY);
+	} else if (code == RAW_RSX)
+		pad.raxis.x = value;
+	else if (code == RAW_RSY)
+		pad.raxis.y = value;
+}
 
 /**
  * Polls all input devices and updates the global pad state.
  *
- * Reads input events from all three input devices (power, gamepad, volume)
- * and translates raw input codes to button masks. Handles both digital buttons
- * (EV_KEY) and analog sticks (EV_ABS). The left analog stick generates digital
- * button presses via PAD_setAnalog().
- *
- * Special behavior:
- * - L3 and R3 buttons also trigger BTN_MENU
- * - Analog stick values are stored in pad.laxis and pad.raxis
- * - Button repeat timing is automatically handled for held buttons
+ * Drains pending events from the power, gamepad and volume devices
+ * through the evdev backend. Analog stick values are stored in
+ * pad.laxis and pad.raxis.
  *
  * @note Transient state (just_pressed, just_released, just_repeated) is
  *       reset at the start of each poll
  */
 void PLAT_pollInput(void) {
-	// reset transient state
-	pad.just_pressed = BTN_NONE;
-	pad.just_released = BTN_NONE;
-	pad.just_repeated = BTN_NONE;
-
 	uint32_t tick = SDL_GetTicks();
-	// Handle button repeat for held buttons
-	for (int i = 0; i < BTN_ID_COUNT; i++) {
-		int btn = 1 << i;
-		if ((pad.is_pressed & btn) && (tick >= pad.repeat_at[i])) {
-			pad.just_repeated |= btn; // set
-			pad.repeat_at[i] += PAD_REPEAT_INTERVAL;
-		}
-	}
-
-	// the actual poll
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type != EV_KEY && event.type != EV_ABS)
-				continue;
-
-			int btn = BTN_NONE;
-			int pressed = 0; // 0=up,1=down
-			int id = -1;
-			int type = event.type;
-			int code = event.code;
-			int value = event.value;
-
-			if (type == EV_KEY) {
-				if (value > 1)
-					continue; // ignore kernel key repeats (we handle repeats ourselves)
-
-				pressed = value;
-				// LOG_info("key event: %i (%i)\n", code,pressed);
-				if (code == RAW_UP) {
-					btn = BTN_DPAD_UP;
-					id = BTN_ID_DPAD_UP;
-				} else if (code == RAW_DOWN) {
-					btn = BTN_DPAD_DOWN;
-					id = BTN_ID_DPAD_DOWN;
-				} else if (code == RAW_LEFT) {
-					btn = BTN_DPAD_LEFT;
-					id = BTN_ID_DPAD_LEFT;
-				} else if (code == RAW_RIGHT) {
-					btn = BTN_DPAD_RIGHT;
-					id = BTN_ID_DPAD_RIGHT;
-				} else if (code == RAW_A) {
-					btn = BTN_A;
-					id = BTN_ID_A;
-				} else if (code == RAW_B) {
-					btn = BTN_B;
-					id = BTN_ID_B;
-				} else if (code == RAW_X) {
-					btn = BTN_X;
-					id = BTN_ID_X;
-				} else if (code == RAW_Y) {
-					btn = BTN_Y;
-					id = BTN_ID_Y;
-				} else if (code == RAW_START) {
-					btn = BTN_START;
-					id = BTN_ID_START;
-				} else if (code == RAW_SELECT) {
-					btn = BTN_SELECT;
-					id = BTN_ID_SELECT;
-				} else if (code == RAW_MENU) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_MENU1) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_MENU2) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_L1) {
-					btn = BTN_L1;
-					id = BTN_ID_L1;
-				} else if (code == RAW_L2) {
-					btn = BTN_L2;
-					id = BTN_ID_L2;
-				} else if (code == RAW_L3) {
-					btn = BTN_L3;
-					id = BTN_ID_L3;
-				} else if (code == RAW_R1) {
-					btn = BTN_R1;
-					id = BTN_ID_R1;
-				} else if (code == RAW_R2) {
-					btn = BTN_R2;
-					id = BTN_ID_R2;
-				} else if (code == RAW_R3) {
-					btn = BTN_R3;
-					id = BTN_ID_R3;
-				} else if (code == RAW_PLUS) {
-					btn = BTN_PLUS;
-					id = BTN_ID_PLUS;
-				} else if (code == RAW_MINUS) {
-					btn = BTN_MINUS;
-					id = BTN_ID_MINUS;
-				} else if (code == RAW_POWER) {
-					btn = BTN_POWER;
-					id = BTN_ID_POWER;
-				}
-			} else if (type == EV_ABS) {
-				// Analog stick events - left stick generates digital button presses
-				LOG_info("abs event: %i (%i)\n", code, value);
-				if (code == RAW_LSX) {
-					pad.laxis.x = value;
-					PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
-					              tick + PAD_REPEAT_DELAY);
-				} else if (code == RAW_LSY) {
-					pad.laxis.y = value;
-					PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
-					              tick + PAD_REPEAT_DELAY);
-				} else if (code == RAW_RSX)
-					pad.raxis.x = value;
-				else if (code == RAW_RSY)
-					pad.raxis.y = value;
-			}
+	PAD_beginFrame(tick);
 
-			if (btn == BTN_NONE)
-				continue;
+	EVDEV_poll(handleEvent, &tick);
+}
 
-			updateButton(btn, id, pressed, tick);
-			// L3/R3 buttons also trigger MENU button
-			if (btn == BTN_L3 || btn == BTN_R3)
-				updateButton(BTN_MENU, BTN_ID_MENU, pressed, tick);
-		}
-	}
+/**
+ * Checks for a power button release while asleep.
+ */
+static void handleWakeEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type == EVDEV_EV_KEY && event->code == RAW_POWER && event->value == 0)
+		*(int*)userdata = 1;
 }
 
 /**
@@ -313,17 +206,9 @@ void PLAT_pollInput(void) {
  * @return 1 if power button was released, 0 otherwise
  */
 int PLAT_shouldWake(void) {
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type == EV_KEY && event.code == RAW_POWER && event.value == 0) {
-				return 1;
-			}
-		}
-	}
-	return 0;
+	int wake = 0;
+	EVDEV_poll(handleWakeEvent, &wake);
+	return wake;
 }
 
 ///////////////////////////////
@@ -1037,6 +922,9 @@ void PLAT_flip(SDL_Surface* IGNORED, int ignored) {
 
 static int online = 0; // Wi-Fi connection status
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/ac/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/battery/capacity", 0);
+
 /**
  * Gets battery charging status and charge level.
  *
@@ -1049,9 +937,9 @@ static int online = 0; // Wi-Fi connection status
  * @note Wi-Fi status tracking is currently disabled but could be polled here
  */
 void PLAT_getBatteryStatus(int* is_charging, int* charge) {
-	*is_charging = getInt("/sys/class/power_supply/ac/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
-	int i = getInt("/sys/class/power_supply/battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// Bucket charge level to reduce UI flicker from minor fluctuations
 	if (i > 80)
 		*charge = 100;
@@ -1083,7 +971,7 @@ void PLAT_enableBacklight(int enable) {
 		putInt(BACKLIGHT_PATH, FB_BLANK_UNBLANK);
 	} else {
 		SetRawBrightness(0);
-		system("dd if=/dev/zero of=/dev/fb0"); // Clear framebuffer (may not work on all kernels)
+		zeroDevice("/dev/fb0"); // Clear framebuffer (may not work on all kernels)
 		putInt(BACKLIGHT_PATH, FB_BLANK_POWERDOWN);
 	}
 }
@@ -26,7 +26,9 @@
  * The daemon auto-detects the hardware variant by checking for /customer/app/axp_test
  * and uses the appropriate battery monitoring interface.
  *
- * Runs continuously polling input events and battery status.
+ * Built on the shared keymon core, which sleeps until input arrives or a
+ * timer is due, repeats held keys itself and checks the battery every
+ * 5 seconds from the same loop.
  */
 
 #include <stdio.h>
@@ -45,9 +47,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
-#include <pthread.h>
 
 #include "../../all/common/log.h"
+#include "../../all/common/keymon_core.h"
 
 // Button code definitions (from Linux input.h)
 #define	BUTTON_MENU		KEY_ESC
@@ -67,25 +69,12 @@
 #define VOLMAX		20
 #define BRIMAX		10
 
-// Input event values from linux/input.h
-#define RELEASED	0
-#define PRESSED		1
-#define REPEAT		2
-
 // Button state bit flags for tracking SELECT/START combinations
 #define SELECT_BIT	0
 #define START_BIT	1
 #define SELECT		(1<<SELECT_BIT)
 #define START		(1<<START_BIT)
 
-// Debug error handling
-// #define DEBUG  // Replaced with LOG system
-#if 0  // Replaced with LOG system
-#define ERROR(str) do { LOG_error(str); quit(EXIT_FAILURE); } while(0)
-#else
-#define ERROR(str) do { LOG_error(str); quit(EXIT_FAILURE); } while(0)
-#endif
-
 // Miyoo Mini Plus AXP223 PMIC I2C configuration (via eggs)
 #define	AXPDEV	"/dev/i2c-1"
 #define	AXPID	(0x34)
@@ -188,26 +177,10 @@ static int is_charging = 0;           // Current charging state
 static int is_plus = 0;               // Hardware variant flag (1=Plus, 0=standard)
 static int eased_charge = 0;          // Smoothed battery percentage
 static int sar_fd = 0;                // SAR ADC file descriptor
-static struct input_event	ev;
-static int	input_fd = 0;
-static pthread_t adc_pt;              // Battery monitoring thread
 
-/**
- * Clean shutdown handler.
- *
- * Cancels battery monitoring thread, closes file descriptors, and exits.
- *
- * @param exitcode Exit status code
- */
-void quit(int exitcode) {
-	pthread_cancel(adc_pt);
-	pthread_join(adc_pt, NULL);
-	QuitSettings();
-
-	if (input_fd > 0) close(input_fd);
-	if (sar_fd > 0) close(sar_fd);
-	exit(exitcode);
-}
+static int button_flag = 0;           // Bit flags for SELECT/START state
+static int menu_pressed = 0;
+static int power_pressed = 0;
 
 /**
  * Reads current battery percentage.
@@ -338,159 +311,134 @@ static void checkADC(void) {
 }
 
 /**
- * Background thread for battery monitoring.
+ * Steps volume or brightness for a held L/R or volume key.
  *
- * Updates battery status every 5 seconds.
+ * - Standard Miyoo Mini: SELECT+L/R steps volume, START+L/R brightness
+ * - Miyoo Mini Plus: VOLUMEUP/DOWN alone steps volume, MENU+VOLUMEUP/DOWN
+ *   brightness
  *
- * @param arg Thread argument (unused)
- * @return Never returns (runs infinite loop)
+ * @param code Key code
+ * @return 1 if volume or brightness changed, 0 otherwise
  */
-static void* runADC(void *arg) {
-	while(1) {
-		sleep(5);
-		checkADC();
+static int stepSetting(int code) {
+	int up = code==BUTTON_R1 || code==BUTTON_R2 || code==BUTTON_PLUS;
+	int val;
+	if ((is_plus && !menu_pressed) || button_flag==SELECT) {
+		val = GetVolume();
+		if (up && val<VOLMAX) SetVolume(++val);
+		else if (!up && val>0) SetVolume(--val);
+		else return 0;
+		return 1;
+	}
+	else if ((is_plus && menu_pressed) || button_flag==START) {
+		val = GetBrightness();
+		if (up && val<BRIMAX) SetBrightness(++val);
+		else if (!up && val>0) SetBrightness(--val);
+		else return 0;
+		return 1;
 	}
 	return 0;
 }
 
 /**
- * Main event loop for hardware button monitoring.
+ * Steps volume or brightness again while the key is held.
  *
- * Continuously polls input device for button events and handles:
- * - Standard Miyoo Mini:
- *   - SELECT+L1/R1/L2/R2: Adjust volume
- *   - START+L1/R1/L2/R2: Adjust brightness
- * - Miyoo Mini Plus:
- *   - VOLUMEUP/DOWN alone: Adjust volume
- *   - MENU+VOLUMEUP/DOWN: Adjust brightness
- *   - L1/R1/L2/R2 also work as alternatives
- * - Both models:
- *   - MENU+POWER: System shutdown
+ * @param code Key code
+ */
+static void repeatSetting(int code) {
+	stepSetting(code);
+}
+
+/**
+ * Handles hardware button presses and releases.
  *
- * Also starts battery monitoring thread to update /tmp/battery every 5 seconds.
+ * MENU+POWER initiates a system shutdown on both models.
  *
- * Implements custom repeat handling (halved repeat rate: every other REPEAT event).
+ * @param code Key code
+ * @param value KEYMON_PRESSED or KEYMON_RELEASED
+ * @return 1 to repeat a volume/brightness key while held, only if the
+ *         press changed a setting (a shoulder button alone is game input)
+ */
+static int handleKey(int code, int value) {
+	int repeat = 0;
+	switch (code) {
+	case BUTTON_MENU:
+		menu_pressed = value;
+		break;
+	case BUTTON_POWER:
+		power_pressed = value;
+		break;
+	case BUTTON_SELECT:
+		button_flag = (button_flag & ~SELECT) | (value<<SELECT_BIT);
+		break;
+	case BUTTON_START:
+		button_flag = (button_flag & ~START) | (value<<START_BIT);
+		break;
+	case BUTTON_L1:
+	case BUTTON_L2:
+	case BUTTON_MINUS:
+	case BUTTON_R1:
+	case BUTTON_R2:
+	case BUTTON_PLUS:
+		// L/R only adjust on the standard model, the Plus has volume keys
+		if (value==KEYMON_PRESSED && (code==BUTTON_MINUS || code==BUTTON_PLUS || !is_plus)) {
+			repeat = stepSetting(code);
+		}
+		break;
+	default:
+		break;
+	}
+
+	// MENU+POWER: Initiate system shutdown
+	if (menu_pressed && power_pressed) {
+		menu_pressed = power_pressed = 0;
+		system("shutdown");
+		while (1) pause();  // Wait for shutdown to complete
+	}
+	return repeat;
+}
+
+/**
+ * Releases held modifiers after stale input was dropped.
+ */
+static void resetKeys(void) {
+	button_flag = 0;
+	menu_pressed = 0;
+	power_pressed = 0;
+}
+
+/**
+ * Runs the keymon event loop.
+ *
+ * Key repeat comes from the keymon core (300ms delay, then every 100ms),
+ * and the battery is checked every 5 seconds to keep /tmp/battery up to
+ * date.
  *
  * @param argc Argument count (unused)
  * @param argv Argument values (unused)
- * @return Never returns (runs infinite loop)
+ * @return 0 on clean exit, 1 if the event loop couldn't start
+ *
+ * @note Uses event0 input device
  */
 int main (int argc, char *argv[]) {
 	// Initialize battery monitoring
 	initADC();
-	checkADC();
-	pthread_create(&adc_pt, NULL, &runADC, NULL);
 
 	// Initialize settings (volume/brightness)
 	InitSettings();
 
-	input_fd = open("/dev/input/event0", O_RDONLY);
-
-	// Main button processing loop
-	register uint32_t val;
-	register uint32_t code;
-	register uint32_t button_flag = 0;  // Bit flags for SELECT/START state
-	register uint32_t menu_pressed = 0;
-	register uint32_t power_pressed = 0;
-	uint32_t repeat_LR = 0;  // Toggle for halving repeat rate
-	while( read(input_fd, &ev, sizeof(ev)) == sizeof(ev) ) {
-		val = ev.value;
-		// Only process key events (PRESSED, RELEASED, or REPEAT)
-		if (( ev.type != EV_KEY ) || ( val > REPEAT )) continue;
-		code = ev.code;
-
-		// Process hardware button events
-		switch (code) {
-		case BUTTON_MENU:
-			// Ignore REPEAT events for MENU (modifier key)
-			if ( val != REPEAT ) menu_pressed = val;
-			break;
-		case BUTTON_POWER:
-			// Ignore REPEAT events for POWER
-			if ( val != REPEAT ) power_pressed = val;
-			break;
-		case BUTTON_SELECT:
-			// Update SELECT bit in button_flag (ignore REPEAT)
-			if ( val != REPEAT ) button_flag = button_flag & (~SELECT) | (val<<SELECT_BIT);
-			// if (val) {
-			// 	static int tick = 0;
-			// 	char cmd[256];
-			//
-			// 	sprintf(cmd, "ps ax -o pid,nice,comm,args &> /mnt/SDCARD/%04i-nice.txt", tick);
-			// 	system(cmd);
-			//
-			// 	sprintf(cmd, "top -b -n 1 > /mnt/SDCARD/%04i-top.txt", tick++);
-			// 	system(cmd);
-			// }
-			break;
-		case BUTTON_START:
-			// Update START bit in button_flag (ignore REPEAT)
-			if ( val != REPEAT ) button_flag = button_flag & (~START) | (val<<START_BIT);
-			break;
-		case BUTTON_L1:
-		case BUTTON_L2:
-		case BUTTON_MINUS:
-			// Volume/brightness down (MINUS on Plus, L1/L2 on both)
-			if (code==BUTTON_MINUS || !is_plus) {
-				if ( val == REPEAT ) {
-					// Halve repeat rate (process every other REPEAT event)
-					val = repeat_LR;
-					repeat_LR ^= PRESSED;
-				} else {
-					repeat_LR = 0;
-				}
-
-				if ( val == PRESSED ) {
-					if ((is_plus && !menu_pressed) || button_flag==SELECT) {
-						// Plus: VOLUMEDOWN alone, or Mini: SELECT+L
-						val = GetVolume();
-						if (val>0) SetVolume(--val);
-					}
-					else if ((is_plus && menu_pressed) || button_flag==START) {
-						// Plus: MENU+VOLUMEDOWN, or Mini: START+L
-						val = GetBrightness();
-						if (val>0) SetBrightness(--val);
-					}
-				}
-			}
-			break;
-		case BUTTON_R1:
-		case BUTTON_R2:
-		case BUTTON_PLUS:
-			// Volume/brightness up (PLUS on Plus, R1/R2 on both)
-			if (code==BUTTON_PLUS || !is_plus) {
-				if ( val == REPEAT ) {
-					// Halve repeat rate (process every other REPEAT event)
-					val = repeat_LR;
-					repeat_LR ^= PRESSED;
-				} else {
-					repeat_LR = 0;
-				}
-
-				if ( val == PRESSED ) {
-					if ((is_plus && !menu_pressed) || button_flag==SELECT) {
-						// Plus: VOLUMEUP alone, or Mini: SELECT+R
-						val = GetVolume();
-						if (val<VOLMAX) SetVolume(++val);
-					}
-					else if ((is_plus && menu_pressed) || button_flag==START) {
-						// Plus: MENU+VOLUMEUP, or Mini: START+R
-						val = GetBrightness();
-						if (val<BRIMAX) SetBrightness(++val);
-					}
-				}
-			}
-			break;
-		default:
-			break;
-		}
-		
-		// MENU+POWER: Initiate system shutdown
-		if (menu_pressed && power_pressed) {
-			menu_pressed = power_pressed = 0;
-			system("shutdown");
-			while (1) pause();  // Wait for shutdown to complete
-		}
-	}
-	ERROR("Failed to read input event");
+	static const char* inputs[] = {"/dev/input/event0", NULL};
+	KEYMON_Hooks hooks = {
+		.handleKey = handleKey,
+		.handleRepeat = repeatSetting,
+		.reset = resetKeys,
+		.poll = checkADC,
+		.poll_ms = 5000,
+	};
+	int result = KEYMON_run(inputs, &hooks);
+	if (result < 0) LOG_error("Failed to start input event loop");
+
+	QuitSettings();
+	if (sar_fd > 0) close(sar_fd);
+	return result < 0 ? 1 : 0;
 }
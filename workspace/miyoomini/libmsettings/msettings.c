@@ -15,6 +15,7 @@
 #include <linux/i2c-dev.h>
 
 #include "msettings.h"
+#include "../../all/common/settings_sync.h"
 #include "log.h"
 
 ///////////////////////////////////////
@@ -107,11 +108,18 @@ static Settings DefaultSettings = {
 };
 static Settings* settings;
 
+// shared memory layout, only settings is persisted so it must stay first
+typedef struct SharedSettings {
+	Settings settings;
+	SettingsSync sync;
+} SharedSettings;
+static SettingsSync* settings_sync;
+
 #define SHM_KEY "/SharedSettings"
 static char SettingsPath[256];
 static int shm_fd = -1;
 static int is_host = 0;
-static int shm_size = sizeof(Settings);
+static int shm_size = sizeof(SharedSettings);
 static int is_plus = 0;
 
 void InitSettings(void) {
@@ -123,7 +131,11 @@ void InitSettings(void) {
 	if (shm_fd==-1 && errno==EEXIST) { // already exists
 		LOG_debug("Settings client (connecting to existing shared memory)");
 		shm_fd = shm_open(SHM_KEY, O_RDWR, 0644);
+		// an older build may have left a smaller object, mapping past its end would SIGBUS
+		struct stat st;
+		if (fstat(shm_fd, &st)==0 && st.st_size<shm_size) ftruncate(shm_fd, shm_size);
 		settings = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+		settings_sync = &((SharedSettings*)settings)->sync;
 	}
 	else { // host (creating new shared memory)
 		LOG_debug("Settings host (creating new shared memory)");
@@ -131,16 +143,17 @@ void InitSettings(void) {
 		// we created it so set initial size and populate
 		ftruncate(shm_fd, shm_size);
 		settings = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+		settings_sync = &((SharedSettings*)settings)->sync;
 		
 		int fd = open(SettingsPath, O_RDONLY);
 		if (fd>=0) {
-			read(fd, settings, shm_size);
+			read(fd, settings, sizeof(Settings));
 			// TODO: use settings->version for future proofing
 			close(fd);
 		}
 		else {
 			// load defaults
-			memcpy(settings, &DefaultSettings, shm_size);
+			memcpy(settings, &DefaultSettings, sizeof(Settings));
 		}
 	}
 	LOG_debug("Loaded settings: brightness=%i speaker=%i", settings->brightness, settings->speaker);
@@ -154,10 +167,16 @@ void QuitSettings(void) {
 	munmap(settings, shm_size);
 	if (is_host) shm_unlink(SHM_KEY);
 }
+static Settings SnapshotSettings(void) {
+	Settings copy;
+	SettingsSync_read(settings_sync, &copy, settings, sizeof(Settings));
+	return copy;
+}
 static inline void SaveSettings(void) {
 	int fd = open(SettingsPath, O_CREAT|O_WRONLY, 0644);
 	if (fd>=0) {
-		write(fd, settings, shm_size);
+		Settings copy = SnapshotSettings();
+		write(fd, &copy, sizeof(copy));
 		close(fd);
 		sync();
 	}
@@ -168,7 +187,9 @@ int GetBrightness(void) { // 0-10
 }
 void SetBrightness(int value) {
 	SetRawBrightness(value==0?6:value*10);
+	SettingsSync_beginWrite(settings_sync);
 	settings->brightness = value;
+	SettingsSync_endWrite(settings_sync);
 	SaveSettings();
 }
 
@@ -178,7 +199,9 @@ int GetVolume(void) { // 0-20
 void SetVolume(int value) {
 	int raw = -60 + value * 3;
 	SetRawVolume(raw);
+	SettingsSync_beginWrite(settings_sync);
 	settings->speaker = value;
+	SettingsSync_endWrite(settings_sync);
 	SaveSettings();
 }
 
@@ -227,3 +250,7 @@ void SetHDMI(int value) {
 
 int GetMute(void) { return 0; }
 void SetMute(int value) {}
+
+unsigned GetSettingsGeneration(void) {
+	return SettingsSync_getGeneration(settings_sync);
+}
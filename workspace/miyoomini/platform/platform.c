@@ -49,6 +49,7 @@
 #include "defines.h"
 #include "platform.h"
 #include "scaler.h"
+#include "sysfs.h"
 #include "utils.h"
 
 ///////////////////////////////
@@ -249,6 +250,9 @@ static inline void GFX_BlitSurfaceExec(SDL_Surface* src, SDL_Rect* srcrect, SDL_
 
 #define LID_PATH "/sys/devices/soc0/soc/soc:hall-mh248/hallvalue"
 
+// polled every frame, so keep it open and re-read at most every 100ms
+static SysfsValue lid_state = SYSFS_VALUE(LID_PATH, 100);
+
 /**
  * Initializes lid sensor support.
  *
@@ -267,7 +271,7 @@ void PLAT_initLid(void) {
  */
 int PLAT_lidChanged(int* state) {
 	if (lid.has_lid) {
-		int lid_open = getInt(LID_PATH);
+		int lid_open = SysfsValue_getInt(&lid_state);
 		if (lid_open != lid.is_open) {
 			lid.is_open = lid_open;
 			if (state)
@@ -647,6 +651,19 @@ void PLAT_flip(SDL_Surface* IGNORED, int sync) {
 	}
 }
 
+/**
+ * Checks whether the screen surface holds the frame about to be flipped.
+ *
+ * PLAT_blitRenderer() scales into the screen page, so it always does.
+ *
+ * @param blitted Unused
+ * @return 1
+ */
+int PLAT_screenHoldsFrame(int blitted) {
+	(void)blitted;
+	return 1;
+}
+
 ///////////////////////////////
 // Power Management - AXP223 PMIC (Plus Model)
 ///////////////////////////////
@@ -746,6 +763,9 @@ int axp_read(unsigned char address) {
 
 static int online = 0; // WiFi connection status
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/devices/gpiochip0/gpio/gpio59/value", 0);
+static SysfsValue wifi_state = SYSFS_VALUE("/sys/class/net/wlan0/operstate", 0);
+
 /**
  * Gets battery charge level and charging status.
  *
@@ -763,7 +783,7 @@ static int online = 0; // WiFi connection status
 void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// Check charging status (hardware-dependent)
 	*is_charging =
-	    is_plus ? (axp_read(0x00) & 0x4) > 0 : getInt("/sys/devices/gpiochip0/gpio/gpio59/value");
+	    is_plus ? (axp_read(0x00) & 0x4) > 0 : SysfsValue_getInt(&charger_online);
 
 	// Read battery percentage from system daemon
 	int i = getInt("/tmp/battery"); // 0-100
@@ -783,9 +803,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 		*charge = 10;
 
 	// Update WiFi connection status
-	char status[16];
-	getFile("/sys/class/net/wlan0/operstate", status, 16);
-	online = prefixMatch("up", status);
+	online = prefixMatch("up", (char*)SysfsValue_getString(&wifi_state));
 }
 
 /**
@@ -870,9 +888,9 @@ void PLAT_setCPUSpeed(int speed) {
 		break;
 	}
 
-	char cmd[32];
-	sprintf(cmd, "overclock.elf %d\n", freq);
-	system(cmd);
+	char arg[16];
+	sprintf(arg, "%d", freq);
+	runProgram((char* const[]){"overclock.elf", arg, NULL});
 }
 
 ///////////////////////////////
@@ -10,8 +10,8 @@
  * Uses different input event codes than SDL (CODE_MENU can be 1 or 354).
  * Monitors two separate input devices (event0 and event3).
  *
- * Runs continuously at 60Hz polling the input devices for button events.
- * Ignores stale input after system sleep to prevent spurious events.
+ * Built on the shared keymon core, which sleeps until input arrives or a
+ * timer is due and ignores stale input after system sleep.
  */
 
 #include <stdio.h>
@@ -19,17 +19,11 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <string.h>
-#include <fcntl.h>
-#include <dirent.h>
-#include <linux/input.h>
 
-#include <msettings.h>
-
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/ioctl.h>
+#include "../../all/common/log.h"
+#include "../../all/common/keymon_core.h"
 
-// #include "defines.h"
+#include <msettings.h>
 
 #define VOLUME_MIN 		0
 #define VOLUME_MAX 		20
@@ -41,146 +35,81 @@
 #define CODE_PLUS		115
 #define CODE_MINUS		114
 
-// Input event values from linux/input.h
-#define RELEASED	0
-#define PRESSED		1
-#define REPEAT		2
+static const char* inputs[] = {
+	"/dev/input/event0",
+	"/dev/input/event3",
+	NULL,
+};
 
-#define INPUT_COUNT 2
-static int inputs[INPUT_COUNT];
-static struct input_event ev;
+static int menu_pressed = 0;
 
 /**
- * Main event loop for hardware button monitoring.
+ * Steps brightness (MENU held) or volume by one in the key's direction.
  *
- * Continuously polls two input devices for button events and handles:
- * - MENU+PLUS: Increase brightness
- * - MENU+MINUS: Decrease brightness
- * - PLUS alone: Increase volume
- * - MINUS alone: Decrease volume
+ * @param code CODE_PLUS or CODE_MINUS
+ */
+static void stepSetting(int code) {
+	int val;
+	if (menu_pressed) {
+		val = GetBrightness();
+		if (code==CODE_PLUS && val<BRIGHTNESS_MAX) SetBrightness(++val);
+		else if (code==CODE_MINUS && val>BRIGHTNESS_MIN) SetBrightness(--val);
+	}
+	else {
+		val = GetVolume();
+		if (code==CODE_PLUS && val<VOLUME_MAX) SetVolume(++val);
+		else if (code==CODE_MINUS && val>VOLUME_MIN) SetVolume(--val);
+	}
+}
+
+/**
+ * Handles hardware button presses and releases.
  *
- * Implements repeat functionality (initial 300ms delay, then 100ms interval)
- * and ignores stale input after system sleep (> 1 second gap).
+ * @param code Key code
+ * @param value KEYMON_PRESSED or KEYMON_RELEASED
+ * @return 1 to repeat PLUS/MINUS while held
+ */
+static int handleKey(int code, int value) {
+	switch (code) {
+		case CODE_MENU:
+			menu_pressed = value;
+		break;
+		case CODE_PLUS:
+		case CODE_MINUS:
+			if (value==KEYMON_PRESSED) {
+				stepSetting(code);
+				return 1;
+			}
+		break;
+		default:
+		break;
+	}
+	return 0;
+}
+
+/**
+ * Releases the MENU modifier after stale input was dropped.
+ */
+static void resetKeys(void) {
+	menu_pressed = 0;
+}
+
+/**
+ * Runs the keymon event loop.
  *
  * @param argc Argument count (unused)
  * @param argv Argument values (unused)
- * @return Never returns (runs infinite loop)
+ * @return 0 on clean exit
  *
  * @note Uses event0 and event3 input devices
  */
 int main (int argc, char *argv[]) {
 	InitSettings();
 
-	// Open multiple input devices for button monitoring
-	inputs[0] = open("/dev/input/event0", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-	inputs[1] = open("/dev/input/event3", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-
-	uint32_t val;
-	uint32_t menu_pressed = 0;
-
-	// Track PLUS button state for repeat handling
-	uint32_t up_pressed = 0;
-	uint32_t up_just_pressed = 0;
-	uint32_t up_repeat_at = 0;
-
-	// Track MINUS button state for repeat handling
-	uint32_t down_pressed = 0;
-	uint32_t down_just_pressed = 0;
-	uint32_t down_repeat_at = 0;
-
-	uint8_t ignore;
-	uint32_t then;
-	uint32_t now;
-	struct timeval tod;
-
-	gettimeofday(&tod, NULL);
-	then = tod.tv_sec * 1000 + tod.tv_usec / 1000; // SDL_GetTicks() equivalent
-	ignore = 0;
-
-	while (1) {
-		gettimeofday(&tod, NULL);
-		now = tod.tv_sec * 1000 + tod.tv_usec / 1000;
-
-		// Ignore stale input after system sleep to avoid spurious events
-		if (now-then>1000) ignore = 1;
-
-		// Poll both input devices for button events
-		for (int i=0; i<INPUT_COUNT; i++) {
-			int input_fd = inputs[i];
-			while(read(input_fd, &ev, sizeof(ev))==sizeof(ev)) {
-				if (ignore) continue;
-				val = ev.value;
-
-				// Only process key events (PRESSED, RELEASED, or REPEAT)
-				if (( ev.type != EV_KEY ) || ( val > REPEAT )) continue;
-
-				// Process hardware button events
-				switch (ev.code) {
-					case CODE_MENU:
-						menu_pressed = val;
-					break;
-				case CODE_PLUS:
-						// Volume up button (or brightness up if MENU held)
-						up_pressed = up_just_pressed = val;
-						if (val) up_repeat_at = now + 300; // 300ms initial delay
-					break;
-					case CODE_MINUS:
-						// Volume down button (or brightness down if MENU held)
-						down_pressed = down_just_pressed = val;
-						if (val) down_repeat_at = now + 300; // 300ms initial delay
-					break;
-					default:
-					break;
-				}
-			}
-		}
-
-		// Reset button state after ignoring stale input
-		if (ignore) {
-			menu_pressed = 0;
-			up_pressed = up_just_pressed = 0;
-			down_pressed = down_just_pressed = 0;
-			up_repeat_at = 0;
-			down_repeat_at = 0;
-		}
-
-		// Handle PLUS button (initial press or repeat after delay)
-		if (up_just_pressed || (up_pressed && now>=up_repeat_at)) {
-			if (menu_pressed) {
-				// MENU+PLUS: Brightness up
-				val = GetBrightness();
-				if (val<BRIGHTNESS_MAX) SetBrightness(++val);
-			}
-			else {
-				// PLUS alone: Volume up
-				val = GetVolume();
-				if (val<VOLUME_MAX) SetVolume(++val);
-			}
-
-			if (up_just_pressed) up_just_pressed = 0;
-			else up_repeat_at += 100; // 100ms repeat interval
-		}
-
-		// Handle MINUS button (initial press or repeat after delay)
-		if (down_just_pressed || (down_pressed && now>=down_repeat_at)) {
-			if (menu_pressed) {
-				// MENU+MINUS: Brightness down
-				val = GetBrightness();
-				if (val>BRIGHTNESS_MIN) SetBrightness(--val);
-			}
-			else {
-				// MINUS alone: Volume down
-				val = GetVolume();
-				if (val>VOLUME_MIN) SetVolume(--val);
-			}
-
-			if (down_just_pressed) down_just_pressed = 0;
-			else down_repeat_at += 100; // 100ms repeat interval
-		}
-
-		then = now;
-		ignore = 0;
-
-		usleep(16666); // 60Hz polling rate
-	}
+	KEYMON_Hooks hooks = {
+		.handleKey = handleKey,
+		.handleRepeat = stepSetting,
+		.reset = resetKeys,
+	};
+	return KEYMON_run(inputs, &hooks) < 0 ? 1 : 0;
 }
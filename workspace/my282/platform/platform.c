@@ -30,7 +30,10 @@
 
 #include "api.h"
 #include "defines.h"
+#include "evdev.h"
+#include "latency.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -58,19 +61,39 @@
 #define RAW_MINUS 114
 #define RAW_POWER 116
 
-#define INPUT_COUNT 2
-static int inputs[INPUT_COUNT];
+static const EVDEV_Mapping button_mapping[] = {
+    {RAW_UP, BTN_ID_DPAD_UP},
+    {RAW_DOWN, BTN_ID_DPAD_DOWN},
+    {RAW_LEFT, BTN_ID_DPAD_LEFT},
+    {RAW_RIGHT, BTN_ID_DPAD_RIGHT},
+    {RAW_A, BTN_ID_A},
+    {RAW_B, BTN_ID_B},
+    {RAW_X, BTN_ID_X},
+    {RAW_Y, BTN_ID_Y},
+    {RAW_START, BTN_ID_START},
+    {RAW_SELECT, BTN_ID_SELECT},
+    {RAW_MENU, BTN_ID_MENU},
+    {RAW_L1, BTN_ID_L1},
+    {RAW_L2, BTN_ID_L2},
+    {RAW_R1, BTN_ID_R1},
+    {RAW_R2, BTN_ID_R2},
+    {RAW_PLUS, BTN_ID_PLUS},
+    {RAW_MINUS, BTN_ID_MINUS},
+    {RAW_POWER, BTN_ID_POWER},
+    EVDEV_MAPPING_END,
+};
 
 /**
  * Initializes input system (buttons and analog stick).
  *
- * Opens input event devices for power button (event0) and
- * controller buttons/dpad (event3). Also initializes analog
- * stick support via Stick_init() from mstick library.
+ * Registers the power button (event0) and controller buttons/dpad
+ * (event3) with the evdev backend. Also initializes analog stick
+ * support via Stick_init() from mstick library.
  */
 void PLAT_initInput(void) {
-	inputs[0] = open("/dev/input/event0", O_RDONLY | O_NONBLOCK | O_CLOEXEC); // power
-	inputs[1] = open("/dev/input/event3", O_RDONLY | O_NONBLOCK | O_CLOEXEC); // controller
+	EVDEV_init();
+	EVDEV_addDevice("/dev/input/event0", 0); // power
+	EVDEV_addDevice("/dev/input/event3", 0); // controller
 	Stick_init(); // analog
 }
 
@@ -79,164 +102,61 @@ void PLAT_initInput(void) {
  */
 void PLAT_quitInput(void) {
 	Stick_quit();
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		close(inputs[i]);
-	}
+	EVDEV_quit();
 }
 
-// from <linux/input.h> which has BTN_ constants that conflict with platform.h
-struct input_event {
-	struct timeval time;
-	__u16 type;
-	__u16 code;
-	__s32 value;
-};
-#define EV_KEY 0x01
-#define EV_ABS 0x03
+/**
+ * Translates a single evdev key event to button state.
+ */
+static void handleEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type != EVDEV_EV_KEY || event->value > 1)
+		return; // ignore repeats
+
+	// LOG_info("key event: %i (%i)\n", event->code,event->value);
+	uint32_t tick = *(uint32_t*)userdata;
+	int id = EVDEV_mapCode(button_mapping, event->code);
+	if (event->value == 1)
+		LAT_markInput(EVDEV_eventTime(event), id);
+	PAD_setButton(id, event->value, tick);
+}
 
 /**
  * Polls input devices and updates global pad state.
  *
- * Reads from all input event devices, processes button presses/releases,
- * handles key repeat logic, and updates analog stick position. Updates
- * the global pad structure with current button and analog state.
+ * Drains pending button events through the evdev backend, handles key
+ * repeat logic, and updates analog stick position.
  */
 void PLAT_pollInput(void) {
-	// reset transient state
-	pad.just_pressed = BTN_NONE;
-	pad.just_released = BTN_NONE;
-	pad.just_repeated = BTN_NONE;
-
 	uint32_t tick = SDL_GetTicks();
-	for (int i = 0; i < BTN_ID_COUNT; i++) {
-		int btn = 1 << i;
-		if ((pad.is_pressed & btn) && (tick >= pad.repeat_at[i])) {
-			pad.just_repeated |= btn; // set
-			pad.repeat_at[i] += PAD_REPEAT_INTERVAL;
-		}
-	}
+	PAD_beginFrame(tick);
 
-	// the actual poll
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type != EV_KEY && event.type != EV_ABS)
-				continue;
-
-			int btn = BTN_NONE;
-			int pressed = 0; // 0=up,1=down
-			int id = -1;
-			int type = event.type;
-			int code = event.code;
-			int value = event.value;
-
-			// TODO: tmp, hardcoded, missing some buttons
-			if (type == EV_KEY) {
-				if (value > 1)
-					continue; // ignore repeats
-
-				pressed = value;
-				// LOG_info("key event: %i (%i)\n", code,pressed);
-				if (code == RAW_UP) {
-					btn = BTN_DPAD_UP;
-					id = BTN_ID_DPAD_UP;
-				} else if (code == RAW_DOWN) {
-					btn = BTN_DPAD_DOWN;
-					id = BTN_ID_DPAD_DOWN;
-				} else if (code == RAW_LEFT) {
-					btn = BTN_DPAD_LEFT;
-					id = BTN_ID_DPAD_LEFT;
-				} else if (code == RAW_RIGHT) {
-					btn = BTN_DPAD_RIGHT;
-					id = BTN_ID_DPAD_RIGHT;
-				} else if (code == RAW_A) {
-					btn = BTN_A;
-					id = BTN_ID_A;
-				} else if (code == RAW_B) {
-					btn = BTN_B;
-					id = BTN_ID_B;
-				} else if (code == RAW_X) {
-					btn = BTN_X;
-					id = BTN_ID_X;
-				} else if (code == RAW_Y) {
-					btn = BTN_Y;
-					id = BTN_ID_Y;
-				} else if (code == RAW_START) {
-					btn = BTN_START;
-					id = BTN_ID_START;
-				} else if (code == RAW_SELECT) {
-					btn = BTN_SELECT;
-					id = BTN_ID_SELECT;
-				} else if (code == RAW_MENU) {
-					btn = BTN_MENU;
-					id = BTN_ID_MENU;
-				} else if (code == RAW_L1) {
-					btn = BTN_L1;
-					id = BTN_ID_L1;
-				} else if (code == RAW_L2) {
-					btn = BTN_L2;
-					id = BTN_ID_L2;
-				} else if (code == RAW_R1) {
-					btn = BTN_R1;
-					id = BTN_ID_R1;
-				} else if (code == RAW_R2) {
-					btn = BTN_R2;
-					id = BTN_ID_R2;
-				} else if (code == RAW_PLUS) {
-					btn = BTN_PLUS;
-					id = BTN_ID_PLUS;
-				} else if (code == RAW_MINUS) {
-					btn = BTN_MINUS;
-					id = BTN_ID_MINUS;
-				} else if (code == RAW_POWER) {
-					btn = BTN_POWER;
-					id = BTN_ID_POWER;
-				}
-			}
-
-			if (btn == BTN_NONE)
-				continue;
-
-			if (!pressed) {
-				pad.is_pressed &= ~btn; // unset
-				pad.just_repeated &= ~btn; // unset
-				pad.just_released |= btn; // set
-			} else if ((pad.is_pressed & btn) == BTN_NONE) {
-				pad.just_pressed |= btn; // set
-				pad.just_repeated |= btn; // set
-				pad.is_pressed |= btn; // set
-				pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
-			}
-		}
-	}
+	EVDEV_poll(handleEvent, &tick);
 
 	Stick_get(&(pad.laxis.x), &(pad.laxis.y));
 	PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x, tick + PAD_REPEAT_DELAY);
 	PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y, tick + PAD_REPEAT_DELAY);
 }
 
+/**
+ * Checks for a power button release while asleep.
+ */
+static void handleWakeEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type == EVDEV_EV_KEY && event->code == RAW_POWER && event->value == 0)
+		*(int*)userdata = 1;
+}
+
 /**
  * Checks if device should wake from sleep.
  *
- * Polls input devices looking for power button release event.
+ * Drains pending input looking for a power button release event.
  * Used to wake device from low-power sleep state.
  *
  * @return 1 if power button was released, 0 otherwise
  */
 int PLAT_shouldWake(void) {
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type == EV_KEY && event.code == RAW_POWER && event.value == 0) {
-				return 1;
-			}
-		}
-	}
-	return 0;
+	int wake = 0;
+	EVDEV_poll(handleWakeEvent, &wake);
+	return wake;
 }
 
 ///////////////////////////////
@@ -846,6 +766,9 @@ void PLAT_flip(SDL_Surface* IGNORED, int ignored) {
 
 static int online = 0;
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/usb/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/battery/capacity", 0);
+
 /**
  * Reads battery status from sysfs.
  *
@@ -860,9 +783,9 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// *charge = PWR_LOW_CHARGE;
 	// return;
 
-	*is_charging = getInt("/sys/class/power_supply/usb/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
-	int i = getInt("/sys/class/power_supply/battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// worry less about battery and more about the game you're playing
 	if (i > 80)
 		*charge = 100;
@@ -964,10 +887,12 @@ void PLAT_setCPUSpeed(int speed) {
 		break;
 	}
 
-	char cmd[128];
+	char cpu_arg[8];
+	char freq_arg[16];
+	sprintf(cpu_arg, "%d", cpu);
+	sprintf(freq_arg, "%d", freq);
 	// Set CPU governor to userspace mode with specified cores and frequency
-	sprintf(cmd, "overclock.elf userspace %d %d 384 1080 0", cpu, freq);
-	system(cmd);
+	runProgram((char* const[]){"overclock.elf", "userspace", cpu_arg, freq_arg, "384", "1080", "0", NULL});
 }
 
 #define RUMBLE_PATH "/sys/devices/virtual/timed_output/vibrator/enable"
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "msettings.h"
+#include "../../all/common/settings_sync.h"
 
 ///////////////////////////////////////
 
@@ -35,11 +36,18 @@ static Settings DefaultSettings = {
 };
 static Settings* settings;
 
+// shared memory layout, only settings is persisted so it must stay first
+typedef struct SharedSettings {
+	Settings settings;
+	SettingsSync sync;
+} SharedSettings;
+static SettingsSync* settings_sync;
+
 #define SHM_KEY "/SharedSettings"
 static char SettingsPath[256];
 static int shm_fd = -1;
 static int is_host = 0;
-static int shm_size = sizeof(Settings);
+static int shm_size = sizeof(SharedSettings);
 
 int getInt(char* path) {
 	int i = 0;
@@ -101,7 +109,11 @@ void InitSettings(void) {
 	if (shm_fd==-1 && errno==EEXIST) { // already exists
 		puts("Settings client");
 		shm_fd = shm_open(SHM_KEY, O_RDWR, 0644);
+		// an older build may have left a smaller object, mapping past its end would SIGBUS
+		struct stat st;
+		if (fstat(shm_fd, &st)==0 && st.st_size<shm_size) ftruncate(shm_fd, shm_size);
 		settings = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+		settings_sync = &((SharedSettings*)settings)->sync;
 	}
 	else { // host
 		puts("Settings host"); // should always be keymon
@@ -109,16 +121,17 @@ void InitSettings(void) {
 		// we created it so set initial size and populate
 		ftruncate(shm_fd, shm_size);
 		settings = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+		settings_sync = &((SharedSettings*)settings)->sync;
 		
 		int fd = open(SettingsPath, O_RDONLY);
 		if (fd>=0) {
-			read(fd, settings, shm_size);
+			read(fd, settings, sizeof(Settings));
 			// TODO: use settings->version for future proofing?
 			close(fd);
 		}
 		else {
 			// load defaults
-			memcpy(settings, &DefaultSettings, shm_size);
+			memcpy(settings, &DefaultSettings, sizeof(Settings));
 		}
 		
 		// these shouldn't be persisted
@@ -146,10 +159,16 @@ void QuitSettings(void) {
 	munmap(settings, shm_size);
 	if (is_host) shm_unlink(SHM_KEY);
 }
+static Settings SnapshotSettings(void) {
+	Settings copy;
+	SettingsSync_read(settings_sync, &copy, settings, sizeof(Settings));
+	return copy;
+}
 static inline void SaveSettings(void) {
 	int fd = open(SettingsPath, O_CREAT|O_WRONLY, 0644);
 	if (fd>=0) {
-		write(fd, settings, shm_size);
+		Settings copy = SnapshotSettings();
+		write(fd, &copy, sizeof(copy));
 		close(fd);
 		sync();
 	}
@@ -178,18 +197,24 @@ void SetBrightness(int value) {
 	}
 	
 	SetRawBrightness(raw);
+	SettingsSync_beginWrite(settings_sync);
 	settings->brightness = value;
+	SettingsSync_endWrite(settings_sync);
 	SaveSettings();
 }
 
 int GetVolume(void) { // 0-20
-	return settings->jack ? settings->headphones : settings->speaker;
+	Settings current = SnapshotSettings();
+	return current.jack ? current.headphones : current.speaker;
 }
 void SetVolume(int value) {
-	if (settings->hdmi) return;
+	Settings current = SnapshotSettings();
+	if (current.hdmi) return;
 	
+	SettingsSync_beginWrite(settings_sync);
 	if (settings->jack) settings->headphones = value;
 	else settings->speaker = value;
+	SettingsSync_endWrite(settings_sync);
 	
 	int raw = value * 5;
 	SetRawVolume(raw);
@@ -238,7 +263,9 @@ void SetJack(int value) {
 	// sprintf(cmd, "amixer cset name='Playback Path' '%s' &> /dev/null", value?"HP":"SPK");
 	// system(cmd);
 	
+	SettingsSync_beginWrite(settings_sync);
 	settings->jack = value;
+	SettingsSync_endWrite(settings_sync);
 	SetVolume(GetVolume());
 }
 
@@ -249,10 +276,16 @@ int GetHDMI(void) {
 void SetHDMI(int value) {
 	// printf("SetHDMI(%i)\n", value); fflush(stdout);
 	
+	SettingsSync_beginWrite(settings_sync);
 	settings->hdmi = value;
+	SettingsSync_endWrite(settings_sync);
 	if (value) SetRawVolume(100); // max
 	else SetVolume(GetVolume()); // restore
 }
 
 int GetMute(void) { return 0; }
 void SetMute(int value) {}
+
+unsigned GetSettingsGeneration(void) {
+	return SettingsSync_getGeneration(settings_sync);
+}
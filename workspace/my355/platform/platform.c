@@ -34,6 +34,7 @@
 #include "api.h"
 #include "defines.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -50,6 +51,9 @@ int on_hdmi = 0;
 // Hall sensor path: reports 1 when lid is open, 0 when closed
 #define LID_PATH "/sys/devices/platform/hall-mh248/hallvalue"
 
+// polled every frame, so keep it open and re-read at most every 100ms
+static SysfsValue lid_state = SYSFS_VALUE(LID_PATH, 100);
+
 /**
  * Initializes lid detection hardware.
  *
@@ -74,7 +78,7 @@ void PLAT_initLid(void) {
  */
 int PLAT_lidChanged(int* state) {
 	if (lid.has_lid) {
-		int lid_open = getInt(LID_PATH);
+		int lid_open = SysfsValue_getInt(&lid_state);
 		if (lid_open != lid.is_open) {
 			lid.is_open = lid_open;
 			if (state)
@@ -818,6 +822,10 @@ int PLAT_supportsOverscan(void) {
 
 static int online = 0;
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/ac/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/battery/capacity", 0);
+static SysfsValue wifi_state = SYSFS_VALUE("/sys/class/net/wlan0/operstate", 0);
+
 /**
  * Gets battery charge level and charging status.
  *
@@ -834,9 +842,9 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// *charge = PWR_LOW_CHARGE;
 	// return;
 
-	*is_charging = getInt("/sys/class/power_supply/ac/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
-	int i = getInt("/sys/class/power_supply/battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// worry less about battery and more about the game you're playing
 	if (i > 80)
 		*charge = 100;
@@ -852,9 +860,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 		*charge = 10;
 
 	// wifi status, just hooking into the regular PWR polling
-	char status[16];
-	getFile("/sys/class/net/wlan0/operstate", status, 16);
-	online = prefixMatch("up", status);
+	online = prefixMatch("up", (char*)SysfsValue_getString(&wifi_state));
 }
 
 #define LED_PATH "/sys/class/leds/work/brightness"
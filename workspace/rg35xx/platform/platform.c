@@ -41,6 +41,7 @@
 #include "api.h"
 #include "defines.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "de_atm7059.h"
@@ -904,6 +905,19 @@ void PLAT_flip(SDL_Surface* IGNORED, int sync) {
 	}
 }
 
+/**
+ * Checks whether the screen surface holds the frame about to be flipped.
+ *
+ * PLAT_blitRenderer() scales into the screen page, so it always does.
+ *
+ * @param blitted Unused
+ * @return 1
+ */
+int PLAT_screenHoldsFrame(int blitted) {
+	(void)blitted;
+	return 1;
+}
+
 ///////////////////////////////
 // Hardware Overlay (Battery Indicator)
 ///////////////////////////////
@@ -1055,6 +1069,9 @@ void PLAT_enableOverlay(int enable) {
 // Power Management
 ///////////////////////////////
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/battery/charger_online", 0);
+static SysfsValue battery_voltage = SYSFS_VALUE("/sys/class/power_supply/battery/voltage_now", 0);
+
 /**
  * Retrieves battery status.
  *
@@ -1076,10 +1093,10 @@ void PLAT_enableOverlay(int enable) {
  * @note Values are read from /sys/class/power_supply/battery/
  */
 void PLAT_getBatteryStatus(int* is_charging, int* charge) {
-	*is_charging = getInt("/sys/class/power_supply/battery/charger_online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
 	// Read voltage (in 10µV units, so divide by 10000 to get centivolts)
-	int i = getInt("/sys/class/power_supply/battery/voltage_now") / 10000; // 310-410
+	int i = SysfsValue_getInt(&battery_voltage) / 10000; // 310-410
 	i -= 310; // Normalize to ~0-100
 
 	// Map to coarse percentage levels (prevents flicker)
@@ -1169,9 +1186,9 @@ void PLAT_setCPUSpeed(int speed) {
 		break;
 	}
 
-	char cmd[32];
-	sprintf(cmd, "overclock.elf %d\n", freq);
-	system(cmd);
+	char arg[16];
+	sprintf(arg, "%d", freq);
+	runProgram((char* const[]){"overclock.elf", arg, NULL});
 }
 
 /**
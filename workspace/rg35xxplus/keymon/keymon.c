@@ -10,13 +10,13 @@
  * - MENU+PLUS/MINUS: Adjust brightness
  * - PLUS/MINUS alone: Adjust volume
  *
- * Also monitors HDMI state in a separate thread and updates video routing
+ * Also polls HDMI state once a second and updates video routing
  * accordingly.
  *
  * Uses different input event codes than SDL (CODE_MENU is 312).
  *
- * Runs continuously at 60Hz polling input device for button events.
- * Ignores stale input after system sleep to prevent spurious events.
+ * Built on the shared keymon core, which sleeps until input arrives or a
+ * timer is due and ignores stale input after system sleep.
  */
 
 #include <stdio.h>
@@ -24,21 +24,12 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <string.h>
-#include <fcntl.h>
-#include <dirent.h>
-#include <linux/input.h>
-#include <pthread.h>
 
 #include "../../all/common/log.h"
+#include "../../all/common/keymon_core.h"
 
 #include <msettings.h>
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/ioctl.h>
-
-// #include "defines.h"
-
 #define VOLUME_MIN 		0
 #define VOLUME_MAX 		20
 #define BRIGHTNESS_MIN 	0
@@ -49,16 +40,15 @@
 #define CODE_PLUS		115
 #define CODE_MINUS		114
 
-// Input event values from linux/input.h
-#define RELEASED	0
-#define PRESSED		1
-#define REPEAT		2
+#define HDMI_STATE_PATH "/sys/class/extcon/hdmi/cable.0/state"
 
-static int	input_fd = 0;
-static struct input_event ev;
+static const char* inputs[] = {
+	"/dev/input/event1",
+	NULL,
+};
 
-static pthread_t hdmi_pt;
-#define HDMI_STATE_PATH "/sys/class/extcon/hdmi/cable.0/state"
+static int menu_pressed = 0;
+static int had_hdmi = -1;
 
 /**
  * Reads an integer value from a sysfs file.
@@ -68,7 +58,7 @@ static pthread_t hdmi_pt;
  * @param path Path to sysfs file
  * @return Integer value read from file, or 0 if file cannot be opened
  */
-int getInt(char* path) {
+static int getInt(char* path) {
 	int i = 0;
 	FILE *file = fopen(path, "r");
 	if (file!=NULL) {
@@ -79,166 +69,88 @@ int getInt(char* path) {
 }
 
 /**
- * Background thread that monitors HDMI state.
+ * Checks HDMI state.
  *
- * Polls the HDMI extcon interface every second and updates video
- * routing when the state changes (HDMI connected/disconnected).
- *
- * @param arg Thread argument (unused)
- * @return Never returns (runs infinite loop)
+ * Called once a second by the keymon core and updates video routing when
+ * HDMI is connected or disconnected (the first call always applies it).
  */
-static void* watchHDMI(void *arg) {
-	int has_hdmi,had_hdmi;
-
-	// Initialize HDMI state
-	has_hdmi = had_hdmi = getInt(HDMI_STATE_PATH);
-	SetHDMI(has_hdmi);
-
-	while(1) {
-		sleep(1);
+static void watchHDMI(void) {
+	int has_hdmi = getInt(HDMI_STATE_PATH);
+	if (had_hdmi!=has_hdmi) {
+		had_hdmi = has_hdmi;
+		SetHDMI(has_hdmi);
+	}
+}
 
-		// Check for HDMI state changes
-		has_hdmi = getInt(HDMI_STATE_PATH);
-		if (had_hdmi!=has_hdmi) {
-			had_hdmi = has_hdmi;
-			SetHDMI(has_hdmi);
-		}
+/**
+ * Steps brightness (MENU held) or volume by one in the key's direction.
+ *
+ * @param code CODE_PLUS or CODE_MINUS
+ */
+static void stepSetting(int code) {
+	int val;
+	if (menu_pressed) {
+		val = GetBrightness();
+		if (code==CODE_PLUS && val<BRIGHTNESS_MAX) SetBrightness(++val);
+		else if (code==CODE_MINUS && val>BRIGHTNESS_MIN) SetBrightness(--val);
+	}
+	else {
+		val = GetVolume();
+		if (code==CODE_PLUS && val<VOLUME_MAX) SetVolume(++val);
+		else if (code==CODE_MINUS && val>VOLUME_MIN) SetVolume(--val);
 	}
+}
 
+/**
+ * Handles hardware button presses and releases.
+ *
+ * @param code Key code
+ * @param value KEYMON_PRESSED or KEYMON_RELEASED
+ * @return 1 to repeat PLUS/MINUS while held
+ */
+static int handleKey(int code, int value) {
+	switch (code) {
+		case CODE_MENU:
+			menu_pressed = value;
+		break;
+		case CODE_PLUS:
+		case CODE_MINUS:
+			if (value==KEYMON_PRESSED) {
+				stepSetting(code);
+				return 1;
+			}
+		break;
+		default:
+		break;
+	}
 	return 0;
 }
 
 /**
- * Main event loop for hardware button monitoring.
- *
- * Continuously polls input device for button events and handles:
- * - MENU+PLUS: Increase brightness
- * - MENU+MINUS: Decrease brightness
- * - PLUS alone: Increase volume
- * - MINUS alone: Decrease volume
- *
- * Also starts background thread to monitor HDMI state.
- *
- * Implements repeat functionality (initial 300ms delay, then 100ms interval)
- * and ignores stale input after system sleep (> 1 second gap).
+ * Releases the MENU modifier after stale input was dropped.
+ */
+static void resetKeys(void) {
+	menu_pressed = 0;
+}
+
+/**
+ * Runs the keymon event loop.
  *
  * @param argc Argument count (unused)
  * @param argv Argument values (unused)
- * @return Never returns (runs infinite loop)
+ * @return 0 on clean exit
  *
  * @note Uses event1 input device
  */
 int main (int argc, char *argv[]) {
 	InitSettings();
 
-	// Start HDMI monitoring thread
-	pthread_create(&hdmi_pt, NULL, &watchHDMI, NULL);
-
-	input_fd = open("/dev/input/event1", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-
-	uint32_t val;
-	uint32_t menu_pressed = 0;
-
-	// Track PLUS button state for repeat handling
-	uint32_t up_pressed = 0;
-	uint32_t up_just_pressed = 0;
-	uint32_t up_repeat_at = 0;
-
-	// Track MINUS button state for repeat handling
-	uint32_t down_pressed = 0;
-	uint32_t down_just_pressed = 0;
-	uint32_t down_repeat_at = 0;
-
-	uint8_t ignore;
-	uint32_t then;
-	uint32_t now;
-	struct timeval tod;
-
-	gettimeofday(&tod, NULL);
-	then = tod.tv_sec * 1000 + tod.tv_usec / 1000; // SDL_GetTicks() equivalent
-	ignore = 0;
-
-	while (1) {
-		gettimeofday(&tod, NULL);
-		now = tod.tv_sec * 1000 + tod.tv_usec / 1000;
-
-		// Ignore stale input after system sleep to avoid spurious events
-		if (now-then>1000) ignore = 1;
-
-		// Read and process all available input events
-		while(read(input_fd, &ev, sizeof(ev))==sizeof(ev)) {
-			if (ignore) continue;
-			val = ev.value;
-
-			// Only process key events (PRESSED, RELEASED, or REPEAT)
-			if (( ev.type != EV_KEY ) || ( val > REPEAT )) continue;
-
-			// Process hardware button events
-			switch (ev.code) {
-				case CODE_MENU:
-					menu_pressed = val;
-				break;
-				case CODE_PLUS:
-					// Volume up button (or brightness up if MENU held)
-					up_pressed = up_just_pressed = val;
-					if (val) up_repeat_at = now + 300; // 300ms initial delay
-				break;
-				case CODE_MINUS:
-					// Volume down button (or brightness down if MENU held)
-					down_pressed = down_just_pressed = val;
-					if (val) down_repeat_at = now + 300; // 300ms initial delay
-				break;
-				default:
-				break;
-			}
-		}
-
-		// Reset button state after ignoring stale input
-		if (ignore) {
-			menu_pressed = 0;
-			up_pressed = up_just_pressed = 0;
-			down_pressed = down_just_pressed = 0;
-			up_repeat_at = 0;
-			down_repeat_at = 0;
-		}
-
-		// Handle PLUS button (initial press or repeat after delay)
-		if (up_just_pressed || (up_pressed && now>=up_repeat_at)) {
-			if (menu_pressed) {
-				// MENU+PLUS: Brightness up
-				val = GetBrightness();
-				if (val<BRIGHTNESS_MAX) SetBrightness(++val);
-			}
-			else {
-				// PLUS alone: Volume up
-				val = GetVolume();
-				if (val<VOLUME_MAX) SetVolume(++val);
-			}
-
-			if (up_just_pressed) up_just_pressed = 0;
-			else up_repeat_at += 100; // 100ms repeat interval
-		}
-
-		// Handle MINUS button (initial press or repeat after delay)
-		if (down_just_pressed || (down_pressed && now>=down_repeat_at)) {
-			if (menu_pressed) {
-				// MENU+MINUS: Brightness down
-				val = GetBrightness();
-				if (val>BRIGHTNESS_MIN) SetBrightness(--val);
-			}
-			else {
-				// MINUS alone: Volume down
-				val = GetVolume();
-				if (val>VOLUME_MIN) SetVolume(--val);
-			}
-
-			if (down_just_pressed) down_just_pressed = 0;
-			else down_repeat_at += 100; // 100ms repeat interval
-		}
-
-		then = now;
-		ignore = 0;
-
-		usleep(16666); // 60Hz polling rate
-	}
+	KEYMON_Hooks hooks = {
+		.handleKey = handleKey,
+		.handleRepeat = stepSetting,
+		.poll = watchHDMI,
+		.poll_ms = 1000,
+		.reset = resetKeys,
+	};
+	return KEYMON_run(inputs, &hooks) < 0 ? 1 : 0;
 }
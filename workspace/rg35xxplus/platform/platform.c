@@ -32,7 +32,10 @@
 
 #include "api.h"
 #include "defines.h"
+#include "evdev.h"
+#include "latency.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -128,18 +131,85 @@ typedef enum GamepadType {
 	kGamepadTypeXbox,
 } GamepadType;
 
-#define INPUT_COUNT 3
-static int inputs[INPUT_COUNT];
+#define GAMEPAD_PATH "/dev/input/event3"
+#define GAMEPAD_NAME_PATH "/sys/class/input/event3/device/name"
 
-#define kPadIndex 2
+static int pad_index = -1;
 static GamepadType pad_type = kGamepadTypeUnknown;
 
+// Built-in controls, MENU1/MENU2 (L3/R3) resolve to MENU before L3/R3
+static const EVDEV_Mapping builtin_mapping[] = {
+    {RAW_UP, BTN_ID_DPAD_UP},
+    {RAW_DOWN, BTN_ID_DPAD_DOWN},
+    {RAW_LEFT, BTN_ID_DPAD_LEFT},
+    {RAW_RIGHT, BTN_ID_DPAD_RIGHT},
+    {RAW_A, BTN_ID_A},
+    {RAW_B, BTN_ID_B},
+    {RAW_X, BTN_ID_X},
+    {RAW_Y, BTN_ID_Y},
+    {RAW_START, BTN_ID_START},
+    {RAW_SELECT, BTN_ID_SELECT},
+    {RAW_MENU, BTN_ID_MENU},
+    {RAW_MENU1, BTN_ID_MENU},
+    {RAW_MENU2, BTN_ID_MENU},
+    {RAW_L1, BTN_ID_L1},
+    {RAW_L2, BTN_ID_L2},
+    {RAW_L3, BTN_ID_L3},
+    {RAW_R1, BTN_ID_R1},
+    {RAW_R2, BTN_ID_R2},
+    {RAW_R3, BTN_ID_R3},
+    {RAW_PLUS, BTN_ID_PLUS},
+    {RAW_MINUS, BTN_ID_MINUS},
+    {RAW_POWER, BTN_ID_POWER},
+    EVDEV_MAPPING_END,
+};
+
+static const EVDEV_Mapping rgp01_mapping[] = {
+    {RGP01_A, BTN_ID_A},
+    {RGP01_B, BTN_ID_B},
+    {RGP01_X, BTN_ID_X},
+    {RGP01_Y, BTN_ID_Y},
+    {RGP01_START, BTN_ID_START},
+    {RGP01_SELECT, BTN_ID_SELECT},
+    {RGP01_MENU, BTN_ID_MENU},
+    {RGP01_MENU1, BTN_ID_MENU},
+    {RGP01_MENU2, BTN_ID_MENU},
+    {RGP01_L1, BTN_ID_L1},
+    {RGP01_L2, BTN_ID_L2},
+    {RGP01_L3, BTN_ID_L3},
+    {RGP01_R1, BTN_ID_R1},
+    {RGP01_R2, BTN_ID_R2},
+    {RGP01_R3, BTN_ID_R3},
+    EVDEV_MAPPING_END,
+};
+
+// L2/R2 are analog triggers on Xbox pads, handled as EV_ABS
+static const EVDEV_Mapping xbox_mapping[] = {
+    {XBOX_A, BTN_ID_A},
+    {XBOX_B, BTN_ID_B},
+    {XBOX_X, BTN_ID_X},
+    {XBOX_Y, BTN_ID_Y},
+    {XBOX_START, BTN_ID_START},
+    {XBOX_SELECT, BTN_ID_SELECT},
+    {XBOX_MENU, BTN_ID_MENU},
+    {XBOX_MENU1, BTN_ID_MENU},
+    {XBOX_MENU2, BTN_ID_MENU},
+    {XBOX_L1, BTN_ID_L1},
+    {XBOX_L3, BTN_ID_L3},
+    {XBOX_R1, BTN_ID_R1},
+    {XBOX_R3, BTN_ID_R3},
+    EVDEV_MAPPING_END,
+};
+
 ///////////////////////////////
 // Input - Lid detection
 ///////////////////////////////
 
 #define LID_PATH "/sys/class/power_supply/axp2202-battery/hallkey"
 
+// polled every frame, so keep it open and re-read at most every 100ms
+static SysfsValue lid_state = SYSFS_VALUE(LID_PATH, 100);
+
 /**
  * Initializes lid detection via hall sensor.
  *
@@ -157,7 +227,7 @@ void PLAT_initLid(void) {
  */
 int PLAT_lidChanged(int* state) {
 	if (lid.has_lid) {
-		int lid_open = getInt(LID_PATH);
+		int lid_open = SysfsValue_getInt(&lid_state);
 		if (lid_open != lid.is_open) {
 			lid.is_open = lid_open;
 			if (state)
@@ -173,396 +243,166 @@ int PLAT_lidChanged(int* state) {
 ///////////////////////////////
 
 /**
- * Checks for external gamepad connection/disconnection.
+ * Identifies an external gamepad when it connects or disconnects.
  *
- * Polls every 2 seconds for gamepad on /dev/input/event3.
+ * Called by the evdev backend when /dev/input/event3 appears or
+ * disappears, so there's no polling from the frame loop.
  * Detects gamepad type by device name:
  * - "Anbernic" -> RG P01 controller
  * - "Microsoft" -> Xbox-compatible controller
  * - Other -> Unknown (uses default mappings)
  */
-static void checkForGamepad(void) {
-	uint32_t now = SDL_GetTicks();
-	static uint32_t last_check = 0;
-	if (last_check == 0 || now - last_check > 2000) {
-		last_check = now;
-		int connected = exists("/dev/input/event3");
-		if (inputs[kPadIndex] < 0 && connected) {
-			LOG_info("Connecting gamepad: ");
-			char pad_name[256];
-			getFile("/sys/class/input/event3/device/name", pad_name, 256);
-			// Detect gamepad type by device name
-			if (containsString(pad_name, "Anbernic")) {
-				LOG_info("P01\n");
-				pad_type = kGamepadTypeRGP01;
-			} else if (containsString(pad_name, "Microsoft")) {
-				LOG_info("Xbox\n");
-				pad_type = kGamepadTypeXbox;
-			} else {
-				LOG_info("Unknown\n");
-				pad_type = kGamepadTypeUnknown;
-			}
+static void onGamepadHotplug(int device, int connected, void* userdata) {
+	// the gamepad is the only hotplug device, so no need to check the index
+	if (!connected) {
+		LOG_info("Gamepad disconnected");
+		pad_type = kGamepadTypeUnknown;
+		return;
+	}
 
-			inputs[kPadIndex] = open("/dev/input/event3", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-		} else if (inputs[kPadIndex] >= 0 && !connected) {
-			LOG_info("Gamepad disconnected\n");
-			close(inputs[kPadIndex]);
-			inputs[kPadIndex] = -1;
-			pad_type = kGamepadTypeUnknown;
-		}
+	char pad_name[256];
+	getFile(GAMEPAD_NAME_PATH, pad_name, 256);
+	if (containsString(pad_name, "Anbernic")) {
+		LOG_info("Connecting gamepad: P01");
+		pad_type = kGamepadTypeRGP01;
+	} else if (containsString(pad_name, "Microsoft")) {
+		LOG_info("Connecting gamepad: Xbox");
+		pad_type = kGamepadTypeXbox;
+	} else {
+		LOG_info("Connecting gamepad: Unknown");
+		pad_type = kGamepadTypeUnknown;
 	}
 }
 
 /**
  * Initializes input subsystem.
  *
- * Opens built-in input devices (event0, event1) and checks for gamepad.
+ * Opens built-in input devices (event0, event1) and registers the
+ * external gamepad node for hotplug detection.
  */
 void PLAT_initInput(void) {
-	inputs[0] = open("/dev/input/event0", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-	inputs[1] = open("/dev/input/event1", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
-	inputs[kPadIndex] = -1;
-	checkForGamepad();
+	EVDEV_init();
+	EVDEV_addDevice("/dev/input/event0", 0);
+	EVDEV_addDevice("/dev/input/event1", 0);
+	EVDEV_setHotplugCallback(onGamepadHotplug, NULL);
+	pad_index = EVDEV_addDevice(GAMEPAD_PATH, 1);
 }
 void PLAT_quitInput(void) {
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		close(inputs[i]);
-	}
+	EVDEV_quit();
+	pad_index = -1;
 }
 
-// from <linux/input.h> which has BTN_ constants that conflict with platform.h
-struct input_event {
-	struct timeval time;
-	__u16 type;
-	__u16 code;
-	__s32 value;
-};
-#define EV_KEY 0x01
-#define EV_ABS 0x03
-
-void PLAT_pollInput(void) {
-	// reset transient state
-	pad.just_pressed = BTN_NONE;
-	pad.just_released = BTN_NONE;
-	pad.just_repeated = BTN_NONE;
-
-	uint32_t tick = SDL_GetTicks();
-	for (int i = 0; i < BTN_ID_COUNT; i++) {
-		int btn = 1 << i;
-		if ((pad.is_pressed & btn) && (tick >= pad.repeat_at[i])) {
-			pad.just_repeated |= btn; // set
-			pad.repeat_at[i] += PAD_REPEAT_INTERVAL;
+/**
+ * Translates a single evdev event to button/axis state.
+ */
+static void handleEvent(int device, const EVDEV_Event* event, void* userdata) {
+	uint32_t tick = *(uint32_t*)userdata;
+	int code = event->code;
+	int value = event->value;
+
+	if (event->type == EVDEV_EV_KEY) {
+		if (value > 1)
+			return; // ignore repeats
+
+		// LOG_info("key event: %i (%i)\n", code,value);
+		const EVDEV_Mapping* mapping = builtin_mapping;
+		if (device == pad_index) {
+			if (pad_type == kGamepadTypeRGP01)
+				mapping = rgp01_mapping;
+			else if (pad_type == kGamepadTypeXbox)
+				mapping = xbox_mapping;
+			else
+				return;
 		}
+		int id = EVDEV_mapCode(mapping, code);
+		if (value == 1)
+			LAT_markInput(EVDEV_eventTime(event), id);
+		PAD_setButton(id, value, tick);
+		return;
 	}
 
-	checkForGamepad();
-
-	// the actual poll
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		if (input < 0)
-			continue;
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type != EV_KEY && event.type != EV_ABS)
-				continue;
-
-			int btn = BTN_NONE;
-			int pressed = 0; // 0=up,1=down
-			int id = -1;
-			int type = event.type;
-			int code = event.code;
-			int value = event.value;
-
-			// TODO: tmp, hardcoded, missing some buttons
-			if (type == EV_KEY) {
-				if (value > 1)
-					continue; // ignore repeats
-
-				pressed = value;
-				// LOG_info("key event: %i (%i)\n", code,pressed);
-				if (i == kPadIndex) {
-					if (pad_type == kGamepadTypeRGP01) {
-						if (code == RGP01_A) {
-							btn = BTN_A;
-							id = BTN_ID_A;
-						} else if (code == RGP01_B) {
-							btn = BTN_B;
-							id = BTN_ID_B;
-						} else if (code == RGP01_X) {
-							btn = BTN_X;
-							id = BTN_ID_X;
-						} else if (code == RGP01_Y) {
-							btn = BTN_Y;
-							id = BTN_ID_Y;
-						} else if (code == RGP01_START) {
-							btn = BTN_START;
-							id = BTN_ID_START;
-						} else if (code == RGP01_SELECT) {
-							btn = BTN_SELECT;
-							id = BTN_ID_SELECT;
-						} else if (code == RGP01_MENU) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == RGP01_MENU1) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == RGP01_MENU2) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == RGP01_L1) {
-							btn = BTN_L1;
-							id = BTN_ID_L1;
-						} else if (code == RGP01_L2) {
-							btn = BTN_L2;
-							id = BTN_ID_L2;
-						} else if (code == RGP01_L3) {
-							btn = BTN_L3;
-							id = BTN_ID_L3;
-						} else if (code == RGP01_R1) {
-							btn = BTN_R1;
-							id = BTN_ID_R1;
-						} else if (code == RGP01_R2) {
-							btn = BTN_R2;
-							id = BTN_ID_R2;
-						} else if (code == RGP01_R3) {
-							btn = BTN_R3;
-							id = BTN_ID_R3;
-						}
-					} else if (pad_type == kGamepadTypeXbox) {
-						if (code == XBOX_A) {
-							btn = BTN_A;
-							id = BTN_ID_A;
-						} else if (code == XBOX_B) {
-							btn = BTN_B;
-							id = BTN_ID_B;
-						} else if (code == XBOX_X) {
-							btn = BTN_X;
-							id = BTN_ID_X;
-						} else if (code == XBOX_Y) {
-							btn = BTN_Y;
-							id = BTN_ID_Y;
-						} else if (code == XBOX_START) {
-							btn = BTN_START;
-							id = BTN_ID_START;
-						} else if (code == XBOX_SELECT) {
-							btn = BTN_SELECT;
-							id = BTN_ID_SELECT;
-						} else if (code == XBOX_MENU) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == XBOX_MENU1) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == XBOX_MENU2) {
-							btn = BTN_MENU;
-							id = BTN_ID_MENU;
-						} else if (code == XBOX_L1) {
-							btn = BTN_L1;
-							id = BTN_ID_L1;
-						} else if (code == XBOX_L3) {
-							btn = BTN_L3;
-							id = BTN_ID_L3;
-						} else if (code == XBOX_R1) {
-							btn = BTN_R1;
-							id = BTN_ID_R1;
-						} else if (code == XBOX_R3) {
-							btn = BTN_R3;
-							id = BTN_ID_R3;
-						}
-					}
-				} else {
-					if (code == RAW_UP) {
-						btn = BTN_DPAD_UP;
-						id = BTN_ID_DPAD_UP;
-					} else if (code == RAW_DOWN) {
-						btn = BTN_DPAD_DOWN;
-						id = BTN_ID_DPAD_DOWN;
-					} else if (code == RAW_LEFT) {
-						btn = BTN_DPAD_LEFT;
-						id = BTN_ID_DPAD_LEFT;
-					} else if (code == RAW_RIGHT) {
-						btn = BTN_DPAD_RIGHT;
-						id = BTN_ID_DPAD_RIGHT;
-					} else if (code == RAW_A) {
-						btn = BTN_A;
-						id = BTN_ID_A;
-					} else if (code == RAW_B) {
-						btn = BTN_B;
-						id = BTN_ID_B;
-					} else if (code == RAW_X) {
-						btn = BTN_X;
-						id = BTN_ID_X;
-					} else if (code == RAW_Y) {
-						btn = BTN_Y;
-						id = BTN_ID_Y;
-					} else if (code == RAW_START) {
-						btn = BTN_START;
-						id = BTN_ID_START;
-					} else if (code == RAW_SELECT) {
-						btn = BTN_SELECT;
-						id = BTN_ID_SELECT;
-					} else if (code == RAW_MENU) {
-						btn = BTN_MENU;
-						id = BTN_ID_MENU;
-					} else if (code == RAW_MENU1) {
-						btn = BTN_MENU;
-						id = BTN_ID_MENU;
-					} else if (code == RAW_MENU2) {
-						btn = BTN_MENU;
-						id = BTN_ID_MENU;
-					} else if (code == RAW_L1) {
-						btn = BTN_L1;
-						id = BTN_ID_L1;
-					} else if (code == RAW_L2) {
-						btn = BTN_L2;
-						id = BTN_ID_L2;
-					} else if (code == RAW_L3) {
-						btn = BTN_L3;
-						id = BTN_ID_L3;
-					} else if (code == RAW_R1) {
-						btn = BTN_R1;
-						id = BTN_ID_R1;
-					} else if (code == RAW_R2) {
-						btn = BTN_R2;
-						id = BTN_ID_R2;
-					} else if (code == RAW_R3) {
-						btn = BTN_R3;
-						id = BTN_ID_R3;
-					} else if (code == RAW_PLUS) {
-						btn = BTN_PLUS;
-						id = BTN_ID_PLUS;
-					} else if (code == RAW_MINUS) {
-						btn = BTN_MINUS;
-						id = BTN_ID_MINUS;
-					} else if (code == RAW_POWER) {
-						btn = BTN_POWER;
-						id = BTN_ID_POWER;
-					}
-				}
-			} else if (type == EV_ABS) {
-				// LOG_info("abs event: %i (%i)\n", code,value);
-				// { up, down, left, right }
-				if (code == RAW_HATY || code == RAW_HATX) {
-					if (value > 1)
-						continue; // ignore repeats
-
-					int hats[4] = {-1, -1, -1, -1}; // -1=no change,1=pressed,0=released
-					if (code == RAW_HATY) {
-						hats[0] = value == -1; // up
-						hats[1] = value == 1; // down
-					} else if (code == RAW_HATX) { // left/right
-						hats[2] = value == -1; // left
-						hats[3] = value == 1; // right
-					}
-
-					for (id = 0; id < 4; id++) {
-						int state = hats[id];
-						btn = 1 << id;
-						if (state == 0) {
-							pad.is_pressed &= ~btn; // unset
-							pad.just_repeated &= ~btn; // unset
-							pad.just_released |= btn; // set
-						} else if (state == 1 && (pad.is_pressed & btn) == BTN_NONE) {
-							pad.just_pressed |= btn; // set
-							pad.just_repeated |= btn; // set
-							pad.is_pressed |= btn; // set
-							pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
-						}
-					}
-
-					btn = BTN_NONE; // already handled, force continue
-				} else if (i == kPadIndex) {
-					if (pad_type == kGamepadTypeRGP01) {
-						if (code == RGP01_LSX) {
-							pad.laxis.x = ((value - 128) * 32767) / 128;
-							PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
-							              tick + PAD_REPEAT_DELAY);
-						} else if (code == RGP01_LSY) {
-							pad.laxis.y = ((value - 128) * 32767) / 128;
-							PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
-							              tick + PAD_REPEAT_DELAY);
-						} else if (code == RGP01_RSX)
-							pad.raxis.x = ((value - 128) * 32767) / 128;
-						else if (code == RGP01_RSY)
-							pad.raxis.y = ((value - 128) * 32767) / 128;
-					} else if (pad_type == kGamepadTypeXbox) {
-						if (code == XBOX_LSX) {
-							pad.laxis.x = value;
-							PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
-							              tick + PAD_REPEAT_DELAY);
-						} else if (code == XBOX_LSY) {
-							pad.laxis.y = value;
-							PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
-							              tick + PAD_REPEAT_DELAY);
-						} else if (code == XBOX_RSX)
-							pad.raxis.x = value;
-						else if (code == XBOX_RSY)
-							pad.raxis.y = value;
-						else if (code == XBOX_L2) {
-							pressed = value > 0;
-							btn = BTN_L2;
-							id = BTN_ID_L2;
-						} else if (code == XBOX_R2) {
-							pressed = value > 0;
-							btn = BTN_R2;
-							id = BTN_ID_R2;
-						}
-					}
-				} else {
-					if (code == RAW_LSX) {
-						pad.laxis.x = (value * 32767) / 4096;
-						PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
-						              tick + PAD_REPEAT_DELAY);
-					} else if (code == RAW_LSY) {
-						pad.laxis.y = (value * 32767) / 4096;
-						PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
-						              tick + PAD_REPEAT_DELAY);
-					} else if (code == RAW_RSX)
-						pad.raxis.x = (value * 32767) / 4096;
-					else if (code == RAW_RSY)
-						pad.raxis.y = (value * 32767) / 4096;
-				}
-			}
-
-			if (btn == BTN_NONE)
-				continue;
-
-			if (!pressed) {
-				pad.is_pressed &= ~btn; // unset
-				pad.just_repeated &= ~btn; // unset
-				pad.just_released |= btn; // set
-			} else if ((pad.is_pressed & btn) == BTN_NONE) {
-				pad.just_pressed |= btn; // set
-				pad.just_repeated |= btn; // set
-				pad.is_pressed |= btn; // set
-				pad.repeat_at[id] = tick + PAD_REPEAT_DELAY;
-			}
+	// EV_ABS
+	// LOG_info("abs event: %i (%i)\n", code,value);
+	if (code == RAW_HATY || code == RAW_HATX) {
+		PAD_setHat(code == RAW_HATY, value, tick);
+	} else if (device == pad_index) {
+		if (pad_type == kGamepadTypeRGP01) {
+			if (code == RGP01_LSX) {
+				pad.laxis.x = ((value - 128) * 32767) / 128;
+				PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
+				              tick + PAD_REPEAT_DELAY);
+			} else if (code == RGP01_LSY) {
+				pad.laxis.y = ((value - 128) * 32767) / 128;
+				PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
+				              tick + PAD_REPEAT_DELAY);
+			} else if (code == RGP01_RSX)
+				pad.raxis.x = ((value - 128) * 32767) / 128;
+			else if (code == RGP01_RSY)
+				pad.raxis.y = ((value - 128) * 32767) / 128;
+		} else if (pad_type == kGamepadTypeXbox) {
+			if (code == XBOX_LSX) {
+				pad.laxis.x = value;
+				PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
+				              tick + PAD_REPEAT_DELAY);
+			} else if (code == XBOX_LSY) {
+				pad.laxis.y = value;
+				PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
+				              tick + PAD_REPEAT_DELAY);
+			} else if (code == XBOX_RSX)
+				pad.raxis.x = value;
+			else if (code == XBOX_RSY)
+				pad.raxis.y = value;
+			else if (code == XBOX_L2)
+				PAD_setButton(BTN_ID_L2, value > 0, tick);
+			else if (code == XBOX_R2)
+				PAD_setButton(BTN_ID_R2, value > 0, tick);
 		}
+	} else {
+		if (code == RAW_LSX) {
+			pad.laxis.x = (value * 32767) / 4096;
+			PAD_setAnalog(BTN_ID_ANALOG_LEFT, BTN_ID_ANALOG_RIGHT, pad.laxis.x,
+			              tick + PAD_REPEAT_DELAY);
+		} else if (code == RAW_LSY) {
+			pad.laxis.y = (value * 32767) / 4096;
+			PAD_setAnalog(BTN_ID_ANALOG_UP, BTN_ID_ANALOG_DOWN, pad.laxis.y,
+			              tick + PAD_REPEAT_DELAY);
+		} else if (code == RAW_RSX)
+			pad.raxis.x = (value * 32767) / 4096;
+		else if (code == RAW_RSY)
+			pad.raxis.y = (value * 32767) / 4096;
 	}
+}
+
+void PLAT_pollInput(void) {
+	uint32_t tick = SDL_GetTicks();
+	PAD_beginFrame(tick);
+
+	EVDEV_poll(handleEvent, &tick);
 
 	if (lid.has_lid && PLAT_lidChanged(NULL))
 		pad.just_released |= BTN_SLEEP;
 }
 
+/**
+ * Checks for a power button release while asleep.
+ */
+static void handleWakeEvent(int device, const EVDEV_Event* event, void* userdata) {
+	if (event->type == EVDEV_EV_KEY && event->code == RAW_POWER && event->value == 0)
+		*(int*)userdata = 1;
+}
+
 int PLAT_shouldWake(void) {
 	int lid_open = 1; // assume open by default
 	if (lid.has_lid && PLAT_lidChanged(&lid_open) && lid_open)
 		return 1;
 
-	int input;
-	static struct input_event event;
-	for (int i = 0; i < INPUT_COUNT; i++) {
-		input = inputs[i];
-		while (read(input, &event, sizeof(event)) == sizeof(event)) {
-			if (event.type == EV_KEY && event.code == RAW_POWER && event.value == 0) {
-				// ignore input while lid is closed
-				if (lid.has_lid && !lid.is_open)
-					return 0; // do it here so we eat the input
-				return 1;
-			}
-		}
+	int wake = 0;
+	EVDEV_poll(handleWakeEvent, &wake);
+	if (wake) {
+		// ignore input while lid is closed
+		if (lid.has_lid && !lid.is_open)
+			return 0; // do it here so we eat the input
+		return 1;
 	}
 	return 0;
 }
@@ -1092,14 +932,18 @@ int PLAT_supportsOverscan(void) {
 ///////////////////////////////
 
 static int online = 0;
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/axp2202-usb/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/axp2202-battery/capacity", 0);
+static SysfsValue wifi_state = SYSFS_VALUE("/sys/class/net/wlan0/operstate", 0);
+
 void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// *is_charging = 0;
 	// *charge = PWR_LOW_CHARGE;
 	// return;
 
-	*is_charging = getInt("/sys/class/power_supply/axp2202-usb/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
-	int i = getInt("/sys/class/power_supply/axp2202-battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// worry less about battery and more about the game you're playing
 	if (i > 80)
 		*charge = 100;
@@ -1115,9 +959,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 		*charge = 10;
 
 	// wifi status, just hooking into the regular PWR polling
-	char status[16];
-	getFile("/sys/class/net/wlan0/operstate", status, 16);
-	online = prefixMatch("up", status);
+	online = prefixMatch("up", (char*)SysfsValue_getString(&wifi_state));
 }
 
 #define LED_PATH "/sys/class/power_supply/axp2202-battery/work_led"
@@ -22,4 +22,7 @@ void SetHDMI(int value); // 0-1
 int GetMute(void);
 void SetMute(int value); // 0-1
 
+// changes made by any process through the setters above
+unsigned GetSettingsGeneration(void);
+
 #endif  // __msettings_h__
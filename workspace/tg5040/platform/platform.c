@@ -33,6 +33,7 @@
 #include "api.h"
 #include "defines.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -157,7 +158,7 @@ void PLAT_quitVideo(void) {
 	SDL_DestroyWindow(vid.window);
 
 	SDL_Quit();
-	system("cat /dev/zero > /dev/fb0 2>/dev/null");
+	zeroDevice("/dev/fb0");
 }
 
 void PLAT_clearVideo(SDL_Surface* screen) {
@@ -494,6 +495,10 @@ void PLAT_flip(SDL_Surface* IGNORED, int ignored) {
 
 static int online = 0;
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/axp2202-usb/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/axp2202-battery/capacity", 0);
+static SysfsValue wifi_state = SYSFS_VALUE("/sys/class/net/wlan0/operstate", 0);
+
 /**
  * Reads battery status from AXP2202 power management IC.
  *
@@ -508,9 +513,9 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// *charge = PWR_LOW_CHARGE;
 	// return;
 
-	*is_charging = getInt("/sys/class/power_supply/axp2202-usb/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
-	int i = getInt("/sys/class/power_supply/axp2202-battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	// Quantize battery level to reduce UI flicker during gameplay
 	if (i > 80)
 		*charge = 100;
@@ -526,9 +531,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 		*charge = 10;
 
 	// WiFi status (polled during battery check)
-	char status[16];
-	getFile("/sys/class/net/wlan0/operstate", status, 16);
-	online = prefixMatch("up", status);
+	online = prefixMatch("up", (char*)SysfsValue_getString(&wifi_state));
 }
 
 #define LED_PATH1 "/sys/class/led_anim/max_scale"
@@ -931,10 +931,10 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 void PLAT_enableBacklight(int enable) {
 	if (enable) {
 		SetBrightness(GetBrightness());
-		system("leds_off");
+		runProgram((char* const[]){"leds_off", NULL});
 	} else {
 		SetRawBrightness(0);
-		system("leds_on");
+		runProgram((char* const[]){"leds_on", NULL});
 	}
 }
 
@@ -953,7 +953,7 @@ void PLAT_enableBacklight(int enable) {
  * @note Creates /tmp/poweroff for init system to detect
  */
 void PLAT_powerOff(void) {
-	system("leds_on");
+	runProgram((char* const[]){"leds_on", NULL});
 	sleep(2);
 
 	SetRawVolume(MUTE_VOLUME_RAW);
@@ -1003,9 +1003,7 @@ void PLAT_setCPUSpeed(int speed) {
 		break;
 	}
 
-	char cmd[256];
-	sprintf(cmd, "echo %i > %s", freq, GOVERNOR_PATH);
-	system(cmd);
+	putInt(GOVERNOR_PATH, freq);
 }
 
 ///////////////////////////////
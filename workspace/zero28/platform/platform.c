@@ -30,6 +30,7 @@
 #include "api.h"
 #include "defines.h"
 #include "platform.h"
+#include "sysfs.h"
 #include "utils.h"
 
 #include "scaler.h"
@@ -227,7 +228,7 @@ void PLAT_quitVideo(void) {
 
 	SDL_Quit();
 	// Directly blank framebuffer to prevent visual artifacts
-	system("cat /dev/zero > /dev/fb0 2>/dev/null");
+	zeroDevice("/dev/fb0");
 }
 
 /**
@@ -705,6 +706,10 @@ void PLAT_flip(SDL_Surface* IGNORED, int ignored) {
 // WiFi connectivity state (updated during battery polling)
 static int online = 0;
 
+static SysfsValue charger_online = SYSFS_VALUE("/sys/class/power_supply/axp2202-usb/online", 0);
+static SysfsValue battery_capacity = SYSFS_VALUE("/sys/class/power_supply/axp2202-battery/capacity", 0);
+static SysfsValue wifi_state = SYSFS_VALUE("/sys/class/net/wlan0/operstate", 0);
+
 /**
  * Gets battery and charging status.
  *
@@ -721,10 +726,10 @@ static int online = 0;
  */
 void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 	// Check USB power connection (AXP2202-specific path)
-	*is_charging = getInt("/sys/class/power_supply/axp2202-usb/online");
+	*is_charging = SysfsValue_getInt(&charger_online);
 
 	// Read battery capacity and round to nearest 20%
-	int i = getInt("/sys/class/power_supply/axp2202-battery/capacity");
+	int i = SysfsValue_getInt(&battery_capacity);
 	if (i > 80)
 		*charge = 100;
 	else if (i > 60)
@@ -739,9 +744,7 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 		*charge = 10;
 
 	// Update WiFi status (polled here to avoid separate polling loop)
-	char status[16];
-	getFile("/sys/class/net/wlan0/operstate", status, 16);
-	online = prefixMatch("up", status);
+	online = prefixMatch("up", (char*)SysfsValue_getString(&wifi_state));
 }
 
 #define BLANK_PATH "/sys/class/graphics/fb0/blank"
@@ -757,11 +760,11 @@ void PLAT_getBatteryStatus(int* is_charging, int* charge) {
 void PLAT_enableBacklight(int enable) {
 	if (enable) {
 		SetBrightness(GetBrightness());
-		system("bl_enable"); // Platform-specific backlight enable script
+		runProgram((char* const[]){"bl_enable", NULL}); // Platform-specific backlight enable script
 		putInt(BLANK_PATH, FB_BLANK_UNBLANK);
 	} else {
 		SetRawBrightness(0);
-		system("bl_disable"); // Platform-specific backlight disable script
+		runProgram((char* const[]){"bl_disable", NULL}); // Platform-specific backlight disable script
 		putInt(BLANK_PATH, FB_BLANK_POWERDOWN);
 	}
 }
@@ -787,7 +790,7 @@ void PLAT_powerOff(void) {
 	PWR_quit();
 	GFX_quit();
 
-	system("cat /dev/zero > /dev/fb0 2>/dev/null");
+	zeroDevice("/dev/fb0");
 	system("poweroff");
 	exit(0);
 }